@@ -32,16 +32,20 @@
 //@{
 
 #include <hid.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <time.h>
+#include <errno.h>
 #include "config.h"
 #include "cy3240.h"
 #include "cy3240_types.h"
 #include "cy3240_private_types.h"
 #include "cy3240_debug.h"
 #include "cy3240_packet.h"
+#include "cy3240_util.h"
+#include "cy3240_handle.h"
 
 //@} End of Includes
 
@@ -50,9 +54,6 @@
 /// @name Defines
 //@{
 
-#define SEND_PACKET_LEN (64)
-#define RECV_PACKET_LEN (64)
-
 /* Result Macros */
 #define HID_SUCCESS(s)  ((s == HID_RET_SUCCESS) ? TRUE : FALSE)
 #define HID_FAILURE(s)  ((s != HID_RET_SUCCESS) ? TRUE : FALSE)
@@ -69,24 +70,17 @@
 const int INPUT_ENDPOINT   = 0x82;              ///< The input usb endpoint
 const int OUTPUT_ENDPOINT  = 0x01;              ///< The output usb endpoint
 
-// The sending buffer
-char SEND_PACKET[SEND_PACKET_LEN] = {
-    0x03, 0x02, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
-
-// The receive buffer
-char RECV_PACKET[RECV_PACKET_LEN] = {
-    0x03, 0x02, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
-
-// Mutex to lock concurrent access to the bridge chip
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * Priority class of the writes, reads and transfers of the calling thread
+ */
+static __thread Cy3240_Priority_t thread_priority = CY3240_PRIORITY_INTERACTIVE;
+
+/**
+ * libhid keeps one state for the whole process, initialized by the first
+ * open and cleaned up by the last close
+ */
+static pthread_mutex_t libhid_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int libhid_users = 0;
 
 //@} End of Data
 
@@ -141,862 +135,3202 @@ disable_hid_debug(
 }
 #endif // DEBUG
 
-
 //-----------------------------------------------------------------------------
 /**
- *  Method to Transmit and Receive a packet from the CY3240
+ *  Method to take a reference on libhid for a handle, initializing it if
+ *  no other handle holds one
  *
- *  @param pCy3240        [in] the Cypress 3240 status structure
- *  @param pSendData      [in] the data to send
- *  @param pSendLength    [in] the length of the send data
- *  @param pReceiveData   [out] the data received from the Cypress 3240
- *  @param pReceiveLength [out] the length of the received data
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @returns hid_return
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-transcieve(
-        const Cy3240_t* const pCy3240,
-        const uint8_t* const pSendData,
-        const uint16_t* const pSendLength,
-        uint8_t* const pReceiveData,
-        uint16_t* const pReceiveLength
+static hid_return
+libhid_acquire(
+        Cy3240_t* const pCy3240
         )
 {
-    if ((pCy3240 != NULL) &&
-        (pSendData != NULL) &&
-        (pSendLength != NULL) &&
-        (*pSendLength != 0) &&
-        (pReceiveData != NULL) &&
-        (pReceiveLength != NULL) &&
-        (*pReceiveLength != 0)) {
-
-        hid_return error = HID_RET_SUCCESS;
-
-        CY3240_DEBUG_PRINT_TX_PACKET(pSendData, *pSendLength);
+    hid_return error = HID_RET_SUCCESS;
 
-        // Write the data to the USB HID device
-        error = pCy3240->w.write(
-                pCy3240->pHid,
-                OUTPUT_ENDPOINT,
-                pSendData,
-                SEND_PACKET_LEN,
-                pCy3240->timeout);
+    // Opened before
+    if (pCy3240->hid_user)
+        return HID_RET_SUCCESS;
 
-        if (error != HID_RET_SUCCESS) {
-            fprintf(stderr, "hid_set_output_report failed with return code %d\n", error);
-            return CY3240_ERROR_HID;
-        }
+    pthread_mutex_lock(&libhid_lock);
 
-        // Read the response data from the USB HID device
-        error = pCy3240->w.read(
-                pCy3240->pHid,
-                INPUT_ENDPOINT,
-                pReceiveData,
-                RECV_PACKET_LEN,
-                pCy3240->timeout);
+    if (libhid_users == 0)
+        error = pCy3240->w.init();
 
-        if (error != HID_RET_SUCCESS) {
-            fprintf(stderr, "hid_get_input_report failed with return code %d\n", error);
-            return CY3240_ERROR_HID;
-        }
+    if (!HID_FAILURE(error)) {
+        libhid_users++;
+        pCy3240->hid_user = true;
+    }
 
-        CY3240_DEBUG_PRINT_RX_PACKET(pReceiveData, *pReceiveLength);
+    pthread_mutex_unlock(&libhid_lock);
 
-        return CY3240_ERROR_OK;
-    }
+    return error;
 }
 
-
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack the packet to change the power mode for the bridge controller
+ *  Method to drop the libhid reference of a handle, cleaning libhid up if
+ *  it was the last one
  *
- *  @param pCy3240 [in] the CY3240 state
- *  @param pLength [out] the length of the reconfigure data
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @returns hid_return
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_reconfigure_power(
-        Cy3240_Power_t power,
-        uint16_t* const pLength
+static hid_return
+libhid_release(
+        Cy3240_t* const pCy3240
         )
 {
-    // Check the parameters
-    if (pLength != NULL) {
-
-        // Initialize the byte index
-        uint8_t byteIndex = 0;
+    hid_return error = HID_RET_SUCCESS;
 
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START;
-        SEND_PACKET[byteIndex++] = LENGTH_BYTE_LAST_PACKET | 0x01;
+    if (!pCy3240->hid_user)
+        return HID_RET_SUCCESS;
 
-        // Set the I2C address of the CY3240 control register
-        SEND_PACKET[byteIndex++] = CONTROL_I2C_ADDRESS;
+    pthread_mutex_lock(&libhid_lock);
 
-        // Set the power mode to use
-        SEND_PACKET[byteIndex] = power;
+    pCy3240->hid_user = false;
 
-        // Set the length
-        *pLength = byteIndex + 1;
+    if (--libhid_users == 0)
+        error = pCy3240->w.cleanup();
 
-        return CY3240_ERROR_OK;
-    }
+    pthread_mutex_unlock(&libhid_lock);
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_reconfigure_power  ----- */
+    return error;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack the reconfigure the clock speed for the bridge controller
+ *  Method to mark the power and clock settings of the bridge as unknown, so
+ *  the next reconfigure sends them again
  *
- *  @param pCy3240 [in] the CY3240 state
- *  @param pLength [out] the length of the reconfigure data
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_reconfigure_clock(
-        Cy3240_I2C_ClockSpeed_t clock,
-        uint16_t* const pLength
+static void
+invalidate_config(
+        Cy3240_t* const pCy3240
         )
 {
-    // Check the parameters
-    if (pLength != NULL) {
-
-        // Initialize the byte index
-        uint8_t byteIndex = 0;
-
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_RECONFIG | clock;
-        SEND_PACKET[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
+    pCy3240->power_valid = false;
+    pCy3240->clock_valid = false;
+}
 
-        // Set the I2C address of the CY3240 control register
-        SEND_PACKET[byteIndex++] = CONTROL_I2C_ADDRESS;
+//-----------------------------------------------------------------------------
+/**
+ *  Method to estimate the time a packet spends on the I2C bus
+ *
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param pPacket [in] the packet sent to the bridge
+ *  @returns the time in microseconds
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+bus_time_us(
+        const Cy3240_t* const pCy3240,
+        const uint8_t* const pPacket
+        )
+{
+    uint32_t hz;
+    uint32_t bits;
 
-        // Set the length
-        *pLength = byteIndex + 1;
+    // Bridge commands do not touch the bus
+    if (pPacket[INPUT_PACKET_INDEX_CMD] & (CONTROL_BYTE_RECONFIG | CONTROL_BYTE_REINIT))
+        return 0;
 
-        return CY3240_ERROR_OK;
+    switch (pCy3240->clock) {
+        case CY3240_CLOCK__400kHz: hz = 400000; break;
+        case CY3240_CLOCK__50kHz:  hz = 50000;  break;
+        default:                   hz = 100000; break;
     }
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_reconfigure_clock ----- */
+    // Address and data bytes with their acknowledge, plus start and stop
+    bits = 9 * ((pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS) + 1) + 2;
 
+    return (uint32_t)(((uint64_t)bits * 1000000 + hz - 1) / hz);
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack the restart the bridge controller
+ *  Method to get the timeout for a packet
  *
- *  @param pLength [out] the length of the restart data
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param bus_us  [in] the expected time on the I2C bus
+ *  @returns the timeout in milliseconds
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_restart(
-        uint16_t* const pLength
+static int
+packet_timeout(
+        const Cy3240_t* const pCy3240,
+        uint32_t bus_us
         )
 {
-    if (pLength != NULL) {
+    uint64_t us;
 
-        // Initialize the byte index
-        uint8_t byteIndex = 0;
+    if (!pCy3240->adaptive ||
+        (pCy3240->latency_samples < CY3240_LATENCY_MIN_SAMPLES))
+        return pCy3240->timeout;
 
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_RESTART;
-        SEND_PACKET[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
-
-        // Set the control address
-        SEND_PACKET[byteIndex++] = CONTROL_I2C_ADDRESS;
+    us = (uint64_t)bus_us + pCy3240->latency_us + 4 * (uint64_t)pCy3240->deviation_us + CY3240_LATENCY_MARGIN_US;
 
-        // Set the length
-        *pLength = byteIndex + 1;
+    return (int)MIN((us + 999) / 1000, (uint64_t)pCy3240->timeout);
+}
 
-        return CY3240_ERROR_OK;
+//-----------------------------------------------------------------------------
+/**
+ *  Method to learn from a measured round trip, smoothed the same way TCP
+ *  smooths its round trip time
+ *
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param sample  [in] the round trip less the bus time
+ */
+//-----------------------------------------------------------------------------
+static void
+update_latency(
+        Cy3240_t* const pCy3240,
+        uint32_t sample
+        )
+{
+    if (pCy3240->latency_samples++ == 0) {
+        pCy3240->latency_us = sample;
+        pCy3240->deviation_us = sample / 2;
+        return;
     }
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_restart  ----- */
+    pCy3240->deviation_us = (3 * pCy3240->deviation_us +
+            (uint32_t)abs((int32_t)(sample - pCy3240->latency_us))) / 4;
+    pCy3240->latency_us = (7 * pCy3240->latency_us + sample) / 8;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack the re-initialize the bridge controller
+ *  Method to find the histogram bucket of a duration, bucket n holds the
+ *  durations from 2^n up to 2^(n+1) microseconds
  *
- *  @param pLength [out] the length of the reinit data
- *  @returns Cy3240_Error_t
+ *  @param us [in] the duration
+ *  @returns the bucket
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_reinit(
-        uint16_t* const pLength
+static int
+histogram_bucket(
+        uint64_t us
         )
 {
-    if (pLength != NULL) {
-
-        // Initialize the byte index
-        uint8_t byteIndex = 0;
-
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_REINIT;
-        SEND_PACKET[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
-
-        // Set the control address
-        SEND_PACKET[byteIndex++] = CONTROL_I2C_ADDRESS;
+    int bucket = 0;
 
-        // Set the length
-        *pLength = byteIndex + 1;
-
-        return CY3240_ERROR_OK;
-    }
-
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_reinit  ----- */
+    while ((us >>= 1) && (bucket < CY3240_LATENCY_BUCKETS - 1))
+        bucket++;
 
+    return bucket;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack a data write input packet
+ *  Method to count a round trip in the histogram
  *
- *  @param address     [in] the I2C address of the target
- *  @param pSendData   [in] the data to send
- *  @param pSendLength [in] the length of the data to send
- *  @param first       [in] is this the first packet
- *  @param more        [in] are there more packets
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param us      [in] the round trip including the bus time
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_write_input(
-        uint8_t address,
-        const uint8_t* const pSendData,
-        uint16_t* const pSendLength,
-        bool first,
-        bool more
+static void
+count_round_trip(
+        Cy3240_t* const pCy3240,
+        uint64_t us
         )
 {
-    // Check parameters
-    if ((pSendData != NULL) &&
-        (pSendLength != NULL) &&
-        (*pSendLength != 0)) {
-
-        // Initialize the byte index
-        uint8_t byteIndex = 0;
+    pCy3240->traffic.histogram[histogram_bucket(us)]++;
+}
 
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START;
-        SEND_PACKET[byteIndex++] = (uint8_t)*pSendLength;
+//-----------------------------------------------------------------------------
+/**
+ *  Method to estimate a percentile from a histogram
+ *
+ *  @param pHistogram [in] CY3240_LATENCY_BUCKETS counters
+ *  @param percent    [in] the percentile, 1 to 100
+ *  @returns the upper bound of the bucket holding the percentile in
+ *           microseconds, 0 for an empty histogram
+ */
+//-----------------------------------------------------------------------------
+static uint64_t
+histogram_percentile(
+        const uint64_t* const pHistogram,
+        unsigned int percent
+        )
+{
+    uint64_t total = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    int x;
 
-        // Check to see if this is the last packet
-        if (more)
-             SEND_PACKET[INPUT_PACKET_INDEX_LENGTH] |= LENGTH_BYTE_MORE_PACKETS;
+    if ((percent == 0) ||
+        (percent > 100))
+        return 0;
 
-        else
-             SEND_PACKET[INPUT_PACKET_INDEX_CMD] |= CONTROL_BYTE_STOP;
+    for (x = 0; x < CY3240_LATENCY_BUCKETS; x++)
+        total += pHistogram[x];
 
-        // If this is the first packet, we need to send the address
-        if (first)
-             SEND_PACKET[byteIndex++] = address;
+    // The duration at this rank is the percentile
+    rank = (total * percent + 99) / 100;
 
-        // Copy the data in to the send buffer
-        memcpy(&SEND_PACKET[byteIndex], pSendData, *pSendLength);
+    for (x = 0; (x < CY3240_LATENCY_BUCKETS) && (rank != 0); x++) {
 
-        // Update the length to include the header bytes
-        *pSendLength += byteIndex;
+        seen += pHistogram[x];
 
-        return CY3240_ERROR_OK;
+        if (seen >= rank)
+            return (uint64_t)1 << (x + 1);
     }
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_write  ----- */
+    return 0;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to decode the write output packet
+ *  Method to count the outcome of a write, read or probe
  *
- *  @param pWriteLength [in] the number of bytes written
- *  @param pReadLength  [in] the number of bytes read
- *  @param pBytesLeft   [out] the number of bytes left to send
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param type    [in] the kind of operation
+ *  @param length  [in] the number of data bytes moved
+ *  @param result  [in] the result of the operation
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-unpack_write_output(
-        const uint16_t* const pWriteLength,
-        const uint16_t* const pReadLength,
-        uint16_t* const pBytesLeft
+static void
+count_op(
+        Cy3240_t* const pCy3240,
+        Cy3240_Op_Type_t type,
+        uint16_t length,
+        Cy3240_Error_t result
         )
 {
-    // Check the parameters
-    if ((pWriteLength != NULL) &&
-        (*pWriteLength != 0) &&
-        (pReadLength != NULL) &&
-        (*pReadLength != 0) &&
-        (RECV_PACKET[OUTPUT_PACKET_INDEX_STATUS] != 0x00)) {
-
-        int x = 0;
-
-        // Loop through the pack acknowledgments
-        for (x = OUTPUT_PACKET_INDEX_STATUS + 1; x < *pReadLength; x++) {
+    // A NAK just reports that nothing answers at the address
+    if ((type == CY3240_OP_PROBE) && (result == CY3240_ERROR_TX))
+        return;
 
-            DBG(printf("RECV_PACKET[%i]=%02x\n", x, RECV_PACKET[x]);)
+    if CY3240_FAILURE(result) {
+        pCy3240->traffic.errors++;
 
-            // Check for ack
-            if (RECV_PACKET[x] == TX_ACK) {
-
-                // Decrement the number of remaining bytes
-                if (pBytesLeft != NULL) {
-                     *pBytesLeft = *pBytesLeft - 1;
-                }
-
-            // Nack
-            } else {
-                printf(" Nack: %i\n", x);
-                return CY3240_ERROR_TX;
-            }
-        }
+    } else if (type == CY3240_OP_READ) {
+        pCy3240->traffic.reads++;
+        pCy3240->traffic.read_bytes += length;
 
-        // Finished
-        return CY3240_ERROR_OK;
+    } else {
+        pCy3240->traffic.writes++;
+        pCy3240->traffic.write_bytes += length;
     }
-
-    return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
-
 //-----------------------------------------------------------------------------
 /**
- *  Method to pack the read input packet
+ *  Method to count the NAK in the response to a single write, read or probe
+ *  packet. Writes and probes return an acknowledgment per byte, a read only
+ *  reports in the status byte whether the slave answered to its address.
+ *  The retries of cy3240_write() count their own NAKs.
  *
- *  @param address     [in] the I2C address of the device to read
- *  @param pReadLength [in] the length of bytes to read
- *  @param first       [in] is this the first read
- *  @param more        [in] is there more data to read
- *  @returns Cy3240_Error_t
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @param pPacket [in] the received packet
+ *  @param type    [in] the kind of operation
+ *  @param length  [in] the number of data bytes in the packet
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-pack_read_input (
-        uint8_t address,
-        uint16_t* const pReadLength
+static void
+count_nak(
+        Cy3240_t* const pCy3240,
+        const uint8_t* const pPacket,
+        Cy3240_Op_Type_t type,
+        uint16_t length
         )
 {
-    // Check the parameters
-    if ((pReadLength != NULL) &&
-        (*pReadLength != 0)) {
+    uint16_t x;
 
-        uint8_t byteIndex = 0;
+    // The bridge failed, the slave was not asked
+    if (pPacket[OUTPUT_PACKET_INDEX_STATUS] == 0x00)
+        return;
 
-        SEND_PACKET[byteIndex++] = CONTROL_BYTE_I2C_READ | CONTROL_BYTE_START | CONTROL_BYTE_STOP;
-        SEND_PACKET[byteIndex++] = (uint8_t)*pReadLength;
+    if (type == CY3240_OP_READ) {
+
+        if (!(pPacket[OUTPUT_PACKET_INDEX_STATUS] & STATUS_BYTE_ACK))
+            pCy3240->retry_stats.naks[CY3240_NAK_ADDRESS]++;
+
+        return;
+    }
+
+    // Nothing acknowledged means the slave did not answer to its address
+    for (x = 0; x < MAX(length, 1); x++) {
+
+        if (pPacket[OUTPUT_PACKET_INDEX_DATA + x] != TX_ACK) {
+            pCy3240->retry_stats.naks[(x == 0) ? CY3240_NAK_ADDRESS : CY3240_NAK_DATA]++;
+            return;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check for calls of a higher class waiting for the bridge
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure
+ *  @param priority [in] the class of the caller
+ *  @returns true if a higher class is waiting
+ */
+//-----------------------------------------------------------------------------
+static bool
+higher_waiting(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority
+        )
+{
+    int x;
+
+    for (x = 0; x < (int)priority; x++)
+        if (__atomic_load_n(&pCy3240->waiting[x], __ATOMIC_SEQ_CST) != 0)
+            return true;
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to wait, holding the lock, until no higher class is waiting. The
+ *  caller counts as waiting itself meanwhile, so a preempted call still
+ *  goes before the lower classes.
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure, locked
+ *  @param priority [in] the class of the caller
+ */
+//-----------------------------------------------------------------------------
+static void
+wait_turn(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority
+        )
+{
+    if (!higher_waiting(pCy3240, priority))
+        return;
+
+    __atomic_add_fetch(&pCy3240->waiting[priority], 1, __ATOMIC_SEQ_CST);
+
+    while (higher_waiting(pCy3240, priority) && !pCy3240->closing)
+        pthread_cond_wait(&pCy3240->turn, &pCy3240->lock);
+
+    __atomic_sub_fetch(&pCy3240->waiting[priority], 1, __ATOMIC_SEQ_CST);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to take the bridge once no higher class is waiting for it
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure
+ *  @param priority [in] the class of the caller
+ */
+//-----------------------------------------------------------------------------
+static void
+bridge_acquire(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority
+        )
+{
+    // Announce the call before blocking, so a lower class holding the
+    // bridge steps aside at its next packet boundary
+    __atomic_add_fetch(&pCy3240->waiting[priority], 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&pCy3240->lock);
+
+    while (higher_waiting(pCy3240, priority) && !pCy3240->closing)
+        pthread_cond_wait(&pCy3240->turn, &pCy3240->lock);
+
+    __atomic_sub_fetch(&pCy3240->waiting[priority], 1, __ATOMIC_SEQ_CST);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to give up the bridge
+ *
+ *  @param pCy3240 [in] the Cypress 3240 status structure, locked
+ */
+//-----------------------------------------------------------------------------
+static void
+bridge_release(
+        Cy3240_t* const pCy3240
+        )
+{
+    // Lower classes waiting for this one check again
+    pthread_cond_broadcast(&pCy3240->turn);
+    pthread_mutex_unlock(&pCy3240->lock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to take the bridge for a write, read or transfer in the class of
+ *  the calling thread
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure
+ *  @param pStart   [out] the time of the call
+ *  @returns the class of the call
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Priority_t
+bridge_lock(
+        Cy3240_t* const pCy3240,
+        uint64_t* const pStart
+        )
+{
+    const Cy3240_Priority_t priority = thread_priority;
+    Cy3240_Class_Stats_t* const pClass = &pCy3240->classes[priority];
+    uint64_t wait;
+
+    *pStart = cy3240_util_time_us();
+
+    bridge_acquire(
+            pCy3240,
+            priority);
+
+    wait = cy3240_util_time_us() - *pStart;
+    pClass->wait_us += wait;
+    pClass->max_wait_us = MAX(pClass->max_wait_us, wait);
+
+    return priority;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to let a waiting higher class use the bridge. Only called where
+ *  the last packet ended with a stop condition.
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure, locked
+ *  @param priority [in] the class of the caller
+ *  @returns true if the bridge was handed over
+ */
+//-----------------------------------------------------------------------------
+static bool
+bridge_yield(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority
+        )
+{
+    if (!higher_waiting(pCy3240, priority))
+        return false;
+
+    pCy3240->classes[priority].preempted++;
+
+    wait_turn(
+            pCy3240,
+            priority);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to count the duration of a call and release the bridge
+ *
+ *  @param pCy3240  [in] the Cypress 3240 status structure, locked
+ *  @param priority [in] the class of the call
+ *  @param start    [in] the time of the call
+ */
+//-----------------------------------------------------------------------------
+static void
+bridge_unlock(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority,
+        uint64_t start
+        )
+{
+    Cy3240_Class_Stats_t* const pClass = &pCy3240->classes[priority];
+    const uint64_t us = cy3240_util_time_us() - start;
+
+    pClass->calls++;
+    pClass->total_us += us;
+    pClass->max_us = MAX(pClass->max_us, us);
+    pClass->histogram[histogram_bucket(us)]++;
+
+    bridge_release(pCy3240);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the bus time of the packets still waiting for a response
+ *
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ *  @returns the time in microseconds
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+inflight_bus_us(
+        const Cy3240_t* const pCy3240
+        )
+{
+    uint32_t us = 0;
+    uint16_t x;
+
+    for (x = pCy3240->inflight_tail; x != pCy3240->inflight_head; x++)
+        us += pCy3240->inflight[x % CY3240_INFLIGHT_MAX].bus_us;
+
+    return us;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to drop responses that arrived after their adaptive timeout, so
+ *  they are not taken for the response to the next packet. The adaptive
+ *  estimate has already proven too short, each late response is given the
+ *  fixed timeout plus the bus time of every late packet queued before it.
+ *
+ *  @param pCy3240 [in] the Cypress 3240 status structure
+ */
+//-----------------------------------------------------------------------------
+static void
+drop_stale(
+        Cy3240_t* const pCy3240
+        )
+{
+    while (pCy3240->stale > 0) {
+
+        pCy3240->stale--;
+
+        // Whatever has not arrived by now is assumed lost
+        if (pCy3240->w.read(
+                pCy3240->pHid,
+                INPUT_ENDPOINT,
+                pCy3240->recv,
+                RECV_PACKET_LEN,
+                pCy3240->timeout + (int)((pCy3240->stale_us + 999) / 1000)) != HID_RET_SUCCESS)
+            pCy3240->stale = 0;
+    }
+
+    pCy3240->stale_us = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to Transmit a packet to the CY3240
+ *
+ *  @param pCy3240        [in] the Cypress 3240 status structure
+ *  @param pSendData      [in] the data to send
+ *  @param pSendLength    [in] the length of the send data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+transmit(
+        Cy3240_t* const pCy3240,
+        const uint8_t* const pSendData,
+        const uint16_t* const pSendLength
+        )
+{
+    if ((pCy3240 != NULL) &&
+        (pSendData != NULL) &&
+        (pSendLength != NULL) &&
+        (*pSendLength != 0)) {
+
+        hid_return error = HID_RET_SUCCESS;
+        Cy3240_Inflight_t* pInflight;
+
+        // The handle is being closed
+        if (pCy3240->closing)
+            return CY3240_ERROR_INVALID_PARAMETERS;
+
+        // A failed rebuild left the handle without an interface
+        if (pCy3240->pHid == NULL) {
+            fprintf(stderr, "The bridge has no HID interface\n");
+            return CY3240_ERROR_HID;
+        }
+
+        if (pCy3240->stale > 0)
+            drop_stale(pCy3240);
+
+        CY3240_DEBUG_PRINT_TX_PACKET(pSendData, *pSendLength);
+
+        // Write the data to the USB HID device
+        error = pCy3240->w.write(
+                pCy3240->pHid,
+                OUTPUT_ENDPOINT,
+                pSendData,
+                SEND_PACKET_LEN,
+                packet_timeout(pCy3240, 0));
+
+        if (error != HID_RET_SUCCESS) {
+            fprintf(stderr, "hid_set_output_report failed with return code %d\n", error);
+            invalidate_config(pCy3240);
+            pCy3240->inflight_tail = pCy3240->inflight_head;
+            return CY3240_ERROR_HID;
+        }
+
+        // Remember when the packet left for the timeout of its response
+        if ((uint16_t)(pCy3240->inflight_head - pCy3240->inflight_tail) < CY3240_INFLIGHT_MAX) {
+            pInflight = &pCy3240->inflight[pCy3240->inflight_head++ % CY3240_INFLIGHT_MAX];
+            pInflight->sent_us = cy3240_util_time_us();
+            pInflight->bus_us = bus_time_us(pCy3240, pSendData);
+        }
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to Receive a packet from the CY3240
+ *
+ *  @param pCy3240        [in] the Cypress 3240 status structure
+ *  @param pReceiveData   [out] the data received from the Cypress 3240
+ *  @param pReceiveLength [out] the length of the received data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+receive(
+        Cy3240_t* const pCy3240,
+        uint8_t* const pReceiveData,
+        uint16_t* const pReceiveLength
+        )
+{
+    if ((pCy3240 != NULL) &&
+        (pReceiveData != NULL) &&
+        (pReceiveLength != NULL) &&
+        (*pReceiveLength != 0)) {
+
+        hid_return error = HID_RET_SUCCESS;
+        Cy3240_Inflight_t inflight = {pCy3240->last_transfer, 0};
+        uint64_t start;
+        uint64_t now;
+        uint64_t elapsed;
+        uint8_t previous;
+
+        // The handle is being closed
+        if (pCy3240->closing)
+            return CY3240_ERROR_INVALID_PARAMETERS;
+
+        if (pCy3240->inflight_tail != pCy3240->inflight_head)
+            inflight = pCy3240->inflight[pCy3240->inflight_tail++ % CY3240_INFLIGHT_MAX];
+
+        // A pipelined packet is only served once the one before it is answered
+        start = MAX(inflight.sent_us, pCy3240->last_transfer);
+        pCy3240->last_timeout = packet_timeout(pCy3240, inflight.bus_us);
+
+        // Read the response data from the USB HID device
+        error = pCy3240->w.read(
+                pCy3240->pHid,
+                INPUT_ENDPOINT,
+                pReceiveData,
+                RECV_PACKET_LEN,
+                pCy3240->last_timeout);
+
+        if (error != HID_RET_SUCCESS) {
+
+            // The packets still in flight will be answered late, if at all
+            const uint16_t late = 1 + (uint16_t)(pCy3240->inflight_head - pCy3240->inflight_tail);
+            const uint32_t late_us = inflight.bus_us + inflight_bus_us(pCy3240);
+
+            pCy3240->inflight_tail = pCy3240->inflight_head;
+            invalidate_config(pCy3240);
+
+            if ((error == HID_RET_TIMEOUT) &&
+                (pCy3240->last_timeout < pCy3240->timeout)) {
+                fprintf(stderr, "No response within the adaptive timeout of %d ms\n", pCy3240->last_timeout);
+                pCy3240->timeouts++;
+                pCy3240->stale = late;
+                pCy3240->stale_us = late_us;
+                pCy3240->deviation_us = MAX(2 * pCy3240->deviation_us, CY3240_LATENCY_MARGIN_US);
+                return CY3240_ERROR_TIMEOUT;
+            }
+
+            fprintf(stderr, "hid_get_input_report failed with return code %d\n", error);
+            return CY3240_ERROR_HID;
+        }
+
+        CY3240_DEBUG_PRINT_RX_PACKET(pReceiveData, *pReceiveLength);
+
+        // Learn the USB part of the round trip
+        now = cy3240_util_time_us();
+        elapsed = (now > start) ? (now - start) : 0;
+        count_round_trip(pCy3240, elapsed);
+        update_latency(pCy3240, (uint32_t)MIN((elapsed > inflight.bus_us) ? (elapsed - inflight.bus_us) : 0, UINT32_MAX));
+
+        // Record the status byte and wake anybody waiting for an interrupt.
+        // A flag held over several responses is one interrupt.
+        previous = pCy3240->status;
+        pCy3240->status = pReceiveData[OUTPUT_PACKET_INDEX_STATUS];
+        pCy3240->last_transfer = now;
+
+        if ((pCy3240->status & STATUS_BYTE_INTERRUPT) &&
+            !(previous & STATUS_BYTE_INTERRUPT)) {
+            pCy3240->interrupts++;
+            pthread_cond_broadcast(&pCy3240->interrupt);
+        }
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to Transmit and Receive a packet from the CY3240
+ *
+ *  @param pCy3240        [in] the Cypress 3240 status structure
+ *  @param pSendData      [in] the data to send
+ *  @param pSendLength    [in] the length of the send data
+ *  @param pReceiveData   [out] the data received from the Cypress 3240
+ *  @param pReceiveLength [out] the length of the received data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+transcieve(
+        Cy3240_t* const pCy3240,
+        const uint8_t* const pSendData,
+        const uint16_t* const pSendLength,
+        uint8_t* const pReceiveData,
+        uint16_t* const pReceiveLength
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = transmit(
+            pCy3240,
+            pSendData,
+            pSendLength);
+
+    if CY3240_SUCCESS(result)
+        result = receive(
+                pCy3240,
+                pReceiveData,
+                pReceiveLength);
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack the packet to change the power mode for the bridge controller
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param pCy3240 [in] the CY3240 state
+ *  @param pLength [out] the length of the reconfigure data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_reconfigure_power(
+        uint8_t* const pPacket,
+        Cy3240_Power_t power,
+        uint16_t* const pLength
+        )
+{
+    // Check the parameters
+    if (pLength != NULL) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START;
+        pPacket[byteIndex++] = LENGTH_BYTE_LAST_PACKET | 0x01;
+
+        // Set the I2C address of the CY3240 control register
+        pPacket[byteIndex++] = CONTROL_I2C_ADDRESS;
+
+        // Set the power mode to use
+        pPacket[byteIndex] = power;
+
+        // Set the length
+        *pLength = byteIndex + 1;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_reconfigure_power  ----- */
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack the reconfigure the clock speed for the bridge controller
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param pCy3240 [in] the CY3240 state
+ *  @param pLength [out] the length of the reconfigure data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_reconfigure_clock(
+        uint8_t* const pPacket,
+        Cy3240_I2C_ClockSpeed_t clock,
+        uint16_t* const pLength
+        )
+{
+    // Check the parameters
+    if (pLength != NULL) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_RECONFIG | clock;
+        pPacket[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
+
+        // Set the I2C address of the CY3240 control register
+        pPacket[byteIndex++] = CONTROL_I2C_ADDRESS;
+
+        // Set the length
+        *pLength = byteIndex + 1;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_reconfigure_clock ----- */
+
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack the restart the bridge controller
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param pLength [out] the length of the restart data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_restart(
+        uint8_t* const pPacket,
+        uint16_t* const pLength
+        )
+{
+    if (pLength != NULL) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_RESTART;
+        pPacket[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
+
+        // Set the control address
+        pPacket[byteIndex++] = CONTROL_I2C_ADDRESS;
+
+        // Set the length
+        *pLength = byteIndex + 1;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_restart  ----- */
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack the re-initialize the bridge controller
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param pLength [out] the length of the reinit data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_reinit(
+        uint8_t* const pPacket,
+        uint16_t* const pLength
+        )
+{
+    if (pLength != NULL) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_REINIT;
+        pPacket[byteIndex++] = LENGTH_BYTE_LAST_PACKET;
+
+        // Set the control address
+        pPacket[byteIndex++] = CONTROL_I2C_ADDRESS;
+
+        // Set the length
+        *pLength = byteIndex + 1;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_reinit  ----- */
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack a status query to the bridge controller. The query reads
+ *  the bridge control register, so no traffic reaches the I2C bus.
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param pLength [out] the length of the query data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_status_query(
+        uint8_t* const pPacket,
+        uint16_t* const pLength
+        )
+{
+    if (pLength != NULL) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_READ | CONTROL_BYTE_START | CONTROL_BYTE_STOP;
+        pPacket[byteIndex++] = LENGTH_BYTE_LAST_PACKET | STATUS_QUERY_LENGTH;
+
+        // Set the control address
+        pPacket[byteIndex++] = CONTROL_I2C_ADDRESS;
+
+        // Set the length
+        *pLength = byteIndex;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_status_query  ----- */
+
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack a data write input packet
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param address     [in] the I2C address of the target
+ *  @param pSendData   [in] the data to send
+ *  @param pSendLength [in] the length of the data to send
+ *  @param first       [in] is this the first packet
+ *  @param more        [in] are there more packets
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_write_input(
+        uint8_t* const pPacket,
+        uint8_t address,
+        const uint8_t* const pSendData,
+        uint16_t* const pSendLength,
+        bool first,
+        bool more
+        )
+{
+    // Check parameters
+    if ((pSendData != NULL) &&
+        (pSendLength != NULL) &&
+        (*pSendLength != 0)) {
+
+        // Initialize the byte index
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START;
+        pPacket[byteIndex++] = (uint8_t)*pSendLength;
+
+        // Check to see if this is the last packet
+        if (more)
+             pPacket[INPUT_PACKET_INDEX_LENGTH] |= LENGTH_BYTE_MORE_PACKETS;
+
+        else
+             pPacket[INPUT_PACKET_INDEX_CMD] |= CONTROL_BYTE_STOP;
+
+        // If this is the first packet, we need to send the address
+        if (first)
+             pPacket[byteIndex++] = address;
+
+        // Copy the data in to the send buffer
+        memcpy(&pPacket[byteIndex], pSendData, *pSendLength);
+
+        // Update the length to include the header bytes
+        *pSendLength += byteIndex;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_write  ----- */
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to decode the write output packet
+ *
+ *  @param pPacket [in] the received packet
+ *  @param pWriteLength [in] the number of bytes written
+ *  @param pReadLength  [in] the number of bytes read
+ *  @param pBytesLeft   [out] the number of bytes left to send
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+unpack_write_output(
+        const uint8_t* const pPacket,
+        const uint16_t* const pWriteLength,
+        const uint16_t* const pReadLength,
+        uint16_t* const pBytesLeft
+        )
+{
+    // Check the parameters
+    if ((pWriteLength != NULL) &&
+        (*pWriteLength != 0) &&
+        (pReadLength != NULL) &&
+        (*pReadLength != 0) &&
+        (pPacket[OUTPUT_PACKET_INDEX_STATUS] != 0x00)) {
+
+        int x = 0;
+
+        // Loop through the pack acknowledgments
+        for (x = OUTPUT_PACKET_INDEX_STATUS + 1; x < *pReadLength; x++) {
+
+            DBG(printf("recv[%i]=%02x\n", x, pPacket[x]);)
+
+            // Check for ack
+            if (pPacket[x] == TX_ACK) {
+
+                // Decrement the number of remaining bytes
+                if (pBytesLeft != NULL) {
+                     *pBytesLeft = *pBytesLeft - 1;
+                }
+
+            // Nack
+            } else {
+                DBG(printf(" Nack: %i\n", x);)
+                return CY3240_ERROR_TX;
+            }
+        }
+
+        // Finished
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack the read input packet
+ *
+ *  @param pPacket [out] the packet to send
+ *  @param address     [in] the I2C address of the device to read
+ *  @param pReadLength [in] the length of bytes to read
+ *  @param first       [in] is this the first read
+ *  @param more        [in] is there more data to read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_read_input (
+        uint8_t* const pPacket,
+        uint8_t address,
+        uint16_t* const pReadLength
+        )
+{
+    // Check the parameters
+    if ((pReadLength != NULL) &&
+        (*pReadLength != 0)) {
+
+        uint8_t byteIndex = 0;
+
+        pPacket[byteIndex++] = CONTROL_BYTE_I2C_READ | CONTROL_BYTE_START | CONTROL_BYTE_STOP;
+        pPacket[byteIndex++] = (uint8_t)*pReadLength;
 
         // We need to send the address
-        SEND_PACKET[byteIndex++] = address;
+        pPacket[byteIndex++] = address;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function pack_read_packet  ----- */
+
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to unpack the read output packet data
+ *
+ *  @param pPacket [in] the received packet
+ *  @param pData   [out] the buffer to read the data into
+ *  @param pLength [in] the amount of data to read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+unpack_read_output (
+        const uint8_t* const pPacket,
+        uint8_t* const pData,
+        const uint16_t* const pLength
+        )
+{
+    // Check the parameters
+    if ((pData != NULL) &&
+        (pLength != NULL) &&
+        (*pLength != 0) &&
+        (pPacket[OUTPUT_PACKET_INDEX_STATUS] != 0x00)) {
+
+        // Copy the data from the receive buffer
+        memcpy(pData, &pPacket[OUTPUT_PACKET_INDEX_DATA], *pLength);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}   /* -----  end of static function unpack_read_output  ----- */
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to reconfigure the power mode and clock rate for the CY3240 bridge
+ * chip. Settings that the bridge has already confirmed are not sent again,
+ * and when both are needed the clock packet is queued behind the power
+ * packet before either response is read.
+ *
+ * @param pCy3240 [in] the bridge state inforamtion
+ * @param power   [in] the power mode to set
+ * @param clock   [in] the clock rate to set
+ * @return Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+reconfigure_combined(
+        Cy3240_t* const pCy3240,
+        Cy3240_Power_t power,
+        Cy3240_I2C_ClockSpeed_t clock
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t writeLength = 0;
+    uint16_t readLength = 0;
+
+    bool needPower = !(pCy3240->power_valid && (pCy3240->power == power));
+    bool needClock = !(pCy3240->clock_valid && (pCy3240->clock == clock));
+
+    // Send the power packet
+    if (CY3240_SUCCESS(result) && needPower) {
+
+        result = pack_reconfigure_power(
+                pCy3240->send,
+                power,
+                &writeLength);
+
+        if CY3240_SUCCESS(result)
+            result = transmit(
+                    pCy3240,
+                    pCy3240->send,
+                    &writeLength);
+
+        if CY3240_FAILURE(result)
+            printf("Failed to set the requested power mode: %02x\n", power);
+    }
+
+    // Queue the clock packet behind it
+    if (CY3240_SUCCESS(result) && needClock) {
+
+        result = pack_reconfigure_clock(
+                pCy3240->send,
+                clock,
+                &writeLength);
+
+        if CY3240_SUCCESS(result)
+            result = transmit(
+                    pCy3240,
+                    pCy3240->send,
+                    &writeLength);
+
+        if CY3240_FAILURE(result)
+            printf("Failed to set the requested clock mode: %02x\n", clock);
+    }
+
+    // Collect the responses
+    // Note! The received data is ignored
+    if (CY3240_SUCCESS(result) && needPower) {
+
+        readLength = RECV_PACKET_LEN;
+
+        result = receive(
+                pCy3240,
+                pCy3240->recv,
+                &readLength);
+
+        if CY3240_SUCCESS(result) {
+            pCy3240->power = power;
+            pCy3240->power_valid = true;
+        }
+    }
+
+    if (CY3240_SUCCESS(result) && needClock) {
+
+        readLength = RECV_PACKET_LEN;
+
+        result = receive(
+                pCy3240,
+                pCy3240->recv,
+                &readLength);
+
+        if CY3240_SUCCESS(result) {
+            pCy3240->clock = clock;
+            pCy3240->clock_valid = true;
+        }
+    }
+
+    if CY3240_FAILURE(result)
+        invalidate_config(pCy3240);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to set the clock rate for the CY3240 bridge chip
+ *
+ * @param pCy3240 [in] the bridge state inforamtion
+ * @param clock   [in] the clock rate to set
+ * @return Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+reconfigure_clock(
+        Cy3240_t* const pCy3240,
+        Cy3240_I2C_ClockSpeed_t clock
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t writeLength = 0;
+    uint16_t readLength = 0;
+
+    // The bridge already runs at this speed
+    if (pCy3240->clock_valid && (pCy3240->clock == clock))
+        return CY3240_ERROR_OK;
+
+    result = pack_reconfigure_clock(
+            pCy3240->send,
+            clock,
+            &writeLength);
+
+    if CY3240_FAILURE(result)
+        printf("Failed to pack send data in write input packet: %i\n", result);
+
+    if (CY3240_SUCCESS(result)) {
+
+        readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+
+        // Write the data to the buffer
+        // Note! The received data is ignored
+        result = transcieve(
+                pCy3240,
+                pCy3240->send,
+                &writeLength,
+                pCy3240->recv,
+                &readLength);
+
+        if CY3240_FAILURE(result)
+            printf("Failed to transmit packet\n");
+    }
+
+    // Set the clock rate
+    if CY3240_SUCCESS(result) {
+        pCy3240->clock = clock;
+        pCy3240->clock_valid = true;
+
+    } else {
+        invalidate_config(pCy3240);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to check if the bridge clock has to change before talking to a slave
+ *
+ * @param pCy3240 [in] the bridge state inforamtion
+ * @param address [in] the I2C address of the next operation
+ * @param pClock  [out] the clock speed the slave needs
+ * @return true if a clock packet has to be sent
+ */
+//-----------------------------------------------------------------------------
+static bool
+slave_clock_pending(
+        const Cy3240_t* const pCy3240,
+        uint8_t address,
+        Cy3240_I2C_ClockSpeed_t* const pClock
+        )
+{
+    bool profile = false;
+
+    *pClock = pCy3240->default_clock;
+
+    // Use the slave profile if one is set
+    if ((address < CY3240_SLAVE_COUNT) &&
+        (pCy3240->slave_clock[address] != CY3240_SLAVE_CLOCK_NONE)) {
+        *pClock = (Cy3240_I2C_ClockSpeed_t)pCy3240->slave_clock[address];
+        profile = true;
+    }
+
+    // Slaves without a profile run at whatever the bridge was configured
+    // to, even if that has not been confirmed yet
+    return !((*pClock == pCy3240->clock) &&
+             (pCy3240->clock_valid || !profile));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to switch the bridge clock to the speed required by a slave. The
+ * clock packet is only sent when the speed actually changes.
+ *
+ * @param pCy3240 [in] the bridge state inforamtion
+ * @param address [in] the I2C address of the next operation
+ * @return Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+select_slave_clock(
+        Cy3240_t* const pCy3240,
+        uint8_t address
+        )
+{
+    Cy3240_I2C_ClockSpeed_t clock;
+
+    if (!slave_clock_pending(pCy3240, address, &clock))
+        return CY3240_ERROR_OK;
+
+    return reconfigure_clock(
+            pCy3240,
+            clock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to wait before a write packet is sent again after a NAK. The
+ *  bridge is released while waiting, so other transfers can use the bus
+ *  while the slave is busy.
+ *
+ *  @param pCy3240  [in] the CY3240 state, locked
+ *  @param priority [in] the class of the write
+ *  @param address  [in] the I2C address of the slave
+ *  @param nak      [in] the kind of NAK
+ *  @param attempt  [in] the number of attempts made for the packet
+ *  @returns CY3240_ERROR_OK to send the packet again, CY3240_ERROR_TX
+ *           when the attempts are exhausted
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+retry_wait(
+        Cy3240_t* const pCy3240,
+        Cy3240_Priority_t priority,
+        uint8_t address,
+        Cy3240_Nak_t nak,
+        uint16_t attempt
+        )
+{
+    const Cy3240_Retry_Policy_t* const pPolicy = &pCy3240->retry[nak];
+    uint64_t delay = pPolicy->backoff_us;
+    uint64_t spread;
+    uint16_t x;
+
+    pCy3240->retry_stats.naks[nak]++;
+
+    if (attempt >= pPolicy->attempts) {
+        pCy3240->retry_stats.exhausted++;
+        return CY3240_ERROR_TX;
+    }
+
+    // Exponential backoff, capped
+    for (x = 1; (x < attempt) && (delay < pPolicy->max_backoff_us); x++)
+        delay *= pPolicy->multiplier;
+
+    delay = MIN(delay, pPolicy->max_backoff_us);
+
+    // Replace part of the delay with a random one so slaves NAKing the
+    // same bridge do not retry in lock step
+    spread = (delay * pPolicy->jitter) / 100;
+
+    if (spread != 0)
+        delay = delay - spread + ((uint64_t)rand_r(&pCy3240->retry_seed) % (spread + 1));
+
+    pCy3240->retry_stats.retries++;
+    pCy3240->retry_stats.backoff_us += delay;
+
+    bridge_release(pCy3240);
+    cy3240_util_sleep_until_us(cy3240_util_time_us() + delay);
+    bridge_acquire(
+            pCy3240,
+            priority);
+
+    // Another transfer may have switched the clock
+    return select_slave_clock(
+            pCy3240,
+            address);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack a single packet transfer operation
+ *
+ *  @param pPacket      [out] the packet to send
+ *  @param pOp          [in] the operation
+ *  @param pWriteLength [out] the length of the packet
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+pack_op(
+        uint8_t* const pPacket,
+        const Cy3240_Op_t* const pOp,
+        uint16_t* const pWriteLength
+        )
+{
+    uint16_t length = pOp->length;
+
+    switch (pOp->type) {
+
+        case CY3240_OP_WRITE:
+            *pWriteLength = length;
+
+            return pack_write_input(
+                    pPacket,
+                    pOp->address,
+                    pOp->pData,
+                    pWriteLength,
+                    true,
+                    false);
+
+        case CY3240_OP_READ:
+            *pWriteLength = READ_INPUT_PACKET_SIZE;
+
+            return pack_read_input(
+                    pPacket,
+                    pOp->address,
+                    &length);
+
+        case CY3240_OP_PROBE:
+            // Address only write, the slave just has to acknowledge
+            pPacket[INPUT_PACKET_INDEX_CMD] = CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START | CONTROL_BYTE_STOP;
+            pPacket[INPUT_PACKET_INDEX_LENGTH] = LENGTH_BYTE_LAST_PACKET;
+            pPacket[INPUT_PACKET_INDEX_ADDRESS] = pOp->address;
+
+            *pWriteLength = INPUT_PACKET_INDEX_ADDRESS + 1;
+
+            return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to unpack the response to a single packet transfer operation.
+ *  Unlike unpack_write_output() a NAK is only reported in the result.
+ *
+ *  @param pPacket [in] the received packet
+ *  @param pOp     [in,out] the operation
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+unpack_op(
+        const uint8_t* const pPacket,
+        Cy3240_Op_t* const pOp
+        )
+{
+    uint16_t x;
+
+    if (pPacket[OUTPUT_PACKET_INDEX_STATUS] == 0x00)
+        return CY3240_ERROR_RX;
+
+    switch (pOp->type) {
+
+        case CY3240_OP_WRITE:
+            for (x = 0; x < pOp->length; x++)
+                if (pPacket[OUTPUT_PACKET_INDEX_DATA + x] != TX_ACK)
+                    return CY3240_ERROR_TX;
+
+            return CY3240_ERROR_OK;
+
+        case CY3240_OP_READ:
+            return unpack_read_output(
+                    pPacket,
+                    pOp->pData,
+                    &pOp->length);
+
+        case CY3240_OP_PROBE:
+            if (pPacket[OUTPUT_PACKET_INDEX_DATA] != TX_ACK)
+                return CY3240_ERROR_TX;
+
+            return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Interrupt monitor thread. Every response updates the status byte, so the
+ * monitor only queries the bridge when the handle has been idle for longer
+ * than the poll interval.
+ *
+ * @param arg [in] the bridge state information
+ * @return NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+interrupt_monitor(
+        void* arg
+        )
+{
+    Cy3240_t* const pCy3240 = (Cy3240_t*)arg;
+    const uint64_t interval = (uint64_t)pCy3240->poll_interval * 1000;
+
+    while (pCy3240->monitor) {
+
+        uint64_t wakeup;
+
+        pthread_mutex_lock(&pCy3240->lock);
+
+        if (cy3240_util_time_us() - pCy3240->last_transfer >= interval) {
+
+            uint16_t writeLength = 0;
+            uint16_t readLength = STATUS_QUERY_LENGTH + CY3240_STATUS_CODE_SIZE;
+
+            if CY3240_SUCCESS(pack_status_query(pCy3240->send, &writeLength))
+                transcieve(
+                        pCy3240,
+                        pCy3240->send,
+                        &writeLength,
+                        pCy3240->recv,
+                        &readLength);
+        }
+
+        wakeup = pCy3240->last_transfer + interval;
+
+        pthread_mutex_unlock(&pCy3240->lock);
+
+        cy3240_util_sleep_until_us(MAX(wakeup, cy3240_util_time_us() + 1000));
+    }
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check the bridge answers with a status query round trip
+ *
+ *  @param pCy3240 [in] the CY3240 state, locked
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+check_bridge(
+        Cy3240_t* const pCy3240
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t writeLength = 0;
+    uint16_t readLength = STATUS_QUERY_LENGTH + CY3240_STATUS_CODE_SIZE;
+
+    result = pack_status_query(
+            pCy3240->send,
+            &writeLength);
+
+    if CY3240_SUCCESS(result)
+        result = transcieve(
+                pCy3240,
+                pCy3240->send,
+                &writeLength,
+                pCy3240->recv,
+                &readLength);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run one recovery tier
+ *
+ *  @param pCy3240 [in] the CY3240 state, locked
+ *  @param tier    [in] the tier
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+recover_tier(
+        Cy3240_t* const pCy3240,
+        Cy3240_Tier_t tier
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    hid_return error = HID_RET_SUCCESS;
+    uint16_t writeLength = 0;
+    uint16_t readLength = 0;
+
+    // A closed handle does not get its interface back
+    if (pCy3240->closing)
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    // Only a rebuild gets the handle a new interface
+    if ((pCy3240->pHid == NULL) &&
+        (tier != CY3240_TIER_REBUILD))
+        return CY3240_ERROR_HID;
+
+    switch (tier) {
+
+        case CY3240_TIER_RETRY:
+            // Responses still on their way would be taken for the next
+            // ones, read until the bridge goes quiet
+            pCy3240->stale = CY3240_INFLIGHT_MAX;
+            pCy3240->stale_us += inflight_bus_us(pCy3240);
+            pCy3240->inflight_tail = pCy3240->inflight_head;
+            drop_stale(pCy3240);
+            break;
+
+        case CY3240_TIER_REINIT:
+            result = pack_reinit(
+                    pCy3240->send,
+                    &writeLength);
+
+            if CY3240_SUCCESS(result) {
+
+                readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+
+                result = transcieve(
+                        pCy3240,
+                        pCy3240->send,
+                        &writeLength,
+                        pCy3240->recv,
+                        &readLength);
+            }
+            break;
+
+        case CY3240_TIER_RECLAIM:
+            // Keep the interface and the libhid state, only claim it again
+            pCy3240->w.close(pCy3240->pHid);
+
+            error = pCy3240->w.force_open(
+                    pCy3240->pHid,
+                    pCy3240->iface_number,
+                    &pCy3240->matcher,
+                    CY3240_OPEN_RETRIES);
+            break;
+
+        case CY3240_TIER_REBUILD:
+            // Only this handle starts over, libhid stays up for the others
+            if (pCy3240->pHid != NULL) {
+                pCy3240->w.close(pCy3240->pHid);
+                pCy3240->w.delete_if(&pCy3240->pHid);
+            }
+
+            // Without an interface the handle is unusable until the next
+            // rebuild succeeds
+            pCy3240->pHid = pCy3240->w.new_if();
+
+            if (pCy3240->pHid == NULL)
+                error = HID_RET_FAIL_ALLOC;
+
+            if HID_SUCCESS(error)
+                error = pCy3240->w.force_open(
+                        pCy3240->pHid,
+                        pCy3240->iface_number,
+                        &pCy3240->matcher,
+                        CY3240_OPEN_RETRIES);
+            break;
+
+        default:
+            return CY3240_ERROR_INVALID_PARAMETERS;
+    }
+
+    if HID_FAILURE(error) {
+        fprintf(stderr, "Recovery tier %d failed with return code %d\n", tier, error);
+        result = CY3240_ERROR_HID;
+    }
+
+    if (tier != CY3240_TIER_RETRY) {
+
+        // Nothing sent before can still be answered
+        pCy3240->inflight_tail = pCy3240->inflight_head;
+        pCy3240->stale = 0;
+        pCy3240->stale_us = 0;
+
+        // The bridge settings are back to their defaults
+        invalidate_config(pCy3240);
+    }
+
+    if CY3240_SUCCESS(result)
+        result = check_bridge(pCy3240);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run one recovery tier and record its timing
+ *
+ *  @param pCy3240 [in] the CY3240 state, locked
+ *  @param tier    [in] the tier
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+run_tier(
+        Cy3240_t* const pCy3240,
+        Cy3240_Tier_t tier
+        )
+{
+    Cy3240_Tier_Stats_t* const pStats = &pCy3240->recovery[tier];
+    uint64_t start = cy3240_util_time_us();
+    Cy3240_Error_t result;
+
+    result = recover_tier(
+            pCy3240,
+            tier);
+
+    pStats->attempts++;
+    pStats->last_us = cy3240_util_time_us() - start;
+    pStats->max_us = MAX(pStats->max_us, pStats->last_us);
+    pStats->total_us += pStats->last_us;
+
+    if CY3240_SUCCESS(result)
+        pStats->successes++;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to point the matcher at the location, or else the serial number,
+ *  of the bridge to open
+ *
+ *  @param pCy3240 [in] the CY3240 state, locked
+ */
+//-----------------------------------------------------------------------------
+static void
+select_matcher(
+        Cy3240_t* const pCy3240
+        )
+{
+    // Match the terminator too, so a prefix does not match
+    if (pCy3240->location[0] != '\0') {
+        pCy3240->matcher.matcher_fn = (matcher_fn_t)cy3240_util_match_location;
+        pCy3240->matcher.custom_data = pCy3240->location;
+        pCy3240->matcher.custom_data_length = strlen(pCy3240->location) + 1;
+
+    } else if (pCy3240->serial[0] != '\0') {
+        pCy3240->matcher.matcher_fn = (matcher_fn_t)cy3240_util_match_serial_number;
+        pCy3240->matcher.custom_data = pCy3240->serial;
+        pCy3240->matcher.custom_data_length = strlen(pCy3240->serial) + 1;
+
+    } else {
+        pCy3240->matcher.matcher_fn = NULL;
+        pCy3240->matcher.custom_data = NULL;
+        pCy3240->matcher.custom_data_length = 0;
+    }
+}
+
+//@} End of Private Methods
+
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_restart(
+        int handle
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    // Check the parameters
+    if (pCy3240 != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        uint16_t writeLength = 0;
+        uint16_t readLength = 0;
+        uint64_t start;
+
+        // Bridge commands wait for their turn as writes and reads do
+        const Cy3240_Priority_t priority = bridge_lock(
+                pCy3240,
+                &start);
+
+        // TODO: Check the state machine
+        // Construct the message
+        if CY3240_SUCCESS(result) {
+
+            result = pack_restart(
+                    pCy3240->send,
+                    &writeLength);
+
+            if CY3240_FAILURE(result)
+                printf("Failed to pack restart data in write input packet: %i\n", result);
+        }
+
+        // Send the message
+        if (CY3240_SUCCESS(result)) {
+
+            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+
+            // Write the data to the buffer
+            // Note! The received data is ignored
+            result = transcieve(
+                    pCy3240,
+                    pCy3240->send,
+                    &writeLength,
+                    pCy3240->recv,
+                    &readLength);
+
+            if CY3240_FAILURE(result)
+                printf("Failed to transmit restart packet\n");
+        }
+
+        // Decode the response
+        if (CY3240_SUCCESS(result)) {
+
+            result = unpack_write_output(
+                    pCy3240->recv,
+                    &writeLength,
+                    &readLength,
+                    NULL);
+
+            if CY3240_FAILURE(result)
+                printf("Slave failed to Ack restart\n");
+        }
+
+        bridge_unlock(
+                pCy3240,
+                priority,
+                start);
+        cy3240_handle_put(handle);
+
+        return result;
+
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_reinit(
+        int handle
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    // Check the parameters
+    if (pCy3240 != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        uint16_t writeLength = 0;
+        uint16_t readLength = 0;
+        uint64_t start;
+
+        // Bridge commands wait for their turn as writes and reads do
+        const Cy3240_Priority_t priority = bridge_lock(
+                pCy3240,
+                &start);
+
+        // Construct the packet
+        if CY3240_SUCCESS(result) {
+
+            result = pack_reinit(
+                    pCy3240->send,
+                    &writeLength);
+
+            if CY3240_FAILURE(result)
+                printf("Failed to pack reinit data in write input packet: %i\n", result);
+        }
+
+        // Write the packet
+        if (CY3240_SUCCESS(result)) {
+
+            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+
+            // Write the data to the buffer
+            // Note! The received data is ignored
+            result = transcieve(
+                    pCy3240,
+                    pCy3240->send,
+                    &writeLength,
+                    pCy3240->recv,
+                    &readLength);
+
+            if CY3240_FAILURE(result)
+                printf("Failed to transmit reinit packet\n");
+        }
+
+        // The bridge settings are back to their defaults
+        invalidate_config(pCy3240);
+
+        bridge_unlock(
+                pCy3240,
+                priority,
+                start);
+        cy3240_handle_put(handle);
+
+        return result;
+
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_reconfigure(
+        int handle,
+        Cy3240_Power_t power,
+        Cy3240_Bus_t bus,
+        Cy3240_I2C_ClockSpeed_t clock
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* const pCy3240 = cy3240_handle_get(handle);
+
+    // Check the parameters
+    if (pCy3240 != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint64_t start;
+
+        // Bridge commands wait for their turn as writes and reads do
+        const Cy3240_Priority_t priority = bridge_lock(
+                pCy3240,
+                &start);
+
+        // Change the power and clock modes
+        result = reconfigure_combined(
+                pCy3240,
+                power,
+                clock);
+
+        if CY3240_SUCCESS(result)
+            pCy3240->default_clock = clock;
+
+        // TODO: Changing bus not supported
+        if CY3240_SUCCESS(result) {
+
+            pCy3240->bus = bus;
+        }
+
+        bridge_unlock(
+                pCy3240,
+                priority,
+                start);
+        cy3240_handle_put(handle);
+
+        return result;
+
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_invalidate(
+        int handle
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if (pCy3240 != NULL) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+        invalidate_config(pCy3240);
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_slave_clock(
+        int handle,
+        uint8_t address,
+        Cy3240_I2C_ClockSpeed_t clock
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (address < CY3240_SLAVE_COUNT) &&
+        (clock != CY3240_CLOCK__Reserved)) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+        pCy3240->slave_clock[address] = clock;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_clear_slave_clock(
+        int handle,
+        uint8_t address
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (address < CY3240_SLAVE_COUNT)) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+        pCy3240->slave_clock[address] = CY3240_SLAVE_CLOCK_NONE;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_slave_clock(
+        int handle,
+        uint8_t address,
+        Cy3240_I2C_ClockSpeed_t* const pClock
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (address < CY3240_SLAVE_COUNT) &&
+        (pClock != NULL)) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+
+        if (pCy3240->slave_clock[address] != CY3240_SLAVE_CLOCK_NONE)
+            *pClock = (Cy3240_I2C_ClockSpeed_t)pCy3240->slave_clock[address];
+        else
+            *pClock = pCy3240->default_clock;
+
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_priority(
+        Cy3240_Priority_t priority
+        )
+{
+    if (priority < CY3240_PRIORITY_COUNT) {
+
+        thread_priority = priority;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Priority_t
+cy3240_get_priority(
+        void
+        )
+{
+    return thread_priority;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_write(
+        int handle,
+        uint8_t address,
+        const uint8_t* const pData,
+        uint16_t* const pLength
+        )
+{
+
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (pData != NULL) &&
+        (pLength != NULL) &&
+        (*pLength != 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        uint16_t writeLength;
+        uint16_t readLength;
+        uint16_t chunkLength;
+        const uint8_t* pWriteStart = pData;
+        uint16_t bytesLeft = *pLength;
+        uint16_t attempt = 0;
+        uint64_t start;
+
+        bool first = true;
+
+        // Only the last packet stops the bus, so a write is not preempted
+        const Cy3240_Priority_t priority = bridge_lock(
+                pCy3240,
+                &start);
+
+        // Switch to the clock speed of the slave
+        result = select_slave_clock(
+                pCy3240,
+                address);
+
+        if CY3240_FAILURE(result)
+            printf("Failed to select the slave clock\n");
+
+        while (CY3240_SUCCESS(result) && (bytesLeft > 0)) {
+
+            // Are there going to be more segments
+            bool more;
+
+            // Check if there will be more segments
+            if (bytesLeft > CY3240_MAX_WRITE_BYTES)
+                 more = true;
+            else
+                 more = false;
+
+            // Set the write and read length to transfer one packet at a time
+            chunkLength = MIN(bytesLeft, CY3240_MAX_WRITE_BYTES);
+            writeLength = chunkLength;
+            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+
+            if CY3240_SUCCESS(result) {
+
+                // Pack the data in to the send packet
+                result = pack_write_input(
+                        pCy3240->send,
+                        address,
+                        pWriteStart,
+                        &writeLength,
+                        first,
+                        more);
+
+                if CY3240_FAILURE(result)
+                    printf("Failed to pack send data in write input packet: %i\n", result);
+            }
+
+            if (CY3240_SUCCESS(result)) {
+
+                // Write the data to the buffer
+                result = transcieve(
+                        pCy3240,
+                        pCy3240->send,
+                        &writeLength,
+                        pCy3240->recv,
+                        &readLength);
+
+                if CY3240_FAILURE(result)
+                    printf("Failed to transmit write packet\n");
+            }
+
+            if (CY3240_SUCCESS(result)) {
+
+                // Decode the response
+                result = unpack_write_output(
+                        pCy3240->recv,
+                        &writeLength,
+                        &readLength,
+                        &bytesLeft);
+
+                attempt++;
+
+                if (result == CY3240_ERROR_TX) {
+
+                    // Nothing acknowledged in the first packet means the
+                    // slave did not answer to its address
+                    Cy3240_Nak_t nak = (bytesLeft == *pLength) ?
+                            CY3240_NAK_ADDRESS : CY3240_NAK_DATA;
+
+                    result = retry_wait(
+                            pCy3240,
+                            priority,
+                            address,
+                            nak,
+                            attempt);
+
+                    if CY3240_SUCCESS(result) {
+
+                        // The slave dropped the transaction, which starts
+                        // with its register address, so send it all again
+                        pCy3240->retry_stats.resent_bytes += (pWriteStart - pData) + chunkLength;
+                        pWriteStart = pData;
+                        bytesLeft = *pLength;
+                        first = true;
+                        continue;
+                    }
+
+                    printf("Failed to transmit all data\n");
+
+                } else if CY3240_SUCCESS(result) {
+
+                    // Move on to the next packet
+                    pWriteStart += chunkLength;
+                    attempt = 0;
+                }
+            }
+
+            // No longer the first time
+            first = false;
+        }
+
+        count_op(
+                pCy3240,
+                CY3240_OP_WRITE,
+                *pLength,
+                result);
+
+        bridge_unlock(
+                pCy3240,
+                priority,
+                start);
+        cy3240_handle_put(handle);
+
+        return result;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_read(
+        int handle,
+        uint8_t address,
+        uint8_t* const pData,
+        uint16_t* const pLength
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (pData != NULL) &&
+        (pLength != NULL) &&
+        (*pLength != 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        uint16_t readLength;
+        uint8_t* pReadStart = pData;
+        const uint16_t writeLength = READ_INPUT_PACKET_SIZE;
+        uint16_t bytesLeft = *pLength;
+        uint64_t start;
+
+        const Cy3240_Priority_t priority = bridge_lock(
+                pCy3240,
+                &start);
+
+        // Switch to the clock speed of the slave
+        result = select_slave_clock(
+                pCy3240,
+                address);
+
+        if CY3240_FAILURE(result)
+            printf("Failed to select the slave clock\n");
+
+        // Loop while there is still data to read
+        while (CY3240_SUCCESS(result) &&
+               (bytesLeft > 0)) {
+
+            // Calculate the number of packets to read
+            readLength = MIN(bytesLeft, CY3240_MAX_READ_BYTES);
+
+            // Create the read input packet
+            if (CY3240_SUCCESS(result)) {
+
+                result = pack_read_input(
+                        pCy3240->send,
+                        address,
+                        &readLength);
+
+                if CY3240_FAILURE(result)
+                    printf("Failed to pack read input packet: %i\n", result);
+            }
+
+            // Send the data
+            if (CY3240_SUCCESS(result)) {
+
+                // Write the data to the buffer
+                result = transcieve(
+                        pCy3240,
+                        pCy3240->send,
+                        &writeLength,
+                        pCy3240->recv,
+                        &readLength);
+
+                if CY3240_FAILURE(result)
+                    printf("Failed to transmit read packet\n");
+            }
+
+            // unpack the result
+            if (CY3240_SUCCESS(result)) {
+
+                // Decode the response
+                result = unpack_read_output(
+                        pCy3240->recv,
+                        pReadStart,
+                        &readLength);
+
+                count_nak(
+                        pCy3240,
+                        pCy3240->recv,
+                        CY3240_OP_READ,
+                        readLength);
+
+                if CY3240_FAILURE(result) {
+                    printf("Failed to read data\n");
+
+                } else {
+                    pReadStart += readLength;
+                    bytesLeft -= readLength;
+                }
+            }
 
-        return CY3240_ERROR_OK;
+            // Every read packet ends with a stop, so a higher class can
+            // go in between. It may have switched the clock.
+            if (CY3240_SUCCESS(result) &&
+                (bytesLeft > 0) &&
+                bridge_yield(pCy3240, priority))
+                result = select_slave_clock(
+                        pCy3240,
+                        address);
+        }
+
+        count_op(
+                pCy3240,
+                CY3240_OP_READ,
+                *pLength,
+                result);
+
+        bridge_unlock(
+                pCy3240,
+                priority,
+                start);
+        cy3240_handle_put(handle);
+
+        return result;
     }
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function pack_read_packet  ----- */
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to unpack the read output packet data
+ *  Method to check that an operation fits in one packet
  *
- *  @param pData   [out] the buffer to read the data into
- *  @param pLength [in] the amount of data to read
- *  @returns Cy3240_Error_t
+ *  @param pOp [in] the operation
+ *  @returns true if the operation can be packed
  */
 //-----------------------------------------------------------------------------
-static Cy3240_Error_t
-unpack_read_output (
-        uint8_t* const pData,
-        const uint16_t* const pLength
+static bool
+op_valid(
+        const Cy3240_Op_t* const pOp
         )
 {
-    // Check the parameters
-    if ((pData != NULL) &&
-        (pLength != NULL) &&
-        (*pLength != 0) &&
-        (RECV_PACKET[OUTPUT_PACKET_INDEX_STATUS] != 0x00)) {
+    switch (pOp->type) {
 
-        // Copy the data from the receive buffer
-        memcpy(pData, &RECV_PACKET[OUTPUT_PACKET_INDEX_DATA], *pLength);
+        case CY3240_OP_PROBE:
+            return true;
 
-        return CY3240_ERROR_OK;
+        case CY3240_OP_WRITE:
+            return (pOp->pData != NULL) &&
+                   (pOp->length != 0) &&
+                   (pOp->length <= CY3240_MAX_WRITE_BYTES);
+
+        case CY3240_OP_READ:
+            return (pOp->pData != NULL) &&
+                   (pOp->length != 0) &&
+                   (pOp->length <= CY3240_MAX_READ_BYTES);
     }
 
-    return CY3240_ERROR_INVALID_PARAMETERS;
-}   /* -----  end of static function unpack_read_output  ----- */
+    return false;
+}
 
 //-----------------------------------------------------------------------------
 /**
- * Method to reconfigure the power mode for the CY3240 bridge chip
+ *  Method to run a list of single packet operations through the pipeline
  *
- * @param pCy3240 [in] the bridge state inforamtion
- * @param power   [in] the power mode to set
- * @return Cy3240_Error_t
+ *  @param pCy3240  [in] the bridge
+ *  @param pOps     [in,out] the operations
+ *  @param pReports [in] reports packed by cy3240_pack(), NULL to pack here
+ *  @param count    [in] the number of operations
+ *  @returns the first HID error, the per operation result is in each op
  */
 //-----------------------------------------------------------------------------
 static Cy3240_Error_t
-reconfigure_power(
+transfer_ops(
         Cy3240_t* const pCy3240,
-        Cy3240_Power_t power
+        Cy3240_Op_t* const pOps,
+        const uint8_t* const pReports,
+        uint16_t count
         )
 {
-    Cy3240_Error_t result = CY3240_ERROR_OK;
-    uint16_t writeLength = 0;
-    uint16_t readLength = 0;
+    if ((pCy3240 != NULL) &&
+        (pOps != NULL) &&
+        (count != 0)) {
 
-    result = pack_reconfigure_power(
-            power,
-            &writeLength);
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Priority_t priority;
+        uint16_t sent = 0;
+        uint16_t done = 0;
+        uint64_t start;
+        uint16_t x;
+
+        // Every operation has to fit in one packet
+        for (x = 0; x < count; x++)
+            if (!op_valid(&pOps[x]))
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+        priority = bridge_lock(
+                pCy3240,
+                &start);
 
-    if CY3240_FAILURE(result)
-        printf("Failed to pack send data in write input packet: %i\n", result);
+        while (CY3240_SUCCESS(result) && (done < count)) {
 
-    if (CY3240_SUCCESS(result)) {
+            // Fill the pipeline
+            while (CY3240_SUCCESS(result) &&
+                   (sent < count) &&
+                   ((sent - done) < pCy3240->pipeline_depth)) {
 
-        readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+                Cy3240_I2C_ClockSpeed_t clock;
+                uint16_t writeLength = 0;
 
-        // Write the data to the buffer
-        // Note! The received data is ignored
-        result = transcieve(
+                // Every operation ends with a stop, a higher class can go
+                // in between once the bridge is idle
+                if ((sent != 0) && higher_waiting(pCy3240, priority)) {
+
+                    if (sent != done)
+                        break;
+
+                    bridge_yield(
+                            pCy3240,
+                            priority);
+                }
+
+                // The clock can only change once the bridge is idle
+                if (slave_clock_pending(pCy3240, pOps[sent].address, &clock)) {
+
+                    if (sent != done)
+                        break;
+
+                    result = reconfigure_clock(
+                            pCy3240,
+                            clock);
+
+                    if CY3240_FAILURE(result)
+                        printf("Failed to select the slave clock\n");
+                }
+
+                // Prepacked reports go out as they are
+                if (CY3240_SUCCESS(result) && (pReports != NULL)) {
+
+                    writeLength = SEND_PACKET_LEN;
+
+                    result = transmit(
+                            pCy3240,
+                            &pReports[sent * SEND_PACKET_LEN],
+                            &writeLength);
+
+                } else if CY3240_SUCCESS(result) {
+
+                    result = pack_op(
+                            pCy3240->send,
+                            &pOps[sent],
+                            &writeLength);
+
+                    if CY3240_SUCCESS(result)
+                        result = transmit(
+                                pCy3240,
+                                pCy3240->send,
+                                &writeLength);
+                }
+
+                if CY3240_SUCCESS(result)
+                    sent++;
+            }
+
+            // Collect the oldest response
+            if (CY3240_SUCCESS(result) && (done < sent)) {
+
+                uint16_t readLength = CY3240_STATUS_CODE_SIZE + MAX(pOps[done].length, 1);
+
+                result = receive(
+                        pCy3240,
+                        pCy3240->recv,
+                        &readLength);
+
+                if CY3240_SUCCESS(result) {
+
+                    pOps[done].result = unpack_op(
+                            pCy3240->recv,
+                            &pOps[done]);
+
+                    count_nak(
+                            pCy3240,
+                            pCy3240->recv,
+                            pOps[done].type,
+                            pOps[done].length);
+                    pOps[done].complete_us = pCy3240->last_transfer;
+
+                    done++;
+                }
+            }
+        }
+
+        // Operations that never completed carry the transport error
+        for (x = done; x < count; x++)
+            pOps[x].result = result;
+
+        for (x = 0; x < count; x++)
+            count_op(
+                    pCy3240,
+                    pOps[x].type,
+                    pOps[x].length,
+                    pOps[x].result);
+
+        bridge_unlock(
                 pCy3240,
-                SEND_PACKET,
-                &writeLength,
-                RECV_PACKET,
-                &readLength);
+                priority,
+                start);
 
-        if CY3240_FAILURE(result)
-            printf("Failed to transmit write packet\n");
+        return result;
     }
 
-    // Set the power mode
-    if CY3240_SUCCESS(result)
-        pCy3240->power = power;
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_transfer(
+        int handle,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+    Cy3240_Error_t result;
+
+    result = transfer_ops(
+            pCy3240,
+            pOps,
+            NULL,
+            count);
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
     return result;
 }
 
 //-----------------------------------------------------------------------------
-/**
- * Method to set the clock rate for the CY3240 bridge chip
- *
- * @param pCy3240 [in] the bridge state inforamtion
- * @param clock   [in] the clock rate to set
- * @return Cy3240_Error_t
- */
-//-----------------------------------------------------------------------------
-static Cy3240_Error_t
-reconfigure_clock(
-        Cy3240_t* const pCy3240,
-        Cy3240_I2C_ClockSpeed_t clock
+Cy3240_Error_t
+cy3240_pack(
+        const Cy3240_Op_t* const pOp,
+        uint8_t* const pReport
         )
 {
-    Cy3240_Error_t result = CY3240_ERROR_OK;
-    uint16_t writeLength = 0;
-    uint16_t readLength = 0;
+    if ((pOp != NULL) &&
+        (pReport != NULL)) {
 
-    result = pack_reconfigure_clock(
-            clock,
-            &writeLength);
+        uint16_t writeLength = 0;
 
-    if CY3240_FAILURE(result)
-        printf("Failed to pack send data in write input packet: %i\n", result);
+        if (!op_valid(pOp))
+            return CY3240_ERROR_INVALID_PARAMETERS;
 
-    if (CY3240_SUCCESS(result)) {
+        memset(pReport, 0x00, SEND_PACKET_LEN);
 
-        readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+        return pack_op(
+                pReport,
+                pOp,
+                &writeLength);
+    }
 
-        // Write the data to the buffer
-        // Note! The received data is ignored
-        result = transcieve(
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_transfer_packed(
+        int handle,
+        Cy3240_Op_t* const pOps,
+        const uint8_t* const pReports,
+        uint16_t count
+        )
+{
+    if (pReports != NULL) {
+
+        // Look up the state structure of the handle
+        Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+        Cy3240_Error_t result;
+
+        result = transfer_ops(
                 pCy3240,
-                SEND_PACKET,
-                &writeLength,
-                RECV_PACKET,
-                &readLength);
+                pOps,
+                pReports,
+                count);
 
-        if CY3240_FAILURE(result)
-            printf("Failed to transmit packet\n");
-    }
+        if (pCy3240 != NULL)
+            cy3240_handle_put(handle);
 
-    // Set the clock rate
-    if CY3240_SUCCESS(result)
-        pCy3240->clock = clock;
+        return result;
+    }
 
-    return result;
+    return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
-//@} End of Private Methods
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_pipeline_depth(
+        int handle,
+        int depth
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
+    if ((pCy3240 != NULL) &&
+        (depth >= 1) &&
+        (depth <= CY3240_PIPELINE_DEPTH_MAX)) {
 
-//////////////////////////////////////////////////////////////////////
-/// @name Methods
-//@{
+        pthread_mutex_lock(&pCy3240->lock);
+        pCy3240->pipeline_depth = depth;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
 //-----------------------------------------------------------------------------
 Cy3240_Error_t
-cy3240_restart(
-        int handle
+cy3240_set_adaptive_timeout(
+        int handle,
+        int enable
         )
 {
-    // The handle is the pointer to the state structure
-    const Cy3240_t* pCy3240 = (const Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-    // Check the parameters
     if (pCy3240 != NULL) {
 
-        Cy3240_Error_t result = CY3240_ERROR_OK;
+        pthread_mutex_lock(&pCy3240->lock);
+        pCy3240->adaptive = enable ? true : false;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-        uint16_t writeLength = 0;
-        uint16_t readLength = 0;
+        return CY3240_ERROR_OK;
+    }
 
-        pthread_mutex_lock(&mutex);
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-        // TODO: Check the state machine
-        // Construct the message
-        if CY3240_SUCCESS(result) {
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_latency(
+        int handle,
+        Cy3240_Latency_t* const pLatency
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-            result = pack_restart(
-                    &writeLength);
+    if ((pCy3240 != NULL) &&
+        (pLatency != NULL)) {
 
-            if CY3240_FAILURE(result)
-                printf("Failed to pack restart data in write input packet: %i\n", result);
-        }
+        pthread_mutex_lock(&pCy3240->lock);
 
-        // Send the message
-        if (CY3240_SUCCESS(result)) {
+        pLatency->samples = pCy3240->latency_samples;
+        pLatency->timeouts = pCy3240->timeouts;
+        pLatency->latency_us = pCy3240->latency_us;
+        pLatency->deviation_us = pCy3240->deviation_us;
+        pLatency->last_timeout = pCy3240->last_timeout;
 
-            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-            // Write the data to the buffer
-            // Note! The received data is ignored
-            result = transcieve(
-                    pCy3240,
-                    SEND_PACKET,
-                    &writeLength,
-                    RECV_PACKET,
-                    &readLength);
+        return CY3240_ERROR_OK;
+    }
 
-            if CY3240_FAILURE(result)
-                printf("Failed to transmit restart packet\n");
-        }
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
-        // Decode the response
-        if (CY3240_SUCCESS(result)) {
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-            result = unpack_write_output(
-                    &writeLength,
-                    &readLength,
-                    NULL);
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_retry_policy(
+        int handle,
+        Cy3240_Nak_t nak,
+        const Cy3240_Retry_Policy_t* const pPolicy
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-            if CY3240_FAILURE(result)
-                printf("Slave failed to Ack restart\n");
+    if ((pCy3240 != NULL) &&
+        (nak < CY3240_NAK_COUNT) &&
+        (pPolicy != NULL) &&
+        (pPolicy->attempts != 0) &&
+        (pPolicy->multiplier != 0) &&
+        (pPolicy->jitter <= 100) &&
+        (pPolicy->backoff_us <= pPolicy->max_backoff_us)) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+        pCy3240->retry[nak] = *pPolicy;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_retry_stats(
+        int handle,
+        Cy3240_Retry_Stats_t* const pStats
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (pStats != NULL)) {
+
+        pthread_mutex_lock(&pCy3240->lock);
+        *pStats = pCy3240->retry_stats;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        return CY3240_ERROR_OK;
+    }
+
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_recover(
+        int handle,
+        Cy3240_Tier_t max_tier,
+        Cy3240_Tier_t* const pTier
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
+
+    if ((pCy3240 != NULL) &&
+        (max_tier < CY3240_TIER_COUNT)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_HID;
+        int tier;
+
+        pthread_mutex_lock(&pCy3240->lock);
+
+        // Escalate until the bridge answers again
+        for (tier = CY3240_TIER_RETRY; (tier <= max_tier) && CY3240_FAILURE(result); tier++) {
+
+            result = run_tier(
+                    pCy3240,
+                    (Cy3240_Tier_t)tier);
+
+            if (CY3240_SUCCESS(result) && (pTier != NULL))
+                *pTier = (Cy3240_Tier_t)tier;
         }
 
-        pthread_mutex_unlock(&mutex);
+        pthread_mutex_unlock(&pCy3240->lock);
 
-        return result;
+        if CY3240_FAILURE(result)
+            fprintf(stderr, "Failed to recover the bridge: %d\n", result);
+
+        cy3240_handle_put(handle);
 
+        return result;
     }
 
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
     return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
 //-----------------------------------------------------------------------------
 Cy3240_Error_t
-cy3240_reinit(
+cy3240_reattach(
         int handle
         )
 {
-    // The handle is the pointer to the state structure
-    const Cy3240_t* pCy3240 = (const Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-    // Check the parameters
     if (pCy3240 != NULL) {
 
         Cy3240_Error_t result = CY3240_ERROR_OK;
 
-        uint16_t writeLength = 0;
-        uint16_t readLength = 0;
-
-        pthread_mutex_lock(&mutex);
-
-        // Construct the packet
-        if CY3240_SUCCESS(result) {
-
-            result = pack_reinit(
-                    &writeLength);
+        pthread_mutex_lock(&pCy3240->lock);
 
-            if CY3240_FAILURE(result)
-                printf("Failed to pack reinit data in write input packet: %i\n", result);
-        }
+        // The old interface belongs to a device that is gone
+        result = run_tier(
+                pCy3240,
+                CY3240_TIER_REBUILD);
 
-        // Write the packet
-        if (CY3240_SUCCESS(result)) {
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+        return result;
+    }
 
-            // Write the data to the buffer
-            // Note! The received data is ignored
-            result = transcieve(
-                    pCy3240,
-                    SEND_PACKET,
-                    &writeLength,
-                    RECV_PACKET,
-                    &readLength);
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-            if CY3240_FAILURE(result)
-                printf("Failed to transmit reinit packet\n");
-        }
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_recovery_stats(
+        int handle,
+        Cy3240_Tier_t tier,
+        Cy3240_Tier_Stats_t* const pStats
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-        pthread_mutex_lock(&mutex);
+    if ((pCy3240 != NULL) &&
+        (tier < CY3240_TIER_COUNT) &&
+        (pStats != NULL)) {
 
-        return result;
+        pthread_mutex_lock(&pCy3240->lock);
+        *pStats = pCy3240->recovery[tier];
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
+        return CY3240_ERROR_OK;
     }
 
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
     return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
 //-----------------------------------------------------------------------------
 Cy3240_Error_t
-cy3240_reconfigure(
+cy3240_get_stats(
         int handle,
-        Cy3240_Power_t power,
-        Cy3240_Bus_t bus,
-        Cy3240_I2C_ClockSpeed_t clock
+        Cy3240_Stats_t* const pStats
         )
 {
-    // The handle is the pointer to the state structure
-    Cy3240_t* const pCy3240 = (Cy3240_t* const)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-    // Check the parameters
-    if (pCy3240 != NULL) {
+    if ((pCy3240 != NULL) &&
+        (pStats != NULL)) {
 
-        Cy3240_Error_t result = CY3240_ERROR_OK;
+        pthread_mutex_lock(&pCy3240->lock);
 
-        pthread_mutex_lock(&mutex);
+        pStats->traffic = pCy3240->traffic;
+        pStats->latency.samples = pCy3240->latency_samples;
+        pStats->latency.timeouts = pCy3240->timeouts;
+        pStats->latency.latency_us = pCy3240->latency_us;
+        pStats->latency.deviation_us = pCy3240->deviation_us;
+        pStats->latency.last_timeout = pCy3240->last_timeout;
+        pStats->retry = pCy3240->retry_stats;
+        memcpy(pStats->recovery, pCy3240->recovery, sizeof(pStats->recovery));
+        memcpy(pStats->classes, pCy3240->classes, sizeof(pStats->classes));
 
-        // Change the power mode
-        if CY3240_SUCCESS(result) {
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-            result = reconfigure_power(
-                    pCy3240,
-                    power);
+        return CY3240_ERROR_OK;
+    }
 
-            if CY3240_FAILURE(result)
-                printf("Failed to set the requested power mode: %02x\n", power);
-        }
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
-        // Set the clock mode
-        if CY3240_SUCCESS(result) {
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-             result = reconfigure_clock(
-                     pCy3240,
-                     clock);
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_stats_percentile(
+        const Cy3240_Stats_t* const pStats,
+        unsigned int percent
+        )
+{
+    if (pStats == NULL)
+        return 0;
 
-             if CY3240_FAILURE(result)
-                 printf("Failed to set the requested clock mode: %02x\n", clock);
+    return histogram_percentile(
+            pStats->traffic.histogram,
+            percent);
+}
 
-        }
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_class_percentile(
+        const Cy3240_Stats_t* const pStats,
+        Cy3240_Priority_t priority,
+        unsigned int percent
+        )
+{
+    if ((pStats == NULL) ||
+        (priority >= CY3240_PRIORITY_COUNT))
+        return 0;
 
-        // TODO: Changing bus not supported
-        if CY3240_SUCCESS(result) {
+    return histogram_percentile(
+            pStats->classes[priority].histogram,
+            percent);
+}
 
-            pCy3240->bus = bus;
-        }
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_status(
+        int handle,
+        uint8_t* const pStatus
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-        pthread_mutex_unlock(&mutex);
+    if ((pCy3240 != NULL) &&
+        (pStatus != NULL)) {
 
-        return result;
+        pthread_mutex_lock(&pCy3240->lock);
+        *pStatus = pCy3240->status;
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
+        return CY3240_ERROR_OK;
     }
 
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
     return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
-
 //-----------------------------------------------------------------------------
 Cy3240_Error_t
-cy3240_write(
+cy3240_interrupt_subscribe(
         int handle,
-        uint8_t address,
-        const uint8_t* const pData,
-        uint16_t* const pLength
+        int poll_interval
         )
 {
-
-    // The handle is the pointer to the state structure
-    Cy3240_t* pCy3240 = (Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
     if ((pCy3240 != NULL) &&
-        (pData != NULL) &&
-        (pLength != NULL) &&
-        (*pLength != 0)) {
-
-        Cy3240_Error_t result = CY3240_ERROR_OK;
+        (poll_interval > 0) &&
+        (!pCy3240->monitor) &&
+        (!pCy3240->closing)) {
+
+        pCy3240->poll_interval = poll_interval;
+        pCy3240->monitor = true;
+
+        if (pthread_create(&pCy3240->monitor_thread, NULL, interrupt_monitor, pCy3240) != 0) {
+            fprintf(stderr, "Failed to start the interrupt monitor\n");
+            pCy3240->monitor = false;
+            cy3240_handle_put(handle);
+            return CY3240_ERROR_UNKNOWN;
+        }
 
-        // TODO: Move the WriteStart point after each write
-        uint16_t writeLength;
-        uint16_t readLength;
-        uint8_t* pWriteStart = pData;
-        uint16_t bytesLeft = *pLength;
+        cy3240_handle_put(handle);
 
-        bool first = true;
+        return CY3240_ERROR_OK;
+    }
 
-        pthread_mutex_lock(&mutex);
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
-        while (CY3240_SUCCESS(result) && (bytesLeft > 0)) {
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-            // Are there going to be more segments
-            bool more;
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_interrupt_unsubscribe(
+        int handle
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-            // Check if there will be more segments
-            if (bytesLeft > CY3240_MAX_WRITE_BYTES)
-                 more = true;
-            else
-                 more = false;
+    if (pCy3240 != NULL) {
 
-            // Set the write and read length to transfer one packet at a time
-            writeLength = MIN(bytesLeft, CY3240_MAX_WRITE_BYTES);
-            readLength = writeLength + CY3240_STATUS_CODE_SIZE;
+        if (pCy3240->monitor) {
+            pCy3240->monitor = false;
+            pthread_join(pCy3240->monitor_thread, NULL);
+        }
 
-            // TODO:
-            // Need to be able to retransmit data if Nack is received
-            if CY3240_SUCCESS(result) {
+        cy3240_handle_put(handle);
 
-                // Pack the data in to the send packet
-                result = pack_write_input(
-                        address,
-                        pWriteStart,
-                        &writeLength,
-                        first,
-                        more);
+        return CY3240_ERROR_OK;
+    }
 
-                if CY3240_FAILURE(result)
-                    printf("Failed to pack send data in write input packet: %i\n", result);
-            }
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-            if (CY3240_SUCCESS(result)) {
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_interrupt_wait(
+        int handle,
+        int timeout
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-                // Write the data to the buffer
-                result = transcieve(
-                        pCy3240,
-                        SEND_PACKET,
-                        &writeLength,
-                        RECV_PACKET,
-                        &readLength);
+    if ((pCy3240 != NULL) &&
+        (timeout >= 0)) {
 
-                if CY3240_FAILURE(result)
-                    printf("Failed to transmit write packet\n");
-            }
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint64_t deadline = cy3240_util_time_us() + ((uint64_t)timeout * 1000);
+        struct timespec when;
 
-            if (CY3240_SUCCESS(result)) {
+        when.tv_sec = deadline / 1000000;
+        when.tv_nsec = (deadline % 1000000) * 1000;
 
-                // Decode the response
-                result = unpack_write_output(
-                        &writeLength,
-                        &readLength,
-                        &bytesLeft);
+        pthread_mutex_lock(&pCy3240->lock);
 
-                if CY3240_FAILURE(result)
-                    printf("Failed to transmit all data\n");
-            }
+        // Interrupts seen since the last wait return at once
+        while (CY3240_SUCCESS(result) &&
+               (pCy3240->interrupts == pCy3240->interrupts_taken)) {
 
-            // No longer the first time
-            first = false;
+            if (pCy3240->closing)
+                result = CY3240_ERROR_INVALID_PARAMETERS;
+            else if (pthread_cond_timedwait(&pCy3240->interrupt, &pCy3240->lock, &when) == ETIMEDOUT)
+                result = CY3240_ERROR_TIMEOUT;
         }
 
-        pthread_mutex_unlock(&mutex);
+        // Every pending interrupt is handled by this wake up
+        if CY3240_SUCCESS(result)
+            pCy3240->interrupts_taken = pCy3240->interrupts;
+
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
         return result;
     }
 
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
     return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
 //-----------------------------------------------------------------------------
 Cy3240_Error_t
-cy3240_read(
+cy3240_set_serial_number(
         int handle,
-        uint8_t address,
-        uint8_t* const pData,
-        uint16_t* const pLength
+        const char* const pSerial
         )
 {
-    // The handle is the pointer to the state structure
-    const Cy3240_t* pCy3240 = (const Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
     if ((pCy3240 != NULL) &&
-        (pData != NULL) &&
-        (pLength != NULL) &&
-        (*pLength != 0)) {
-
-        Cy3240_Error_t result = CY3240_ERROR_OK;
-
-        uint16_t readLength;
-        uint8_t* pReadStart = pData;
-        const uint16_t writeLength = READ_INPUT_PACKET_SIZE;
-        uint16_t bytesLeft = *pLength;
+        ((pSerial == NULL) || (strlen(pSerial) < CY3240_SERIAL_MAX))) {
 
-        pthread_mutex_lock(&mutex);
-
-        // Loop while there is still data to read
-        while (CY3240_SUCCESS(result) &&
-               (bytesLeft > 0)) {
+        pthread_mutex_lock(&pCy3240->lock);
 
-            // Calculate the number of packets to read
-            readLength = MIN(bytesLeft, CY3240_MAX_READ_BYTES);
+        if (pSerial != NULL)
+            strcpy(pCy3240->serial, pSerial);
+        else
+            pCy3240->serial[0] = '\0';
 
-            // Create the read input packet
-            if (CY3240_SUCCESS(result)) {
+        select_matcher(pCy3240);
 
-                result = pack_read_input(
-                        address,
-                        &readLength);
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-                if CY3240_FAILURE(result)
-                    printf("Failed to pack read input packet: %i\n", result);
-            }
+        return CY3240_ERROR_OK;
+    }
 
-            // Send the data
-            if (CY3240_SUCCESS(result)) {
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
 
-                // Write the data to the buffer
-                result = transcieve(
-                        pCy3240,
-                        SEND_PACKET,
-                        &writeLength,
-                        RECV_PACKET,
-                        &readLength);
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
 
-                if CY3240_FAILURE(result)
-                    printf("Failed to transmit read packet\n");
-            }
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_location(
+        int handle,
+        const char* const pLocation
+        )
+{
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
-            // unpack the result
-            if (CY3240_SUCCESS(result)) {
+    if ((pCy3240 != NULL) &&
+        ((pLocation == NULL) || (strlen(pLocation) < CY3240_LOCATION_MAX))) {
 
-                // Decode the response
-                result = unpack_read_output(
-                        pReadStart,
-                        &readLength);
+        pthread_mutex_lock(&pCy3240->lock);
 
-                if CY3240_FAILURE(result) {
-                    printf("Failed to read data\n");
+        if (pLocation != NULL)
+            strcpy(pCy3240->location, pLocation);
+        else
+            pCy3240->location[0] = '\0';
 
-                } else {
-                    pReadStart += readLength;
-                    bytesLeft -= readLength;
-                }
-            }
-        }
+        select_matcher(pCy3240);
 
-        pthread_mutex_unlock(&mutex);
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
-        return result;
+        return CY3240_ERROR_OK;
     }
 
+    if (pCy3240 != NULL)
+        cy3240_handle_put(handle);
+
     return CY3240_ERROR_INVALID_PARAMETERS;
 }
 
@@ -1006,17 +3340,15 @@ cy3240_open(
         int handle
         )
 {
-    // The handle is the pointer to the state structure
-    Cy3240_t* pCy3240 = (Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
     if (pCy3240 != NULL) {
 
         hid_return error = HID_RET_SUCCESS;
         Cy3240_Error_t result = CY3240_ERROR_OK;
 
-        HIDInterfaceMatcher matcher = {pCy3240->vendor_id, pCy3240->product_id, NULL, NULL, 0};
-
-        pthread_mutex_lock(&mutex);
+        pthread_mutex_lock(&pCy3240->lock);
 #ifdef DEBUG
 
         // Enable hid debugging
@@ -1031,10 +3363,10 @@ cy3240_open(
         }
 #endif
 
-        // Initialize the device
+        // Initialize libhid, unless another handle did
         if CY3240_SUCCESS(result) {
 
-            error = pCy3240->w.init();
+            error = libhid_acquire(pCy3240);
 
             if (HID_FAILURE(error)) {
                  fprintf(stderr, "hid_init failed with return code %d\n", error);
@@ -1059,8 +3391,8 @@ cy3240_open(
             error = pCy3240->w.force_open(
                       pCy3240->pHid,
                       pCy3240->iface_number,
-                      &matcher,
-                      3);
+                      &pCy3240->matcher,
+                      CY3240_OPEN_RETRIES);
 
             if (HID_FAILURE(error)) {
                 fprintf(stderr, "hid_force_open failed with return code %d\n", error);
@@ -1104,7 +3436,8 @@ cy3240_open(
         }
 #endif
 
-        pthread_mutex_unlock(&mutex);
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
 
         return result;
     }
@@ -1118,18 +3451,37 @@ cy3240_close(
         int handle
         )
 {
-    // The handle is the pointer to the state structure
-    Cy3240_t* pCy3240 = (Cy3240_t*)handle;
+    // Look up the state structure of the handle
+    Cy3240_t* pCy3240 = cy3240_handle_get(handle);
 
     if (pCy3240 != NULL) {
 
         Cy3240_Error_t result = CY3240_ERROR_OK;
         hid_return error = HID_RET_SUCCESS;
 
-        pthread_mutex_lock(&mutex);
+        pthread_mutex_lock(&pCy3240->lock);
 
-        // Close the connection
-        if (CY3240_SUCCESS(result)) {
+        // Only one close goes on
+        if (pCy3240->closing) {
+            pthread_mutex_unlock(&pCy3240->lock);
+            cy3240_handle_put(handle);
+            return CY3240_ERROR_INVALID_PARAMETERS;
+        }
+
+        // Calls waiting for the bridge or an interrupt give up
+        pCy3240->closing = true;
+        pthread_cond_broadcast(&pCy3240->turn);
+        pthread_cond_broadcast(&pCy3240->interrupt);
+
+        pthread_mutex_unlock(&pCy3240->lock);
+
+        // Stop the interrupt monitor before the interface goes away
+        cy3240_interrupt_unsubscribe(handle);
+
+        pthread_mutex_lock(&pCy3240->lock);
+
+        // Close the connection, unless the handle was never opened
+        if (CY3240_SUCCESS(result) && (pCy3240->pHid != NULL)) {
 
             error = pCy3240->w.close(pCy3240->pHid);
 
@@ -1141,11 +3493,13 @@ cy3240_close(
         }
 
         // Delete the interface
-        if (CY3240_SUCCESS(result)) {
-
+        if (CY3240_SUCCESS(result) && (pCy3240->pHid != NULL))
             pCy3240->w.delete_if(&pCy3240->pHid);
 
-            error = pCy3240->w.cleanup();
+        // The last handle cleans up libhid
+        if CY3240_SUCCESS(result) {
+
+            error = libhid_release(pCy3240);
 
             if (HID_FAILURE(error)) {
 
@@ -1154,11 +3508,21 @@ cy3240_close(
             }
         }
 
-        // Free unused resources
-        if CY3240_SUCCESS(result)
-            free(pCy3240);
+        // The handle stays usable if it could not be closed
+        if CY3240_FAILURE(result)
+            pCy3240->closing = false;
 
-        pthread_mutex_lock(&mutex);
+        pthread_mutex_unlock(&pCy3240->lock);
+        cy3240_handle_put(handle);
+
+        // Free unused resources once the other users are done with them
+        if CY3240_SUCCESS(result) {
+            cy3240_handle_release(handle);
+            pthread_cond_destroy(&pCy3240->interrupt);
+            pthread_cond_destroy(&pCy3240->turn);
+            pthread_mutex_destroy(&pCy3240->lock);
+            free(pCy3240);
+        }
 
         return result;
     }
@@ -1177,7 +3541,7 @@ cy3240_factory (
         Cy3240_I2C_ClockSpeed_t clock
         )
 {
-     // The handle is the pointer to the state structure
+     // The state structure
      Cy3240_t* pCy3240;
 
      // Allocate the handle
@@ -1186,6 +3550,9 @@ cy3240_factory (
      // Check the parameters
      if (pCy3240 != NULL) {
 
+          pthread_condattr_t attr;
+          int x;
+
           // Initialize the Cy3240 data structure
           pCy3240->vendor_id = CY3240_VID;
           pCy3240->product_id = CY3240_PID;
@@ -1194,6 +3561,13 @@ cy3240_factory (
           pCy3240->power = power;
           pCy3240->bus = bus;
           pCy3240->clock = clock;
+          pCy3240->default_clock = clock;
+          pCy3240->power_valid = false;
+          pCy3240->clock_valid = false;
+          memset(pCy3240->slave_clock, CY3240_SLAVE_CLOCK_NONE, sizeof(pCy3240->slave_clock));
+          pCy3240->pHid = NULL;
+          pCy3240->hid_user = false;
+          pCy3240->closing = false;
           pCy3240->w.init = hid_init;
           pCy3240->w.close = hid_close;
           pCy3240->w.write = hid_interrupt_write;
@@ -1202,9 +3576,58 @@ cy3240_factory (
           pCy3240->w.delete_if = hid_delete_HIDInterface;
           pCy3240->w.force_open = hid_force_open;
           pCy3240->w.new_if = hid_new_HIDInterface;
-
-          // Initialize the handle
-          *pHandle = pCy3240;
+          pCy3240->status = 0;
+          pCy3240->interrupts = 0;
+          pCy3240->interrupts_taken = 0;
+          pCy3240->last_transfer = 0;
+          pCy3240->poll_interval = 0;
+          pCy3240->monitor = false;
+          pCy3240->pipeline_depth = CY3240_PIPELINE_DEPTH_DEFAULT;
+          pCy3240->adaptive = true;
+          pCy3240->latency_us = 0;
+          pCy3240->deviation_us = 0;
+          pCy3240->latency_samples = 0;
+          pCy3240->timeouts = 0;
+          pCy3240->last_timeout = timeout;
+          pCy3240->stale = 0;
+          pCy3240->stale_us = 0;
+          pCy3240->inflight_head = 0;
+          pCy3240->inflight_tail = 0;
+          for (x = 0; x < CY3240_NAK_COUNT; x++) {
+              pCy3240->retry[x].attempts = 1;
+              pCy3240->retry[x].backoff_us = CY3240_RETRY_BACKOFF_US;
+              pCy3240->retry[x].max_backoff_us = CY3240_RETRY_MAX_BACKOFF_US;
+              pCy3240->retry[x].multiplier = 2;
+              pCy3240->retry[x].jitter = CY3240_RETRY_JITTER;
+          }
+          memset(&pCy3240->retry_stats, 0x00, sizeof(pCy3240->retry_stats));
+          pCy3240->retry_seed = (unsigned int)cy3240_util_time_us();
+          memset(&pCy3240->matcher, 0x00, sizeof(pCy3240->matcher));
+          pCy3240->matcher.vendor_id = pCy3240->vendor_id;
+          pCy3240->matcher.product_id = pCy3240->product_id;
+          pCy3240->serial[0] = '\0';
+          pCy3240->location[0] = '\0';
+          memset(pCy3240->recovery, 0x00, sizeof(pCy3240->recovery));
+          memset(&pCy3240->traffic, 0x00, sizeof(pCy3240->traffic));
+          memset(pCy3240->waiting, 0x00, sizeof(pCy3240->waiting));
+          memset(pCy3240->classes, 0x00, sizeof(pCy3240->classes));
+          pthread_mutex_init(&pCy3240->lock, NULL);
+          pthread_cond_init(&pCy3240->turn, NULL);
+
+          // Interrupt waits use the monotonic clock
+          pthread_condattr_init(&attr);
+          pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+          pthread_cond_init(&pCy3240->interrupt, &attr);
+          pthread_condattr_destroy(&attr);
+
+          // Hand out a table handle instead of the pointer
+          if CY3240_FAILURE(cy3240_handle_alloc(pCy3240, pHandle)) {
+              pthread_cond_destroy(&pCy3240->interrupt);
+              pthread_cond_destroy(&pCy3240->turn);
+              pthread_mutex_destroy(&pCy3240->lock);
+              free(pCy3240);
+              return CY3240_ERROR_UNKNOWN;
+          }
 
           return CY3240_ERROR_OK;
      }
@@ -51,6 +51,19 @@ extern "C" {
 #define CY3240_SUCCESS(s)  ((s == CY3240_ERROR_OK) ? TRUE : FALSE)
 #define CY3240_FAILURE(s)  ((s != CY3240_ERROR_OK) ? TRUE : FALSE)
 
+/* Transfer pipeline */
+#define CY3240_PIPELINE_DEPTH_DEFAULT  (4)     ///< Packets in flight by default
+#define CY3240_PIPELINE_DEPTH_MAX      (16)    ///< Largest supported pipeline depth
+#define CY3240_REPORT_SIZE             (64)    ///< Size of a packed HID report
+
+/* Write retries after a NAK, used until a policy is set */
+#define CY3240_RETRY_BACKOFF_US        (1000)  ///< Delay before the first retry
+#define CY3240_RETRY_MAX_BACKOFF_US    (16000) ///< Upper bound of the retry delay
+#define CY3240_RETRY_JITTER            (25)    ///< Random part of the retry delay in percent
+
+/* Interface claims */
+#define CY3240_OPEN_RETRIES            (3)     ///< Attempts to claim the interface
+
 //@} End of Defines
 
 //////////////////////////////////////////////////////////////////////
@@ -72,7 +85,8 @@ cy3240_restart(
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to reconfigure the settings for the CY3240 bridge chip
+ *  Method to reconfigure the settings for the CY3240 bridge chip. Power and
+ *  clock settings the bridge has already confirmed are not sent again.
  *
  *  @param handle [in] the handle to the bridge controller
  *  @param power  [in] the power mode
@@ -102,6 +116,105 @@ cy3240_reinit(
         int handle
         );
 
+//-----------------------------------------------------------------------------
+/**
+ *  Method to forget the confirmed power and clock settings of the CY3240,
+ *  so the next cy3240_reconfigure() sends them again. This happens
+ *  automatically after cy3240_reinit() and after a HID error.
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_invalidate(
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to set the clock profile of a slave. Reads and writes to the slave
+ *  switch the bridge to this clock speed first, but only when the bridge
+ *  is not already running at that speed. Slaves without a profile use the
+ *  clock speed from cy3240_reconfigure().
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the 7-bit I2C address of the slave
+ *  @param clock   [in] the clock speed the slave supports
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_slave_clock(
+        int handle,
+        uint8_t address,
+        Cy3240_I2C_ClockSpeed_t clock
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to remove the clock profile of a slave
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the 7-bit I2C address of the slave
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_clear_slave_clock(
+        int handle,
+        uint8_t address
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the clock speed used for a slave
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the 7-bit I2C address of the slave
+ *  @param pClock  [out] the clock speed used for the slave
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_slave_clock(
+        int handle,
+        uint8_t address,
+        Cy3240_I2C_ClockSpeed_t* const pClock
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to set the priority class of the writes, reads and transfers the
+ *  calling thread makes, on every handle. A waiting call is let on to the
+ *  bridge before calls of lower classes. A multi packet read or a transfer
+ *  of a lower class steps aside between packets while it waits, a multi
+ *  packet write only stops the bus after its last packet and is not
+ *  preempted. A preempted read of a slave that streams from an address
+ *  pointer continues where it was, so higher classes should not move the
+ *  pointer of that slave meanwhile.
+ *
+ *  @param priority [in] the class, CY3240_PRIORITY_INTERACTIVE by default
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_priority(
+        Cy3240_Priority_t priority
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the priority class of the calling thread
+ *
+ *  @returns the class
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Priority_t
+cy3240_get_priority(
+        void
+        );
+
 //-----------------------------------------------------------------------------
 /**
  *  Method to write data to the CY3240
@@ -142,7 +255,369 @@ cy3240_read(
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to open the CY3240
+ *  Method to run a list of single packet operations. Up to the pipeline
+ *  depth of packets are sent before the first response is read, so the
+ *  USB round trip is paid once per batch instead of once per operation.
+ *  The pipeline is drained before a slave clock switch. Each operation
+ *  gets its own result and NAKs are not reported on stdout.
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param pOps   [in,out] the operations, each at most CY3240_MAX_READ_BYTES
+ *                or CY3240_MAX_WRITE_BYTES long
+ *  @param count  [in] the number of operations
+ *  @returns the first HID error, the per operation result is in each op
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_transfer(
+        int handle,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pack an operation in to the HID report cy3240_transfer()
+ *  would send for it. Operations that run many times can be packed once
+ *  and sent with cy3240_transfer_packed().
+ *
+ *  @param pOp     [in] the operation
+ *  @param pReport [out] CY3240_REPORT_SIZE bytes
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_pack(
+        const Cy3240_Op_t* const pOp,
+        uint8_t* const pReport
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a list of operations like cy3240_transfer(), sending
+ *  reports packed earlier by cy3240_pack() instead of packing them again.
+ *  The operations still receive the results and read data.
+ *
+ *  @param handle   [in] the handle to the bridge controller
+ *  @param pOps     [in,out] the operations
+ *  @param pReports [in] count reports of CY3240_REPORT_SIZE bytes, one per op
+ *  @param count    [in] the number of operations
+ *  @returns the first HID error, the per operation result is in each op
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_transfer_packed(
+        int handle,
+        Cy3240_Op_t* const pOps,
+        const uint8_t* const pReports,
+        uint16_t count
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to set the number of packets cy3240_transfer() keeps in flight
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param depth  [in] 1 to CY3240_PIPELINE_DEPTH_MAX, 1 disables pipelining
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_pipeline_depth(
+        int handle,
+        int depth
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to enable the adaptive timeouts. Once enough round trips have
+ *  been measured every packet waits for the time its bytes take on the bus
+ *  at the current clock plus the smoothed USB latency and four times its
+ *  deviation, never longer than the timeout given to cy3240_factory().
+ *  An adaptive timeout that expires is reported as CY3240_ERROR_TIMEOUT
+ *  and the late response is dropped before the next packet. Enabled by
+ *  default.
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param enable [in] TRUE to adapt, FALSE to always use the fixed timeout
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_adaptive_timeout(
+        int handle,
+        int enable
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the round trip statistics behind the adaptive timeouts
+ *
+ *  @param handle   [in] the handle to the bridge controller
+ *  @param pLatency [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_latency(
+        int handle,
+        Cy3240_Latency_t* const pLatency
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to set how cy3240_write() retries a write the slave refused.
+ *  A NAK of the first byte of the first packet is an address NAK, for
+ *  example a slave busy with an internal write cycle; any later NAK is a
+ *  data NAK. The slave has dropped the transaction either way, so the
+ *  whole write is sent again from its first byte after an exponential
+ *  backoff with jitter. By default a NAK fails the write.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param nak     [in] the kind of NAK the policy applies to
+ *  @param pPolicy [in] the policy, attempts of 1 disables retries
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_retry_policy(
+        int handle,
+        Cy3240_Nak_t nak,
+        const Cy3240_Retry_Policy_t* const pPolicy
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the write retry statistics
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param pStats [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_retry_stats(
+        int handle,
+        Cy3240_Retry_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to bring the bridge back after a failed transfer without closing
+ *  the handle. The tiers are tried from the cheapest up to max_tier until
+ *  a status query round trip succeeds:
+ *
+ *  - CY3240_TIER_RETRY drops responses still in flight and repeats a round trip
+ *  - CY3240_TIER_REINIT sends the bridge a reinit packet
+ *  - CY3240_TIER_RECLAIM claims the interface again with the cached matcher
+ *  - CY3240_TIER_REBUILD replaces the interface of the handle with a new one,
+ *    other handles keep theirs. If no interface can be created the handle
+ *    fails every transfer until a later rebuild succeeds.
+ *
+ *  Any tier above the first resets the power and clock settings, they are
+ *  sent again by the next transfer. The failed transfer is not repeated,
+ *  the caller does that once the bridge has recovered.
+ *
+ *  @param handle   [in] the handle to the bridge controller
+ *  @param max_tier [in] the most expensive tier to try
+ *  @param pTier    [out] the tier that recovered the bridge, may be NULL
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_recover(
+        int handle,
+        Cy3240_Tier_t max_tier,
+        Cy3240_Tier_t* const pTier
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to attach the handle to a bridge that was unplugged and plugged
+ *  in again. Runs the CY3240_TIER_REBUILD recovery tier directly, the
+ *  cheaper tiers cannot reach a new device.
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_reattach(
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the timing statistics of a recovery tier
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param tier   [in] the tier
+ *  @param pStats [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_recovery_stats(
+        int handle,
+        Cy3240_Tier_t tier,
+        Cy3240_Tier_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get every statistic of the handle at once. The counters are
+ *  copied under the bridge lock, so they are consistent with each other.
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param pStats [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_stats(
+        int handle,
+        Cy3240_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to estimate a round trip percentile from the histogram
+ *
+ *  @param pStats  [in] the statistics
+ *  @param percent [in] the percentile, 1 to 100
+ *  @returns the upper bound of the bucket holding the percentile in
+ *           microseconds, 0 without round trips
+ */
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_stats_percentile(
+        const Cy3240_Stats_t* const pStats,
+        unsigned int percent
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to estimate a percentile of the call durations of a priority
+ *  class, including the time waiting for the bridge
+ *
+ *  @param pStats   [in] the statistics
+ *  @param priority [in] the class
+ *  @param percent  [in] the percentile, 1 to 100
+ *  @returns the upper bound of the bucket holding the percentile in
+ *           microseconds, 0 without calls
+ */
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_class_percentile(
+        const Cy3240_Stats_t* const pStats,
+        Cy3240_Priority_t priority,
+        unsigned int percent
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the status byte of the last response from the CY3240
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param pStatus [out] the status byte, see STATUS_BYTE_* in cy3240_packet.h
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_get_status(
+        int handle,
+        uint8_t* const pStatus
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to subscribe to the interrupt indication of the CY3240. The
+ *  interrupt flag is reported in the status byte of every response, so a
+ *  monitor thread only queries the bridge control register when no other
+ *  transfer has happened for poll_interval. The query does not touch the
+ *  I2C bus.
+ *
+ *  @param handle        [in] the handle to the bridge controller
+ *  @param poll_interval [in] the idle time before the status is queried (ms)
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_interrupt_subscribe(
+        int handle,
+        int poll_interval
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop the interrupt monitor
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_interrupt_unsubscribe(
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to block until the CY3240 reports an interrupt. An interrupt is
+ *  a response with the interrupt flag set after one without it. Returns at
+ *  once if an interrupt arrived since the last wait, and one return covers
+ *  all the interrupts that arrived since.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param timeout [in] the maximum time to wait (ms), 0 or more
+ *  @returns CY3240_ERROR_OK or CY3240_ERROR_TIMEOUT
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_interrupt_wait(
+        int handle,
+        int timeout
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to select the bridge with the specified serial number. Without
+ *  a serial number the first bridge found is opened.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param pSerial [in] the serial number, NULL for any bridge
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_serial_number(
+        int handle,
+        const char* const pSerial
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to select the bridge on the specified USB bus and device, as
+ *  the libusb bus and device names joined by a slash, for example
+ *  "001/004". The location takes precedence over the serial number and
+ *  saves reading the serial number of every bridge while opening, but it
+ *  changes whenever the bridge is plugged in again.
+ *
+ *  @param handle    [in] the handle to the bridge controller
+ *  @param pLocation [in] the location, NULL to select by serial number again
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_set_location(
+        int handle,
+        const char* const pLocation
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to open the CY3240. libhid is initialized by the first handle
+ *  opened in the process and shared with the others.
  *
  *  @param handle [in] the handle to the bridge controller
  *  @returns Cy3240_Error_t
@@ -155,7 +630,8 @@ cy3240_open(
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to close the CY3240 usb device
+ *  Method to close the CY3240 usb device. libhid is cleaned up when the
+ *  last open handle is closed.
  *
  *  @param handle [in] the handle to the bridge controller
  *  @returns Cy3240_Error_t
@@ -0,0 +1,790 @@
+/**
+ * @file cy3240_client.c
+ *
+ * @brief Uses a bridge shared by cy3240d
+ *
+ * Uses a bridge shared by cy3240d
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_packet.h"
+#include "cy3240_protocol.h"
+#include "cy3240_ring.h"
+#include "cy3240_client.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SHM_POLL_MS     (100)    ///< How often a wait on the rings checks the server is alive
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Client state
+ */
+struct Cy3240_Client_s {
+    int fd;                                    ///< Connection to the server
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)]; ///< Socket path
+    char serial[CY3240_SERIAL_MAX];            ///< Serial number of the bridge
+    pthread_mutex_t lock;                      ///< One request at a time
+    int shm;                                   ///< Connection of the ring session, -1 before a map
+    Cy3240_Shm_Header_t* pShm;                 ///< Shared memory, NULL before a map
+    Cy3240_Ring_t* pRequests;                  ///< Operations to the server
+    Cy3240_Ring_t* pResponses;                 ///< Operations with their results
+    Cy3240_Ring_t* pSamples;                   ///< Published samples, NULL without a subscription
+    Cy3240_Msg_Header_t header;                ///< Header of the last message
+    uint8_t buffer[CY3240_PROTOCOL_MAX_BODY];  ///< Body of the last message
+};
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read exactly length bytes from the server
+ *
+ *  @param fd      [in] the connection
+ *  @param pBuffer [out] the data
+ *  @param length  [in] the number of bytes
+ *  @returns false if the connection failed
+ */
+//-----------------------------------------------------------------------------
+static bool
+read_full(
+        int fd,
+        void* const pBuffer,
+        size_t length
+        )
+{
+    uint8_t* pNext = (uint8_t*)pBuffer;
+
+    while (length > 0) {
+
+        ssize_t bytes = recv(fd, pNext, length, 0);
+
+        if ((bytes < 0) && (errno == EINTR))
+            continue;
+
+        if (bytes <= 0)
+            return false;
+
+        pNext += bytes;
+        length -= (size_t)bytes;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to write exactly length bytes to the server
+ *
+ *  @param fd      [in] the connection
+ *  @param pBuffer [in] the data
+ *  @param length  [in] the number of bytes
+ *  @returns false if the connection failed
+ */
+//-----------------------------------------------------------------------------
+static bool
+write_full(
+        int fd,
+        const void* const pBuffer,
+        size_t length
+        )
+{
+    const uint8_t* pNext = (const uint8_t*)pBuffer;
+
+    while (length > 0) {
+
+        ssize_t bytes = send(fd, pNext, length, MSG_NOSIGNAL);
+
+        if ((bytes < 0) && (errno == EINTR))
+            continue;
+
+        if (bytes <= 0)
+            return false;
+
+        pNext += bytes;
+        length -= (size_t)bytes;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to send the request in the client buffer and receive the
+ *  response in to it. Called with the lock held.
+ *
+ *  @param pClient [in,out] the client
+ *  @param fd      [in] the connection
+ *  @param type    [in] Cy3240_Msg_Type_t
+ *  @param count   [in] the number of operations of a transfer
+ *  @param length  [in] the length of the request body
+ *  @returns the result of the response, CY3240_ERROR_HID if the
+ *           connection failed
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+exchange(
+        Cy3240_Client_t* const pClient,
+        int fd,
+        Cy3240_Msg_Type_t type,
+        uint16_t count,
+        uint32_t length
+        )
+{
+    memset(&pClient->header, 0x00, sizeof(pClient->header));
+    pClient->header.length = length;
+    pClient->header.type = (uint8_t)type;
+    pClient->header.count = count;
+
+    if (!write_full(fd, &pClient->header, sizeof(pClient->header)) ||
+        !write_full(fd, pClient->buffer, length) ||
+        !read_full(fd, &pClient->header, sizeof(pClient->header)) ||
+        (pClient->header.length > CY3240_PROTOCOL_MAX_BODY) ||
+        !read_full(fd, pClient->buffer, pClient->header.length)) {
+        pClient->header.length = 0;
+        return CY3240_ERROR_HID;
+    }
+
+    return (Cy3240_Error_t)pClient->header.result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to open a connection to the bridge of the client
+ *
+ *  @param pClient [in,out] the client
+ *  @param pFd     [out] the connection
+ *  @returns CY3240_ERROR_HID if the server cannot be reached or does not
+ *           share the bridge
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+connect_bridge(
+        Cy3240_Client_t* const pClient,
+        int* const pFd
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    struct sockaddr_un address;
+
+    memset(&address, 0x00, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, pClient->path);
+
+    *pFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if ((*pFd < 0) ||
+        (connect(*pFd, (struct sockaddr*)&address, sizeof(address)) != 0))
+        result = CY3240_ERROR_HID;
+
+    if CY3240_SUCCESS(result) {
+        memcpy(pClient->buffer, pClient->serial, strlen(pClient->serial));
+        result = exchange(pClient, *pFd, CY3240_MSG_OPEN, 0, strlen(pClient->serial));
+    }
+
+    if (CY3240_FAILURE(result) && (*pFd >= 0)) {
+        close(*pFd);
+        *pFd = -1;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to receive a response with a file descriptor attached
+ *
+ *  @param fd          [in] the connection
+ *  @param pHeader     [out] the response header
+ *  @param pDescriptor [out] the file descriptor, -1 if none was attached
+ *  @returns false if the connection failed
+ */
+//-----------------------------------------------------------------------------
+static bool
+receive_descriptor(
+        int fd,
+        Cy3240_Msg_Header_t* const pHeader,
+        int* const pDescriptor
+        )
+{
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr message;
+    struct iovec vector;
+    struct cmsghdr* pControl;
+    ssize_t bytes;
+
+    memset(&message, 0x00, sizeof(message));
+
+    vector.iov_base = pHeader;
+    vector.iov_len = sizeof(Cy3240_Msg_Header_t);
+
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    *pDescriptor = -1;
+
+    do {
+        bytes = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while ((bytes < 0) && (errno == EINTR));
+
+    if (bytes != sizeof(Cy3240_Msg_Header_t))
+        return false;
+
+    for (pControl = CMSG_FIRSTHDR(&message); pControl != NULL; pControl = CMSG_NXTHDR(&message, pControl))
+        if ((pControl->cmsg_level == SOL_SOCKET) &&
+            (pControl->cmsg_type == SCM_RIGHTS))
+            memcpy(pDescriptor, CMSG_DATA(pControl), sizeof(int));
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check the server still serves the ring session
+ *
+ *  @param fd [in] the connection of the ring session
+ *  @returns false once the server closed the connection
+ */
+//-----------------------------------------------------------------------------
+static bool
+peer_alive(
+        int fd
+        )
+{
+    uint8_t byte;
+    ssize_t bytes = recv(fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+
+    return (bytes > 0) || ((bytes < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a list of operations through the shared memory rings.
+ *  Called with the lock held.
+ *
+ *  @param pClient [in,out] the client
+ *  @param pOps    [in,out] the operations
+ *  @param count   [in] the number of operations
+ *  @returns the first HID error, the per operation result is in each op
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+transfer_shared(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        )
+{
+    Cy3240_Error_t first = CY3240_ERROR_OK;
+    Cy3240_Shm_Op_t shared;
+    uint16_t done;
+    uint16_t x;
+
+    // Operations without an answer keep the error
+    for (x = 0; x < count; x++)
+        pOps[x].result = CY3240_ERROR_HID;
+
+    // At most a ring full is out at a time, so the server never blocks
+    for (done = 0; done < count; ) {
+
+        const uint16_t chunk = (uint16_t)MIN(count - done, CY3240_SHM_OPS);
+        uint16_t answered = 0;
+
+        for (x = 0; x < chunk; x++) {
+
+            const Cy3240_Op_t* const pOp = &pOps[done + x];
+
+            shared.tag = done + x;
+            shared.type = (uint8_t)pOp->type;
+            shared.address = pOp->address;
+            shared.length = (uint8_t)pOp->length;
+            shared.result = CY3240_ERROR_OK;
+
+            if (pOp->type == CY3240_OP_WRITE)
+                memcpy(shared.data, pOp->pData, pOp->length);
+
+            cy3240_ring_push(pClient->pRequests, &shared);
+        }
+
+        cy3240_ring_wake(pClient->pRequests);
+
+        while (answered < chunk) {
+
+            Cy3240_Op_t* pOp;
+
+            if (!cy3240_ring_pop(pClient->pResponses, &shared)) {
+
+                if (!cy3240_ring_wait(pClient->pResponses, SHM_POLL_MS) &&
+                    !peer_alive(pClient->shm))
+                    return CY3240_ERROR_HID;
+
+                continue;
+            }
+
+            pOp = &pOps[shared.tag];
+            pOp->result = (Cy3240_Error_t)shared.result;
+
+            if ((pOp->type == CY3240_OP_READ) && CY3240_SUCCESS(pOp->result))
+                memcpy(pOp->pData, shared.data, pOp->length);
+
+            // Transport errors fail the transfer, NAKs only the operation
+            if (CY3240_SUCCESS(first) &&
+                ((pOp->result == CY3240_ERROR_HID) || (pOp->result == CY3240_ERROR_TIMEOUT)))
+                first = pOp->result;
+
+            answered++;
+        }
+
+        done += chunk;
+    }
+
+    return first;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to send one transfer request. Called with the lock held.
+ *
+ *  @param pClient [in,out] the client
+ *  @param pOps    [in,out] the operations
+ *  @param count   [in] the number of operations, at most CY3240_PROTOCOL_MAX_OPS
+ *  @returns the first HID error, the per operation result is in each op
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+transfer_chunk(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint32_t length = 0;
+    uint32_t expected = count;
+    uint16_t x;
+
+    for (x = 0; x < count; x++) {
+
+        uint8_t* const pHeader = &pClient->buffer[length];
+        const Cy3240_Op_t* const pOp = &pOps[x];
+
+        pHeader[0] = (uint8_t)pOp->type;
+        pHeader[1] = pOp->address;
+        pHeader[2] = (uint8_t)pOp->length;
+        length += CY3240_PROTOCOL_OP_HEADER;
+
+        if (pOp->type == CY3240_OP_WRITE) {
+            memcpy(&pClient->buffer[length], pOp->pData, pOp->length);
+            length += pOp->length;
+
+        } else if (pOp->type == CY3240_OP_READ) {
+            expected += pOp->length;
+        }
+    }
+
+    result = exchange(pClient, pClient->fd, CY3240_MSG_TRANSFER, count, length);
+
+    // Refused or lost, every operation gets the same result
+    if (pClient->header.length != expected) {
+
+        if CY3240_SUCCESS(result)
+            result = CY3240_ERROR_UNKNOWN;
+
+        for (x = 0; x < count; x++)
+            pOps[x].result = result;
+
+        return result;
+    }
+
+    for (x = 0, length = count; x < count; x++) {
+
+        Cy3240_Op_t* const pOp = &pOps[x];
+
+        pOp->result = (Cy3240_Error_t)(int8_t)pClient->buffer[x];
+
+        if (pOp->type == CY3240_OP_READ) {
+            memcpy(pOp->pData, &pClient->buffer[length], pOp->length);
+            length += pOp->length;
+        }
+    }
+
+    return result;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_open(
+        Cy3240_Client_t** ppClient,
+        const char* pPath,
+        const char* pSerial
+        )
+{
+    if (pPath == NULL)
+        pPath = CY3240_PROTOCOL_DEFAULT_PATH;
+
+    if (pSerial == NULL)
+        pSerial = "";
+
+    if ((ppClient != NULL) &&
+        (strlen(pPath) < sizeof(((Cy3240_Client_t*)0)->path)) &&
+        (strlen(pSerial) < CY3240_SERIAL_MAX)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Client_t* const pClient = (Cy3240_Client_t*)malloc(sizeof(Cy3240_Client_t));
+
+        if (pClient == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        strcpy(pClient->path, pPath);
+        strcpy(pClient->serial, pSerial);
+        pClient->shm = -1;
+        pClient->pShm = NULL;
+        pClient->pRequests = NULL;
+        pClient->pResponses = NULL;
+        pClient->pSamples = NULL;
+
+        result = connect_bridge(pClient, &pClient->fd);
+
+        if CY3240_FAILURE(result) {
+            free(pClient);
+            return result;
+        }
+
+        pthread_mutex_init(&pClient->lock, NULL);
+        *ppClient = pClient;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_map(
+        Cy3240_Client_t* const pClient,
+        bool subscribe
+        )
+{
+    if ((pClient != NULL) &&
+        (pClient->pShm == NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint8_t* pBase = (uint8_t*)MAP_FAILED;
+        struct stat status;
+        int descriptor = -1;
+        int fd = -1;
+
+        pthread_mutex_lock(&pClient->lock);
+
+        // The ring session gets a connection of its own
+        result = connect_bridge(pClient, &fd);
+
+        if CY3240_SUCCESS(result) {
+
+            memset(&pClient->header, 0x00, sizeof(pClient->header));
+            pClient->header.length = 1;
+            pClient->header.type = CY3240_MSG_MAP;
+            pClient->buffer[0] = subscribe ? 1 : 0;
+
+            if (!write_full(fd, &pClient->header, sizeof(pClient->header)) ||
+                !write_full(fd, pClient->buffer, 1) ||
+                !receive_descriptor(fd, &pClient->header, &descriptor))
+                result = CY3240_ERROR_HID;
+
+            else
+                result = (Cy3240_Error_t)pClient->header.result;
+        }
+
+        if (CY3240_SUCCESS(result) &&
+            ((descriptor < 0) || (fstat(descriptor, &status) != 0)))
+            result = CY3240_ERROR_HID;
+
+        if CY3240_SUCCESS(result)
+            pBase = (uint8_t*)mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+        if (CY3240_SUCCESS(result) && (pBase == (uint8_t*)MAP_FAILED))
+            result = CY3240_ERROR_UNKNOWN;
+
+        if (descriptor >= 0)
+            close(descriptor);
+
+        if CY3240_SUCCESS(result) {
+            pClient->shm = fd;
+            pClient->pShm = (Cy3240_Shm_Header_t*)pBase;
+            pClient->pRequests = (Cy3240_Ring_t*)&pBase[pClient->pShm->requests];
+            pClient->pResponses = (Cy3240_Ring_t*)&pBase[pClient->pShm->responses];
+            pClient->pSamples = (pClient->pShm->samples != 0) ?
+                (Cy3240_Ring_t*)&pBase[pClient->pShm->samples] : NULL;
+
+        } else if (fd >= 0) {
+            close(fd);
+        }
+
+        pthread_mutex_unlock(&pClient->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_close(
+        Cy3240_Client_t* const pClient
+        )
+{
+    if (pClient != NULL) {
+
+        if (pClient->pShm != NULL) {
+            munmap(pClient->pShm, pClient->pShm->size);
+            close(pClient->shm);
+        }
+
+        close(pClient->fd);
+        pthread_mutex_destroy(&pClient->lock);
+        free(pClient);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_write(
+        Cy3240_Client_t* const pClient,
+        uint8_t address,
+        const uint8_t* const pData,
+        uint16_t* const pLength
+        )
+{
+    if ((pClient != NULL) &&
+        (pData != NULL) &&
+        (pLength != NULL) &&
+        (*pLength > 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        pthread_mutex_lock(&pClient->lock);
+
+        pClient->buffer[0] = address;
+        memcpy(&pClient->buffer[1], pData, *pLength);
+
+        result = exchange(pClient, pClient->fd, CY3240_MSG_WRITE, 0, 1 + *pLength);
+
+        pthread_mutex_unlock(&pClient->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_read(
+        Cy3240_Client_t* const pClient,
+        uint8_t address,
+        uint8_t* const pData,
+        uint16_t* const pLength
+        )
+{
+    if ((pClient != NULL) &&
+        (pData != NULL) &&
+        (pLength != NULL) &&
+        (*pLength > 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        pthread_mutex_lock(&pClient->lock);
+
+        pClient->buffer[0] = address;
+        memcpy(&pClient->buffer[1], pLength, sizeof(*pLength));
+
+        result = exchange(pClient, pClient->fd, CY3240_MSG_READ, 0, 1 + sizeof(*pLength));
+
+        if CY3240_SUCCESS(result) {
+            *pLength = (uint16_t)MIN(pClient->header.length, *pLength);
+            memcpy(pData, pClient->buffer, *pLength);
+        }
+
+        pthread_mutex_unlock(&pClient->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_transfer(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        )
+{
+    uint16_t x;
+
+    if ((pClient == NULL) ||
+        (pOps == NULL) ||
+        (count == 0))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    // Refuse what the server would, before anything is sent
+    for (x = 0; x < count; x++) {
+
+        const Cy3240_Op_t* const pOp = &pOps[x];
+
+        if ((pOp->type != CY3240_OP_PROBE) &&
+            ((pOp->pData == NULL) ||
+             (pOp->length == 0) ||
+             (pOp->length > ((pOp->type == CY3240_OP_WRITE) ? CY3240_MAX_WRITE_BYTES : CY3240_MAX_READ_BYTES))))
+            return CY3240_ERROR_INVALID_PARAMETERS;
+    }
+
+    {
+        Cy3240_Error_t first = CY3240_ERROR_OK;
+
+        pthread_mutex_lock(&pClient->lock);
+
+        if (pClient->pShm != NULL) {
+            first = transfer_shared(pClient, pOps, count);
+            pthread_mutex_unlock(&pClient->lock);
+            return first;
+        }
+
+        for (x = 0; x < count; x += CY3240_PROTOCOL_MAX_OPS) {
+
+            Cy3240_Error_t result = transfer_chunk(
+                    pClient,
+                    &pOps[x],
+                    (uint16_t)MIN(count - x, CY3240_PROTOCOL_MAX_OPS));
+
+            if (CY3240_SUCCESS(first) && CY3240_FAILURE(result))
+                first = result;
+        }
+
+        pthread_mutex_unlock(&pClient->lock);
+
+        return first;
+    }
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_get_stats(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Stats_t* const pStats
+        )
+{
+    if ((pClient != NULL) &&
+        (pStats != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        pthread_mutex_lock(&pClient->lock);
+
+        result = exchange(pClient, pClient->fd, CY3240_MSG_STATS, 0, 0);
+
+        if (CY3240_SUCCESS(result) &&
+            (pClient->header.length != sizeof(Cy3240_Stats_t)))
+            result = CY3240_ERROR_HID;
+
+        if CY3240_SUCCESS(result)
+            memcpy(pStats, pClient->buffer, sizeof(Cy3240_Stats_t));
+
+        pthread_mutex_unlock(&pClient->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_wait_sample(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Sample_t* const pSample,
+        uint32_t timeout_ms
+        )
+{
+    if ((pClient != NULL) &&
+        (pClient->pSamples != NULL) &&
+        (pSample != NULL)) {
+
+        if (cy3240_ring_pop(pClient->pSamples, pSample))
+            return CY3240_ERROR_OK;
+
+        if (cy3240_ring_wait(pClient->pSamples, timeout_ms) &&
+            cy3240_ring_pop(pClient->pSamples, pSample))
+            return CY3240_ERROR_OK;
+
+        return CY3240_ERROR_TIMEOUT;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t
+cy3240_client_get_dropped(
+        Cy3240_Client_t* const pClient
+        )
+{
+    if ((pClient != NULL) &&
+        (pClient->pShm != NULL))
+        return __atomic_load_n(&pClient->pShm->dropped, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+//@} End of Methods
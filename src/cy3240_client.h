@@ -0,0 +1,213 @@
+/**
+ * @file cy3240_client.h
+ *
+ * @brief Uses a bridge shared by cy3240d
+ *
+ * The calls mirror cy3240.h but run on a bridge held open by a server,
+ * see cy3240_server.h. Many processes can use the same bridge at once.
+ * Transfers from different clients are merged by the server, so short
+ * transfers from many processes cost little more bus time than one
+ * process doing them all. A client can be used from many threads, the
+ * requests are sent one at a time.
+ *
+ * High rate clients call cy3240_client_map() once. Transfers then go
+ * through rings in memory shared with the server instead of the socket,
+ * and published samples can be received with cy3240_client_wait_sample().
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_CLIENT_H
+#define INCLUSION_GUARD_CY3240_CLIENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+#include "cy3240_scheduler.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Opaque client state
+ */
+typedef struct Cy3240_Client_s Cy3240_Client_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to connect to a server and select a bridge
+ *
+ *  @param ppClient [out] the new client
+ *  @param pPath    [in] the socket path, NULL for CY3240_PROTOCOL_DEFAULT_PATH
+ *  @param pSerial  [in] the serial number of the bridge, NULL for the first
+ *  @returns CY3240_ERROR_HID if the server cannot be reached or does not
+ *           share the bridge
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_open(
+        Cy3240_Client_t** ppClient,
+        const char* pPath,
+        const char* pSerial
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to switch transfers to rings in memory shared with the server.
+ *  The client wakes the server only when it sleeps, so back to back
+ *  transfers cost no system call. Writes, reads and statistics keep using
+ *  the socket.
+ *
+ *  @param pClient   [in] the client
+ *  @param subscribe [in] receive the samples the server publishes
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_map(
+        Cy3240_Client_t* const pClient,
+        bool subscribe
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to disconnect and free a client
+ *
+ *  @param pClient [in] the client
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_close(
+        Cy3240_Client_t* const pClient
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to write data to a device, see cy3240_write()
+ *
+ *  @param pClient [in] the client
+ *  @param address [in] the I2C Address of the device
+ *  @param pData   [in] the data to write
+ *  @param pLength [in] the length of the data
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_write(
+        Cy3240_Client_t* const pClient,
+        uint8_t address,
+        const uint8_t* const pData,
+        uint16_t* const pLength
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read data from a device, see cy3240_read()
+ *
+ *  @param pClient [in] the client
+ *  @param address [in] the I2C Address of the device
+ *  @param pData   [out] the data read from the device
+ *  @param pLength [in,out] the length to read, the length read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_read(
+        Cy3240_Client_t* const pClient,
+        uint8_t address,
+        uint8_t* const pData,
+        uint16_t* const pLength
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a list of single packet operations, see cy3240_transfer().
+ *  Lists longer than CY3240_PROTOCOL_MAX_OPS are sent as several requests.
+ *
+ *  @param pClient [in] the client
+ *  @param pOps    [in,out] the operations
+ *  @param count   [in] the number of operations
+ *  @returns the first HID error, the per operation result is in each op
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_transfer(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Op_t* const pOps,
+        uint16_t count
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the statistics of the bridge, see cy3240_get_stats()
+ *
+ *  @param pClient [in] the client
+ *  @param pStats  [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_get_stats(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to take the oldest published sample, see cy3240_server_publish().
+ *  Only one thread may wait for samples.
+ *
+ *  @param pClient    [in] the client, mapped with a subscription
+ *  @param pSample    [out] the sample
+ *  @param timeout_ms [in] the longest time to wait in milliseconds
+ *  @returns CY3240_ERROR_TIMEOUT if no sample arrived
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_client_wait_sample(
+        Cy3240_Client_t* const pClient,
+        Cy3240_Sample_t* const pSample,
+        uint32_t timeout_ms
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the number of samples lost because the client did not
+ *  take them in time
+ *
+ *  @param pClient [in] the client
+ *  @returns the number of samples lost
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+cy3240_client_get_dropped(
+        Cy3240_Client_t* const pClient
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_CLIENT_H
@@ -181,13 +181,13 @@ cy3240_debug_print_receive_control_packet(
 
         printf("\nReceived packet: (Length=%i)", length);
 
-        if (packet[0] & 0x04)
+        if (packet[0] & STATUS_BYTE_POWERED)
             printf("\nThe device is powered");
 
         else
             printf("\nThe device is not powered");
 
-        if (packet[0] & 0x02)
+        if (packet[0] & STATUS_BYTE_INTERRUPT)
             printf("\nAn interrupt was received");
 
         for (count = 0; count < length; count ++) {
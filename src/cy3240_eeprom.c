@@ -0,0 +1,483 @@
+/**
+ * @file cy3240_eeprom.c
+ *
+ * @brief 24Cxx EEPROM programmer for the CY3240 bridge
+ *
+ * 24Cxx EEPROM programmer for the CY3240 bridge
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_packet.h"
+#include "cy3240_util.h"
+#include "cy3240_eeprom.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Packets read per transfer, after the address write
+ */
+#define EEPROM_READ_BATCH   (16)
+
+/**
+ * Largest read of one transfer
+ */
+#define EEPROM_READ_CHUNK   (EEPROM_READ_BATCH * CY3240_MAX_READ_BYTES)
+
+/**
+ * Probes sent per ACK polling transfer
+ */
+#define EEPROM_POLL_BATCH   (CY3240_PIPELINE_DEPTH_DEFAULT)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to check the EEPROM geometry and the range of an access
+ *
+ * @param pEeprom [in] the EEPROM geometry
+ * @param offset  [in] the first byte
+ * @param length  [in] the number of bytes
+ * @return true if the access is valid
+ */
+//-----------------------------------------------------------------------------
+static bool
+valid_access(
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint32_t length
+        )
+{
+    return (pEeprom != NULL) &&
+           ((pEeprom->address_width == 1) || (pEeprom->address_width == 2)) &&
+           (pEeprom->page_size != 0) &&
+           (pEeprom->page_size <= CY3240_EEPROM_MAX_PAGE) &&
+           ((pEeprom->page_size & (pEeprom->page_size - 1)) == 0) &&
+           (length != 0) &&
+           (offset < pEeprom->size) &&
+           (length <= pEeprom->size - offset);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to get the number of bytes the memory address can reach before the
+ * block bits in the device address have to change
+ *
+ * @param pEeprom [in] the EEPROM geometry
+ * @return the block size in bytes
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+block_size(
+        const Cy3240_Eeprom_t* const pEeprom
+        )
+{
+    return 1UL << (8 * pEeprom->address_width);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to pack the device and memory address of an offset
+ *
+ * @param pEeprom [in] the EEPROM geometry
+ * @param offset  [in] the offset in the part
+ * @param pBuffer [out] the memory address bytes, most significant first
+ * @return the I2C address including the block bits
+ */
+//-----------------------------------------------------------------------------
+static uint8_t
+pack_address(
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint8_t* const pBuffer
+        )
+{
+    if (pEeprom->address_width == 2) {
+        pBuffer[0] = (uint8_t)(offset >> 8);
+        pBuffer[1] = (uint8_t)offset;
+
+    } else {
+        pBuffer[0] = (uint8_t)offset;
+    }
+
+    return pEeprom->address | ((offset / block_size(pEeprom)) & 0x07);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to wait for the end of a write cycle. The part does not acknowledge
+ * its address while it is busy, so batches of probes are sent until one of
+ * them is acknowledged.
+ *
+ * @param handle  [in] the handle to the bridge controller
+ * @param pEeprom [in] the EEPROM geometry
+ * @param address [in] the I2C address that was written
+ * @return Cy3240_Error_t, CY3240_ERROR_TIMEOUT if the part stayed busy
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+ack_poll(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint8_t address
+        )
+{
+    const uint32_t timeout = (pEeprom->poll_timeout_us != 0) ?
+                             pEeprom->poll_timeout_us :
+                             CY3240_EEPROM_POLL_TIMEOUT_US;
+    const uint64_t deadline = cy3240_util_time_us() + timeout;
+
+    Cy3240_Op_t ops[EEPROM_POLL_BATCH];
+    int x;
+
+    do {
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+
+        memset(ops, 0x00, sizeof(ops));
+
+        for (x = 0; x < EEPROM_POLL_BATCH; x++) {
+            ops[x].type = CY3240_OP_PROBE;
+            ops[x].address = address;
+        }
+
+        result = cy3240_transfer(
+                handle,
+                ops,
+                EEPROM_POLL_BATCH);
+
+        if CY3240_FAILURE(result)
+            return result;
+
+        for (x = 0; x < EEPROM_POLL_BATCH; x++)
+            if CY3240_SUCCESS(ops[x].result)
+                return CY3240_ERROR_OK;
+
+    } while (cy3240_util_time_us() < deadline);
+
+    return CY3240_ERROR_TIMEOUT;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to write data that does not cross a page and wait for the write
+ * cycle. When the page fits in one packet the first probes are sent in the
+ * same transfer as the data.
+ *
+ * @param handle  [in] the handle to the bridge controller
+ * @param pEeprom [in] the EEPROM geometry
+ * @param offset  [in] the first byte to write
+ * @param pData   [in] the data to write
+ * @param length  [in] the number of bytes to write
+ * @return Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+write_page(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        const uint8_t* const pData,
+        uint16_t length
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint8_t buffer[2 + CY3240_EEPROM_MAX_PAGE];
+    uint16_t total = pEeprom->address_width + length;
+    uint8_t address;
+    bool ready = false;
+
+    address = pack_address(
+            pEeprom,
+            offset,
+            buffer);
+
+    memcpy(&buffer[pEeprom->address_width], pData, length);
+
+    if (total <= CY3240_MAX_WRITE_BYTES) {
+
+        Cy3240_Op_t ops[1 + EEPROM_POLL_BATCH];
+        int x;
+
+        memset(ops, 0x00, sizeof(ops));
+
+        ops[0].type = CY3240_OP_WRITE;
+        ops[0].address = address;
+        ops[0].pData = buffer;
+        ops[0].length = total;
+
+        for (x = 1; x <= EEPROM_POLL_BATCH; x++) {
+            ops[x].type = CY3240_OP_PROBE;
+            ops[x].address = address;
+        }
+
+        result = cy3240_transfer(
+                handle,
+                ops,
+                1 + EEPROM_POLL_BATCH);
+
+        if CY3240_SUCCESS(result)
+            result = ops[0].result;
+
+        for (x = 1; CY3240_SUCCESS(result) && (x <= EEPROM_POLL_BATCH); x++)
+            if CY3240_SUCCESS(ops[x].result)
+                ready = true;
+
+    } else {
+
+        // Large pages need a multi packet write
+        result = cy3240_write(
+                handle,
+                address,
+                buffer,
+                &total);
+    }
+
+    if CY3240_FAILURE(result)
+        printf("Failed to write EEPROM page at 0x%06x\n", offset);
+
+    else if (!ready)
+        result = ack_poll(
+                handle,
+                pEeprom,
+                address);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to read data that does not cross a block. The memory address is
+ * set once and the part then streams out consecutive bytes, so all the read
+ * packets go through one pipelined transfer.
+ *
+ * @param handle  [in] the handle to the bridge controller
+ * @param pEeprom [in] the EEPROM geometry
+ * @param offset  [in] the first byte to read
+ * @param pData   [out] the data read
+ * @param length  [in] the number of bytes, at most EEPROM_READ_CHUNK
+ * @return Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+read_chunk(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint8_t* const pData,
+        uint32_t length
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Op_t ops[1 + EEPROM_READ_BATCH];
+    uint8_t buffer[2];
+    uint16_t count = 1;
+    uint32_t done = 0;
+    int x;
+
+    memset(ops, 0x00, sizeof(ops));
+
+    // Set the memory address
+    ops[0].type = CY3240_OP_WRITE;
+    ops[0].address = pack_address(pEeprom, offset, buffer);
+    ops[0].pData = buffer;
+    ops[0].length = pEeprom->address_width;
+
+    // Sequential reads from there
+    while (done < length) {
+        ops[count].type = CY3240_OP_READ;
+        ops[count].address = ops[0].address;
+        ops[count].pData = &pData[done];
+        ops[count].length = MIN(length - done, CY3240_MAX_READ_BYTES);
+        done += ops[count].length;
+        count++;
+    }
+
+    result = cy3240_transfer(
+            handle,
+            ops,
+            count);
+
+    for (x = 0; CY3240_SUCCESS(result) && (x < count); x++)
+        result = ops[x].result;
+
+    if CY3240_FAILURE(result)
+        printf("Failed to read EEPROM at 0x%06x\n", offset);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to get the length of the next read that stays in one block
+ *
+ * @param pEeprom [in] the EEPROM geometry
+ * @param offset  [in] the next byte to read
+ * @param left    [in] the number of bytes left
+ * @return the number of bytes to read
+ */
+//-----------------------------------------------------------------------------
+static uint32_t
+chunk_length(
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint32_t left
+        )
+{
+    uint32_t block = block_size(pEeprom) - (offset % block_size(pEeprom));
+
+    return MIN(MIN(left, block), EEPROM_READ_CHUNK);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_write(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        const uint8_t* const pData,
+        uint32_t length
+        )
+{
+    if ((pData != NULL) &&
+        valid_access(pEeprom, offset, length)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint32_t done = 0;
+
+        while (CY3240_SUCCESS(result) && (done < length)) {
+
+            // Never cross a page, the part would wrap around in the page
+            uint32_t page = pEeprom->page_size - ((offset + done) % pEeprom->page_size);
+            uint16_t chunk = MIN(length - done, page);
+
+            result = write_page(
+                    handle,
+                    pEeprom,
+                    offset + done,
+                    &pData[done],
+                    chunk);
+
+            done += chunk;
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_read(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint8_t* const pData,
+        uint32_t length
+        )
+{
+    if ((pData != NULL) &&
+        valid_access(pEeprom, offset, length)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint32_t done = 0;
+
+        while (CY3240_SUCCESS(result) && (done < length)) {
+
+            uint32_t chunk = chunk_length(pEeprom, offset + done, length - done);
+
+            result = read_chunk(
+                    handle,
+                    pEeprom,
+                    offset + done,
+                    &pData[done],
+                    chunk);
+
+            done += chunk;
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_verify(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        const uint8_t* const pData,
+        uint32_t length,
+        uint32_t* const pMismatch
+        )
+{
+    if ((pData != NULL) &&
+        (pMismatch != NULL) &&
+        valid_access(pEeprom, offset, length)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint8_t buffer[EEPROM_READ_CHUNK];
+        uint32_t done = 0;
+
+        *pMismatch = offset + length;
+
+        while (CY3240_SUCCESS(result) && (done < length)) {
+
+            uint32_t chunk = chunk_length(pEeprom, offset + done, length - done);
+            uint32_t x;
+
+            result = read_chunk(
+                    handle,
+                    pEeprom,
+                    offset + done,
+                    buffer,
+                    chunk);
+
+            // Compare the chunk while it is still hot in the cache
+            if (CY3240_SUCCESS(result) &&
+                (memcmp(buffer, &pData[done], chunk) != 0)) {
+
+                for (x = 0; buffer[x] == pData[done + x]; x++)
+                    ;
+
+                *pMismatch = offset + done + x;
+                result = CY3240_ERROR_RX;
+            }
+
+            done += chunk;
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
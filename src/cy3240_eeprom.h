@@ -0,0 +1,138 @@
+/**
+ * @file cy3240_eeprom.h
+ *
+ * @brief 24Cxx EEPROM programmer for the CY3240 bridge
+ *
+ * Writes images to serial EEPROMs one page at a time. Writes are split on
+ * page boundaries, and the end of each write cycle is found by polling for
+ * the address ACK instead of sleeping. Reads and the verify pass stream the
+ * data through pipelined sequential reads.
+ *
+ * Parts with a one byte memory address and more than 256 bytes (24C04 to
+ * 24C16) carry the upper address bits in the device address, and so do
+ * parts with more than 64K and a two byte address. The programmer selects
+ * the block from the offset.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_EEPROM_H
+#define INCLUSION_GUARD_CY3240_EEPROM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_EEPROM_POLL_TIMEOUT_US  (10000)   ///< Default longest write cycle
+#define CY3240_EEPROM_MAX_PAGE         (256)     ///< Largest supported page size
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * EEPROM geometry
+ */
+typedef struct {
+    uint8_t address;                           ///< I2C address of the part, block bits clear
+    uint8_t address_width;                     ///< Bytes of memory address, 1 or 2
+    uint16_t page_size;                        ///< Write page size in bytes, power of two
+    uint32_t size;                             ///< Size of the part in bytes
+    uint32_t poll_timeout_us;                  ///< Longest write cycle, 0 for the default
+} Cy3240_Eeprom_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to program data in to the EEPROM
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param pEeprom [in] the EEPROM geometry
+ *  @param offset  [in] the first byte to write
+ *  @param pData   [in] the data to write
+ *  @param length  [in] the number of bytes to write
+ *  @returns Cy3240_Error_t, CY3240_ERROR_TIMEOUT if a write cycle did not end
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_write(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        const uint8_t* const pData,
+        uint32_t length
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read data from the EEPROM
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param pEeprom [in] the EEPROM geometry
+ *  @param offset  [in] the first byte to read
+ *  @param pData   [out] the data read
+ *  @param length  [in] the number of bytes to read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_read(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        uint8_t* const pData,
+        uint32_t length
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to compare the EEPROM contents with an image
+ *
+ *  @param handle    [in] the handle to the bridge controller
+ *  @param pEeprom   [in] the EEPROM geometry
+ *  @param offset    [in] the first byte to compare
+ *  @param pData     [in] the expected data
+ *  @param length    [in] the number of bytes to compare
+ *  @param pMismatch [out] offset of the first difference, or offset + length
+ *  @returns Cy3240_Error_t, CY3240_ERROR_RX if the contents differ
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_eeprom_verify(
+        int handle,
+        const Cy3240_Eeprom_t* const pEeprom,
+        uint32_t offset,
+        const uint8_t* const pData,
+        uint32_t length,
+        uint32_t* const pMismatch
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_EEPROM_H
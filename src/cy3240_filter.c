@@ -0,0 +1,602 @@
+/**
+ * @file cy3240_filter.c
+ *
+ * @brief Host side baseline and threshold processing of raw touch frames
+ *
+ * Host side baseline and threshold processing of raw touch frames
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cy3240.h"
+#include "cy3240_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_X86
+#endif
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Sensors are processed in blocks of this size by every implementation,
+ * the state arrays and frames hold a whole number of blocks
+ */
+#define FILTER_BLOCK   (16)
+
+/**
+ * Saturating unsigned subtraction
+ */
+#define SUBS(a, b)     ((uint16_t)(((a) > (b)) ? ((a) - (b)) : 0))
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Per sensor state, one array per field so blocks of sensors can be
+ * loaded in to vector registers
+ */
+struct Cy3240_Filter_s {
+    uint16_t sensors;                          ///< Sensors per frame
+    uint16_t blocks;                           ///< Blocks of FILTER_BLOCK sensors
+    bool primed;                               ///< Baselines hold a frame
+    Cy3240_Filter_Isa_t isa;                   ///< Selected implementation
+
+    uint16_t on;                               ///< Finger threshold
+    uint16_t off;                              ///< Finger threshold less the hysteresis
+    uint16_t noise;                            ///< Noise threshold
+    uint16_t negative;                         ///< Negative noise threshold
+    uint16_t update;                           ///< Baseline update threshold
+    uint16_t reset;                            ///< Low baseline reset count
+    uint16_t debounce;                         ///< Debounce count
+
+    uint16_t baseline[CY3240_STREAM_MAX_SENSORS]; ///< Baseline of each sensor
+    uint16_t bucket[CY3240_STREAM_MAX_SENSORS];   ///< Signal collected towards the next baseline step
+    uint16_t low[CY3240_STREAM_MAX_SENSORS];      ///< Frames far below the baseline
+    uint16_t count[CY3240_STREAM_MAX_SENSORS];    ///< Frames above the detection threshold
+    uint16_t active[CY3240_STREAM_MAX_SENSORS];   ///< 0xFFFF while touched
+};
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Reference implementation, one sensor at a time
+ *
+ *  @param pFilter [in] the filter
+ *  @param pFrame  [in,out] the frame
+ */
+//-----------------------------------------------------------------------------
+static void
+process_scalar(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Frame_t* const pFrame
+        )
+{
+    uint16_t x;
+
+    for (x = 0; x < pFilter->blocks * FILTER_BLOCK; x++) {
+
+        const uint16_t raw = pFrame->raw[x];
+        uint16_t baseline = pFilter->baseline[x];
+        const uint16_t signal = SUBS(raw, baseline);
+        const uint16_t below = SUBS(baseline, raw);
+        bool active = pFilter->active[x] != 0;
+        bool candidate;
+
+        // Detection with hysteresis and debounce
+        candidate = signal > (active ? pFilter->off : pFilter->on);
+
+        pFilter->count[x] = candidate ? (pFilter->count[x] == 0xFFFF ? 0xFFFF : pFilter->count[x] + 1) : 0;
+        active = candidate && (active || (pFilter->count[x] >= pFilter->debounce));
+        pFilter->active[x] = active ? 0xFFFF : 0x0000;
+
+        if (active) {
+            pFrame->touched[x >> 3] |= 1 << (x & 0x07);
+            pFilter->low[x] = 0;
+
+        } else if (signal > pFilter->noise) {
+            pFrame->noisy[x >> 3] |= 1 << (x & 0x07);
+            pFilter->low[x] = 0;
+
+        } else if (signal != 0) {
+
+            // Collect small signals until the baseline can move up
+            pFilter->bucket[x] = (pFilter->bucket[x] + signal > 0xFFFF) ? 0xFFFF : pFilter->bucket[x] + signal;
+            pFilter->low[x] = 0;
+
+            if (pFilter->bucket[x] >= pFilter->update) {
+                baseline++;
+                pFilter->bucket[x] = 0;
+            }
+
+        } else if (below > pFilter->negative) {
+
+            // Far below, reset once it stays there
+            pFilter->low[x] = (pFilter->low[x] == 0xFFFF) ? 0xFFFF : pFilter->low[x] + 1;
+
+            if (pFilter->low[x] >= pFilter->reset) {
+                baseline = raw;
+                pFilter->low[x] = 0;
+            }
+
+        } else if (below != 0) {
+            baseline--;
+            pFilter->low[x] = 0;
+
+        } else {
+            pFilter->low[x] = 0;
+        }
+
+        pFilter->baseline[x] = baseline;
+        pFrame->signal[x] = signal;
+    }
+}
+
+#ifdef FILTER_X86
+
+//-----------------------------------------------------------------------------
+/**
+ *  SSE2 implementation, 8 sensors per vector and one block per pass. The
+ *  unsigned compares use a > b when the saturated a - b is not zero.
+ *
+ *  @param pFilter [in] the filter
+ *  @param pFrame  [in,out] the frame
+ */
+//-----------------------------------------------------------------------------
+__attribute__((target("sse2")))
+static void
+process_sse2(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Frame_t* const pFrame
+        )
+{
+#define GT(a, b)        _mm_andnot_si128(_mm_cmpeq_epi16(_mm_subs_epu16(a, b), zero), ones)
+#define GE(a, b)        _mm_cmpeq_epi16(_mm_subs_epu16(b, a), zero)
+#define SEL(m, a, b)    _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#define LOAD(p)         _mm_loadu_si128((const __m128i*)(p))
+#define STORE(p, v)     _mm_storeu_si128((__m128i*)(p), v)
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i on = _mm_set1_epi16(pFilter->on);
+    const __m128i off = _mm_set1_epi16(pFilter->off);
+    const __m128i noise = _mm_set1_epi16(pFilter->noise);
+    const __m128i negative = _mm_set1_epi16(pFilter->negative);
+    const __m128i update = _mm_set1_epi16(pFilter->update);
+    const __m128i reset = _mm_set1_epi16(pFilter->reset);
+    const __m128i debounce = _mm_set1_epi16(pFilter->debounce);
+    uint16_t x;
+    uint16_t y;
+
+    for (x = 0; x < pFilter->blocks * FILTER_BLOCK; x += FILTER_BLOCK) {
+
+        __m128i touched[2];
+        __m128i noisy[2];
+
+        for (y = 0; y < 2; y++) {
+
+            const uint16_t i = x + 8 * y;
+            const __m128i raw = LOAD(&pFrame->raw[i]);
+            __m128i baseline = LOAD(&pFilter->baseline[i]);
+            __m128i bucket = LOAD(&pFilter->bucket[i]);
+            __m128i low = LOAD(&pFilter->low[i]);
+            __m128i count = LOAD(&pFilter->count[i]);
+            __m128i active = LOAD(&pFilter->active[i]);
+            const __m128i signal = _mm_subs_epu16(raw, baseline);
+            const __m128i below = _mm_subs_epu16(baseline, raw);
+            __m128i candidate;
+            __m128i idle;
+            __m128i quiet;
+            __m128i grow;
+            __m128i step;
+            __m128i far;
+            __m128i near;
+            __m128i drop;
+
+            // Detection with hysteresis and debounce
+            candidate = GT(signal, SEL(active, off, on));
+            count = _mm_and_si128(candidate, _mm_adds_epu16(count, one));
+            active = _mm_and_si128(candidate, _mm_or_si128(active, GE(count, debounce)));
+            idle = _mm_andnot_si128(active, ones);
+
+            noisy[y] = _mm_and_si128(idle, GT(signal, noise));
+            quiet = _mm_andnot_si128(noisy[y], idle);
+
+            // Collect small signals until the baseline can move up
+            grow = _mm_andnot_si128(_mm_cmpeq_epi16(signal, zero), quiet);
+            bucket = SEL(grow, _mm_adds_epu16(bucket, signal), bucket);
+            step = _mm_and_si128(grow, GE(bucket, update));
+            baseline = _mm_add_epi16(baseline, _mm_and_si128(step, one));
+            bucket = _mm_andnot_si128(step, bucket);
+
+            // Far below resets once it stays there, near below tracks down
+            far = _mm_and_si128(quiet, GT(below, negative));
+            near = _mm_andnot_si128(far, _mm_and_si128(quiet, GT(below, zero)));
+            low = _mm_and_si128(far, _mm_adds_epu16(low, one));
+            drop = _mm_and_si128(far, GE(low, reset));
+            baseline = SEL(drop, raw, baseline);
+            low = _mm_andnot_si128(drop, low);
+            baseline = _mm_sub_epi16(baseline, _mm_and_si128(near, one));
+
+            touched[y] = active;
+
+            STORE(&pFilter->baseline[i], baseline);
+            STORE(&pFilter->bucket[i], bucket);
+            STORE(&pFilter->low[i], low);
+            STORE(&pFilter->count[i], count);
+            STORE(&pFilter->active[i], active);
+            STORE(&pFrame->signal[i], signal);
+        }
+
+        // Narrow the lane masks to bytes, one bit per sensor
+        y = (uint16_t)_mm_movemask_epi8(_mm_packs_epi16(touched[0], touched[1]));
+        pFrame->touched[x >> 3] = (uint8_t)y;
+        pFrame->touched[(x >> 3) + 1] = (uint8_t)(y >> 8);
+
+        y = (uint16_t)_mm_movemask_epi8(_mm_packs_epi16(noisy[0], noisy[1]));
+        pFrame->noisy[x >> 3] = (uint8_t)y;
+        pFrame->noisy[(x >> 3) + 1] = (uint8_t)(y >> 8);
+    }
+
+#undef GT
+#undef GE
+#undef SEL
+#undef LOAD
+#undef STORE
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  AVX2 implementation, one block of 16 sensors per vector
+ *
+ *  @param pFilter [in] the filter
+ *  @param pFrame  [in,out] the frame
+ */
+//-----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static void
+process_avx2(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Frame_t* const pFrame
+        )
+{
+#define GT(a, b)        _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_subs_epu16(a, b), zero), ones)
+#define GE(a, b)        _mm256_cmpeq_epi16(_mm256_subs_epu16(b, a), zero)
+#define SEL(m, a, b)    _mm256_or_si256(_mm256_and_si256(m, a), _mm256_andnot_si256(m, b))
+#define LOAD(p)         _mm256_loadu_si256((const __m256i*)(p))
+#define STORE(p, v)     _mm256_storeu_si256((__m256i*)(p), v)
+#define MASK(v)         ((uint16_t)_mm_movemask_epi8(_mm_packs_epi16( \
+                                _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1))))
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(-1);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i on = _mm256_set1_epi16(pFilter->on);
+    const __m256i off = _mm256_set1_epi16(pFilter->off);
+    const __m256i noise = _mm256_set1_epi16(pFilter->noise);
+    const __m256i negative = _mm256_set1_epi16(pFilter->negative);
+    const __m256i update = _mm256_set1_epi16(pFilter->update);
+    const __m256i reset = _mm256_set1_epi16(pFilter->reset);
+    const __m256i debounce = _mm256_set1_epi16(pFilter->debounce);
+    uint16_t x;
+    uint16_t bits;
+
+    for (x = 0; x < pFilter->blocks * FILTER_BLOCK; x += FILTER_BLOCK) {
+
+        const __m256i raw = LOAD(&pFrame->raw[x]);
+        __m256i baseline = LOAD(&pFilter->baseline[x]);
+        __m256i bucket = LOAD(&pFilter->bucket[x]);
+        __m256i low = LOAD(&pFilter->low[x]);
+        __m256i count = LOAD(&pFilter->count[x]);
+        __m256i active = LOAD(&pFilter->active[x]);
+        const __m256i signal = _mm256_subs_epu16(raw, baseline);
+        const __m256i below = _mm256_subs_epu16(baseline, raw);
+        __m256i candidate;
+        __m256i idle;
+        __m256i noisy;
+        __m256i quiet;
+        __m256i grow;
+        __m256i step;
+        __m256i far;
+        __m256i near;
+        __m256i drop;
+
+        // Same steps as the SSE2 version
+        candidate = GT(signal, SEL(active, off, on));
+        count = _mm256_and_si256(candidate, _mm256_adds_epu16(count, one));
+        active = _mm256_and_si256(candidate, _mm256_or_si256(active, GE(count, debounce)));
+        idle = _mm256_andnot_si256(active, ones);
+
+        noisy = _mm256_and_si256(idle, GT(signal, noise));
+        quiet = _mm256_andnot_si256(noisy, idle);
+
+        grow = _mm256_andnot_si256(_mm256_cmpeq_epi16(signal, zero), quiet);
+        bucket = SEL(grow, _mm256_adds_epu16(bucket, signal), bucket);
+        step = _mm256_and_si256(grow, GE(bucket, update));
+        baseline = _mm256_add_epi16(baseline, _mm256_and_si256(step, one));
+        bucket = _mm256_andnot_si256(step, bucket);
+
+        far = _mm256_and_si256(quiet, GT(below, negative));
+        near = _mm256_andnot_si256(far, _mm256_and_si256(quiet, GT(below, zero)));
+        low = _mm256_and_si256(far, _mm256_adds_epu16(low, one));
+        drop = _mm256_and_si256(far, GE(low, reset));
+        baseline = SEL(drop, raw, baseline);
+        low = _mm256_andnot_si256(drop, low);
+        baseline = _mm256_sub_epi16(baseline, _mm256_and_si256(near, one));
+
+        STORE(&pFilter->baseline[x], baseline);
+        STORE(&pFilter->bucket[x], bucket);
+        STORE(&pFilter->low[x], low);
+        STORE(&pFilter->count[x], count);
+        STORE(&pFilter->active[x], active);
+        STORE(&pFrame->signal[x], signal);
+
+        bits = MASK(active);
+        pFrame->touched[x >> 3] = (uint8_t)bits;
+        pFrame->touched[(x >> 3) + 1] = (uint8_t)(bits >> 8);
+
+        bits = MASK(noisy);
+        pFrame->noisy[x >> 3] = (uint8_t)bits;
+        pFrame->noisy[(x >> 3) + 1] = (uint8_t)(bits >> 8);
+    }
+
+#undef GT
+#undef GE
+#undef SEL
+#undef LOAD
+#undef STORE
+#undef MASK
+}
+
+#endif // FILTER_X86
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check whether the processor has an implementation
+ *
+ *  @param isa [in] the implementation
+ *  @returns true if it can be used
+ */
+//-----------------------------------------------------------------------------
+static bool
+isa_supported(
+        Cy3240_Filter_Isa_t isa
+        )
+{
+    switch (isa) {
+
+        case CY3240_FILTER_ISA_SCALAR:
+            return true;
+
+#ifdef FILTER_X86
+        case CY3240_FILTER_ISA_SSE2:
+            return __builtin_cpu_supports("sse2");
+
+        case CY3240_FILTER_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+
+        default:
+            return false;
+    }
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_create(
+        Cy3240_Filter_t** ppFilter,
+        uint16_t sensors,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        )
+{
+    if ((ppFilter != NULL) &&
+        (sensors != 0) &&
+        (sensors <= CY3240_STREAM_MAX_SENSORS) &&
+        (pTuning != NULL)) {
+
+        Cy3240_Filter_t* pFilter = (Cy3240_Filter_t*)calloc(1, sizeof(Cy3240_Filter_t));
+
+        if (pFilter == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        pFilter->sensors = sensors;
+        pFilter->blocks = (sensors + FILTER_BLOCK - 1) / FILTER_BLOCK;
+
+        // Use the widest implementation the processor has
+        pFilter->isa = CY3240_FILTER_ISA_AVX2;
+
+        while (!isa_supported(pFilter->isa))
+            pFilter->isa--;
+
+        cy3240_filter_set_tuning(pFilter, pTuning);
+
+        *ppFilter = pFilter;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_set_tuning(
+        Cy3240_Filter_t* const pFilter,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        )
+{
+    if ((pFilter != NULL) &&
+        (pTuning != NULL)) {
+
+        pFilter->on = pTuning->finger_threshold;
+        pFilter->off = SUBS(pTuning->finger_threshold, pTuning->hysteresis);
+        pFilter->noise = pTuning->noise_threshold;
+        pFilter->negative = pTuning->negative_noise_threshold;
+        pFilter->update = pTuning->baseline_update_threshold;
+        pFilter->reset = pTuning->low_baseline_reset;
+        pFilter->debounce = pTuning->debounce;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_set_isa(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Filter_Isa_t isa
+        )
+{
+    if ((pFilter != NULL) &&
+        isa_supported(isa)) {
+
+        pFilter->isa = isa;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_reset(
+        Cy3240_Filter_t* const pFilter
+        )
+{
+    if (pFilter != NULL) {
+
+        pFilter->primed = false;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_process(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Frame_t* const pFrame
+        )
+{
+    if ((pFilter != NULL) &&
+        (pFrame != NULL) &&
+        (pFrame->count == pFilter->sensors)) {
+
+        const uint16_t padded = pFilter->blocks * FILTER_BLOCK;
+        uint16_t x;
+
+        pFrame->touches = 0;
+        memset(pFrame->touched, 0x00, sizeof(pFrame->touched));
+        memset(pFrame->noisy, 0x00, sizeof(pFrame->noisy));
+
+        if CY3240_FAILURE(pFrame->result)
+            return CY3240_ERROR_OK;
+
+        // The sensors past the end of the last block are never reported
+        memset(&pFrame->raw[pFilter->sensors], 0x00, (padded - pFilter->sensors) * sizeof(uint16_t));
+
+        // The first frame is the baseline
+        if (!pFilter->primed) {
+            memcpy(pFilter->baseline, pFrame->raw, padded * sizeof(uint16_t));
+            memset(pFilter->bucket, 0x00, sizeof(pFilter->bucket));
+            memset(pFilter->low, 0x00, sizeof(pFilter->low));
+            memset(pFilter->count, 0x00, sizeof(pFilter->count));
+            memset(pFilter->active, 0x00, sizeof(pFilter->active));
+            pFilter->primed = true;
+        }
+
+        switch (pFilter->isa) {
+
+#ifdef FILTER_X86
+            case CY3240_FILTER_ISA_AVX2:
+                process_avx2(pFilter, pFrame);
+                break;
+
+            case CY3240_FILTER_ISA_SSE2:
+                process_sse2(pFilter, pFrame);
+                break;
+#endif
+
+            default:
+                process_scalar(pFilter, pFrame);
+                break;
+        }
+
+        for (x = 0; x < padded / 8; x++)
+            pFrame->touches += __builtin_popcount(pFrame->touched[x]);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_get_baseline(
+        Cy3240_Filter_t* const pFilter,
+        uint16_t* const pBaseline
+        )
+{
+    if ((pFilter != NULL) &&
+        (pBaseline != NULL)) {
+
+        memcpy(pBaseline, pFilter->baseline, pFilter->sensors * sizeof(uint16_t));
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_destroy(
+        Cy3240_Filter_t* const pFilter
+        )
+{
+    if (pFilter != NULL) {
+
+        free(pFilter);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
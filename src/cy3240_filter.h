@@ -0,0 +1,180 @@
+/**
+ * @file cy3240_filter.h
+ *
+ * @brief Host side baseline and threshold processing of raw touch frames
+ *
+ * Tracks a baseline for every sensor of a touch controller and reports the
+ * signal above it, the sensors that cross the finger threshold and the ones
+ * that are only above the noise threshold. The rules follow the tuning
+ * parameters of the controller firmware:
+ *
+ * - A sensor turns on when the signal is above the finger threshold for
+ *   debounce frames in a row, and turns off when it falls to the finger
+ *   threshold less the hysteresis.
+ * - While a sensor is off, signals up to the noise threshold are added to
+ *   a bucket and the baseline moves up one count every time the bucket
+ *   reaches the baseline update threshold.
+ * - Raw counts below the baseline move it down one count per frame. When
+ *   they are more than the negative noise threshold below it for low
+ *   baseline reset frames, the baseline is reset to the raw count.
+ *
+ * All sensors are processed together with SSE2 or AVX2 when the processor
+ * has them, and with a scalar loop otherwise. Every implementation gives
+ * the same results.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_FILTER_H
+#define INCLUSION_GUARD_CY3240_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+#include "cy3240_touch.h"
+#include "cy3240_stream.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Implementations of the processing
+ */
+typedef enum {
+    CY3240_FILTER_ISA_SCALAR = 0,              ///< Portable C
+    CY3240_FILTER_ISA_SSE2,                    ///< 8 sensors per instruction
+    CY3240_FILTER_ISA_AVX2,                    ///< 16 sensors per instruction
+} Cy3240_Filter_Isa_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to create a filter. The baseline is taken from the first
+ *  frame processed.
+ *
+ *  @param ppFilter [out] the new filter
+ *  @param sensors  [in] the number of sensors per frame
+ *  @param pTuning  [in] the tuning parameters
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_create(
+        Cy3240_Filter_t** ppFilter,
+        uint16_t sensors,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to change the tuning parameters
+ *
+ *  @param pFilter [in] the filter
+ *  @param pTuning [in] the tuning parameters
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_set_tuning(
+        Cy3240_Filter_t* const pFilter,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to select the implementation, by default the fastest one the
+ *  processor supports is used
+ *
+ *  @param pFilter [in] the filter
+ *  @param isa     [in] the implementation
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS if the processor lacks it
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_set_isa(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Filter_Isa_t isa
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to forget the baselines, the next frame becomes the baseline
+ *
+ *  @param pFilter [in] the filter
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_reset(
+        Cy3240_Filter_t* const pFilter
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to process a frame. Fills in the signal, touched, noisy and
+ *  touches fields of the frame. Failed frames report no touches and leave
+ *  the baselines alone.
+ *
+ *  @param pFilter [in] the filter
+ *  @param pFrame  [in,out] the frame
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_process(
+        Cy3240_Filter_t* const pFilter,
+        Cy3240_Frame_t* const pFrame
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the current baselines
+ *
+ *  @param pFilter   [in] the filter
+ *  @param pBaseline [out] one baseline per sensor
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_get_baseline(
+        Cy3240_Filter_t* const pFilter,
+        uint16_t* const pBaseline
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to free a filter
+ *
+ *  @param pFilter [in] the filter
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_filter_destroy(
+        Cy3240_Filter_t* const pFilter
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_FILTER_H
@@ -0,0 +1,235 @@
+/**
+ * @file cy3240_handle.c
+ *
+ * @brief Handle table for the CY3240 bridge state
+ *
+ * Handle table for the CY3240 bridge state
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "cy3240_handle.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define INDEX_MASK  (CY3240_HANDLE_MAX - 1)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * A table slot
+ */
+typedef struct {
+    void* pState;                    ///< The state, NULL while the slot is free
+    uint32_t generation;             ///< Generation of the current or next handle
+    uint32_t users;                  ///< Lookups not put back yet
+    bool draining;                   ///< A release waits for the users to finish
+} Slot_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+static Slot_t slots[CY3240_HANDLE_MAX];
+
+// Free slot indexes, only used with the lock held
+static uint16_t free_slots[CY3240_HANDLE_MAX];
+static int free_count = 0;
+static bool initialized = false;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drained = PTHREAD_COND_INITIALIZER;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to split a handle
+ *
+ *  @param handle      [in] the handle
+ *  @param pIndex      [out] the slot index
+ *  @param pGeneration [out] the generation
+ *  @returns true if the handle could have been allocated
+ */
+//-----------------------------------------------------------------------------
+static bool
+split_handle(
+        int handle,
+        int* const pIndex,
+        uint32_t* const pGeneration
+        )
+{
+    *pIndex = handle & INDEX_MASK;
+    *pGeneration = ((uint32_t)handle >> CY3240_HANDLE_INDEX_BITS) & CY3240_HANDLE_GEN_MASK;
+
+    return (handle > 0) && (*pGeneration != 0);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_handle_alloc(
+        void* const pState,
+        int* const pHandle
+        )
+{
+    if ((pState != NULL) &&
+        (pHandle != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_UNKNOWN;
+        int x;
+
+        pthread_mutex_lock(&lock);
+
+        // Lowest slots first, every generation starts at 1 so 0 is never a handle
+        if (!initialized) {
+            for (x = 0; x < CY3240_HANDLE_MAX; x++) {
+                free_slots[x] = CY3240_HANDLE_MAX - 1 - x;
+                slots[x].generation = 1;
+            }
+            free_count = CY3240_HANDLE_MAX;
+            initialized = true;
+        }
+
+        if (free_count > 0) {
+
+            int index = free_slots[--free_count];
+
+            // Publish the state before the handle can be used
+            __atomic_store_n(&slots[index].pState, pState, __ATOMIC_RELEASE);
+
+            *pHandle = (int)((slots[index].generation << CY3240_HANDLE_INDEX_BITS) | index);
+            result = CY3240_ERROR_OK;
+        }
+
+        pthread_mutex_unlock(&lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+void*
+cy3240_handle_get(
+        int handle
+        )
+{
+    uint32_t generation;
+    void* pState;
+    int index;
+
+    if (!split_handle(handle, &index, &generation))
+        return NULL;
+
+    if (__atomic_load_n(&slots[index].generation, __ATOMIC_ACQUIRE) != generation)
+        return NULL;
+
+    // Count the user first, a release from now on waits for the put
+    __atomic_add_fetch(&slots[index].users, 1, __ATOMIC_SEQ_CST);
+
+    pState = __atomic_load_n(&slots[index].pState, __ATOMIC_ACQUIRE);
+
+    // A release in between may have cleared or reused the slot
+    if ((pState == NULL) ||
+        (__atomic_load_n(&slots[index].generation, __ATOMIC_SEQ_CST) != generation)) {
+        cy3240_handle_put(handle);
+        return NULL;
+    }
+
+    return pState;
+}
+
+//-----------------------------------------------------------------------------
+void
+cy3240_handle_put(
+        int handle
+        )
+{
+    uint32_t generation;
+    int index;
+
+    if (!split_handle(handle, &index, &generation))
+        return;
+
+    // The last user wakes a release waiting for the slot
+    if ((__atomic_sub_fetch(&slots[index].users, 1, __ATOMIC_SEQ_CST) == 0) &&
+        __atomic_load_n(&slots[index].draining, __ATOMIC_SEQ_CST)) {
+
+        pthread_mutex_lock(&lock);
+        pthread_cond_broadcast(&drained);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_handle_release(
+        int handle
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_INVALID_PARAMETERS;
+    uint32_t generation;
+    int index;
+
+    if (!split_handle(handle, &index, &generation))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    pthread_mutex_lock(&lock);
+
+    if (initialized &&
+        (slots[index].generation == generation) &&
+        (slots[index].pState != NULL)) {
+
+        uint32_t next = (generation + 1) & CY3240_HANDLE_GEN_MASK;
+
+        __atomic_store_n(&slots[index].pState, NULL, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&slots[index].generation, (next != 0) ? next : 1, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&slots[index].draining, true, __ATOMIC_SEQ_CST);
+
+        // New lookups fail now, wait for the ones still using the state
+        while (__atomic_load_n(&slots[index].users, __ATOMIC_SEQ_CST) != 0)
+            pthread_cond_wait(&drained, &lock);
+
+        __atomic_store_n(&slots[index].draining, false, __ATOMIC_SEQ_CST);
+
+        free_slots[free_count++] = (uint16_t)index;
+        result = CY3240_ERROR_OK;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return result;
+}
+
+//@} End of Methods
@@ -0,0 +1,115 @@
+/**
+ * @file cy3240_handle.h
+ *
+ * @brief Handle table for the CY3240 bridge state
+ *
+ * Maps the int handles given to applications to the state of a bridge.
+ * A handle holds the index of a table slot and the generation of the slot
+ * when it was allocated. The generation is bumped when the handle is
+ * released, so a stale handle is rejected even once its slot is reused,
+ * and the handle never has to hold a pointer, which does not fit an int
+ * on 64 bit systems.
+ *
+ * Lookups do not take a lock. Every lookup that returns a state counts
+ * as a user of the slot until it is put back, and releasing a handle
+ * waits for those users, so the state can be freed once the release
+ * returns. Allocating and releasing take the table mutex.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_HANDLE_H
+#define INCLUSION_GUARD_CY3240_HANDLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_HANDLE_INDEX_BITS  (8)                                ///< Bits of the slot index
+#define CY3240_HANDLE_MAX         (1 << CY3240_HANDLE_INDEX_BITS)   ///< Handles open at once
+#define CY3240_HANDLE_GEN_MASK    (0x7FFFFF)                         ///< Generation bits, keeps handles positive
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to allocate a handle for a state
+ *
+ *  @param pState  [in] the state, not NULL
+ *  @param pHandle [out] the handle, never 0
+ *  @returns Cy3240_Error_t, CY3240_ERROR_UNKNOWN if the table is full
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_handle_alloc(
+        void* const pState,
+        int* const pHandle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to look up the state of a handle without taking a lock. A state
+ *  returned has to be given back with cy3240_handle_put.
+ *
+ *  @param handle [in] the handle
+ *  @returns the state, NULL if the handle is not valid or was released
+ */
+//-----------------------------------------------------------------------------
+void*
+cy3240_handle_get(
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to give back a state looked up with cy3240_handle_get
+ *
+ *  @param handle [in] the handle the state was looked up with
+ */
+//-----------------------------------------------------------------------------
+void
+cy3240_handle_put(
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to release a handle. Its slot can be reused, the handle itself
+ *  is never valid again. Blocks until every lookup of the handle was put
+ *  back, so the caller has to put its own first.
+ *
+ *  @param handle [in] the handle
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_handle_release(
+        int handle
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_HANDLE_H
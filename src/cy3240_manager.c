@@ -0,0 +1,1005 @@
+/**
+ * @file cy3240_manager.c
+ *
+ * @brief Hotplug aware manager for CY3240 bridges
+ *
+ * Hotplug aware manager for CY3240 bridges
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include "config.h"
+#include "cy3240.h"
+#include "cy3240_util.h"
+#include "cy3240_manager.h"
+
+#ifdef HAVE_LIBUDEV
+#include <poll.h>
+#include <libudev.h>
+#endif
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Longest wait for an event, bounds the time to stop the manager
+ */
+#define MANAGER_WAIT_MS            (100)
+
+/**
+ * A freshly plugged bridge may not accept the claim at once
+ */
+#define MANAGER_REATTACH_ATTEMPTS  (10)
+#define MANAGER_REATTACH_DELAY_US  (20000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * A bridge known to the manager
+ */
+typedef struct {
+    char serial[CY3240_SERIAL_MAX];            ///< Serial number, empty for a free entry
+    bool present;                              ///< The bridge is connected
+    char location[CY3240_LOCATION_MAX];        ///< USB bus and device, empty if unknown
+    int handle;                                ///< Handle opened through the manager, 0 for none
+    bool pending;                              ///< The handle waits to be reattached
+    bool busy;                                 ///< The handle is being reattached
+    uint16_t attempts;                         ///< Reattach attempts so far
+    uint64_t added_us;                         ///< Time the add event arrived
+    uint64_t retry_us;                         ///< Time of the next reattach attempt
+} Manager_Device_t;
+
+/**
+ * Manager state
+ */
+struct Cy3240_Manager_s {
+    Cy3240_Event_Source_t source;              ///< Enumeration and hotplug events
+    Cy3240_Device_Callback_t callback;         ///< Told about unplugged and reattached bridges
+    void* arg;                                 ///< Passed to the callback
+    Manager_Device_t devices[CY3240_MANAGER_MAX_DEVICES]; ///< Known bridges
+    volatile bool running;                     ///< Worker should keep running
+    pthread_t thread;                          ///< Worker thread
+    pthread_mutex_t lock;                      ///< Protects the devices and statistics
+    pthread_cond_t idle;                       ///< Signalled when a reattach ends
+    Cy3240_Manager_Stats_t stats;              ///< Statistics
+};
+
+#ifdef HAVE_LIBUDEV
+
+/**
+ * udev event source state. Remove events carry no sysfs attributes, so
+ * the serial number of every bridge seen is kept by device path.
+ */
+typedef struct {
+    struct udev* pUdev;                        ///< The udev library context
+    struct udev_monitor* pMonitor;             ///< Monitor of the USB devices
+    struct {
+        char path[256];                        ///< sysfs path of the device
+        char serial[CY3240_SERIAL_MAX];        ///< Serial number of the device
+    } known[CY3240_MANAGER_MAX_DEVICES];
+} Udev_Source_t;
+
+#endif
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to find a bridge, optionally adding it
+ *
+ *  @param pManager [in] the manager, locked
+ *  @param pSerial  [in] the serial number
+ *  @param add      [in] add the bridge if it is not known
+ *  @returns the device or NULL
+ */
+//-----------------------------------------------------------------------------
+static Manager_Device_t*
+find_device(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial,
+        bool add
+        )
+{
+    Manager_Device_t* pFree = NULL;
+    int x;
+
+    for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++) {
+
+        Manager_Device_t* const pDevice = &pManager->devices[x];
+
+        if (strcmp(pDevice->serial, pSerial) == 0)
+            return pDevice;
+
+        // Entries of bridges that are gone and not opened can be reused
+        if ((pFree == NULL) &&
+            ((pDevice->serial[0] == '\0') ||
+             (!pDevice->present && (pDevice->handle == 0))))
+            pFree = pDevice;
+    }
+
+    if (add && (pFree != NULL) && (strlen(pSerial) < CY3240_SERIAL_MAX)) {
+
+        memset(pFree, 0x00, sizeof(Manager_Device_t));
+        strcpy(pFree->serial, pSerial);
+
+        return pFree;
+    }
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to remember where a bridge is connected
+ *
+ *  @param pDevice   [in] the device, locked
+ *  @param pLocation [in] the USB bus and device, may be NULL
+ */
+//-----------------------------------------------------------------------------
+static void
+set_location(
+        Manager_Device_t* const pDevice,
+        const char* const pLocation
+        )
+{
+    if ((pLocation != NULL) && (strlen(pLocation) < CY3240_LOCATION_MAX))
+        strcpy(pDevice->location, pLocation);
+    else
+        pDevice->location[0] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to record a bridge found by the enumeration
+ *
+ *  @param arg       [in] the manager, locked
+ *  @param pSerial   [in] the serial number
+ *  @param pLocation [in] the USB bus and device, may be NULL
+ */
+//-----------------------------------------------------------------------------
+static void
+device_found(
+        void* arg,
+        const char* pSerial,
+        const char* pLocation
+        )
+{
+    Manager_Device_t* const pDevice = find_device(
+            (Cy3240_Manager_t*)arg,
+            pSerial,
+            true);
+
+    if (pDevice != NULL) {
+        pDevice->present = true;
+        set_location(pDevice, pLocation);
+    } else {
+        fprintf(stderr, "Too many bridges, %s is ignored\n", pSerial);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to apply a hotplug event
+ *
+ *  @param pManager [in] the manager
+ *  @param pEvent   [in] the event
+ */
+//-----------------------------------------------------------------------------
+static void
+handle_event(
+        Cy3240_Manager_t* const pManager,
+        const Cy3240_Device_Event_t* const pEvent
+        )
+{
+    Manager_Device_t* pDevice;
+    int removed = 0;
+
+    pthread_mutex_lock(&pManager->lock);
+
+    pManager->stats.events++;
+
+    pDevice = find_device(
+            pManager,
+            pEvent->serial,
+            pEvent->type == CY3240_DEVICE_ADDED);
+
+    if (pDevice != NULL) {
+
+        if (pEvent->type == CY3240_DEVICE_ADDED) {
+
+            pDevice->present = true;
+            set_location(pDevice, pEvent->location);
+
+            // Reattach the open handle from the manager thread
+            if (pDevice->handle != 0) {
+                pDevice->pending = true;
+                pDevice->attempts = 0;
+                pDevice->added_us = cy3240_util_time_us();
+                pDevice->retry_us = pDevice->added_us;
+            }
+
+        } else {
+
+            pDevice->present = false;
+            pDevice->pending = false;
+            pDevice->location[0] = '\0';
+
+            // The new bridge starts with the default settings
+            if (pDevice->handle != 0) {
+                cy3240_invalidate(pDevice->handle);
+                removed = pDevice->handle;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&pManager->lock);
+
+    if ((removed != 0) && (pManager->callback != NULL))
+        pManager->callback(
+                pManager->arg,
+                pEvent->serial,
+                removed,
+                CY3240_DEVICE_REMOVED,
+                CY3240_ERROR_HID);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to reattach the handles of bridges that were plugged in again
+ *
+ *  @param pManager [in] the manager
+ *  @returns the time in milliseconds until the next attempt is due
+ */
+//-----------------------------------------------------------------------------
+static int
+reattach_pending(
+        Cy3240_Manager_t* const pManager
+        )
+{
+    int wait = MANAGER_WAIT_MS;
+    int x;
+
+    for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++) {
+
+        Manager_Device_t* const pDevice = &pManager->devices[x];
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        char serial[CY3240_SERIAL_MAX];
+        char location[CY3240_LOCATION_MAX];
+        uint64_t now = cy3240_util_time_us();
+        uint64_t added;
+        bool report = false;
+        int handle = 0;
+
+        pthread_mutex_lock(&pManager->lock);
+
+        if (pDevice->pending && (now < pDevice->retry_us)) {
+
+            wait = MIN(wait, (int)((pDevice->retry_us - now + 999) / 1000));
+
+        } else if (pDevice->pending) {
+
+            handle = pDevice->handle;
+            added = pDevice->added_us;
+            strcpy(location, pDevice->location);
+
+            // The rebuild runs without the lock, closing the handle waits
+            // for it instead
+            pDevice->busy = true;
+            pthread_mutex_unlock(&pManager->lock);
+
+            // Open the bridge where it was plugged in, instead of reading
+            // the serial number of every bridge
+            result = cy3240_set_location(
+                    handle,
+                    (location[0] != '\0') ? location : NULL);
+
+            if CY3240_SUCCESS(result)
+                result = cy3240_reattach(handle);
+
+            pthread_mutex_lock(&pManager->lock);
+
+            pDevice->busy = false;
+            pthread_cond_broadcast(&pManager->idle);
+
+            // A remove or a new add event that came in meanwhile has
+            // taken over from this attempt
+            if (!pDevice->pending || (pDevice->added_us != added)) {
+
+                report = false;
+
+            } else if CY3240_SUCCESS(result) {
+
+                uint64_t elapsed = cy3240_util_time_us() - pDevice->added_us;
+
+                pDevice->pending = false;
+                pManager->stats.reattaches++;
+                pManager->stats.last_reconnect_us = elapsed;
+                pManager->stats.max_reconnect_us = MAX(pManager->stats.max_reconnect_us, elapsed);
+                report = true;
+
+            } else if (++pDevice->attempts >= MANAGER_REATTACH_ATTEMPTS) {
+
+                fprintf(stderr, "Failed to reattach bridge %s\n", pDevice->serial);
+                pDevice->pending = false;
+                pManager->stats.failures++;
+                report = true;
+
+            } else {
+
+                pDevice->retry_us = cy3240_util_time_us() + MANAGER_REATTACH_DELAY_US;
+                wait = MIN(wait, MANAGER_REATTACH_DELAY_US / 1000);
+            }
+
+            strcpy(serial, pDevice->serial);
+        }
+
+        pthread_mutex_unlock(&pManager->lock);
+
+        if (report && (pManager->callback != NULL))
+            pManager->callback(
+                    pManager->arg,
+                    serial,
+                    handle,
+                    CY3240_DEVICE_ADDED,
+                    result);
+    }
+
+    return wait;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Worker thread. Waits for hotplug events and reattaches handles, so the
+ *  application never has to poll for a bridge to come back.
+ *
+ *  @param arg [in] the manager
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+manager_thread(
+        void* arg
+        )
+{
+    Cy3240_Manager_t* const pManager = (Cy3240_Manager_t*)arg;
+    int wait = MANAGER_WAIT_MS;
+
+    while (pManager->running) {
+
+        Cy3240_Device_Event_t event;
+
+        if (pManager->source.wait(pManager->source.pContext, wait, &event))
+            handle_event(pManager, &event);
+
+        wait = reattach_pending(pManager);
+    }
+
+    return NULL;
+}
+
+#ifdef HAVE_LIBUDEV
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check a udev device is a CY3240 bridge
+ *
+ *  @param pDevice [in] the udev device
+ *  @returns true for a bridge
+ */
+//-----------------------------------------------------------------------------
+static bool
+udev_is_bridge(
+        struct udev_device* const pDevice
+        )
+{
+    const char* pVendor = udev_device_get_sysattr_value(pDevice, "idVendor");
+    const char* pProduct = udev_device_get_sysattr_value(pDevice, "idProduct");
+
+    return (pVendor != NULL) &&
+           (pProduct != NULL) &&
+           (strtoul(pVendor, NULL, 16) == CY3240_VID) &&
+           (strtoul(pProduct, NULL, 16) == CY3240_PID);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the location of a udev device in the form libusb names
+ *  its bus directories and device files
+ *
+ *  @param pDevice   [in] the udev device
+ *  @param pLocation [out] the location, empty if unknown
+ */
+//-----------------------------------------------------------------------------
+static void
+udev_location(
+        struct udev_device* const pDevice,
+        char* const pLocation
+        )
+{
+    const char* pBus = udev_device_get_sysattr_value(pDevice, "busnum");
+    const char* pNumber = udev_device_get_sysattr_value(pDevice, "devnum");
+
+    pLocation[0] = '\0';
+
+    if ((pBus != NULL) && (pNumber != NULL))
+        snprintf(pLocation, CY3240_LOCATION_MAX, "%03lu/%03lu",
+                strtoul(pBus, NULL, 10),
+                strtoul(pNumber, NULL, 10));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to remember the serial number of a bridge by its device path
+ *
+ *  @param pUdev   [in] the udev source
+ *  @param pDevice [in] the udev device
+ *  @returns the serial number or NULL
+ */
+//-----------------------------------------------------------------------------
+static const char*
+udev_remember(
+        Udev_Source_t* const pUdev,
+        struct udev_device* const pDevice
+        )
+{
+    const char* pPath = udev_device_get_syspath(pDevice);
+    const char* pSerial = udev_device_get_sysattr_value(pDevice, "serial");
+    int x;
+
+    if ((pPath == NULL) ||
+        (pSerial == NULL) ||
+        (strlen(pPath) >= sizeof(pUdev->known[0].path)) ||
+        (strlen(pSerial) >= CY3240_SERIAL_MAX))
+        return NULL;
+
+    for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++) {
+
+        if ((pUdev->known[x].path[0] == '\0') ||
+            (strcmp(pUdev->known[x].path, pPath) == 0)) {
+
+            strcpy(pUdev->known[x].path, pPath);
+            strcpy(pUdev->known[x].serial, pSerial);
+            break;
+        }
+    }
+
+    return pSerial;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to enumerate the connected bridges
+ *
+ *  @see Cy3240_Event_Source_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+udev_enumerate(
+        void* pContext,
+        Cy3240_Device_Found_t found,
+        void* arg
+        )
+{
+    Udev_Source_t* const pUdev = (Udev_Source_t*)pContext;
+    struct udev_enumerate* pEnumerate = udev_enumerate_new(pUdev->pUdev);
+    struct udev_list_entry* pEntry;
+
+    if (pEnumerate == NULL)
+        return CY3240_ERROR_UNKNOWN;
+
+    udev_enumerate_add_match_subsystem(pEnumerate, "usb");
+    udev_enumerate_add_match_property(pEnumerate, "DEVTYPE", "usb_device");
+    udev_enumerate_scan_devices(pEnumerate);
+
+    udev_list_entry_foreach(pEntry, udev_enumerate_get_list_entry(pEnumerate)) {
+
+        struct udev_device* pDevice = udev_device_new_from_syspath(
+                pUdev->pUdev,
+                udev_list_entry_get_name(pEntry));
+
+        if (pDevice != NULL) {
+
+            const char* pSerial = udev_is_bridge(pDevice) ? udev_remember(pUdev, pDevice) : NULL;
+            char location[CY3240_LOCATION_MAX];
+
+            udev_location(pDevice, location);
+
+            if (pSerial != NULL)
+                found(arg, pSerial, location);
+
+            udev_device_unref(pDevice);
+        }
+    }
+
+    udev_enumerate_unref(pEnumerate);
+
+    return CY3240_ERROR_OK;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to wait for a bridge to be plugged in or unplugged
+ *
+ *  @see Cy3240_Event_Source_t
+ */
+//-----------------------------------------------------------------------------
+static bool
+udev_wait(
+        void* pContext,
+        int timeout_ms,
+        Cy3240_Device_Event_t* pEvent
+        )
+{
+    Udev_Source_t* const pUdev = (Udev_Source_t*)pContext;
+    struct pollfd fd = {udev_monitor_get_fd(pUdev->pMonitor), POLLIN, 0};
+    struct udev_device* pDevice;
+    const char* pAction;
+    bool result = false;
+    int x;
+
+    if (poll(&fd, 1, timeout_ms) <= 0)
+        return false;
+
+    pDevice = udev_monitor_receive_device(pUdev->pMonitor);
+
+    if (pDevice == NULL)
+        return false;
+
+    pAction = udev_device_get_action(pDevice);
+
+    if ((pAction != NULL) &&
+        (strcmp(pAction, "add") == 0) &&
+        udev_is_bridge(pDevice)) {
+
+        const char* pSerial = udev_remember(pUdev, pDevice);
+
+        if (pSerial != NULL) {
+            pEvent->type = CY3240_DEVICE_ADDED;
+            strcpy(pEvent->serial, pSerial);
+            udev_location(pDevice, pEvent->location);
+            result = true;
+        }
+
+    } else if ((pAction != NULL) &&
+               (strcmp(pAction, "remove") == 0) &&
+               (udev_device_get_syspath(pDevice) != NULL)) {
+
+        for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++) {
+
+            if (strcmp(pUdev->known[x].path, udev_device_get_syspath(pDevice)) == 0) {
+                pEvent->type = CY3240_DEVICE_REMOVED;
+                strcpy(pEvent->serial, pUdev->known[x].serial);
+                pEvent->location[0] = '\0';
+                pUdev->known[x].path[0] = '\0';
+                result = true;
+                break;
+            }
+        }
+    }
+
+    udev_device_unref(pDevice);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to free the udev source
+ *
+ *  @see Cy3240_Event_Source_t
+ */
+//-----------------------------------------------------------------------------
+static void
+udev_destroy(
+        void* pContext
+        )
+{
+    Udev_Source_t* const pUdev = (Udev_Source_t*)pContext;
+
+    if (pUdev->pMonitor != NULL)
+        udev_monitor_unref(pUdev->pMonitor);
+
+    if (pUdev->pUdev != NULL)
+        udev_unref(pUdev->pUdev);
+
+    free(pUdev);
+}
+
+#endif // HAVE_LIBUDEV
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_udev_source(
+        Cy3240_Event_Source_t* const pSource
+        )
+{
+    if (pSource != NULL) {
+
+#ifdef HAVE_LIBUDEV
+        Udev_Source_t* pUdev = (Udev_Source_t*)calloc(1, sizeof(Udev_Source_t));
+
+        if (pUdev == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        pUdev->pUdev = udev_new();
+
+        if (pUdev->pUdev != NULL)
+            pUdev->pMonitor = udev_monitor_new_from_netlink(pUdev->pUdev, "udev");
+
+        // Listen before enumerating, so no bridge is missed in between
+        if ((pUdev->pMonitor == NULL) ||
+            (udev_monitor_filter_add_match_subsystem_devtype(pUdev->pMonitor, "usb", "usb_device") < 0) ||
+            (udev_monitor_enable_receiving(pUdev->pMonitor) < 0)) {
+
+            fprintf(stderr, "Failed to create the udev monitor\n");
+            udev_destroy(pUdev);
+            return CY3240_ERROR_UNKNOWN;
+        }
+
+        pSource->pContext = pUdev;
+        pSource->enumerate = udev_enumerate;
+        pSource->wait = udev_wait;
+        pSource->destroy = udev_destroy;
+
+        return CY3240_ERROR_OK;
+#else
+        fprintf(stderr, "Built without udev support\n");
+
+        return CY3240_ERROR_UNKNOWN;
+#endif
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_create(
+        Cy3240_Manager_t** ppManager,
+        const Cy3240_Event_Source_t* const pSource,
+        Cy3240_Device_Callback_t callback,
+        void* arg
+        )
+{
+    if ((ppManager != NULL) &&
+        (pSource != NULL) &&
+        (pSource->enumerate != NULL) &&
+        (pSource->wait != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Manager_t* pManager;
+
+        pManager = (Cy3240_Manager_t*)calloc(1, sizeof(Cy3240_Manager_t));
+
+        if (pManager == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        pManager->source = *pSource;
+        pManager->callback = callback;
+        pManager->arg = arg;
+        pthread_mutex_init(&pManager->lock, NULL);
+        pthread_cond_init(&pManager->idle, NULL);
+
+        // The only full scan, events keep the list current afterwards
+        pthread_mutex_lock(&pManager->lock);
+
+        result = pSource->enumerate(
+                pSource->pContext,
+                device_found,
+                pManager);
+
+        pthread_mutex_unlock(&pManager->lock);
+
+        if CY3240_SUCCESS(result) {
+
+            pManager->running = true;
+
+            if (pthread_create(&pManager->thread, NULL, manager_thread, pManager) != 0) {
+                pManager->running = false;
+                fprintf(stderr, "Failed to start the manager thread\n");
+                result = CY3240_ERROR_UNKNOWN;
+            }
+        }
+
+        if CY3240_FAILURE(result) {
+            pthread_cond_destroy(&pManager->idle);
+            pthread_mutex_destroy(&pManager->lock);
+            free(pManager);
+            return result;
+        }
+
+        *ppManager = pManager;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_manager_is_present(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial
+        )
+{
+    bool present = false;
+
+    if ((pManager != NULL) &&
+        (pSerial != NULL)) {
+
+        Manager_Device_t* pDevice;
+
+        pthread_mutex_lock(&pManager->lock);
+
+        pDevice = find_device(pManager, pSerial, false);
+        present = (pDevice != NULL) && pDevice->present;
+
+        pthread_mutex_unlock(&pManager->lock);
+    }
+
+    return present;
+}
+
+//-----------------------------------------------------------------------------
+int
+cy3240_manager_get_devices(
+        Cy3240_Manager_t* const pManager,
+        char (*pSerials)[CY3240_SERIAL_MAX],
+        int max
+        )
+{
+    int count = 0;
+    int x;
+
+    if ((pManager != NULL) &&
+        (pSerials != NULL)) {
+
+        pthread_mutex_lock(&pManager->lock);
+
+        for (x = 0; (x < CY3240_MANAGER_MAX_DEVICES) && (count < max); x++)
+            if (pManager->devices[x].present)
+                strcpy(pSerials[count++], pManager->devices[x].serial);
+
+        pthread_mutex_unlock(&pManager->lock);
+    }
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_attach(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial,
+        int handle
+        )
+{
+    if ((pManager != NULL) &&
+        (pSerial != NULL) &&
+        (handle != 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_INVALID_PARAMETERS;
+        Manager_Device_t* pDevice;
+
+        pthread_mutex_lock(&pManager->lock);
+
+        pDevice = find_device(pManager, pSerial, true);
+
+        if ((pDevice != NULL) &&
+            (pDevice->handle == 0)) {
+            pDevice->handle = handle;
+            result = CY3240_ERROR_OK;
+        }
+
+        pthread_mutex_unlock(&pManager->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_open(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial,
+        int timeout,
+        Cy3240_Power_t power,
+        Cy3240_Bus_t bus,
+        Cy3240_I2C_ClockSpeed_t clock,
+        int* const pHandle
+        )
+{
+    if ((pManager != NULL) &&
+        (pSerial != NULL) &&
+        (pHandle != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        char location[CY3240_LOCATION_MAX] = "";
+        Manager_Device_t* pDevice;
+        bool present;
+        int handle = 0;
+
+        pthread_mutex_lock(&pManager->lock);
+
+        pDevice = find_device(pManager, pSerial, false);
+        present = (pDevice != NULL) && pDevice->present;
+
+        if (present)
+            strcpy(location, pDevice->location);
+
+        pthread_mutex_unlock(&pManager->lock);
+
+        // A bridge that is not connected is not searched for
+        if (!present) {
+            fprintf(stderr, "Bridge %s is not connected\n", pSerial);
+            return CY3240_ERROR_HID;
+        }
+
+        result = cy3240_factory(
+                &handle,
+                0,
+                timeout,
+                power,
+                bus,
+                clock);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_set_serial_number(
+                    handle,
+                    pSerial);
+
+        // Open the bridge where it is plugged in, instead of reading the
+        // serial number of every bridge
+        if (CY3240_SUCCESS(result) && (location[0] != '\0'))
+            result = cy3240_set_location(
+                    handle,
+                    location);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_manager_attach(
+                    pManager,
+                    pSerial,
+                    handle);
+
+        // The handle is only returned once the manager looks after it
+        if (CY3240_FAILURE(result) && (handle != 0)) {
+            cy3240_close(handle);
+            return result;
+        }
+
+        // Even if the claim fails the handle is reattached by the next add
+        // event, it is returned so it can be closed
+        if CY3240_SUCCESS(result) {
+            *pHandle = handle;
+            result = cy3240_open(handle);
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_close(
+        Cy3240_Manager_t* const pManager,
+        int handle
+        )
+{
+    if ((pManager != NULL) &&
+        (handle != 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_INVALID_PARAMETERS;
+        int x;
+
+        pthread_mutex_lock(&pManager->lock);
+
+        for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++) {
+
+            Manager_Device_t* const pDevice = &pManager->devices[x];
+
+            if (pDevice->handle == handle) {
+
+                // A reattach still uses the handle
+                while (pDevice->busy)
+                    pthread_cond_wait(&pManager->idle, &pManager->lock);
+
+                pDevice->handle = 0;
+                pDevice->pending = false;
+                result = cy3240_close(handle);
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&pManager->lock);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_get_stats(
+        Cy3240_Manager_t* const pManager,
+        Cy3240_Manager_Stats_t* const pStats
+        )
+{
+    if ((pManager != NULL) &&
+        (pStats != NULL)) {
+
+        pthread_mutex_lock(&pManager->lock);
+        *pStats = pManager->stats;
+        pthread_mutex_unlock(&pManager->lock);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_destroy(
+        Cy3240_Manager_t* const pManager
+        )
+{
+    if (pManager != NULL) {
+
+        int x;
+
+        pManager->running = false;
+        pthread_join(pManager->thread, NULL);
+
+        for (x = 0; x < CY3240_MANAGER_MAX_DEVICES; x++)
+            if (pManager->devices[x].handle != 0)
+                cy3240_close(pManager->devices[x].handle);
+
+        if (pManager->source.destroy != NULL)
+            pManager->source.destroy(pManager->source.pContext);
+
+        pthread_cond_destroy(&pManager->idle);
+        pthread_mutex_destroy(&pManager->lock);
+        free(pManager);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
@@ -0,0 +1,301 @@
+/**
+ * @file cy3240_manager.h
+ *
+ * @brief Hotplug aware manager for CY3240 bridges
+ *
+ * Keeps a list of the connected bridges by serial number, built once at
+ * start up and then kept current by add and remove events, so opening a
+ * bridge does not depend on a fresh bus scan and an unplugged bridge is
+ * known to be gone.  When a bridge opened through the manager is plugged
+ * in again it is reattached to its existing handle by the manager thread
+ * and the application is told through a callback.
+ *
+ * The events come from an event source.  cy3240_manager_udev_source()
+ * provides one based on a udev monitor; tests and other platforms can
+ * provide their own.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_MANAGER_H
+#define INCLUSION_GUARD_CY3240_MANAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_MANAGER_MAX_DEVICES   (16)      ///< Bridges tracked by one manager
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Hotplug event types
+ */
+typedef enum {
+    CY3240_DEVICE_ADDED,                       ///< A bridge was plugged in
+    CY3240_DEVICE_REMOVED                      ///< A bridge was unplugged
+} Cy3240_Device_Event_Type_t;
+
+/**
+ * Hotplug event
+ */
+typedef struct {
+    Cy3240_Device_Event_Type_t type;           ///< What happened
+    char serial[CY3240_SERIAL_MAX];            ///< Serial number of the bridge
+    char location[CY3240_LOCATION_MAX];        ///< USB bus and device, see cy3240_set_location(), may be empty
+} Cy3240_Device_Event_t;
+
+/**
+ * Called by an event source for every bridge found by an enumeration, the
+ * location is that of cy3240_set_location() and may be NULL
+ */
+typedef void (*Cy3240_Device_Found_t)(
+        void* arg,
+        const char* pSerial,
+        const char* pLocation
+        );
+
+/**
+ * Source of the connected bridges and hotplug events
+ */
+typedef struct {
+    void* pContext;                            ///< Passed to every method
+
+    /** Reports every connected bridge through found */
+    Cy3240_Error_t (*enumerate)(
+            void* pContext,
+            Cy3240_Device_Found_t found,
+            void* arg);
+
+    /** Waits up to timeout_ms for an event, returns true if pEvent was filled */
+    bool (*wait)(
+            void* pContext,
+            int timeout_ms,
+            Cy3240_Device_Event_t* pEvent);
+
+    /** Frees the context, may be NULL */
+    void (*destroy)(
+            void* pContext);
+
+} Cy3240_Event_Source_t;
+
+/**
+ * Called from the manager thread after a managed bridge was unplugged or
+ * reattached. For CY3240_DEVICE_ADDED the result is that of the reattach.
+ */
+typedef void (*Cy3240_Device_Callback_t)(
+        void* arg,
+        const char* pSerial,
+        int handle,
+        Cy3240_Device_Event_Type_t type,
+        Cy3240_Error_t result
+        );
+
+/**
+ * Manager statistics
+ */
+typedef struct {
+    uint64_t events;                           ///< Hotplug events received
+    uint64_t reattaches;                       ///< Handles reattached to a bridge
+    uint64_t failures;                         ///< Bridges that could not be reattached
+    uint64_t last_reconnect_us;                ///< Add event to reattached, last reconnect
+    uint64_t max_reconnect_us;                 ///< Add event to reattached, slowest reconnect
+} Cy3240_Manager_Stats_t;
+
+/**
+ * Opaque manager state
+ */
+typedef struct Cy3240_Manager_s Cy3240_Manager_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get an event source based on a udev monitor of the USB
+ *  subsystem
+ *
+ *  @param pSource [out] the event source
+ *  @returns Cy3240_Error_t, CY3240_ERROR_UNKNOWN without udev support
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_udev_source(
+        Cy3240_Event_Source_t* const pSource
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to create a manager. The connected bridges are
+ *  enumerated once and the manager thread is started. The manager owns the
+ *  event source from now on.
+ *
+ *  @param ppManager [out] the new manager
+ *  @param pSource   [in] the event source
+ *  @param callback  [in] told about unplugged and reattached bridges, may be NULL
+ *  @param arg       [in] passed to the callback
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_create(
+        Cy3240_Manager_t** ppManager,
+        const Cy3240_Event_Source_t* const pSource,
+        Cy3240_Device_Callback_t callback,
+        void* arg
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check if a bridge is connected
+ *
+ *  @param pManager [in] the manager
+ *  @param pSerial  [in] the serial number
+ *  @returns true if the bridge is connected
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_manager_is_present(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to list the connected bridges
+ *
+ *  @param pManager [in] the manager
+ *  @param pSerials [out] the serial numbers
+ *  @param max      [in] the number of entries in pSerials
+ *  @returns the number of serial numbers returned
+ */
+//-----------------------------------------------------------------------------
+int
+cy3240_manager_get_devices(
+        Cy3240_Manager_t* const pManager,
+        char (*pSerials)[CY3240_SERIAL_MAX],
+        int max
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to put a handle under the control of the manager. The handle is
+ *  reattached automatically when the bridge is plugged in again and must
+ *  be closed with cy3240_manager_close().
+ *
+ *  @param pManager [in] the manager
+ *  @param pSerial  [in] the serial number of the bridge
+ *  @param handle   [in] the handle, see cy3240_set_serial_number()
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_attach(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial,
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to create and open a handle to a connected bridge, then attach
+ *  it to the manager. The bridge is opened at the USB bus and device the
+ *  event source reported, if any. If only the claim fails the handle is
+ *  still returned and reattached by the next add event, any other failure
+ *  closes it.
+ *
+ *  @param pManager [in] the manager
+ *  @param pSerial  [in] the serial number
+ *  @param timeout  [in] the timeout for tx and rx
+ *  @param power    [in] the power mode to use
+ *  @param bus      [in] the bus type to use
+ *  @param clock    [in] the I2C clock rate to use
+ *  @param pHandle  [out] the handle
+ *  @returns Cy3240_Error_t, CY3240_ERROR_HID if the bridge is not connected
+ *           or could not be claimed
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_open(
+        Cy3240_Manager_t* const pManager,
+        const char* const pSerial,
+        int timeout,
+        Cy3240_Power_t power,
+        Cy3240_Bus_t bus,
+        Cy3240_I2C_ClockSpeed_t clock,
+        int* const pHandle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to close a handle opened through the manager
+ *
+ *  @param pManager [in] the manager
+ *  @param handle   [in] the handle
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_close(
+        Cy3240_Manager_t* const pManager,
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the manager statistics
+ *
+ *  @param pManager [in] the manager
+ *  @param pStats   [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_get_stats(
+        Cy3240_Manager_t* const pManager,
+        Cy3240_Manager_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop the manager, close the handles still open and free it
+ *
+ *  @param pManager [in] the manager
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_manager_destroy(
+        Cy3240_Manager_t* const pManager
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_MANAGER_H
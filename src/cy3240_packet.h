@@ -38,6 +38,11 @@ extern "C" {
 /* Bus configuration */
 #define CY3240_BUS_MASK          (0xC0)
 
+/* Define the status byte bits of the output packets */
+#define STATUS_BYTE_ACK          (0x01)
+#define STATUS_BYTE_INTERRUPT    (0x02)
+#define STATUS_BYTE_POWERED      (0x04)
+
 /**
  * Acknowledgment byte
  */
@@ -67,6 +72,11 @@ extern "C" {
  */
 #define READ_INPUT_PACKET_SIZE             (3)
 
+/**
+ * Status query parameters
+ */
+#define STATUS_QUERY_LENGTH                (1)  ///< Bytes read from the control register by a status query
+
 /**
  * The I2C address of the CY3240 control register
  */
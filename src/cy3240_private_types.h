@@ -22,6 +22,8 @@ extern "C" {
 //@{
 
 #include <hid.h>
+#include <stdint.h>
+#include <pthread.h>
 #include "cy3240_types.h"
 
 //@} End of Includes
@@ -119,6 +121,46 @@ typedef struct {
     hid_new_HIDInterface_fpt new_if;           ///< Pointer to the hid new interface function
 } hid_wrapper_t;
 
+/**
+ * Size of the HID reports exchanged with the bridge
+ */
+#define SEND_PACKET_LEN          (64)
+#define RECV_PACKET_LEN          (64)
+
+/**
+ * Number of 7-bit I2C slave addresses
+ */
+#define CY3240_SLAVE_COUNT       (128)
+
+/**
+ * Marks a slave without a clock profile
+ */
+#define CY3240_SLAVE_CLOCK_NONE  (0xFF)
+
+/**
+ * Packets the bridge has not answered yet, a power of two larger than the
+ * deepest pipeline plus a combined power and clock reconfigure
+ */
+#define CY3240_INFLIGHT_MAX      (32)
+
+/**
+ * Round trips measured before the timeouts adapt
+ */
+#define CY3240_LATENCY_MIN_SAMPLES (8)
+
+/**
+ * Slack added to every adaptive timeout for USB frame scheduling
+ */
+#define CY3240_LATENCY_MARGIN_US (2000)
+
+/**
+ * A packet waiting for its response
+ */
+typedef struct {
+    uint64_t sent_us;                          ///< Time the packet was sent
+    uint32_t bus_us;                           ///< Expected time on the I2C bus
+} Cy3240_Inflight_t;
+
 /**
  * CY3240 device state structure
  */
@@ -128,10 +170,50 @@ typedef struct {
     int iface_number;                          ///< The interface number
     int timeout;                               ///< USB Transfer timeout
     Cy3240_I2C_ClockSpeed_t clock;             ///< The clock speed
+    Cy3240_I2C_ClockSpeed_t default_clock;     ///< Clock for slaves without a profile
+    uint8_t slave_clock[CY3240_SLAVE_COUNT];   ///< Per slave clock profiles
     Cy3240_Bus_t bus;                          ///< The bus configuration
     Cy3240_Power_t power;                      ///< The power configuration
+    bool power_valid;                          ///< The bridge confirmed the power configuration
+    bool clock_valid;                          ///< The bridge confirmed the clock speed
     HIDInterface *pHid;                        ///< HID Interface
+    bool hid_user;                             ///< Holds a reference on the process wide libhid state
+    bool closing;                              ///< Set by close, blocked calls give up
     hid_wrapper_t w;                           ///< HID interface wrapper
+    uint8_t status;                            ///< Status byte of the last response
+    uint32_t interrupts;                       ///< Rising edges of the interrupt flag seen
+    uint32_t interrupts_taken;                 ///< Interrupts returned by cy3240_interrupt_wait()
+    pthread_cond_t interrupt;                  ///< Signalled when the interrupt flag is seen
+    uint64_t last_transfer;                    ///< Time of the last response in microseconds
+    int poll_interval;                         ///< Idle time before the monitor queries the status (ms)
+    volatile bool monitor;                     ///< The interrupt monitor should keep running
+    pthread_t monitor_thread;                  ///< Interrupt monitor thread
+    pthread_mutex_t lock;                      ///< Serializes access to the bridge
+    pthread_cond_t turn;                       ///< Signalled when a write, read or transfer leaves the bridge
+    uint32_t waiting[CY3240_PRIORITY_COUNT];   ///< Calls waiting for the bridge per class, atomic
+    Cy3240_Class_Stats_t classes[CY3240_PRIORITY_COUNT]; ///< Latency statistics per class
+    int pipeline_depth;                        ///< Packets in flight during a transfer
+    bool adaptive;                             ///< Derive each timeout from the latency statistics
+    uint32_t latency_us;                       ///< Smoothed USB round trip without the bus time
+    uint32_t deviation_us;                     ///< Smoothed deviation of the round trip
+    uint64_t latency_samples;                  ///< Round trips measured
+    uint64_t timeouts;                         ///< Adaptive timeouts that expired
+    int last_timeout;                          ///< Timeout of the last read (ms)
+    uint16_t stale;                            ///< Late responses to drop before the next packet
+    uint32_t stale_us;                         ///< Bus time of the late responses (us)
+    Cy3240_Inflight_t inflight[CY3240_INFLIGHT_MAX]; ///< Packets waiting for a response
+    uint16_t inflight_head;                    ///< Next free inflight entry
+    uint16_t inflight_tail;                    ///< Oldest inflight entry
+    Cy3240_Retry_Policy_t retry[CY3240_NAK_COUNT]; ///< Write retry policy per kind of NAK
+    Cy3240_Retry_Stats_t retry_stats;          ///< Write retry statistics
+    unsigned int retry_seed;                   ///< Random state for the backoff jitter
+    HIDInterfaceMatcher matcher;               ///< Matcher used to claim the interface again
+    char serial[CY3240_SERIAL_MAX];            ///< Serial number the matcher selects, empty for any
+    char location[CY3240_LOCATION_MAX];        ///< USB bus and device the matcher selects, empty for any
+    Cy3240_Tier_Stats_t recovery[CY3240_TIER_COUNT]; ///< Recovery statistics per tier
+    Cy3240_Traffic_t traffic;                  ///< Traffic counters and round trip histogram
+    uint8_t send[SEND_PACKET_LEN];             ///< The sending buffer
+    uint8_t recv[RECV_PACKET_LEN];             ///< The receive buffer
 } Cy3240_t;
 
 //@} End of Types
@@ -0,0 +1,126 @@
+/**
+ * @file cy3240_protocol.h
+ *
+ * @brief Wire protocol between cy3240d and its clients
+ *
+ * Every message is a header followed by length bytes of body. Requests
+ * are answered in order, one response per request. The daemon and its
+ * clients run on the same host, so all fields are in host byte order.
+ *
+ * Request bodies and the matching response bodies:
+ *
+ * - CY3240_MSG_OPEN: the serial number of the bridge, empty for the first
+ *   bridge of the daemon, without a terminator. The response is empty.
+ * - CY3240_MSG_TRANSFER: count operations, each the type, address and
+ *   length bytes followed by the data of a write. The response holds count
+ *   result bytes followed by the data of every read, in order. This is
+ *   the encoding Cy3240Transaction uses.
+ * - CY3240_MSG_WRITE: the address byte followed by the data. Run as one
+ *   cy3240_write(), the response is empty.
+ * - CY3240_MSG_READ: the address byte followed by the 16 bit length. Run
+ *   as one cy3240_read(), the response holds the data.
+ * - CY3240_MSG_STATS: empty. The response is the Cy3240_Stats_t of the
+ *   bridge.
+ * - CY3240_MSG_MAP: one byte, non zero to receive published samples. The
+ *   response is empty and carries a memfd as SCM_RIGHTS ancillary data.
+ *
+ * After a CY3240_MSG_MAP the connection carries no more messages. The
+ * memfd holds a Cy3240_Shm_Header_t and the rings it points to: the client
+ * pushes Cy3240_Shm_Op_t in to the request ring and pops them with their
+ * results from the response ring, the server pushes Cy3240_Sample_t in to
+ * the sample ring. Both sides sleep on the rings with futexes, so a busy
+ * client exchanges operations without a system call. Closing the socket
+ * ends the session.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_PROTOCOL_H
+#define INCLUSION_GUARD_CY3240_PROTOCOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+#include "cy3240_packet.h"
+#include "cy3240_scheduler.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_PROTOCOL_DEFAULT_PATH  "/tmp/cy3240d.sock"  ///< Socket of the daemon
+#define CY3240_PROTOCOL_MAX_OPS       (64)                 ///< Operations of one transfer request
+#define CY3240_PROTOCOL_OP_HEADER     (3)                  ///< Type, address and length of an operation
+#define CY3240_PROTOCOL_MAX_BODY      (0x10000 + 2)        ///< Largest body, a 64 KB write plus its address
+#define CY3240_SHM_OPS                (256)                ///< Capacity of the request and response rings
+#define CY3240_SHM_SAMPLES            (256)                ///< Capacity of the sample ring
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Message types
+ */
+typedef enum {
+    CY3240_MSG_OPEN,                 ///< Attach the connection to a bridge
+    CY3240_MSG_TRANSFER,             ///< Single packet operations, merged with other clients
+    CY3240_MSG_WRITE,                ///< Multi packet write
+    CY3240_MSG_READ,                 ///< Multi packet read
+    CY3240_MSG_STATS,                ///< Statistics of the bridge
+    CY3240_MSG_MAP                   ///< Switch to the shared memory rings
+} Cy3240_Msg_Type_t;
+
+/**
+ * Header of every request and response
+ */
+typedef struct {
+    uint32_t length;                 ///< Bytes of body after the header
+    uint8_t type;                    ///< Cy3240_Msg_Type_t
+    int8_t result;                   ///< Cy3240_Error_t of a response, 0 in a request
+    uint16_t count;                  ///< Operations of a transfer, otherwise 0
+} Cy3240_Msg_Header_t;
+
+/**
+ * A single packet operation in the shared memory rings
+ */
+typedef struct {
+    uint32_t tag;                    ///< Chosen by the client, returned with the result
+    uint8_t type;                    ///< Cy3240_Op_Type_t
+    uint8_t address;                 ///< I2C address of the slave
+    uint8_t length;                  ///< Bytes to write or read
+    int8_t result;                   ///< Cy3240_Error_t of the response
+    uint8_t data[CY3240_MAX_WRITE_BYTES]; ///< Data written, or read in the response
+} Cy3240_Shm_Op_t;
+
+/**
+ * Start of the shared memory, the rings follow at the given offsets
+ */
+typedef struct {
+    uint32_t size;                   ///< Size of the mapping
+    uint32_t requests;               ///< Offset of the request ring
+    uint32_t responses;              ///< Offset of the response ring
+    uint32_t samples;                ///< Offset of the sample ring, 0 without samples
+    volatile uint32_t dropped;       ///< Samples lost because the sample ring was full
+} Cy3240_Shm_Header_t;
+
+//@} End of Types
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_PROTOCOL_H
@@ -0,0 +1,169 @@
+/**
+ * @file cy3240_ring.c
+ *
+ * @brief Lock-free single producer / single consumer ring
+ *
+ * Lock-free single producer / single consumer ring
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "cy3240_ring.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+size_t
+cy3240_ring_size(
+        uint32_t capacity,
+        uint32_t element_size
+        )
+{
+    return sizeof(Cy3240_Ring_t) + ((size_t)capacity * element_size);
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_ring_init(
+        Cy3240_Ring_t* const pRing,
+        uint32_t capacity,
+        uint32_t element_size
+        )
+{
+    // The capacity must be a power of two so the indexes can be masked
+    if ((pRing != NULL) &&
+        (capacity != 0) &&
+        ((capacity & (capacity - 1)) == 0) &&
+        (element_size != 0)) {
+
+        memset(pRing, 0x00, sizeof(Cy3240_Ring_t));
+
+        pRing->capacity = capacity;
+        pRing->element_size = element_size;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_push(
+        Cy3240_Ring_t* const pRing,
+        const void* const pElement
+        )
+{
+    // Only the producer writes the head, so a relaxed load is enough
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE);
+
+    if ((head - tail) == pRing->capacity)
+        return false;
+
+    memcpy(&pRing->data[(size_t)(head & (pRing->capacity - 1)) * pRing->element_size],
+           pElement,
+           pRing->element_size);
+
+    // Publish the element to the consumer
+    __atomic_store_n(&pRing->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_pop(
+        Cy3240_Ring_t* const pRing,
+        void* const pElement
+        )
+{
+    // Only the consumer writes the tail, so a relaxed load is enough
+    uint32_t tail = __atomic_load_n(&pRing->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+        return false;
+
+    memcpy(pElement,
+           &pRing->data[(size_t)(tail & (pRing->capacity - 1)) * pRing->element_size],
+           pRing->element_size);
+
+    // Hand the slot back to the producer
+    __atomic_store_n(&pRing->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_wait(
+        Cy3240_Ring_t* const pRing,
+        uint32_t timeout_ms
+        )
+{
+    const uint32_t tail = __atomic_load_n(&pRing->tail, __ATOMIC_RELAXED);
+    struct timespec timeout;
+    uint32_t head;
+
+    if (__atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE) != tail)
+        return true;
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+
+    // Announce the sleep before the last look, cy3240_ring_wake() checks
+    // the flag after it published the head
+    __atomic_store_n(&pRing->waiting, 1, __ATOMIC_SEQ_CST);
+    head = __atomic_load_n(&pRing->head, __ATOMIC_SEQ_CST);
+
+    // Not a private futex, the ring may be shared with another process
+    if (head == tail)
+        syscall(SYS_futex, &pRing->head, FUTEX_WAIT, head, &timeout, NULL, 0);
+
+    __atomic_store_n(&pRing->waiting, 0, __ATOMIC_RELAXED);
+
+    return __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE) != tail;
+}
+
+//-----------------------------------------------------------------------------
+void
+cy3240_ring_wake(
+        Cy3240_Ring_t* const pRing
+        )
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&pRing->waiting, __ATOMIC_RELAXED))
+        syscall(SYS_futex, &pRing->head, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t
+cy3240_ring_count(
+        const Cy3240_Ring_t* const pRing
+        )
+{
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+//@} End of Methods
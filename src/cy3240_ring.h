@@ -0,0 +1,182 @@
+/**
+ * @file cy3240_ring.h
+ *
+ * @brief Lock-free single producer / single consumer ring
+ *
+ * Fixed size element ring used to hand data from a producer thread (the
+ * scheduler or a stream) to a consumer without taking the bridge mutex.
+ * The ring is initialized in place in a caller provided memory block and
+ * contains no pointers, so the block can be placed anywhere, including
+ * memory shared between processes. A consumer that runs out of elements
+ * can sleep on the ring and be woken by the producer through a futex.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_RING_H
+#define INCLUSION_GUARD_CY3240_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Size of a cache line, used to keep the producer and consumer indexes apart
+ */
+#define CY3240_RING_CACHE_LINE   (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Ring header, followed in memory by the element storage
+ */
+typedef struct {
+    uint32_t capacity;                              ///< Number of elements, power of two
+    uint32_t element_size;                          ///< Size of one element in bytes
+    uint8_t pad0[CY3240_RING_CACHE_LINE - 8];
+    volatile uint32_t head;                         ///< Next slot to write, owned by the producer
+    uint8_t pad1[CY3240_RING_CACHE_LINE - 4];
+    volatile uint32_t tail;                         ///< Next slot to read, owned by the consumer
+    volatile uint32_t waiting;                      ///< The consumer sleeps on the head
+    uint8_t pad2[CY3240_RING_CACHE_LINE - 8];
+    uint8_t data[];                                 ///< Element storage
+} Cy3240_Ring_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the size of the memory block needed for a ring
+ *
+ *  @param capacity     [in] the number of elements, must be a power of two
+ *  @param element_size [in] the size of each element
+ *  @returns the number of bytes to allocate
+ */
+//-----------------------------------------------------------------------------
+size_t
+cy3240_ring_size(
+        uint32_t capacity,
+        uint32_t element_size
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to initialize a ring in place
+ *
+ *  @param pRing        [in] memory block of at least cy3240_ring_size() bytes
+ *  @param capacity     [in] the number of elements, must be a power of two
+ *  @param element_size [in] the size of each element
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_ring_init(
+        Cy3240_Ring_t* const pRing,
+        uint32_t capacity,
+        uint32_t element_size
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to copy an element in to the ring. Producer side only.
+ *
+ *  @param pRing    [in] the ring
+ *  @param pElement [in] the element to copy
+ *  @returns true if the element was added, false if the ring is full
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_push(
+        Cy3240_Ring_t* const pRing,
+        const void* const pElement
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to copy the oldest element out of the ring. Consumer side only.
+ *
+ *  @param pRing    [in] the ring
+ *  @param pElement [out] the element
+ *  @returns true if an element was removed, false if the ring is empty
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_pop(
+        Cy3240_Ring_t* const pRing,
+        void* const pElement
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to sleep until the ring holds an element. Consumer side only.
+ *
+ *  @param pRing      [in] the ring
+ *  @param timeout_ms [in] the longest time to sleep in milliseconds
+ *  @returns true if an element is waiting, false after the timeout
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_ring_wait(
+        Cy3240_Ring_t* const pRing,
+        uint32_t timeout_ms
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to wake the consumer if it sleeps in cy3240_ring_wait(). Producer
+ *  side only, called once after a batch of pushes. Costs no system call
+ *  while the consumer is awake.
+ *
+ *  @param pRing [in] the ring
+ */
+//-----------------------------------------------------------------------------
+void
+cy3240_ring_wake(
+        Cy3240_Ring_t* const pRing
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the number of elements waiting in the ring
+ *
+ *  @param pRing [in] the ring
+ *  @returns the number of elements
+ */
+//-----------------------------------------------------------------------------
+uint32_t
+cy3240_ring_count(
+        const Cy3240_Ring_t* const pRing
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_RING_H
@@ -0,0 +1,178 @@
+/**
+ * @file cy3240_scan.c
+ *
+ * @brief I2C bus scanner for the CY3240 bridge
+ *
+ * I2C bus scanner for the CY3240 bridge
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "cy3240.h"
+#include "cy3240_scan.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SCAN_COUNT  (CY3240_SCAN_LAST - CY3240_SCAN_FIRST + 1)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Work for one scanning thread
+ */
+typedef struct {
+    int handle;                                ///< The bridge to scan
+    uint8_t* pBitmap;                          ///< Where the result goes
+    Cy3240_Error_t result;                     ///< Result of the scan
+    pthread_t thread;                          ///< The scanning thread
+} Cy3240_Scan_Work_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ * Scanning thread for cy3240_scan_many()
+ *
+ * @param arg [in] the scan work
+ * @return NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+scan_thread(
+        void* arg
+        )
+{
+    Cy3240_Scan_Work_t* const pWork = (Cy3240_Scan_Work_t*)arg;
+
+    pWork->result = cy3240_scan(
+            pWork->handle,
+            pWork->pBitmap);
+
+    return NULL;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scan(
+        int handle,
+        uint8_t* const pBitmap
+        )
+{
+    if (pBitmap != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Op_t ops[SCAN_COUNT];
+        int x;
+
+        memset(pBitmap, 0x00, CY3240_SCAN_BITMAP_SIZE);
+        memset(ops, 0x00, sizeof(ops));
+
+        for (x = 0; x < SCAN_COUNT; x++) {
+            ops[x].type = CY3240_OP_PROBE;
+            ops[x].address = CY3240_SCAN_FIRST + x;
+        }
+
+        // A NAK only means nobody is there, so just the transport result counts
+        result = cy3240_transfer(
+                handle,
+                ops,
+                SCAN_COUNT);
+
+        if CY3240_SUCCESS(result) {
+
+            for (x = 0; x < SCAN_COUNT; x++)
+                if CY3240_SUCCESS(ops[x].result)
+                    pBitmap[ops[x].address >> 3] |= 1 << (ops[x].address & 0x07);
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scan_many(
+        const int* const pHandles,
+        int count,
+        uint8_t* const pBitmaps
+        )
+{
+    if ((pHandles != NULL) &&
+        (count > 0) &&
+        (pBitmaps != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Scan_Work_t* pWork;
+        int x;
+
+        // No need for threads with a single bridge
+        if (count == 1)
+            return cy3240_scan(pHandles[0], pBitmaps);
+
+        pWork = (Cy3240_Scan_Work_t*)calloc(count, sizeof(Cy3240_Scan_Work_t));
+
+        if (pWork == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        // Every bridge has its own lock, so the scans run in parallel
+        for (x = 0; x < count; x++) {
+
+            pWork[x].handle = pHandles[x];
+            pWork[x].pBitmap = &pBitmaps[x * CY3240_SCAN_BITMAP_SIZE];
+
+            if (pthread_create(&pWork[x].thread, NULL, scan_thread, &pWork[x]) != 0) {
+                fprintf(stderr, "Failed to create the scan thread\n");
+                scan_thread(&pWork[x]);
+                pWork[x].thread = pthread_self();
+            }
+        }
+
+        for (x = 0; x < count; x++) {
+
+            if (!pthread_equal(pWork[x].thread, pthread_self()))
+                pthread_join(pWork[x].thread, NULL);
+
+            if (CY3240_SUCCESS(result) && CY3240_FAILURE(pWork[x].result))
+                result = pWork[x].result;
+        }
+
+        free(pWork);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
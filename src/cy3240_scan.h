@@ -0,0 +1,89 @@
+/**
+ * @file cy3240_scan.h
+ *
+ * @brief I2C bus scanner for the CY3240 bridge
+ *
+ * Finds the slaves that acknowledge their address. All probes of a bridge
+ * go through one pipelined cy3240_transfer() call, and several bridges are
+ * scanned at the same time from one thread each.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_SCAN_H
+#define INCLUSION_GUARD_CY3240_SCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_SCAN_BITMAP_SIZE  (16)          ///< Bytes in a presence bitmap, one bit per address
+#define CY3240_SCAN_FIRST        (0x08)        ///< First address probed, below are reserved
+#define CY3240_SCAN_LAST         (0x77)        ///< Last address probed, above are reserved
+
+/**
+ * Check if an address is marked present in a bitmap
+ */
+#define CY3240_SCAN_PRESENT(pBitmap, address) \
+    (((pBitmap)[(address) >> 3] >> ((address) & 0x07)) & 0x01)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to scan a bridge for slaves. Reserved addresses are not probed.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param pBitmap [out] CY3240_SCAN_BITMAP_SIZE bytes, bit n set if address n acknowledged
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scan(
+        int handle,
+        uint8_t* const pBitmap
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to scan several bridges at the same time
+ *
+ *  @param pHandles [in] the handles to the bridge controllers
+ *  @param count    [in] the number of handles
+ *  @param pBitmaps [out] count * CY3240_SCAN_BITMAP_SIZE bytes, one bitmap per handle
+ *  @returns the first error of any bridge
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scan_many(
+        const int* const pHandles,
+        int count,
+        uint8_t* const pBitmaps
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_SCAN_H
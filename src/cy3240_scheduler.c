@@ -0,0 +1,552 @@
+/**
+ * @file cy3240_scheduler.c
+ *
+ * @brief Periodic sampling scheduler for the CY3240 bridge
+ *
+ * Periodic sampling scheduler for the CY3240 bridge
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_util.h"
+#include "cy3240_ring.h"
+#include "cy3240_scheduler.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Longest time the worker sleeps before checking for a stop request
+ */
+#define SCHEDULER_MAX_SLEEP_US   (10000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Run time state of a job
+ */
+typedef struct {
+    Cy3240_Job_t job;                          ///< The job description
+    Cy3240_I2C_ClockSpeed_t clock;             ///< Clock domain of the slave
+    uint64_t release;                          ///< Next release time
+    uint64_t cost;                             ///< Average execution time
+    Cy3240_Job_Stats_t stats;                  ///< Timing statistics
+} Cy3240_Job_State_t;
+
+/**
+ * A bridge, its worker and the clock domain it was last used in
+ */
+typedef struct {
+    int handle;                                ///< The bridge
+    Cy3240_I2C_ClockSpeed_t clock;             ///< Clock of the last job on the bridge
+    pthread_t thread;                          ///< Worker running the jobs of the bridge
+    struct Cy3240_Scheduler_s* pScheduler;     ///< The scheduler of the worker
+} Cy3240_Domain_t;
+
+/**
+ * Scheduler state
+ */
+struct Cy3240_Scheduler_s {
+    Cy3240_Job_State_t jobs[CY3240_SCHEDULER_MAX_JOBS]; ///< The jobs
+    int count;                                 ///< Number of jobs
+    Cy3240_Domain_t domains[CY3240_SCHEDULER_MAX_JOBS]; ///< Each bridge and its worker
+    int domain_count;                          ///< Number of bridges
+    volatile bool running;                     ///< Workers should keep running
+    bool started;                              ///< Worker threads exist
+    pthread_mutex_t lock;                      ///< Protects the statistics and the queue
+    Cy3240_Ring_t* pQueue;                     ///< Sample queue
+};
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read the job register in to a sample
+ *
+ *  @param pJob    [in] the job
+ *  @param pSample [out] the sample
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+run_job(
+        const Cy3240_Job_t* const pJob,
+        Cy3240_Sample_t* const pSample
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Op_t ops[2];
+    uint8_t reg = pJob->reg;
+    int x;
+
+    memset(ops, 0x00, sizeof(ops));
+
+    // Select the register
+    ops[0].type = CY3240_OP_WRITE;
+    ops[0].address = pJob->address;
+    ops[0].pData = &reg;
+    ops[0].length = sizeof(reg);
+
+    // Read the register contents
+    ops[1].type = CY3240_OP_READ;
+    ops[1].address = pJob->address;
+    ops[1].pData = pSample->data;
+    ops[1].length = pJob->length;
+
+    // Both go out in one pipelined transfer, the bridge is taken once
+    result = cy3240_transfer(
+            pJob->handle,
+            ops,
+            2);
+
+    for (x = 0; CY3240_SUCCESS(result) && (x < 2); x++)
+        result = ops[x].result;
+
+    pSample->length = CY3240_SUCCESS(result) ? pJob->length : 0;
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to find the clock domain entry of a bridge
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @param handle     [in] the bridge handle
+ *  @returns the domain entry
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Domain_t*
+find_domain(
+        Cy3240_Scheduler_t* const pScheduler,
+        int handle
+        )
+{
+    int x;
+
+    for (x = 0; x < pScheduler->domain_count; x++) {
+
+        if (pScheduler->domains[x].handle == handle)
+            return &pScheduler->domains[x];
+    }
+
+    // The bridge has not been used yet
+    pScheduler->domains[x].handle = handle;
+    pScheduler->domains[x].clock = CY3240_CLOCK__Reserved;
+    pScheduler->domain_count++;
+
+    return &pScheduler->domains[x];
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to pick the released job of a bridge with the earliest absolute
+ *  deadline. If that job needs a clock switch, a released job in the
+ *  current clock domain of the bridge runs first when both still fit
+ *  before the earliest deadline.
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @param pDomain    [in] the bridge
+ *  @param now        [in] the current time
+ *  @param pNext      [out] the earliest future release if no job is ready
+ *  @returns the job index or -1 if no job is released
+ */
+//-----------------------------------------------------------------------------
+static int
+pick_job(
+        Cy3240_Scheduler_t* const pScheduler,
+        const Cy3240_Domain_t* const pDomain,
+        uint64_t now,
+        uint64_t* const pNext
+        )
+{
+    int pick = -1;
+    int same = -1;
+    uint64_t earliest = UINT64_MAX;
+    uint64_t earliestSame = UINT64_MAX;
+    int x;
+
+    *pNext = UINT64_MAX;
+
+    for (x = 0; x < pScheduler->count; x++) {
+
+        Cy3240_Job_State_t* pState = &pScheduler->jobs[x];
+
+        // The other bridges have workers of their own
+        if (pState->job.handle != pDomain->handle)
+            continue;
+
+        if (pState->release <= now) {
+
+            uint64_t deadline = pState->release + pState->job.deadline_us;
+
+            if (deadline < earliest) {
+                earliest = deadline;
+                pick = x;
+            }
+
+        } else if (pState->release < *pNext) {
+            *pNext = pState->release;
+        }
+    }
+
+    if (pick < 0)
+        return pick;
+
+    if (pScheduler->jobs[pick].clock == pDomain->clock)
+        return pick;
+
+    // Look for a released job that can run without a clock switch
+    for (x = 0; x < pScheduler->count; x++) {
+
+        Cy3240_Job_State_t* pState = &pScheduler->jobs[x];
+
+        if ((pState->release <= now) &&
+            (pState->job.handle == pDomain->handle) &&
+            (pState->clock == pDomain->clock) &&
+            (pState->release + pState->job.deadline_us < earliestSame)) {
+
+            earliestSame = pState->release + pState->job.deadline_us;
+            same = x;
+        }
+    }
+
+    if ((same >= 0) &&
+        (now + pScheduler->jobs[same].cost + pScheduler->jobs[pick].cost <= earliest))
+        return same;
+
+    return pick;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Scheduler worker thread, runs the jobs of one bridge
+ *
+ *  @param arg [in] the domain of the bridge
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+scheduler_thread(
+        void* arg
+        )
+{
+    Cy3240_Domain_t* const pDomain = (Cy3240_Domain_t*)arg;
+    Cy3240_Scheduler_t* const pScheduler = pDomain->pScheduler;
+    uint64_t now;
+
+    // Periodic reads go before other traffic and between its packets
+    cy3240_set_priority(CY3240_PRIORITY_REALTIME);
+
+    while (pScheduler->running) {
+
+        Cy3240_Job_State_t* pState;
+        Cy3240_Sample_t sample;
+        uint64_t next;
+        uint64_t start;
+        uint64_t jitter;
+        int pick;
+
+        now = cy3240_util_time_us();
+        pick = pick_job(pScheduler, pDomain, now, &next);
+
+        // Nothing released yet, sleep until the next release
+        if (pick < 0) {
+            cy3240_util_sleep_until_us(MIN(next, now + SCHEDULER_MAX_SLEEP_US));
+            continue;
+        }
+
+        pState = &pScheduler->jobs[pick];
+
+        start = now;
+        sample.job = pick;
+        sample.release_us = pState->release;
+        sample.result = run_job(&pState->job, &sample);
+        sample.complete_us = cy3240_util_time_us();
+
+        jitter = start - pState->release;
+
+        // Keep a running average of the execution time
+        if (pState->cost == 0)
+            pState->cost = sample.complete_us - start;
+        else
+            pState->cost = ((pState->cost * 7) + (sample.complete_us - start)) / 8;
+
+        pthread_mutex_lock(&pScheduler->lock);
+
+        pState->stats.runs++;
+
+        if (pState->clock != pDomain->clock) {
+            pState->stats.clock_switches++;
+            pDomain->clock = pState->clock;
+        }
+
+        if CY3240_FAILURE(sample.result)
+            pState->stats.errors++;
+
+        if (sample.complete_us > pState->release + pState->job.deadline_us)
+            pState->stats.misses++;
+
+        pState->stats.jitter_total_us += jitter;
+        pState->stats.jitter_max_us = MAX(pState->stats.jitter_max_us, jitter);
+
+        if (!cy3240_ring_push(pScheduler->pQueue, &sample))
+            pState->stats.dropped++;
+
+        // Schedule the next release. If we are more than a whole period
+        // late, skip releases rather than bursting to catch up.
+        pState->release += pState->job.period_us;
+
+        while (pState->release + pState->job.period_us <= sample.complete_us) {
+            pState->release += pState->job.period_us;
+            pState->stats.skipped++;
+        }
+
+        pthread_mutex_unlock(&pScheduler->lock);
+    }
+
+    return NULL;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_create(
+        Cy3240_Scheduler_t** ppScheduler,
+        uint32_t queue_capacity
+        )
+{
+    if ((ppScheduler != NULL) &&
+        (queue_capacity != 0) &&
+        ((queue_capacity & (queue_capacity - 1)) == 0)) {
+
+        Cy3240_Scheduler_t* pScheduler;
+
+        pScheduler = (Cy3240_Scheduler_t*)calloc(1, sizeof(Cy3240_Scheduler_t));
+
+        if (pScheduler == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        pScheduler->pQueue = (Cy3240_Ring_t*)malloc(
+                cy3240_ring_size(queue_capacity, sizeof(Cy3240_Sample_t)));
+
+        if (pScheduler->pQueue == NULL) {
+            free(pScheduler);
+            return CY3240_ERROR_UNKNOWN;
+        }
+
+        cy3240_ring_init(pScheduler->pQueue, queue_capacity, sizeof(Cy3240_Sample_t));
+        pthread_mutex_init(&pScheduler->lock, NULL);
+
+        *ppScheduler = pScheduler;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_add_job(
+        Cy3240_Scheduler_t* const pScheduler,
+        const Cy3240_Job_t* const pJob,
+        int* const pJobId
+        )
+{
+    if ((pScheduler != NULL) &&
+        (!pScheduler->started) &&
+        (pScheduler->count < CY3240_SCHEDULER_MAX_JOBS) &&
+        (pJob != NULL) &&
+        (pJob->length != 0) &&
+        (pJob->length <= CY3240_SCHEDULER_MAX_SAMPLE) &&
+        (pJob->period_us != 0)) {
+
+        Cy3240_Job_State_t* pState = &pScheduler->jobs[pScheduler->count];
+
+        memset(pState, 0x00, sizeof(Cy3240_Job_State_t));
+        pState->job = *pJob;
+
+        // Default to an implicit deadline
+        if (pState->job.deadline_us == 0)
+            pState->job.deadline_us = pState->job.period_us;
+
+        if (pJobId != NULL)
+            *pJobId = pScheduler->count;
+
+        pScheduler->count++;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_start(
+        Cy3240_Scheduler_t* const pScheduler
+        )
+{
+    if ((pScheduler != NULL) &&
+        (!pScheduler->started)) {
+
+        uint64_t now = cy3240_util_time_us();
+        int x;
+
+        // Release every job at the same instant so jobs with related periods
+        // fall in to the same cycle and run back to back
+        for (x = 0; x < pScheduler->count; x++) {
+
+            Cy3240_Job_State_t* pState = &pScheduler->jobs[x];
+
+            pState->release = now;
+
+            if CY3240_FAILURE(cy3240_get_slave_clock(pState->job.handle, pState->job.address, &pState->clock))
+                pState->clock = CY3240_CLOCK__Reserved;
+
+            find_domain(pScheduler, pState->job.handle);
+        }
+
+        pScheduler->running = true;
+
+        // One worker per bridge, a slow bridge does not hold up the others
+        for (x = 0; x < pScheduler->domain_count; x++) {
+
+            Cy3240_Domain_t* pDomain = &pScheduler->domains[x];
+
+            pDomain->pScheduler = pScheduler;
+
+            if (pthread_create(&pDomain->thread, NULL, scheduler_thread, pDomain) != 0) {
+
+                fprintf(stderr, "Failed to start the scheduler thread\n");
+                pScheduler->running = false;
+
+                while (x-- > 0)
+                    pthread_join(pScheduler->domains[x].thread, NULL);
+
+                return CY3240_ERROR_UNKNOWN;
+            }
+        }
+
+        pScheduler->started = true;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_stop(
+        Cy3240_Scheduler_t* const pScheduler
+        )
+{
+    if (pScheduler != NULL) {
+
+        if (pScheduler->started) {
+
+            int x;
+
+            pScheduler->running = false;
+
+            for (x = 0; x < pScheduler->domain_count; x++)
+                pthread_join(pScheduler->domains[x].thread, NULL);
+
+            pScheduler->started = false;
+        }
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_scheduler_poll(
+        Cy3240_Scheduler_t* const pScheduler,
+        Cy3240_Sample_t* const pSample
+        )
+{
+    if ((pScheduler != NULL) &&
+        (pSample != NULL))
+        return cy3240_ring_pop(pScheduler->pQueue, pSample);
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_get_stats(
+        Cy3240_Scheduler_t* const pScheduler,
+        int job,
+        Cy3240_Job_Stats_t* const pStats
+        )
+{
+    if ((pScheduler != NULL) &&
+        (job >= 0) &&
+        (job < pScheduler->count) &&
+        (pStats != NULL)) {
+
+        pthread_mutex_lock(&pScheduler->lock);
+        *pStats = pScheduler->jobs[job].stats;
+        pthread_mutex_unlock(&pScheduler->lock);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_destroy(
+        Cy3240_Scheduler_t* const pScheduler
+        )
+{
+    if (pScheduler != NULL) {
+
+        cy3240_scheduler_stop(pScheduler);
+
+        pthread_mutex_destroy(&pScheduler->lock);
+        free(pScheduler->pQueue);
+        free(pScheduler);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
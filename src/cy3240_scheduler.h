@@ -0,0 +1,212 @@
+/**
+ * @file cy3240_scheduler.h
+ *
+ * @brief Periodic sampling scheduler for the CY3240 bridge
+ *
+ * Runs periodic register reads for many sensors on one or more bridges, with
+ * one worker thread per bridge so a slow bridge does not hold up the
+ * others.  Released jobs of a bridge are served earliest deadline first and
+ * back to back, so the bus only idles when no job is pending.  Jobs in the
+ * clock domain the bridge is already running are preferred as long as this
+ * cannot make the earliest deadline job late, which keeps the number of
+ * clock switches low.  Each job selects its register and reads it in one
+ * pipelined transfer.  Samples are handed to the application through a
+ * lock-free ring.  The workers read in the realtime priority class, see
+ * cy3240_set_priority().
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_SCHEDULER_H
+#define INCLUSION_GUARD_CY3240_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_SCHEDULER_MAX_JOBS     (32)      ///< Maximum number of jobs per scheduler
+#define CY3240_SCHEDULER_MAX_SAMPLE   (61)      ///< Maximum bytes per sample, one read packet
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * A periodic register read
+ */
+typedef struct {
+    int handle;                                ///< Bridge the sensor is attached to
+    uint8_t address;                           ///< I2C address of the sensor
+    uint8_t reg;                               ///< Register to read
+    uint16_t length;                           ///< Number of bytes to read
+    uint32_t period_us;                        ///< Sampling period in microseconds
+    uint32_t deadline_us;                      ///< Relative deadline, 0 to use the period
+} Cy3240_Job_t;
+
+/**
+ * A sample delivered by the scheduler
+ */
+typedef struct {
+    int job;                                   ///< Id of the job that produced the sample
+    Cy3240_Error_t result;                     ///< Result of the read
+    uint16_t length;                           ///< Number of valid bytes in data
+    uint64_t release_us;                       ///< Time the job was released
+    uint64_t complete_us;                      ///< Time the read completed
+    uint8_t data[CY3240_SCHEDULER_MAX_SAMPLE]; ///< The register data
+} Cy3240_Sample_t;
+
+/**
+ * Per job timing statistics
+ */
+typedef struct {
+    uint64_t runs;                             ///< Number of completed reads
+    uint64_t errors;                           ///< Number of failed reads
+    uint64_t misses;                           ///< Reads that completed after the deadline
+    uint64_t skipped;                          ///< Releases skipped after an overrun
+    uint64_t dropped;                          ///< Samples dropped because the queue was full
+    uint64_t clock_switches;                   ///< Runs that needed a bridge clock switch
+    uint64_t jitter_max_us;                    ///< Largest release to start delay
+    uint64_t jitter_total_us;                  ///< Sum of release to start delays
+} Cy3240_Job_Stats_t;
+
+/**
+ * Opaque scheduler state
+ */
+typedef struct Cy3240_Scheduler_s Cy3240_Scheduler_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to create a scheduler
+ *
+ *  @param ppScheduler    [out] the new scheduler
+ *  @param queue_capacity [in] number of samples the queue holds, power of two
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_create(
+        Cy3240_Scheduler_t** ppScheduler,
+        uint32_t queue_capacity
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to add a periodic job. Jobs can only be added while stopped.
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @param pJob       [in] the job description
+ *  @param pJobId     [out] the id of the job, used in samples and statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_add_job(
+        Cy3240_Scheduler_t* const pScheduler,
+        const Cy3240_Job_t* const pJob,
+        int* const pJobId
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to start a worker thread for each bridge with jobs. All jobs are
+ *  released together.
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_start(
+        Cy3240_Scheduler_t* const pScheduler
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop the worker threads
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_stop(
+        Cy3240_Scheduler_t* const pScheduler
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to take the oldest sample from the queue without blocking.
+ *  Only one thread may consume samples.
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @param pSample    [out] the sample
+ *  @returns true if a sample was returned
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_scheduler_poll(
+        Cy3240_Scheduler_t* const pScheduler,
+        Cy3240_Sample_t* const pSample
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the statistics for a job
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @param job        [in] the job id
+ *  @param pStats     [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_get_stats(
+        Cy3240_Scheduler_t* const pScheduler,
+        int job,
+        Cy3240_Job_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop and free a scheduler
+ *
+ *  @param pScheduler [in] the scheduler
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_scheduler_destroy(
+        Cy3240_Scheduler_t* const pScheduler
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_SCHEDULER_H
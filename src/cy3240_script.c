@@ -0,0 +1,784 @@
+/**
+ * @file cy3240_script.c
+ *
+ * @brief Compiler and executor for .iic bridge command scripts
+ *
+ * Compiler and executor for .iic bridge command scripts
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_packet.h"
+#include "cy3240_util.h"
+#include "cy3240_script.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SCRIPT_MAX_LINE   (1024)   ///< Longest script line
+#define SCRIPT_MAX_OPS    (0xFFFF) ///< Most bus commands in a script
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * A line with bus commands
+ */
+typedef struct {
+    uint16_t first;                            ///< First operation
+    uint16_t count;                            ///< Number of operations
+    uint32_t read_offset;                      ///< Read data in the read pool
+    Cy3240_Script_Step_t info;                 ///< Result and timing
+} Cy3240_Script_Line_t;
+
+/**
+ * Operations sent as one transfer after a delay
+ */
+typedef struct {
+    uint32_t delay_us;                         ///< Delay before the transfer
+    uint16_t first;                            ///< First operation
+    uint16_t count;                            ///< Number of operations
+    uint32_t first_step;                       ///< First step
+    uint32_t steps;                            ///< Number of steps
+} Cy3240_Script_Batch_t;
+
+/**
+ * Compiled script
+ */
+struct Cy3240_Script_s {
+    Cy3240_Op_t* pOps;                         ///< The operations
+    uint32_t* pOffsets;                        ///< Pool offset of each operation
+    uint32_t offset_capacity;                  ///< Allocated offsets
+    uint8_t* pReports;                         ///< One packed report per operation
+    uint16_t op_count;                         ///< Number of operations
+    uint32_t op_capacity;                      ///< Allocated operations
+    Cy3240_Script_Line_t* pSteps;              ///< The steps
+    uint32_t step_count;                       ///< Number of steps
+    uint32_t step_capacity;                    ///< Allocated steps
+    Cy3240_Script_Batch_t* pBatches;           ///< The transfers
+    uint32_t batch_count;                      ///< Number of transfers
+    uint32_t batch_capacity;                   ///< Allocated transfers
+    uint8_t* pData;                            ///< Write data of all operations
+    uint32_t data_length;                      ///< Bytes used in the write pool
+    uint32_t data_capacity;                    ///< Allocated write pool
+    uint8_t* pRead;                            ///< Read buffers of all operations
+    uint32_t read_length;                      ///< Bytes used in the read pool
+    uint32_t read_capacity;                    ///< Allocated read pool
+};
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to make room for more elements in an array
+ *
+ *  @param ppArray   [in,out] the array
+ *  @param pCapacity [in,out] the number of elements allocated
+ *  @param needed    [in] the number of elements needed
+ *  @param size      [in] the size of an element
+ *  @returns false if out of memory
+ */
+//-----------------------------------------------------------------------------
+static bool
+grow(
+        void** ppArray,
+        uint32_t* const pCapacity,
+        uint32_t needed,
+        size_t size
+        )
+{
+    uint32_t capacity = *pCapacity ? *pCapacity : 16;
+    void* pArray;
+
+    if (needed <= *pCapacity)
+        return true;
+
+    while (capacity < needed)
+        capacity *= 2;
+
+    pArray = realloc(*ppArray, capacity * size);
+
+    if (pArray == NULL)
+        return false;
+
+    *ppArray = pArray;
+    *pCapacity = capacity;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to parse a hexadecimal number
+ *
+ *  @param pToken [in] the token, with or without 0x
+ *  @param max    [in] the largest allowed value
+ *  @param pValue [out] the value
+ *  @returns false if the token is not a number up to max
+ */
+//-----------------------------------------------------------------------------
+static bool
+parse_hex(
+        const char* pToken,
+        unsigned long max,
+        unsigned long* const pValue
+        )
+{
+    char* pEnd = NULL;
+
+    *pValue = strtoul(pToken, &pEnd, 16);
+
+    return (*pToken != '\0') && (*pEnd == '\0') && (*pValue <= max);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to add an operation to the current step and batch
+ *
+ *  @param pScript [in] the script
+ *  @param type    [in] the operation
+ *  @param address [in] the slave address
+ *  @param pData   [in] the bytes to write, NULL for reads and probes
+ *  @param length  [in] the number of bytes
+ *  @returns false if out of memory or the script is too long
+ */
+//-----------------------------------------------------------------------------
+static bool
+add_op(
+        Cy3240_Script_t* const pScript,
+        Cy3240_Op_Type_t type,
+        uint8_t address,
+        const uint8_t* const pData,
+        uint16_t length
+        )
+{
+    Cy3240_Op_t* pOp;
+
+    if (pScript->op_count == SCRIPT_MAX_OPS)
+        return false;
+
+    if (!grow((void**)&pScript->pOps, &pScript->op_capacity, pScript->op_count + 1, sizeof(Cy3240_Op_t)) ||
+        !grow((void**)&pScript->pOffsets, &pScript->offset_capacity, pScript->op_count + 1, sizeof(uint32_t)))
+        return false;
+
+    pOp = &pScript->pOps[pScript->op_count];
+    memset(pOp, 0x00, sizeof(Cy3240_Op_t));
+
+    pOp->type = type;
+    pOp->address = address;
+    pOp->length = length;
+
+    // The pools can still move, the pointers are set once they are complete
+    if (type == CY3240_OP_READ) {
+
+        if (!grow((void**)&pScript->pRead, &pScript->read_capacity, pScript->read_length + length, 1))
+            return false;
+
+        pScript->pOffsets[pScript->op_count] = pScript->read_length;
+        memset(&pScript->pRead[pScript->read_length], 0x00, length);
+        pScript->read_length += length;
+
+    } else if (length != 0) {
+
+        if (!grow((void**)&pScript->pData, &pScript->data_capacity, pScript->data_length + length, 1))
+            return false;
+
+        pScript->pOffsets[pScript->op_count] = pScript->data_length;
+        memcpy(&pScript->pData[pScript->data_length], pData, length);
+        pScript->data_length += length;
+    }
+
+    pScript->op_count++;
+    pScript->pSteps[pScript->step_count - 1].count++;
+    pScript->pBatches[pScript->batch_count - 1].count++;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to start a new batch
+ *
+ *  @param pScript  [in] the script
+ *  @param delay_us [in] the delay before the batch
+ *  @returns false if out of memory
+ */
+//-----------------------------------------------------------------------------
+static bool
+add_batch(
+        Cy3240_Script_t* const pScript,
+        uint32_t delay_us
+        )
+{
+    Cy3240_Script_Batch_t* pBatch;
+
+    if (!grow((void**)&pScript->pBatches, &pScript->batch_capacity, pScript->batch_count + 1, sizeof(Cy3240_Script_Batch_t)))
+        return false;
+
+    pBatch = &pScript->pBatches[pScript->batch_count++];
+
+    pBatch->delay_us = delay_us;
+    pBatch->first = pScript->op_count;
+    pBatch->count = 0;
+    pBatch->first_step = pScript->step_count;
+    pBatch->steps = 0;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to flush a pending write or read of a line
+ *
+ *  @param pScript [in] the script
+ *  @param segment [in] 'w', 'r' or 0 when nothing is pending
+ *  @param address [in] the slave address
+ *  @param pBytes  [in] the write data
+ *  @param length  [in] the number of bytes
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS on a syntax error
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+flush_segment(
+        Cy3240_Script_t* const pScript,
+        char segment,
+        uint8_t address,
+        const uint8_t* const pBytes,
+        uint16_t length
+        )
+{
+    bool added = true;
+
+    switch (segment) {
+
+        case 'w':
+            if (length == 0)
+                added = add_op(pScript, CY3240_OP_PROBE, address, NULL, 0);
+
+            else
+                added = add_op(pScript, CY3240_OP_WRITE, address, pBytes, length);
+            break;
+
+        case 'r':
+            if (length == 0)
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            added = add_op(pScript, CY3240_OP_READ, address, NULL, length);
+            break;
+
+        default:
+            break;
+    }
+
+    return added ? CY3240_ERROR_OK : CY3240_ERROR_UNKNOWN;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to compile one line
+ *
+ *  @param pScript [in] the script
+ *  @param pLine   [in,out] the line, modified by the tokenizer
+ *  @param number  [in] the line number
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS on a syntax error
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+compile_line(
+        Cy3240_Script_t* const pScript,
+        char* pLine,
+        int number
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint8_t bytes[CY3240_MAX_WRITE_BYTES];
+    uint16_t length = 0;
+    uint8_t address = 0;
+    char segment = 0;
+    bool expectAddress = false;
+    bool stepped = false;
+    bool delayed = false;
+    char* pSave = NULL;
+    char* pToken;
+    char* pComment;
+    unsigned long value;
+    unsigned long delay;
+
+    // Drop the comment
+    pComment = strchr(pLine, ';');
+
+    if (pComment != NULL)
+        *pComment = '\0';
+
+    for (pToken = strtok_r(pLine, " \t\r\n", &pSave);
+         CY3240_SUCCESS(result) && (pToken != NULL);
+         pToken = strtok_r(NULL, " \t\r\n", &pSave)) {
+
+        // A delay ends the transfer, the next commands start a new one
+        if (sscanf(pToken, "[delay=%lu]", &delay) == 1) {
+
+            // A delay has a line of its own
+            if (stepped)
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            delayed = true;
+
+            if (pScript->pBatches[pScript->batch_count - 1].count == 0)
+                pScript->pBatches[pScript->batch_count - 1].delay_us += delay * 1000;
+
+            else if (!add_batch(pScript, delay * 1000))
+                return CY3240_ERROR_UNKNOWN;
+
+            continue;
+        }
+
+        if (expectAddress) {
+
+            if (!parse_hex(pToken, 0x7F, &value))
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            address = (uint8_t)value;
+            expectAddress = false;
+            continue;
+        }
+
+        if (!strcasecmp(pToken, "s"))
+            continue;
+
+        if (!strcasecmp(pToken, "w") || !strcasecmp(pToken, "r")) {
+
+            // The first bus command of the line starts a step
+            if (!stepped) {
+
+                Cy3240_Script_Line_t* pStep;
+
+                if (delayed)
+                    return CY3240_ERROR_INVALID_PARAMETERS;
+
+                if (!grow((void**)&pScript->pSteps, &pScript->step_capacity, pScript->step_count + 1, sizeof(Cy3240_Script_Line_t)))
+                    return CY3240_ERROR_UNKNOWN;
+
+                pStep = &pScript->pSteps[pScript->step_count++];
+                memset(pStep, 0x00, sizeof(Cy3240_Script_Line_t));
+
+                pStep->first = pScript->op_count;
+                pStep->read_offset = pScript->read_length;
+                pStep->info.line = number;
+                pScript->pBatches[pScript->batch_count - 1].steps++;
+                stepped = true;
+            }
+
+            result = flush_segment(pScript, segment, address, bytes, length);
+
+            segment = (char)(*pToken | 0x20);
+            expectAddress = true;
+            length = 0;
+            continue;
+        }
+
+        if (!strcasecmp(pToken, "p")) {
+
+            result = flush_segment(pScript, segment, address, bytes, length);
+
+            segment = 0;
+            length = 0;
+            continue;
+        }
+
+        // Data of the pending write or read
+        if (segment == 'w') {
+
+            if ((length == CY3240_MAX_WRITE_BYTES) || !parse_hex(pToken, 0xFF, &value))
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            bytes[length++] = (uint8_t)value;
+
+        } else if ((segment == 'r') && !strcasecmp(pToken, "x")) {
+            length++;
+
+        } else if ((segment == 'r') && (sscanf(pToken, "x*%lu", &value) == 1) &&
+                   (value != 0) && (value <= CY3240_MAX_READ_BYTES)) {
+            length += value;
+
+        } else {
+            return CY3240_ERROR_INVALID_PARAMETERS;
+        }
+
+        if (length > CY3240_MAX_READ_BYTES)
+            return CY3240_ERROR_INVALID_PARAMETERS;
+    }
+
+    if (expectAddress)
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    if CY3240_SUCCESS(result)
+        result = flush_segment(pScript, segment, address, bytes, length);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to point the operations at the data pool and pack the reports
+ *
+ *  @param pScript [in] the script
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+link_script(
+        Cy3240_Script_t* const pScript
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint32_t x;
+    uint16_t y;
+
+    pScript->pReports = (uint8_t*)malloc((size_t)MAX(pScript->op_count, 1) * CY3240_REPORT_SIZE);
+
+    if (pScript->pReports == NULL)
+        return CY3240_ERROR_UNKNOWN;
+
+    for (x = 0; CY3240_SUCCESS(result) && (x < pScript->op_count); x++) {
+
+        Cy3240_Op_t* const pOp = &pScript->pOps[x];
+
+        if (pOp->type == CY3240_OP_READ)
+            pOp->pData = &pScript->pRead[pScript->pOffsets[x]];
+
+        else if (pOp->length != 0)
+            pOp->pData = &pScript->pData[pScript->pOffsets[x]];
+
+        result = cy3240_pack(
+                pOp,
+                &pScript->pReports[x * CY3240_REPORT_SIZE]);
+    }
+
+    // Reads of a step are next to each other in the read pool
+    for (x = 0; x < pScript->step_count; x++) {
+
+        Cy3240_Script_Line_t* const pStep = &pScript->pSteps[x];
+
+        pStep->info.pRead = (pScript->pRead != NULL) ? &pScript->pRead[pStep->read_offset] : NULL;
+        pStep->info.pOps = &pScript->pOps[pStep->first];
+        pStep->info.op_count = pStep->count;
+        pStep->info.skipped = true;
+
+        for (y = pStep->first; y < pStep->first + pStep->count; y++)
+            if (pScript->pOps[y].type == CY3240_OP_READ)
+                pStep->info.read_length += pScript->pOps[y].length;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to record the result and timing of the steps of a batch
+ *
+ *  @param pScript [in] the script
+ *  @param pBatch  [in] the batch
+ *  @param start   [in] the time the transfer started
+ *  @returns the result of the first failed step
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+record_batch(
+        Cy3240_Script_t* const pScript,
+        const Cy3240_Script_Batch_t* const pBatch,
+        uint64_t start
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint64_t previous = start;
+    uint32_t x;
+    uint16_t y;
+
+    for (x = pBatch->first_step; x < pBatch->first_step + pBatch->steps; x++) {
+
+        Cy3240_Script_Line_t* const pStep = &pScript->pSteps[x];
+        const Cy3240_Op_t* const pLast = &pScript->pOps[pStep->first + pStep->count - 1];
+        uint64_t end;
+
+        pStep->info.skipped = false;
+
+        for (y = pStep->first; y < pStep->first + pStep->count; y++)
+            if (CY3240_SUCCESS(pStep->info.result))
+                pStep->info.result = pScript->pOps[y].result;
+
+        // Operations that never completed keep an older time
+        end = MAX(pLast->complete_us, previous);
+
+        pStep->info.runs++;
+        pStep->info.last_us = end - previous;
+        pStep->info.total_us += pStep->info.last_us;
+        pStep->info.max_us = MAX(pStep->info.max_us, pStep->info.last_us);
+
+        if CY3240_FAILURE(pStep->info.result) {
+            pStep->info.errors++;
+
+            if CY3240_SUCCESS(result)
+                result = pStep->info.result;
+        }
+
+        previous = end;
+    }
+
+    return result;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_compile(
+        Cy3240_Script_t** ppScript,
+        const char* pText,
+        int* const pErrorLine
+        )
+{
+    if ((ppScript != NULL) &&
+        (pText != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Script_t* pScript;
+        char line[SCRIPT_MAX_LINE];
+        int number = 0;
+
+        if (pErrorLine != NULL)
+            *pErrorLine = 0;
+
+        pScript = (Cy3240_Script_t*)calloc(1, sizeof(Cy3240_Script_t));
+
+        if ((pScript == NULL) || !add_batch(pScript, 0)) {
+            free(pScript);
+            return CY3240_ERROR_UNKNOWN;
+        }
+
+        while (CY3240_SUCCESS(result) && (*pText != '\0')) {
+
+            const char* pEnd = strchr(pText, '\n');
+            size_t length = (pEnd != NULL) ? (size_t)(pEnd - pText) : strlen(pText);
+
+            number++;
+
+            if (length >= sizeof(line)) {
+                result = CY3240_ERROR_INVALID_PARAMETERS;
+                break;
+            }
+
+            memcpy(line, pText, length);
+            line[length] = '\0';
+
+            result = compile_line(pScript, line, number);
+
+            pText += length + ((pEnd != NULL) ? 1 : 0);
+        }
+
+        if CY3240_SUCCESS(result)
+            result = link_script(pScript);
+
+        else if (pErrorLine != NULL)
+            *pErrorLine = number;
+
+        if CY3240_FAILURE(result) {
+            cy3240_script_destroy(pScript);
+            return result;
+        }
+
+        *ppScript = pScript;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_load(
+        Cy3240_Script_t** ppScript,
+        const char* pPath,
+        int* const pErrorLine
+        )
+{
+    if ((ppScript != NULL) &&
+        (pPath != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        FILE* pFile = fopen(pPath, "r");
+        char* pText = NULL;
+        long size;
+
+        if (pFile == NULL) {
+            fprintf(stderr, "Failed to open script %s\n", pPath);
+            return CY3240_ERROR_INVALID_PARAMETERS;
+        }
+
+        fseek(pFile, 0, SEEK_END);
+        size = ftell(pFile);
+        fseek(pFile, 0, SEEK_SET);
+
+        if (size >= 0)
+            pText = (char*)malloc(size + 1);
+
+        if ((pText != NULL) &&
+            (fread(pText, 1, size, pFile) == (size_t)size)) {
+
+            pText[size] = '\0';
+            result = cy3240_script_compile(ppScript, pText, pErrorLine);
+
+        } else {
+            fprintf(stderr, "Failed to read script %s\n", pPath);
+            result = CY3240_ERROR_UNKNOWN;
+        }
+
+        free(pText);
+        fclose(pFile);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_run(
+        Cy3240_Script_t* const pScript,
+        int handle
+        )
+{
+    if (pScript != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        uint32_t x;
+
+        // Steps the run does not reach report nothing of an earlier run
+        for (x = 0; x < pScript->step_count; x++) {
+            pScript->pSteps[x].info.result = CY3240_ERROR_OK;
+            pScript->pSteps[x].info.skipped = true;
+        }
+
+        for (x = 0; CY3240_SUCCESS(result) && (x < pScript->batch_count); x++) {
+
+            const Cy3240_Script_Batch_t* const pBatch = &pScript->pBatches[x];
+            Cy3240_Error_t failure;
+            uint64_t start;
+
+            if (pBatch->delay_us != 0)
+                cy3240_util_sleep_until_us(cy3240_util_time_us() + pBatch->delay_us);
+
+            if (pBatch->count == 0)
+                continue;
+
+            start = cy3240_util_time_us();
+
+            result = cy3240_transfer_packed(
+                    handle,
+                    &pScript->pOps[pBatch->first],
+                    &pScript->pReports[pBatch->first * CY3240_REPORT_SIZE],
+                    pBatch->count);
+
+            failure = record_batch(pScript, pBatch, start);
+
+            if CY3240_SUCCESS(result)
+                result = failure;
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_get_step_count(
+        Cy3240_Script_t* const pScript,
+        uint32_t* const pCount
+        )
+{
+    if ((pScript != NULL) &&
+        (pCount != NULL)) {
+
+        *pCount = pScript->step_count;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_get_step(
+        Cy3240_Script_t* const pScript,
+        uint32_t step,
+        Cy3240_Script_Step_t* const pStep
+        )
+{
+    if ((pScript != NULL) &&
+        (step < pScript->step_count) &&
+        (pStep != NULL)) {
+
+        *pStep = pScript->pSteps[step].info;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_destroy(
+        Cy3240_Script_t* const pScript
+        )
+{
+    if (pScript != NULL) {
+
+        free(pScript->pOps);
+        free(pScript->pOffsets);
+        free(pScript->pReports);
+        free(pScript->pSteps);
+        free(pScript->pBatches);
+        free(pScript->pData);
+        free(pScript->pRead);
+        free(pScript);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
@@ -0,0 +1,184 @@
+/**
+ * @file cy3240_script.h
+ *
+ * @brief Compiler and executor for .iic bridge command scripts
+ *
+ * Runs scripts in the style of the Cypress Bridge Control Panel, see
+ * doc/USB_I2C_Bridge_Commands.iic. A script is compiled once in to packed
+ * HID reports; every run only sends them, so scripts that run many times
+ * are not parsed or packed again. All bus commands between two delays are
+ * sent as one pipelined transfer.
+ *
+ * The supported syntax, one transaction per line:
+ *
+ * @code
+ * ; comment up to the end of the line
+ * w 21 53 32 p          ; write 0x53 0x32 to the slave at 0x21
+ * w 21 51 00 1E r 21 x*60 p ; write, then read 60 bytes
+ * r 21 x x p            ; read two bytes
+ * w 21 p                ; address only probe
+ * [delay=10]            ; wait 10 milliseconds
+ * @endcode
+ *
+ * Addresses are 7 bit and all numbers are hexadecimal. The s and p start
+ * and stop tokens are optional. A repeated start is sent as a stop
+ * followed by a start, and every write or read must fit in one packet.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_SCRIPT_H
+#define INCLUSION_GUARD_CY3240_SCRIPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Result and timing of one script line with bus commands
+ */
+typedef struct {
+    int line;                                  ///< Line in the script
+    Cy3240_Error_t result;                     ///< Result of the last run
+    bool skipped;                              ///< The last run stopped before the line
+    const Cy3240_Op_t* pOps;                   ///< Bus commands with the results of the last run
+    uint16_t op_count;                         ///< Number of bus commands
+    const uint8_t* pRead;                      ///< Data read by the last run
+    uint16_t read_length;                      ///< Number of bytes read
+    uint64_t runs;                             ///< Number of runs
+    uint64_t errors;                           ///< Number of failed runs
+    uint64_t last_us;                          ///< Time of the last run
+    uint64_t max_us;                           ///< Longest run
+    uint64_t total_us;                         ///< Sum of all runs
+} Cy3240_Script_Step_t;
+
+/**
+ * Opaque compiled script
+ */
+typedef struct Cy3240_Script_s Cy3240_Script_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to compile a script
+ *
+ *  @param ppScript   [out] the compiled script
+ *  @param pText      [in] the script text
+ *  @param pErrorLine [out] the line of a syntax error, may be NULL
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS on a syntax error
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_compile(
+        Cy3240_Script_t** ppScript,
+        const char* pText,
+        int* const pErrorLine
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to compile a script file
+ *
+ *  @param ppScript   [out] the compiled script
+ *  @param pPath      [in] the .iic file
+ *  @param pErrorLine [out] the line of a syntax error, may be NULL
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_load(
+        Cy3240_Script_t** ppScript,
+        const char* pPath,
+        int* const pErrorLine
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a compiled script. The script stops after the first
+ *  transfer with a failed step.
+ *
+ *  @param pScript [in] the script
+ *  @param handle  [in] the handle to the bridge controller
+ *  @returns the first HID error or the result of the first failed step
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_run(
+        Cy3240_Script_t* const pScript,
+        int handle
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the number of steps, one per line with bus commands
+ *
+ *  @param pScript [in] the script
+ *  @param pCount  [out] the number of steps
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_get_step_count(
+        Cy3240_Script_t* const pScript,
+        uint32_t* const pCount
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the result, read data and timing of a step. The results
+ *  and data are only those of the last run when the step was not skipped.
+ *
+ *  @param pScript [in] the script
+ *  @param step    [in] the step
+ *  @param pStep   [out] the step information
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_get_step(
+        Cy3240_Script_t* const pScript,
+        uint32_t step,
+        Cy3240_Script_Step_t* const pStep
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to free a compiled script
+ *
+ *  @param pScript [in] the script
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_script_destroy(
+        Cy3240_Script_t* const pScript
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_SCRIPT_H
@@ -0,0 +1,1393 @@
+/**
+ * @file cy3240_server.c
+ *
+ * @brief Shares open bridges with other processes over a Unix socket
+ *
+ * Shares open bridges with other processes over a Unix socket
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <linux/memfd.h>
+#include "cy3240.h"
+#include "cy3240_packet.h"
+#include "cy3240_protocol.h"
+#include "cy3240_ring.h"
+#include "cy3240_server.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SHM_POLL_MS     (100)    ///< How often an idle ring session checks the socket
+#define SHM_ALIGN(x)    (((x) + CY3240_RING_CACHE_LINE - 1) & ~(size_t)(CY3240_RING_CACHE_LINE - 1))
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Connection slot states
+ */
+typedef enum {
+    CLIENT_FREE,                     ///< Slot is unused
+    CLIENT_ACTIVE,                   ///< A thread serves the connection
+    CLIENT_FINISHED                  ///< The thread ended and has to be joined
+} Client_State_t;
+
+/**
+ * A connection and the request it is waiting for
+ */
+typedef struct {
+    int state;                                 ///< Client_State_t
+    int fd;                                    ///< The connection
+    int bridge;                                ///< Bridge selected by the open request, -1 before
+    pthread_t thread;                          ///< Thread serving the connection
+    bool pending;                              ///< The request waits for the bridge worker
+    bool busy;                                 ///< The bridge worker runs the request
+    Cy3240_Msg_Header_t request;               ///< Header of the request
+    Cy3240_Msg_Header_t response;              ///< Header of the response
+    uint8_t* pRequest;                         ///< Body of the request
+    uint8_t* pResponse;                        ///< Body of the response
+    Cy3240_Op_t ops[CY3240_PROTOCOL_MAX_OPS];  ///< Decoded operations of a transfer
+    int shm;                                   ///< memfd still to be handed over, -1 if none
+    Cy3240_Shm_Header_t* pShm;                 ///< Shared memory, NULL before a map request
+    Cy3240_Ring_t* pRequests;                  ///< Operations from the client
+    Cy3240_Ring_t* pResponses;                 ///< Operations with their results
+    Cy3240_Ring_t* pSamples;                   ///< Published samples, NULL without a subscription
+} Server_Client_t;
+
+/**
+ * A shared bridge
+ */
+typedef struct {
+    Cy3240_Server_t* pServer;                  ///< The server
+    int handle;                                ///< The open bridge
+    char serial[CY3240_SERIAL_MAX];            ///< Serial number clients select it by
+    pthread_t thread;                          ///< Worker thread
+    pthread_cond_t work;                       ///< Signalled when a request is pending
+    int next;                                  ///< Client the next round starts at
+    int taken[CY3240_SERVER_MAX_CLIENTS];      ///< Clients of the current round
+    Cy3240_Op_t ops[CY3240_SERVER_BATCH_OPS];  ///< Merged operations of the current round
+} Server_Bridge_t;
+
+/**
+ * Server state
+ */
+struct Cy3240_Server_s {
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)]; ///< Socket path
+    int fd;                                    ///< Listening socket
+    bool started;                              ///< Threads exist
+    volatile bool running;                     ///< Threads should keep running
+    pthread_t thread;                          ///< Accept thread
+    pthread_mutex_t lock;                      ///< Protects the clients and the statistics
+    pthread_cond_t done;                       ///< Signalled when requests complete
+    Server_Bridge_t bridges[CY3240_SERVER_MAX_BRIDGES]; ///< The shared bridges
+    int bridge_count;                          ///< Number of bridges
+    Server_Client_t clients[CY3240_SERVER_MAX_CLIENTS]; ///< The connections
+    Cy3240_Server_Stats_t stats;               ///< Statistics
+};
+
+/**
+ * Argument of a connection thread
+ */
+typedef struct {
+    Cy3240_Server_t* pServer;                  ///< The server
+    Server_Client_t* pClient;                  ///< The connection
+} Server_Connection_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read exactly length bytes from a socket
+ *
+ *  @param fd      [in] the socket
+ *  @param pBuffer [out] the data
+ *  @param length  [in] the number of bytes
+ *  @returns false at the end of the stream or on an error
+ */
+//-----------------------------------------------------------------------------
+static bool
+read_full(
+        int fd,
+        void* const pBuffer,
+        size_t length
+        )
+{
+    uint8_t* pNext = (uint8_t*)pBuffer;
+
+    while (length > 0) {
+
+        ssize_t bytes = recv(fd, pNext, length, 0);
+
+        if ((bytes < 0) && (errno == EINTR))
+            continue;
+
+        if (bytes <= 0)
+            return false;
+
+        pNext += bytes;
+        length -= (size_t)bytes;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to write exactly length bytes to a socket, a peer that went away
+ *  is reported instead of raising SIGPIPE
+ *
+ *  @param fd      [in] the socket
+ *  @param pBuffer [in] the data
+ *  @param length  [in] the number of bytes
+ *  @returns false on an error
+ */
+//-----------------------------------------------------------------------------
+static bool
+write_full(
+        int fd,
+        const void* const pBuffer,
+        size_t length
+        )
+{
+    const uint8_t* pNext = (const uint8_t*)pBuffer;
+
+    while (length > 0) {
+
+        ssize_t bytes = send(fd, pNext, length, MSG_NOSIGNAL);
+
+        if ((bytes < 0) && (errno == EINTR))
+            continue;
+
+        if (bytes <= 0)
+            return false;
+
+        pNext += bytes;
+        length -= (size_t)bytes;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to decode the operations of a transfer request. Writes point in
+ *  to the request, reads in to the response after the result bytes.
+ *
+ *  @param pClient [in] the connection with the request
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS if the request is malformed
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+decode_transfer(
+        Server_Client_t* const pClient
+        )
+{
+    const uint16_t count = pClient->request.count;
+    uint32_t offset = 0;
+    uint32_t readOffset = count;
+    uint16_t x;
+
+    if ((count == 0) ||
+        (count > CY3240_PROTOCOL_MAX_OPS))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    for (x = 0; x < count; x++) {
+
+        Cy3240_Op_t* const pOp = &pClient->ops[x];
+        const uint8_t* pHeader = &pClient->pRequest[offset];
+
+        if (offset + CY3240_PROTOCOL_OP_HEADER > pClient->request.length)
+            return CY3240_ERROR_INVALID_PARAMETERS;
+
+        memset(pOp, 0x00, sizeof(Cy3240_Op_t));
+        pOp->type = (Cy3240_Op_Type_t)pHeader[0];
+        pOp->address = pHeader[1];
+        pOp->length = pHeader[2];
+        offset += CY3240_PROTOCOL_OP_HEADER;
+
+        switch (pOp->type) {
+
+            case CY3240_OP_WRITE:
+                if ((pOp->length == 0) ||
+                    (pOp->length > CY3240_MAX_WRITE_BYTES) ||
+                    (offset + pOp->length > pClient->request.length))
+                    return CY3240_ERROR_INVALID_PARAMETERS;
+
+                pOp->pData = &pClient->pRequest[offset];
+                offset += pOp->length;
+                break;
+
+            case CY3240_OP_READ:
+                if ((pOp->length == 0) ||
+                    (pOp->length > CY3240_MAX_READ_BYTES))
+                    return CY3240_ERROR_INVALID_PARAMETERS;
+
+                pOp->pData = &pClient->pResponse[readOffset];
+                readOffset += pOp->length;
+                break;
+
+            case CY3240_OP_PROBE:
+                pOp->length = 0;
+                break;
+
+            default:
+                return CY3240_ERROR_INVALID_PARAMETERS;
+        }
+    }
+
+    if (offset != pClient->request.length)
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    pClient->response.length = readOffset;
+
+    return CY3240_ERROR_OK;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check a request before it is queued for the bridge
+ *
+ *  @param pClient [in] the connection with the request
+ *  @returns CY3240_ERROR_INVALID_PARAMETERS if the request is malformed
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+prepare_request(
+        Server_Client_t* const pClient
+        )
+{
+    uint16_t length;
+
+    switch (pClient->request.type) {
+
+        case CY3240_MSG_TRANSFER:
+            return decode_transfer(pClient);
+
+        case CY3240_MSG_WRITE:
+            if ((pClient->request.length < 2) ||
+                (pClient->request.length - 1 > UINT16_MAX))
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            return CY3240_ERROR_OK;
+
+        case CY3240_MSG_READ:
+            if (pClient->request.length != 1 + sizeof(length))
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            memcpy(&length, &pClient->pRequest[1], sizeof(length));
+
+            return (length != 0) ? CY3240_ERROR_OK : CY3240_ERROR_INVALID_PARAMETERS;
+
+        case CY3240_MSG_STATS:
+            return (pClient->request.length == 0) ? CY3240_ERROR_OK : CY3240_ERROR_INVALID_PARAMETERS;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a request that is not merged with others
+ *
+ *  @param pBridge [in] the bridge
+ *  @param pClient [in,out] the connection with the request
+ */
+//-----------------------------------------------------------------------------
+static void
+run_single(
+        Server_Bridge_t* const pBridge,
+        Server_Client_t* const pClient
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Stats_t stats;
+    uint16_t length = 0;
+
+    switch (pClient->request.type) {
+
+        case CY3240_MSG_WRITE:
+            length = (uint16_t)(pClient->request.length - 1);
+
+            result = cy3240_write(
+                    pBridge->handle,
+                    pClient->pRequest[0],
+                    &pClient->pRequest[1],
+                    &length);
+
+            length = 0;
+            break;
+
+        case CY3240_MSG_READ:
+            memcpy(&length, &pClient->pRequest[1], sizeof(length));
+
+            result = cy3240_read(
+                    pBridge->handle,
+                    pClient->pRequest[0],
+                    pClient->pResponse,
+                    &length);
+            break;
+
+        case CY3240_MSG_STATS:
+            result = cy3240_get_stats(
+                    pBridge->handle,
+                    &stats);
+
+            memcpy(pClient->pResponse, &stats, sizeof(stats));
+            length = sizeof(stats);
+            break;
+    }
+
+    pClient->response.result = (int8_t)result;
+    pClient->response.length = CY3240_SUCCESS(result) ? length : 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run the transfers of a round as one pipelined transfer and
+ *  hand every client its results
+ *
+ *  @param pBridge [in] the bridge
+ *  @param taken   [in] the number of clients in pBridge->taken
+ */
+//-----------------------------------------------------------------------------
+static void
+run_merged(
+        Server_Bridge_t* const pBridge,
+        int taken
+        )
+{
+    Cy3240_Server_t* const pServer = pBridge->pServer;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t count = 0;
+    int x;
+    int y;
+
+    for (x = 0; x < taken; x++) {
+
+        Server_Client_t* const pClient = &pServer->clients[pBridge->taken[x]];
+
+        memcpy(&pBridge->ops[count], pClient->ops, pClient->request.count * sizeof(Cy3240_Op_t));
+        count += pClient->request.count;
+    }
+
+    // Every operation gets a result even if the transfer is refused
+    for (y = 0; y < count; y++)
+        pBridge->ops[y].result = CY3240_ERROR_UNKNOWN;
+
+    result = cy3240_transfer(
+            pBridge->handle,
+            pBridge->ops,
+            count);
+
+    // Read data already landed in each response, only the results remain
+    for (x = 0, count = 0; x < taken; x++) {
+
+        Server_Client_t* const pClient = &pServer->clients[pBridge->taken[x]];
+
+        for (y = 0; y < pClient->request.count; y++)
+            pClient->pResponse[y] = (uint8_t)pBridge->ops[count++].result;
+
+        pClient->response.count = pClient->request.count;
+        pClient->response.result = (int8_t)result;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bridge worker thread. Each round takes at most one pending request per
+ *  client, starting after the last client served, and stops at the first
+ *  request that cannot be merged.
+ *
+ *  @param arg [in] the bridge
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+bridge_thread(
+        void* arg
+        )
+{
+    Server_Bridge_t* const pBridge = (Server_Bridge_t*)arg;
+    Cy3240_Server_t* const pServer = pBridge->pServer;
+    const int index = (int)(pBridge - pServer->bridges);
+
+    pthread_mutex_lock(&pServer->lock);
+
+    while (pServer->running) {
+
+        const int start = pBridge->next;
+        int single = -1;
+        int taken = 0;
+        int ops = 0;
+        int x;
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+
+            const int slot = (start + x) % CY3240_SERVER_MAX_CLIENTS;
+            Server_Client_t* const pClient = &pServer->clients[slot];
+
+            if ((pClient->state != CLIENT_ACTIVE) ||
+                !pClient->pending ||
+                (pClient->bridge != index))
+                continue;
+
+            // Multi packet requests run on their own
+            if (pClient->request.type != CY3240_MSG_TRANSFER) {
+
+                if (taken == 0) {
+                    single = slot;
+                    pBridge->next = slot + 1;
+                }
+
+                break;
+            }
+
+            if (ops + pClient->request.count > CY3240_SERVER_BATCH_OPS)
+                break;
+
+            pBridge->taken[taken++] = slot;
+            pBridge->next = slot + 1;
+            ops += pClient->request.count;
+        }
+
+        if ((single < 0) && (taken == 0)) {
+            pthread_cond_wait(&pBridge->work, &pServer->lock);
+            continue;
+        }
+
+        for (x = 0; x < taken; x++)
+            pServer->clients[pBridge->taken[x]].busy = true;
+
+        if (single >= 0)
+            pServer->clients[single].busy = true;
+
+        pthread_mutex_unlock(&pServer->lock);
+
+        if (single >= 0)
+            run_single(pBridge, &pServer->clients[single]);
+        else
+            run_merged(pBridge, taken);
+
+        pthread_mutex_lock(&pServer->lock);
+
+        if (single >= 0) {
+            pServer->clients[single].pending = false;
+            pServer->clients[single].busy = false;
+            pServer->stats.requests++;
+
+        } else {
+            for (x = 0; x < taken; x++) {
+                pServer->clients[pBridge->taken[x]].pending = false;
+                pServer->clients[pBridge->taken[x]].busy = false;
+            }
+
+            pServer->stats.requests += taken;
+            pServer->stats.batches++;
+
+            if (taken > 1)
+                pServer->stats.merged += taken;
+        }
+
+        pthread_cond_broadcast(&pServer->done);
+    }
+
+    pthread_mutex_unlock(&pServer->lock);
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to find a bridge by serial number
+ *
+ *  @param pServer [in] the server
+ *  @param pSerial [in] the serial number, empty for the first bridge
+ *  @returns the index of the bridge, -1 if it is not shared
+ */
+//-----------------------------------------------------------------------------
+static int
+find_bridge(
+        Cy3240_Server_t* const pServer,
+        const char* pSerial
+        )
+{
+    int x;
+
+    if (pSerial[0] == '\0')
+        return (pServer->bridge_count > 0) ? 0 : -1;
+
+    for (x = 0; x < pServer->bridge_count; x++)
+        if (!strcmp(pServer->bridges[x].serial, pSerial))
+            return x;
+
+    return -1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to hand a prepared request to the bridge worker and wait until
+ *  it ran
+ *
+ *  @param pServer [in] the server
+ *  @param pClient [in,out] the connection with the request
+ */
+//-----------------------------------------------------------------------------
+static void
+wait_for_bridge(
+        Cy3240_Server_t* const pServer,
+        Server_Client_t* const pClient
+        )
+{
+    pthread_mutex_lock(&pServer->lock);
+
+    pClient->pending = true;
+    pthread_cond_signal(&pServer->bridges[pClient->bridge].work);
+
+    // The worker may still use the buffers after a stop
+    while (pClient->pending && (pServer->running || pClient->busy))
+        pthread_cond_wait(&pServer->done, &pServer->lock);
+
+    if (pClient->pending) {
+        pClient->pending = false;
+        pClient->response.result = CY3240_ERROR_UNKNOWN;
+        pClient->response.length = 0;
+    }
+
+    pthread_mutex_unlock(&pServer->lock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to create the shared memory of a connection, see cy3240_protocol.h
+ *
+ *  @param pServer   [in] the server
+ *  @param pClient   [in,out] the connection
+ *  @param subscribe [in] add a sample ring
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+map_shared(
+        Cy3240_Server_t* const pServer,
+        Server_Client_t* const pClient,
+        bool subscribe
+        )
+{
+    const size_t opsSize = SHM_ALIGN(cy3240_ring_size(CY3240_SHM_OPS, sizeof(Cy3240_Shm_Op_t)));
+    const size_t samplesSize = SHM_ALIGN(cy3240_ring_size(CY3240_SHM_SAMPLES, sizeof(Cy3240_Sample_t)));
+    const size_t size = SHM_ALIGN(sizeof(Cy3240_Shm_Header_t)) + 2 * opsSize + (subscribe ? samplesSize : 0);
+    Cy3240_Shm_Header_t* pShm;
+    uint8_t* pBase;
+    int fd;
+
+    if (pClient->pShm != NULL)
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    fd = (int)syscall(SYS_memfd_create, "cy3240d", MFD_CLOEXEC);
+
+    if (fd < 0)
+        return CY3240_ERROR_UNKNOWN;
+
+    pBase = (ftruncate(fd, size) == 0) ?
+        (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) :
+        (uint8_t*)MAP_FAILED;
+
+    if (pBase == (uint8_t*)MAP_FAILED) {
+        close(fd);
+        return CY3240_ERROR_UNKNOWN;
+    }
+
+    pShm = (Cy3240_Shm_Header_t*)pBase;
+    pShm->size = (uint32_t)size;
+    pShm->requests = (uint32_t)SHM_ALIGN(sizeof(Cy3240_Shm_Header_t));
+    pShm->responses = (uint32_t)(pShm->requests + opsSize);
+    pShm->samples = subscribe ? (uint32_t)(pShm->responses + opsSize) : 0;
+    pShm->dropped = 0;
+
+    cy3240_ring_init((Cy3240_Ring_t*)&pBase[pShm->requests], CY3240_SHM_OPS, sizeof(Cy3240_Shm_Op_t));
+    cy3240_ring_init((Cy3240_Ring_t*)&pBase[pShm->responses], CY3240_SHM_OPS, sizeof(Cy3240_Shm_Op_t));
+
+    if (subscribe)
+        cy3240_ring_init((Cy3240_Ring_t*)&pBase[pShm->samples], CY3240_SHM_SAMPLES, sizeof(Cy3240_Sample_t));
+
+    pthread_mutex_lock(&pServer->lock);
+
+    pClient->shm = fd;
+    pClient->pShm = pShm;
+    pClient->pRequests = (Cy3240_Ring_t*)&pBase[pShm->requests];
+    pClient->pResponses = (Cy3240_Ring_t*)&pBase[pShm->responses];
+    pClient->pSamples = subscribe ? (Cy3240_Ring_t*)&pBase[pShm->samples] : NULL;
+
+    pthread_mutex_unlock(&pServer->lock);
+
+    return CY3240_ERROR_OK;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to release the shared memory of a connection
+ *
+ *  @param pServer [in] the server
+ *  @param pClient [in,out] the connection
+ */
+//-----------------------------------------------------------------------------
+static void
+unmap_shared(
+        Cy3240_Server_t* const pServer,
+        Server_Client_t* const pClient
+        )
+{
+    Cy3240_Shm_Header_t* const pShm = pClient->pShm;
+
+    if (pShm == NULL)
+        return;
+
+    // Publishers look at the rings under the lock
+    pthread_mutex_lock(&pServer->lock);
+
+    pClient->pShm = NULL;
+    pClient->pRequests = NULL;
+    pClient->pResponses = NULL;
+    pClient->pSamples = NULL;
+
+    pthread_mutex_unlock(&pServer->lock);
+
+    if (pClient->shm >= 0)
+        close(pClient->shm);
+
+    pClient->shm = -1;
+    munmap(pShm, pShm->size);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to send a response with a file descriptor attached
+ *
+ *  @param fd         [in] the connection
+ *  @param pBuffer    [in] the response
+ *  @param length     [in] the length of the response
+ *  @param descriptor [in] the file descriptor to hand over
+ *  @returns false if the response was not sent
+ */
+//-----------------------------------------------------------------------------
+static bool
+send_descriptor(
+        int fd,
+        const void* const pBuffer,
+        size_t length,
+        int descriptor
+        )
+{
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr message;
+    struct iovec vector;
+    struct cmsghdr* pHeader;
+
+    memset(&control, 0x00, sizeof(control));
+    memset(&message, 0x00, sizeof(message));
+
+    vector.iov_base = (void*)pBuffer;
+    vector.iov_len = length;
+
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    pHeader = CMSG_FIRSTHDR(&message);
+    pHeader->cmsg_level = SOL_SOCKET;
+    pHeader->cmsg_type = SCM_RIGHTS;
+    pHeader->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(pHeader), &descriptor, sizeof(int));
+
+    return sendmsg(fd, &message, MSG_NOSIGNAL) == (ssize_t)length;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check that the client of a ring session is still connected
+ *
+ *  @param fd [in] the connection
+ *  @returns false once the client closed the connection
+ */
+//-----------------------------------------------------------------------------
+static bool
+peer_alive(
+        int fd
+        )
+{
+    uint8_t byte;
+    ssize_t bytes = recv(fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+
+    return (bytes > 0) || ((bytes < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to serve the rings of a connection. Every wake up takes what the
+ *  client queued, up to one transfer request, and runs it through the
+ *  bridge worker like a socket transfer, so it is merged with the
+ *  requests of the other clients.
+ *
+ *  @param pServer [in] the server
+ *  @param pClient [in,out] the connection
+ */
+//-----------------------------------------------------------------------------
+static void
+serve_shared(
+        Cy3240_Server_t* const pServer,
+        Server_Client_t* const pClient
+        )
+{
+    // The request body is free for the operations taken from the ring
+    Cy3240_Shm_Op_t* const pTaken = (Cy3240_Shm_Op_t*)pClient->pRequest;
+    uint16_t map[CY3240_PROTOCOL_MAX_OPS];
+
+    while (pServer->running) {
+
+        uint16_t count = 0;
+        uint16_t valid = 0;
+        uint16_t x;
+
+        // The socket is only checked while the client is idle
+        if (!cy3240_ring_wait(pClient->pRequests, SHM_POLL_MS)) {
+
+            if (!peer_alive(pClient->fd))
+                break;
+
+            continue;
+        }
+
+        while ((count < CY3240_PROTOCOL_MAX_OPS) &&
+               cy3240_ring_pop(pClient->pRequests, &pTaken[count]))
+            count++;
+
+        for (x = 0; x < count; x++) {
+
+            Cy3240_Shm_Op_t* const pShared = &pTaken[x];
+            Cy3240_Op_t* const pOp = &pClient->ops[valid];
+
+            pShared->result = CY3240_ERROR_INVALID_PARAMETERS;
+
+            if ((pShared->type == CY3240_OP_PROBE) ||
+                (((pShared->type == CY3240_OP_WRITE) || (pShared->type == CY3240_OP_READ)) &&
+                 (pShared->length != 0) &&
+                 (pShared->length <= CY3240_MAX_WRITE_BYTES))) {
+
+                memset(pOp, 0x00, sizeof(Cy3240_Op_t));
+                pOp->type = (Cy3240_Op_Type_t)pShared->type;
+                pOp->address = pShared->address;
+                pOp->length = (pOp->type == CY3240_OP_PROBE) ? 0 : pShared->length;
+                pOp->pData = pShared->data;
+                map[valid++] = x;
+            }
+        }
+
+        if (valid > 0) {
+
+            memset(&pClient->response, 0x00, sizeof(pClient->response));
+            pClient->request.type = CY3240_MSG_TRANSFER;
+            pClient->request.count = valid;
+
+            wait_for_bridge(pServer, pClient);
+
+            // Without a result per operation the round was abandoned
+            for (x = 0; x < valid; x++)
+                pTaken[map[x]].result = (pClient->response.count == valid) ?
+                    (int8_t)pClient->pResponse[x] :
+                    pClient->response.result;
+        }
+
+        // The client never has more operations out than the ring holds
+        for (x = 0; x < count; x++)
+            cy3240_ring_push(pClient->pResponses, &pTaken[x]);
+
+        cy3240_ring_wake(pClient->pResponses);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a request of a connection and wait for the result
+ *
+ *  @param pServer [in] the server
+ *  @param pClient [in,out] the connection with the request
+ */
+//-----------------------------------------------------------------------------
+static void
+handle_request(
+        Cy3240_Server_t* const pServer,
+        Server_Client_t* const pClient
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    char serial[CY3240_SERIAL_MAX];
+
+    memset(&pClient->response, 0x00, sizeof(pClient->response));
+    pClient->response.type = pClient->request.type;
+
+    if (pClient->request.type == CY3240_MSG_OPEN) {
+
+        if (pClient->request.length >= sizeof(serial)) {
+            pClient->response.result = CY3240_ERROR_INVALID_PARAMETERS;
+            return;
+        }
+
+        memcpy(serial, pClient->pRequest, pClient->request.length);
+        serial[pClient->request.length] = '\0';
+
+        pClient->bridge = find_bridge(pServer, serial);
+        pClient->response.result = (pClient->bridge >= 0) ? CY3240_ERROR_OK : CY3240_ERROR_HID;
+        return;
+    }
+
+    if (pClient->bridge < 0)
+        result = CY3240_ERROR_INVALID_PARAMETERS;
+
+    if (pClient->request.type == CY3240_MSG_MAP) {
+
+        if (CY3240_SUCCESS(result) && (pClient->request.length == 1))
+            result = map_shared(pServer, pClient, pClient->pRequest[0] != 0);
+        else
+            result = CY3240_ERROR_INVALID_PARAMETERS;
+
+        pClient->response.result = (int8_t)result;
+        return;
+    }
+
+    if CY3240_SUCCESS(result)
+        result = prepare_request(pClient);
+
+    if CY3240_FAILURE(result) {
+        pClient->response.result = (int8_t)result;
+        pClient->response.length = 0;
+        return;
+    }
+
+    wait_for_bridge(pServer, pClient);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Connection thread, serves the requests of one client in order
+ *
+ *  @param arg [in] the Server_Connection_t, freed here
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+client_thread(
+        void* arg
+        )
+{
+    Server_Connection_t connection = *(Server_Connection_t*)arg;
+    Cy3240_Server_t* const pServer = connection.pServer;
+    Server_Client_t* const pClient = connection.pClient;
+
+    free(arg);
+
+    while (read_full(pClient->fd, &pClient->request, sizeof(pClient->request)) &&
+           (pClient->request.length <= CY3240_PROTOCOL_MAX_BODY) &&
+           read_full(pClient->fd, pClient->pRequest, pClient->request.length)) {
+
+        handle_request(pServer, pClient);
+
+        // After a map request the connection only carries the rings
+        if (pClient->shm >= 0) {
+
+            if (send_descriptor(pClient->fd, &pClient->response, sizeof(pClient->response), pClient->shm)) {
+                close(pClient->shm);
+                pClient->shm = -1;
+                serve_shared(pServer, pClient);
+            }
+
+            break;
+        }
+
+        if (!write_full(pClient->fd, &pClient->response, sizeof(pClient->response)) ||
+            !write_full(pClient->fd, pClient->pResponse, pClient->response.length))
+            break;
+    }
+
+    unmap_shared(pServer, pClient);
+
+    pthread_mutex_lock(&pServer->lock);
+    close(pClient->fd);
+    pClient->fd = -1;
+    pClient->state = CLIENT_FINISHED;
+    pthread_mutex_unlock(&pServer->lock);
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to give an accepted connection a slot and a thread
+ *
+ *  @param pServer [in] the server
+ *  @param fd      [in] the connection
+ *  @returns false if the connection was refused
+ */
+//-----------------------------------------------------------------------------
+static bool
+add_client(
+        Cy3240_Server_t* const pServer,
+        int fd
+        )
+{
+    Server_Client_t* pClient = NULL;
+    Server_Connection_t* pConnection;
+    int x;
+
+    for (x = 0; (x < CY3240_SERVER_MAX_CLIENTS) && (pClient == NULL); x++)
+        if (pServer->clients[x].state != CLIENT_ACTIVE)
+            pClient = &pServer->clients[x];
+
+    if ((pClient == NULL) || !pServer->running)
+        return false;
+
+    // The thread that served the slot last is done with it
+    if (pClient->state == CLIENT_FINISHED) {
+        pthread_join(pClient->thread, NULL);
+        pClient->state = CLIENT_FREE;
+    }
+
+    // The buffers are kept for the next connection in the slot
+    if (pClient->pRequest == NULL)
+        pClient->pRequest = (uint8_t*)malloc(CY3240_PROTOCOL_MAX_BODY);
+
+    if (pClient->pResponse == NULL)
+        pClient->pResponse = (uint8_t*)malloc(CY3240_PROTOCOL_MAX_BODY);
+
+    pConnection = (Server_Connection_t*)malloc(sizeof(Server_Connection_t));
+
+    if ((pClient->pRequest == NULL) ||
+        (pClient->pResponse == NULL) ||
+        (pConnection == NULL)) {
+        free(pConnection);
+        return false;
+    }
+
+    pConnection->pServer = pServer;
+    pConnection->pClient = pClient;
+
+    pClient->fd = fd;
+    pClient->bridge = -1;
+    pClient->pending = false;
+    pClient->busy = false;
+    pClient->shm = -1;
+    pClient->pShm = NULL;
+    pClient->pRequests = NULL;
+    pClient->pResponses = NULL;
+    pClient->pSamples = NULL;
+    pClient->state = CLIENT_ACTIVE;
+
+    if (pthread_create(&pClient->thread, NULL, client_thread, pConnection) != 0) {
+        pClient->state = CLIENT_FREE;
+        free(pConnection);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Accept thread
+ *
+ *  @param arg [in] the server
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+accept_thread(
+        void* arg
+        )
+{
+    Cy3240_Server_t* const pServer = (Cy3240_Server_t*)arg;
+
+    while (pServer->running) {
+
+        int fd = accept(pServer->fd, NULL, NULL);
+
+        if (fd < 0) {
+
+            if ((errno == EINTR) || (errno == ECONNABORTED))
+                continue;
+
+            // The listening socket was shut down
+            break;
+        }
+
+        pthread_mutex_lock(&pServer->lock);
+
+        if (add_client(pServer, fd)) {
+            pServer->stats.connections++;
+
+        } else {
+            pServer->stats.rejected++;
+            close(fd);
+        }
+
+        pthread_mutex_unlock(&pServer->lock);
+    }
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to bind the listening socket, replacing the socket file of a
+ *  server that is no longer running
+ *
+ *  @param pServer [in] the server
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+bind_socket(
+        Cy3240_Server_t* const pServer
+        )
+{
+    struct sockaddr_un address;
+    int bound;
+
+    memset(&address, 0x00, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, pServer->path);
+
+    pServer->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (pServer->fd < 0)
+        return CY3240_ERROR_UNKNOWN;
+
+    bound = bind(pServer->fd, (struct sockaddr*)&address, sizeof(address));
+
+    if ((bound != 0) && (errno == EADDRINUSE)) {
+
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        // Nobody answers on a stale socket file
+        if ((probe >= 0) &&
+            (connect(probe, (struct sockaddr*)&address, sizeof(address)) != 0) &&
+            (errno == ECONNREFUSED))
+            unlink(pServer->path);
+
+        if (probe >= 0)
+            close(probe);
+
+        bound = bind(pServer->fd, (struct sockaddr*)&address, sizeof(address));
+    }
+
+    // Only a bound socket may listen, whatever kept it from binding
+    if (bound != 0) {
+        fprintf(stderr, "Failed to bind %s: %s\n", pServer->path, strerror(errno));
+        close(pServer->fd);
+        pServer->fd = -1;
+        return CY3240_ERROR_UNKNOWN;
+    }
+
+    if (listen(pServer->fd, CY3240_SERVER_MAX_CLIENTS) != 0) {
+        fprintf(stderr, "Failed to listen on %s\n", pServer->path);
+        close(pServer->fd);
+        pServer->fd = -1;
+        unlink(pServer->path);
+        return CY3240_ERROR_UNKNOWN;
+    }
+
+    return CY3240_ERROR_OK;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_create(
+        Cy3240_Server_t** ppServer,
+        const char* pPath
+        )
+{
+    if (pPath == NULL)
+        pPath = CY3240_PROTOCOL_DEFAULT_PATH;
+
+    if ((ppServer != NULL) &&
+        (strlen(pPath) < sizeof(((Cy3240_Server_t*)0)->path))) {
+
+        Cy3240_Server_t* const pServer = (Cy3240_Server_t*)calloc(1, sizeof(Cy3240_Server_t));
+        int x;
+
+        if (pServer == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        strcpy(pServer->path, pPath);
+        pServer->fd = -1;
+        pthread_mutex_init(&pServer->lock, NULL);
+        pthread_cond_init(&pServer->done, NULL);
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+            pServer->clients[x].state = CLIENT_FREE;
+            pServer->clients[x].fd = -1;
+        }
+
+        for (x = 0; x < CY3240_SERVER_MAX_BRIDGES; x++) {
+            pServer->bridges[x].pServer = pServer;
+            pthread_cond_init(&pServer->bridges[x].work, NULL);
+        }
+
+        *ppServer = pServer;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_add_bridge(
+        Cy3240_Server_t* const pServer,
+        int handle,
+        const char* const pSerial
+        )
+{
+    if ((pServer != NULL) &&
+        (!pServer->started) &&
+        (pServer->bridge_count < CY3240_SERVER_MAX_BRIDGES) &&
+        ((pSerial == NULL) || (strlen(pSerial) < CY3240_SERIAL_MAX))) {
+
+        Server_Bridge_t* const pBridge = &pServer->bridges[pServer->bridge_count++];
+
+        pBridge->handle = handle;
+        pBridge->next = 0;
+        strcpy(pBridge->serial, (pSerial != NULL) ? pSerial : "");
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_start(
+        Cy3240_Server_t* const pServer
+        )
+{
+    if ((pServer != NULL) &&
+        (!pServer->started) &&
+        (pServer->bridge_count > 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        int x;
+
+        result = bind_socket(pServer);
+
+        if CY3240_FAILURE(result)
+            return result;
+
+        pServer->running = true;
+        pServer->started = true;
+
+        for (x = 0; x < pServer->bridge_count; x++)
+            pthread_create(&pServer->bridges[x].thread, NULL, bridge_thread, &pServer->bridges[x]);
+
+        pthread_create(&pServer->thread, NULL, accept_thread, pServer);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_stop(
+        Cy3240_Server_t* const pServer
+        )
+{
+    if (pServer != NULL) {
+
+        bool joining[CY3240_SERVER_MAX_CLIENTS];
+        int x;
+
+        if (!pServer->started)
+            return CY3240_ERROR_OK;
+
+        pthread_mutex_lock(&pServer->lock);
+
+        pServer->running = false;
+
+        for (x = 0; x < pServer->bridge_count; x++)
+            pthread_cond_signal(&pServer->bridges[x].work);
+
+        pthread_cond_broadcast(&pServer->done);
+
+        pthread_mutex_unlock(&pServer->lock);
+
+        // No more connections
+        shutdown(pServer->fd, SHUT_RDWR);
+        pthread_join(pServer->thread, NULL);
+        close(pServer->fd);
+        unlink(pServer->path);
+        pServer->fd = -1;
+
+        // Wake the connection threads waiting for a request
+        pthread_mutex_lock(&pServer->lock);
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+
+            joining[x] = (pServer->clients[x].state != CLIENT_FREE);
+
+            if (pServer->clients[x].state == CLIENT_ACTIVE)
+                shutdown(pServer->clients[x].fd, SHUT_RDWR);
+        }
+
+        pthread_mutex_unlock(&pServer->lock);
+
+        for (x = 0; x < pServer->bridge_count; x++)
+            pthread_join(pServer->bridges[x].thread, NULL);
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+
+            if (joining[x]) {
+                pthread_join(pServer->clients[x].thread, NULL);
+                pServer->clients[x].state = CLIENT_FREE;
+            }
+        }
+
+        pServer->started = false;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_publish(
+        Cy3240_Server_t* const pServer,
+        const Cy3240_Sample_t* const pSample
+        )
+{
+    if ((pServer != NULL) &&
+        (pSample != NULL)) {
+
+        int x;
+
+        // The lock also makes the publisher the only producer of each ring
+        pthread_mutex_lock(&pServer->lock);
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+
+            Server_Client_t* const pClient = &pServer->clients[x];
+
+            if ((pClient->state != CLIENT_ACTIVE) ||
+                (pClient->pSamples == NULL))
+                continue;
+
+            if (cy3240_ring_push(pClient->pSamples, pSample)) {
+                cy3240_ring_wake(pClient->pSamples);
+                pServer->stats.samples++;
+
+            } else {
+                __atomic_add_fetch(&pClient->pShm->dropped, 1, __ATOMIC_RELAXED);
+                pServer->stats.dropped++;
+            }
+        }
+
+        pthread_mutex_unlock(&pServer->lock);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_get_stats(
+        Cy3240_Server_t* const pServer,
+        Cy3240_Server_Stats_t* const pStats
+        )
+{
+    if ((pServer != NULL) &&
+        (pStats != NULL)) {
+
+        pthread_mutex_lock(&pServer->lock);
+        *pStats = pServer->stats;
+        pthread_mutex_unlock(&pServer->lock);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_destroy(
+        Cy3240_Server_t* const pServer
+        )
+{
+    if (pServer != NULL) {
+
+        int x;
+
+        cy3240_server_stop(pServer);
+
+        for (x = 0; x < CY3240_SERVER_MAX_CLIENTS; x++) {
+            free(pServer->clients[x].pRequest);
+            free(pServer->clients[x].pResponse);
+        }
+
+        for (x = 0; x < CY3240_SERVER_MAX_BRIDGES; x++)
+            pthread_cond_destroy(&pServer->bridges[x].work);
+
+        pthread_cond_destroy(&pServer->done);
+        pthread_mutex_destroy(&pServer->lock);
+        free(pServer);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
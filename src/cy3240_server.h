@@ -0,0 +1,195 @@
+/**
+ * @file cy3240_server.h
+ *
+ * @brief Shares open bridges with other processes over a Unix socket
+ *
+ * Only one process can claim the HID interface of a bridge. The server
+ * holds the bridges open and runs the requests of many client processes
+ * on them, see cy3240_protocol.h for the messages and cy3240_client.h for
+ * the client side. cy3240d wraps the server in a daemon.
+ *
+ * Every connection is served by a thread of its own that waits for one
+ * request at a time. A worker thread per bridge takes the waiting
+ * requests round robin, one per client, so a busy client cannot starve
+ * the others. The single packet operations of all requests taken in a
+ * round are merged in to one pipelined cy3240_transfer(). Multi packet
+ * writes and reads run on their own.
+ *
+ * Clients that map the shared memory rings exchange single packet
+ * operations without a round trip through the socket, and can subscribe
+ * to the samples the application publishes. A sample read once from the
+ * bus reaches every subscriber.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_SERVER_H
+#define INCLUSION_GUARD_CY3240_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+#include "cy3240_scheduler.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_SERVER_MAX_BRIDGES    (8)       ///< Bridges shared by one server
+#define CY3240_SERVER_MAX_CLIENTS    (32)      ///< Connections served at once
+#define CY3240_SERVER_BATCH_OPS      (256)     ///< Operations merged in to one transfer
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Server statistics
+ */
+typedef struct {
+    uint64_t connections;                      ///< Connections accepted
+    uint64_t rejected;                         ///< Connections refused because all slots were in use
+    uint64_t requests;                         ///< Requests run on a bridge
+    uint64_t batches;                          ///< Merged transfers
+    uint64_t merged;                           ///< Requests that shared a transfer with another
+    uint64_t samples;                          ///< Samples delivered to subscribers
+    uint64_t dropped;                          ///< Samples lost because a subscriber fell behind
+} Cy3240_Server_Stats_t;
+
+/**
+ * Opaque server state
+ */
+typedef struct Cy3240_Server_s Cy3240_Server_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to create a server
+ *
+ *  @param ppServer [out] the new server
+ *  @param pPath    [in] the socket path, NULL for CY3240_PROTOCOL_DEFAULT_PATH
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_create(
+        Cy3240_Server_t** ppServer,
+        const char* pPath
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to share an open bridge. Bridges can only be added while the
+ *  server is stopped and stay open when it is destroyed.
+ *
+ *  @param pServer [in] the server
+ *  @param handle  [in] the open bridge
+ *  @param pSerial [in] the serial number clients select it by, NULL for none
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_add_bridge(
+        Cy3240_Server_t* const pServer,
+        int handle,
+        const char* const pSerial
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to listen on the socket and start the worker threads. A stale
+ *  socket file left by a server that died is replaced.
+ *
+ *  @param pServer [in] the server
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_start(
+        Cy3240_Server_t* const pServer
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to disconnect all clients, stop the threads and remove the socket
+ *
+ *  @param pServer [in] the server
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_stop(
+        Cy3240_Server_t* const pServer
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to hand a sample to every client subscribed through the shared
+ *  memory rings, for example one taken from cy3240_scheduler_poll(). A
+ *  subscriber that fell behind loses the sample and sees it counted in
+ *  its dropped counter.
+ *
+ *  @param pServer [in] the server
+ *  @param pSample [in] the sample
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_publish(
+        Cy3240_Server_t* const pServer,
+        const Cy3240_Sample_t* const pSample
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the server statistics
+ *
+ *  @param pServer [in] the server
+ *  @param pStats  [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_get_stats(
+        Cy3240_Server_t* const pServer,
+        Cy3240_Server_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop and free a server
+ *
+ *  @param pServer [in] the server
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_server_destroy(
+        Cy3240_Server_t* const pServer
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_SERVER_H
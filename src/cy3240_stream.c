@@ -0,0 +1,386 @@
+/**
+ * @file cy3240_stream.c
+ *
+ * @brief Raw sensor data streaming for touch controllers
+ *
+ * Raw sensor data streaming for touch controllers
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_ring.h"
+#include "cy3240_util.h"
+#include "cy3240_touch.h"
+#include "cy3240_stream.h"
+#include "cy3240_filter.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Commands kept in one transfer, whole frames are batched up to this
+ */
+#define STREAM_BATCH_COMMANDS  (16)
+
+/**
+ * Time the worker waits after the bridge itself failed
+ */
+#define STREAM_ERROR_BACKOFF_US (1000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Stream state
+ */
+struct Cy3240_Stream_s {
+    int handle;                                ///< The bridge
+    uint8_t address;                           ///< The touch controller
+    uint16_t sensors;                          ///< Sensors per frame
+    uint16_t commands;                         ///< GET_RAW_DATA commands per frame
+    uint16_t batch;                            ///< Frames per transfer
+    Cy3240_Touch_Frame_t* pCommands;           ///< Preencoded commands of a batch
+    Cy3240_Frame_t frame;                      ///< Frame being decoded
+    uint64_t sequence;                         ///< Next frame number
+    volatile bool running;                     ///< Worker should keep running
+    bool started;                              ///< Worker thread exists
+    pthread_t thread;                          ///< Worker thread
+    pthread_mutex_t lock;                      ///< Protects the statistics
+    Cy3240_Stream_Stats_t stats;               ///< Statistics
+    Cy3240_Filter_t* pFilter;                  ///< Optional baseline filter
+    Cy3240_Ring_t* pRing;                      ///< Frame ring
+};
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to decode the frames of an executed batch in to the ring
+ *
+ *  @param pStream [in] the stream
+ */
+//-----------------------------------------------------------------------------
+static void
+publish_batch(
+        Cy3240_Stream_t* const pStream
+        )
+{
+    Cy3240_Frame_t* const pFrame = &pStream->frame;
+    uint16_t x;
+    uint16_t y;
+
+    for (x = 0; x < pStream->batch; x++) {
+
+        const Cy3240_Touch_Frame_t* const pCommands = &pStream->pCommands[x * pStream->commands];
+        bool pushed;
+
+        pFrame->sequence = pStream->sequence++;
+        pFrame->count = 0;
+        pFrame->result = CY3240_ERROR_OK;
+
+        for (y = 0; y < pStream->commands; y++) {
+
+            if (CY3240_SUCCESS(pFrame->result) && CY3240_FAILURE(pCommands[y].result))
+                pFrame->result = pCommands[y].result;
+
+            pFrame->count += cy3240_touch_decode_raw_data(
+                    &pCommands[y],
+                    &pFrame->raw[pFrame->count]);
+        }
+
+        // The frame is complete when its last response arrived
+        pFrame->timestamp_us = pCommands[pStream->commands - 1].complete_us;
+
+        if (pStream->pFilter != NULL)
+            cy3240_filter_process(pStream->pFilter, pFrame);
+
+        pushed = cy3240_ring_push(pStream->pRing, pFrame);
+
+        pthread_mutex_lock(&pStream->lock);
+
+        if CY3240_FAILURE(pFrame->result)
+            pStream->stats.errors++;
+
+        else
+            pStream->stats.frames++;
+
+        if (!pushed)
+            pStream->stats.dropped++;
+
+        if (pStream->stats.first_us == 0)
+            pStream->stats.first_us = pFrame->timestamp_us;
+
+        pStream->stats.last_us = pFrame->timestamp_us;
+
+        pthread_mutex_unlock(&pStream->lock);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Worker thread. The commands are encoded once, every pass only executes
+ *  them and decodes the responses.
+ *
+ *  @param arg [in] the stream
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+stream_thread(
+        void* arg
+        )
+{
+    Cy3240_Stream_t* const pStream = (Cy3240_Stream_t*)arg;
+
+    while (pStream->running) {
+
+        Cy3240_Error_t result = cy3240_touch_execute(
+                pStream->handle,
+                pStream->address,
+                pStream->pCommands,
+                pStream->batch * pStream->commands);
+
+        // Errors are reported per frame, the stream keeps going
+        if (CY3240_FAILURE(result) && (result != CY3240_ERROR_TX) && (result != CY3240_ERROR_RX))
+            cy3240_util_sleep_until_us(cy3240_util_time_us() + STREAM_ERROR_BACKOFF_US);
+
+        publish_batch(pStream);
+    }
+
+    return NULL;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_create(
+        Cy3240_Stream_t** ppStream,
+        int handle,
+        uint8_t address,
+        uint16_t sensors,
+        uint32_t capacity
+        )
+{
+    if ((ppStream != NULL) &&
+        (sensors <= CY3240_STREAM_MAX_SENSORS) &&
+        (capacity != 0) &&
+        ((capacity & (capacity - 1)) == 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Stream_t* pStream;
+        uint16_t x;
+        uint16_t y;
+
+        // Ask the controller how many sensors it has
+        if (sensors == 0) {
+
+            uint8_t count = 0;
+
+            result = cy3240_touch_get(
+                    handle,
+                    address,
+                    FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS,
+                    &count);
+
+            if CY3240_FAILURE(result)
+                return result;
+
+            if (count == 0)
+                return CY3240_ERROR_RX;
+
+            sensors = count;
+        }
+
+        pStream = (Cy3240_Stream_t*)calloc(1, sizeof(Cy3240_Stream_t));
+
+        if (pStream == NULL)
+            return CY3240_ERROR_UNKNOWN;
+
+        pStream->handle = handle;
+        pStream->address = address;
+        pStream->sensors = sensors;
+        pStream->commands = (sensors + CY3240_TOUCH_MAX_RAW_SENSORS - 1) / CY3240_TOUCH_MAX_RAW_SENSORS;
+        pStream->batch = MAX(1, STREAM_BATCH_COMMANDS / pStream->commands);
+
+        pStream->pCommands = (Cy3240_Touch_Frame_t*)calloc(
+                pStream->batch * pStream->commands,
+                sizeof(Cy3240_Touch_Frame_t));
+
+        pStream->pRing = (Cy3240_Ring_t*)malloc(
+                cy3240_ring_size(capacity, sizeof(Cy3240_Frame_t)));
+
+        if ((pStream->pCommands == NULL) ||
+            (pStream->pRing == NULL)) {
+            free(pStream->pCommands);
+            free(pStream->pRing);
+            free(pStream);
+            return CY3240_ERROR_UNKNOWN;
+        }
+
+        // Encode the commands of every frame in the batch once
+        for (x = 0; x < pStream->batch; x++)
+            for (y = 0; y < pStream->commands; y++)
+                cy3240_touch_encode_raw_data(
+                        &pStream->pCommands[x * pStream->commands + y],
+                        y * CY3240_TOUCH_MAX_RAW_SENSORS,
+                        MIN(sensors - y * CY3240_TOUCH_MAX_RAW_SENSORS, CY3240_TOUCH_MAX_RAW_SENSORS));
+
+        cy3240_ring_init(pStream->pRing, capacity, sizeof(Cy3240_Frame_t));
+        pthread_mutex_init(&pStream->lock, NULL);
+
+        *ppStream = pStream;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_set_filter(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Filter_t* const pFilter
+        )
+{
+    if ((pStream != NULL) &&
+        (!pStream->started)) {
+
+        pStream->pFilter = pFilter;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_start(
+        Cy3240_Stream_t* const pStream
+        )
+{
+    if ((pStream != NULL) &&
+        (!pStream->started)) {
+
+        pStream->running = true;
+
+        if (pthread_create(&pStream->thread, NULL, stream_thread, pStream) != 0) {
+            pStream->running = false;
+            fprintf(stderr, "Failed to start the stream thread\n");
+            return CY3240_ERROR_UNKNOWN;
+        }
+
+        pStream->started = true;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_stop(
+        Cy3240_Stream_t* const pStream
+        )
+{
+    if (pStream != NULL) {
+
+        if (pStream->started) {
+
+            pStream->running = false;
+            pthread_join(pStream->thread, NULL);
+            pStream->started = false;
+        }
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+bool
+cy3240_stream_poll(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Frame_t* const pFrame
+        )
+{
+    if ((pStream != NULL) &&
+        (pFrame != NULL))
+        return cy3240_ring_pop(pStream->pRing, pFrame);
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_get_stats(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Stream_Stats_t* const pStats
+        )
+{
+    if ((pStream != NULL) &&
+        (pStats != NULL)) {
+
+        pthread_mutex_lock(&pStream->lock);
+        *pStats = pStream->stats;
+        pthread_mutex_unlock(&pStream->lock);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_destroy(
+        Cy3240_Stream_t* const pStream
+        )
+{
+    if (pStream != NULL) {
+
+        cy3240_stream_stop(pStream);
+
+        pthread_mutex_destroy(&pStream->lock);
+        free(pStream->pCommands);
+        free(pStream->pRing);
+        free(pStream);
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
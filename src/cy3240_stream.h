@@ -0,0 +1,211 @@
+/**
+ * @file cy3240_stream.h
+ *
+ * @brief Raw sensor data streaming for touch controllers
+ *
+ * Captures GET_RAW_DATA frames from a touch controller as fast as the
+ * bridge allows. A worker thread keeps the command and response packets
+ * of several frames in flight through one pipelined transfer, stamps each
+ * frame with the time its last response arrived and hands the frames to
+ * the consumer through a preallocated lock-free ring. Frames that find the
+ * ring full are counted as dropped, and the sequence number of the next
+ * frame shows the gap.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_STREAM_H
+#define INCLUSION_GUARD_CY3240_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy3240_types.h"
+#include "cy3240_touch.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_STREAM_MAX_SENSORS  (CY3240_TOUCH_MAX_SENSORS) ///< Largest number of sensors per frame
+
+/**
+ * Test whether a sensor is set in a touched or noisy bitmap
+ */
+#define CY3240_STREAM_SENSOR_SET(bitmap, sensor) \
+    (((bitmap)[(sensor) >> 3] >> ((sensor) & 0x07)) & 0x01)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * A raw data frame
+ */
+typedef struct {
+    uint64_t sequence;                         ///< Frame number, gaps show dropped frames
+    uint64_t timestamp_us;                     ///< Monotonic time the frame completed
+    Cy3240_Error_t result;                     ///< Result of the capture
+    uint16_t count;                            ///< Number of sensors
+    uint16_t raw[CY3240_STREAM_MAX_SENSORS];   ///< Raw count of each sensor
+    uint16_t touches;                          ///< Number of touched sensors, filtered streams only
+    uint16_t signal[CY3240_STREAM_MAX_SENSORS];   ///< Raw count above the baseline, filtered streams only
+    uint8_t touched[CY3240_STREAM_MAX_SENSORS / 8]; ///< Sensors above the finger threshold
+    uint8_t noisy[CY3240_STREAM_MAX_SENSORS / 8];   ///< Untouched sensors above the noise threshold
+} Cy3240_Frame_t;
+
+/**
+ * Stream statistics
+ */
+typedef struct {
+    uint64_t frames;                           ///< Frames captured
+    uint64_t dropped;                          ///< Frames dropped because the ring was full
+    uint64_t errors;                           ///< Frames that failed
+    uint64_t first_us;                         ///< Time of the first frame
+    uint64_t last_us;                          ///< Time of the last frame
+} Cy3240_Stream_Stats_t;
+
+/**
+ * Opaque stream state
+ */
+typedef struct Cy3240_Stream_s Cy3240_Stream_t;
+
+/**
+ * Opaque baseline filter state, see cy3240_filter.h
+ */
+typedef struct Cy3240_Filter_s Cy3240_Filter_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Factory method to create a stream
+ *
+ *  @param ppStream [out] the new stream
+ *  @param handle   [in] the handle to the bridge controller
+ *  @param address  [in] the I2C address of the touch controller
+ *  @param sensors  [in] the number of sensors, 0 to ask the controller
+ *  @param capacity [in] number of frames the ring holds, power of two
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_create(
+        Cy3240_Stream_t** ppStream,
+        int handle,
+        uint8_t address,
+        uint16_t sensors,
+        uint32_t capacity
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run every frame through a baseline filter before it is queued.
+ *  The worker thread owns the filter while the stream runs, so it can only
+ *  be changed while stopped.
+ *
+ *  @param pStream [in] the stream
+ *  @param pFilter [in] the filter, NULL to queue raw frames only
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_set_filter(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Filter_t* const pFilter
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to start capturing frames
+ *
+ *  @param pStream [in] the stream
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_start(
+        Cy3240_Stream_t* const pStream
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop capturing frames
+ *
+ *  @param pStream [in] the stream
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_stop(
+        Cy3240_Stream_t* const pStream
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to take the oldest frame from the ring without blocking. Only one
+ *  thread may consume frames.
+ *
+ *  @param pStream [in] the stream
+ *  @param pFrame  [out] the frame
+ *  @returns true if a frame was returned
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_stream_poll(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Frame_t* const pFrame
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to get the stream statistics
+ *
+ *  @param pStream [in] the stream
+ *  @param pStats  [out] the statistics
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_get_stats(
+        Cy3240_Stream_t* const pStream,
+        Cy3240_Stream_Stats_t* const pStats
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to stop and free a stream
+ *
+ *  @param pStream [in] the stream
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_stream_destroy(
+        Cy3240_Stream_t* const pStream
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_STREAM_H
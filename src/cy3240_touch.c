@@ -0,0 +1,574 @@
+/**
+ * @file cy3240_touch.c
+ *
+ * @brief Touch controller driver for the CY3240 bridge
+ *
+ * Touch controller driver for the CY3240 bridge
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/param.h>
+#include "cy3240.h"
+#include "cy3240_touch.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+/**
+ * Frames executed per transfer, each takes a write and a read packet
+ */
+#define TOUCH_BATCH  (16)
+
+/**
+ * Number of tuning parameters
+ */
+#define TOUCH_TUNING_COUNT  (sizeof(TUNING) / sizeof(TUNING[0]))
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Argument and value sizes of a command
+ */
+typedef struct {
+    uint8_t cmd;                               ///< The command
+    uint8_t args;                              ///< Argument bytes
+    uint8_t values;                            ///< Value bytes after the response byte
+} Cy3240_Touch_Layout_t;
+
+/**
+ * Commands of a tuning parameter
+ */
+typedef struct {
+    uint8_t get;                               ///< The GET command
+    uint8_t set;                               ///< The SET command
+    size_t offset;                             ///< Offset in Cy3240_Touch_Tuning_t
+} Cy3240_Touch_Param_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+/**
+ * Layout of every command, GET_RAW_DATA values depend on the arguments
+ */
+static const Cy3240_Touch_Layout_t LAYOUT[] = {
+    { FW_TOUCH_INPUT_CMD_NONE,                          0, 0 },
+    { FW_TOUCH_INPUT_CMD_RESET,                         0, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_USERMODE,                  0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_USERMODE,                  1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_POWERSTATE,                0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_POWERSTATE,                1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_SENSITIVITY,               0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_SENSITIVITY,               1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_NUM_LD,                    0, 1 },
+    { FW_TOUCH_INPUT_CMD_GET_DEVICE_INFO,               0, 4 },
+    { FW_TOUCH_INPUT_CMD_GET_CAPABILITIES,              0, 2 },
+    { FW_TOUCH_INPUT_CMD_GET_STATUS_BTN,                1, 1 },
+    { FW_TOUCH_INPUT_CMD_GET_STATUS_BTN_ALL,            0, 2 },
+    { FW_TOUCH_INPUT_CMD_GET_STATUS_1D,                 1, 2 },
+    { FW_TOUCH_INPUT_CMD_GET_STATUS_2D,                 0, 4 },
+    { FW_TOUCH_INPUT_CMD_GET_GPIO_VAL,                  0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_GPIO_VAL,                  1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_GPIO_DIR,                  0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_GPIO_DIR,                  1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS,               0, 1 },
+    { FW_TOUCH_INPUT_CMD_GET_RAW_DATA,                  2, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_FINGER_THRESHOLD,          0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_FINGER_THRESHOLD,          1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_NOISE_THRESHOLD,           0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_NOISE_THRESHOLD,           1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_BASELINE_UPDATE_THRESHOLD, 0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_BASELINE_UPDATE_THRESHOLD, 1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_SENSOR_AUTORESET,          0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_SENSOR_AUTORESET,          1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_HYSTERESIS,                0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_HYSTERESIS,                1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_DEBOUNCE,                  0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_DEBOUNCE,                  1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_NEGATIVE_NOISE_THRESHOLD,  0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_NEGATIVE_NOISE_THRESHOLD,  1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_LOW_BASELINE_RESET,        0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_LOW_BASELINE_RESET,        1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_SCANNING_SPEED,            0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_SCANNING_SPEED,            1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_RESOLUTION,                0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_RESOLUTION,                1, 0 },
+    { FW_TOUCH_INPUT_CMD_GET_PRESCALER_PERIOD,          0, 1 },
+    { FW_TOUCH_INPUT_CMD_SET_PRESCALER_PERIOD,          1, 0 }
+};
+
+/**
+ * The tuning parameters
+ */
+static const Cy3240_Touch_Param_t TUNING[] = {
+    { FW_TOUCH_INPUT_CMD_GET_FINGER_THRESHOLD,
+      FW_TOUCH_INPUT_CMD_SET_FINGER_THRESHOLD,
+      offsetof(Cy3240_Touch_Tuning_t, finger_threshold) },
+    { FW_TOUCH_INPUT_CMD_GET_NOISE_THRESHOLD,
+      FW_TOUCH_INPUT_CMD_SET_NOISE_THRESHOLD,
+      offsetof(Cy3240_Touch_Tuning_t, noise_threshold) },
+    { FW_TOUCH_INPUT_CMD_GET_NEGATIVE_NOISE_THRESHOLD,
+      FW_TOUCH_INPUT_CMD_SET_NEGATIVE_NOISE_THRESHOLD,
+      offsetof(Cy3240_Touch_Tuning_t, negative_noise_threshold) },
+    { FW_TOUCH_INPUT_CMD_GET_BASELINE_UPDATE_THRESHOLD,
+      FW_TOUCH_INPUT_CMD_SET_BASELINE_UPDATE_THRESHOLD,
+      offsetof(Cy3240_Touch_Tuning_t, baseline_update_threshold) },
+    { FW_TOUCH_INPUT_CMD_GET_LOW_BASELINE_RESET,
+      FW_TOUCH_INPUT_CMD_SET_LOW_BASELINE_RESET,
+      offsetof(Cy3240_Touch_Tuning_t, low_baseline_reset) },
+    { FW_TOUCH_INPUT_CMD_GET_SENSOR_AUTORESET,
+      FW_TOUCH_INPUT_CMD_SET_SENSOR_AUTORESET,
+      offsetof(Cy3240_Touch_Tuning_t, sensor_autoreset) },
+    { FW_TOUCH_INPUT_CMD_GET_HYSTERESIS,
+      FW_TOUCH_INPUT_CMD_SET_HYSTERESIS,
+      offsetof(Cy3240_Touch_Tuning_t, hysteresis) },
+    { FW_TOUCH_INPUT_CMD_GET_DEBOUNCE,
+      FW_TOUCH_INPUT_CMD_SET_DEBOUNCE,
+      offsetof(Cy3240_Touch_Tuning_t, debounce) }
+};
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to find the layout of a command
+ *
+ * @param cmd [in] the command
+ * @return the layout, NULL for unknown commands
+ */
+//-----------------------------------------------------------------------------
+static const Cy3240_Touch_Layout_t*
+find_layout(
+        Cy3240_Touch_Cmd_t cmd
+        )
+{
+    size_t x;
+
+    for (x = 0; x < sizeof(LAYOUT) / sizeof(LAYOUT[0]); x++)
+        if (LAYOUT[x].cmd == cmd)
+            return &LAYOUT[x];
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Method to decode a big endian 16 bit value
+ *
+ * @param pData [in] the two bytes
+ * @return the value
+ */
+//-----------------------------------------------------------------------------
+static uint16_t
+decode_u16(
+        const uint8_t* const pData
+        )
+{
+    return (uint16_t)((pData[0] << 8) | pData[1]);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_encode(
+        Cy3240_Touch_Frame_t* const pFrame,
+        Cy3240_Touch_Cmd_t cmd,
+        const uint8_t* const pArgs,
+        uint8_t length
+        )
+{
+    const Cy3240_Touch_Layout_t* const pLayout = find_layout(cmd);
+
+    if ((pFrame != NULL) &&
+        (pLayout != NULL) &&
+        (pLayout->args == length) &&
+        ((length == 0) || (pArgs != NULL))) {
+
+        uint16_t values = pLayout->values;
+
+        // Two bytes per requested sensor
+        if (cmd == FW_TOUCH_INPUT_CMD_GET_RAW_DATA)
+            values = 2 * pArgs[1];
+
+        if ((1 + values) > CY3240_TOUCH_MAX_FRAME)
+            return CY3240_ERROR_INVALID_PARAMETERS;
+
+        pFrame->request[0] = cmd;
+        if (length != 0)
+            memcpy(&pFrame->request[1], pArgs, length);
+        pFrame->request_length = 1 + length;
+        pFrame->response_length = 1 + values;
+        pFrame->result = CY3240_ERROR_UNKNOWN;
+
+        return CY3240_ERROR_OK;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_execute(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Frame_t* const pFrames,
+        uint16_t count
+        )
+{
+    if ((pFrames != NULL) &&
+        (count != 0)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Op_t ops[2 * TOUCH_BATCH];
+        uint16_t done = 0;
+
+        while (CY3240_SUCCESS(result) && (done < count)) {
+
+            uint16_t batch = MIN(count - done, TOUCH_BATCH);
+            uint16_t x;
+
+            memset(ops, 0x00, sizeof(ops));
+
+            // Every command is a write followed by the read of its response
+            for (x = 0; x < batch; x++) {
+
+                Cy3240_Touch_Frame_t* const pFrame = &pFrames[done + x];
+
+                ops[2 * x].type = CY3240_OP_WRITE;
+                ops[2 * x].address = address;
+                ops[2 * x].pData = pFrame->request;
+                ops[2 * x].length = pFrame->request_length;
+
+                ops[2 * x + 1].type = CY3240_OP_READ;
+                ops[2 * x + 1].address = address;
+                ops[2 * x + 1].pData = pFrame->response;
+                ops[2 * x + 1].length = pFrame->response_length;
+            }
+
+            result = cy3240_transfer(
+                    handle,
+                    ops,
+                    2 * batch);
+
+            for (x = 0; x < batch; x++) {
+
+                Cy3240_Touch_Frame_t* const pFrame = &pFrames[done + x];
+
+                pFrame->result = ops[2 * x].result;
+                pFrame->complete_us = ops[2 * x + 1].complete_us;
+
+                if CY3240_SUCCESS(pFrame->result)
+                    pFrame->result = ops[2 * x + 1].result;
+
+                if (CY3240_SUCCESS(pFrame->result) &&
+                    (pFrame->response[0] != CY3240_TOUCH_RESPONSE(pFrame->request[0]))) {
+
+                    printf("Unexpected touch response 0x%02x to command 0x%02x\n",
+                            pFrame->response[0],
+                            pFrame->request[0]);
+
+                    pFrame->result = CY3240_ERROR_RX;
+                }
+
+                if (CY3240_SUCCESS(result) && CY3240_FAILURE(pFrame->result))
+                    result = pFrame->result;
+            }
+
+            done += batch;
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Cmd_t cmd,
+        uint8_t* const pValue
+        )
+{
+    const Cy3240_Touch_Layout_t* const pLayout = find_layout(cmd);
+
+    if ((pValue != NULL) &&
+        (pLayout != NULL) &&
+        (pLayout->values == 1)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Touch_Frame_t frame;
+
+        result = cy3240_touch_encode(
+                &frame,
+                cmd,
+                NULL,
+                0);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_touch_execute(
+                    handle,
+                    address,
+                    &frame,
+                    1);
+
+        if CY3240_SUCCESS(result)
+            *pValue = frame.response[1];
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_set(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Cmd_t cmd,
+        uint8_t value
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Touch_Frame_t frame;
+
+    result = cy3240_touch_encode(
+            &frame,
+            cmd,
+            &value,
+            1);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_touch_execute(
+                handle,
+                address,
+                &frame,
+                1);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_raw_data(
+        int handle,
+        uint8_t address,
+        uint8_t first,
+        uint16_t count,
+        uint16_t* const pRaw
+        )
+{
+    const uint16_t frames = (count + CY3240_TOUCH_MAX_RAW_SENSORS - 1) / CY3240_TOUCH_MAX_RAW_SENSORS;
+
+    if ((pRaw != NULL) &&
+        (count != 0) &&
+        ((first + count) <= CY3240_TOUCH_MAX_SENSORS)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Touch_Frame_t frame[frames];
+        uint16_t x;
+
+        // Split the range in frame sized pieces
+        for (x = 0; CY3240_SUCCESS(result) && (x < frames); x++)
+            result = cy3240_touch_encode_raw_data(
+                    &frame[x],
+                    first + x * CY3240_TOUCH_MAX_RAW_SENSORS,
+                    MIN(count - x * CY3240_TOUCH_MAX_RAW_SENSORS, CY3240_TOUCH_MAX_RAW_SENSORS));
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_touch_execute(
+                    handle,
+                    address,
+                    frame,
+                    frames);
+
+        for (x = 0; CY3240_SUCCESS(result) && (x < frames); x++)
+            cy3240_touch_decode_raw_data(
+                    &frame[x],
+                    &pRaw[x * CY3240_TOUCH_MAX_RAW_SENSORS]);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_encode_raw_data(
+        Cy3240_Touch_Frame_t* const pFrame,
+        uint8_t first,
+        uint8_t count
+        )
+{
+    uint8_t args[2];
+
+    args[0] = first;
+    args[1] = count;
+
+    return cy3240_touch_encode(
+            pFrame,
+            FW_TOUCH_INPUT_CMD_GET_RAW_DATA,
+            args,
+            sizeof(args));
+}
+
+//-----------------------------------------------------------------------------
+uint16_t
+cy3240_touch_decode_raw_data(
+        const Cy3240_Touch_Frame_t* const pFrame,
+        uint16_t* const pRaw
+        )
+{
+    uint16_t count = pFrame->request[2];
+    uint16_t x;
+
+    for (x = 0; x < count; x++)
+        pRaw[x] = decode_u16(&pFrame->response[1 + 2 * x]);
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_status_2d(
+        int handle,
+        uint8_t address,
+        uint16_t* const pX,
+        uint16_t* const pY
+        )
+{
+    if ((pX != NULL) &&
+        (pY != NULL)) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Touch_Frame_t frame;
+
+        result = cy3240_touch_encode(
+                &frame,
+                FW_TOUCH_INPUT_CMD_GET_STATUS_2D,
+                NULL,
+                0);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_touch_execute(
+                    handle,
+                    address,
+                    &frame,
+                    1);
+
+        if CY3240_SUCCESS(result) {
+            *pX = decode_u16(&frame.response[1]);
+            *pY = decode_u16(&frame.response[3]);
+        }
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_tuning(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Tuning_t* const pTuning
+        )
+{
+    if (pTuning != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Touch_Frame_t frame[TOUCH_TUNING_COUNT];
+        size_t x;
+
+        for (x = 0; CY3240_SUCCESS(result) && (x < TOUCH_TUNING_COUNT); x++)
+            result = cy3240_touch_encode(
+                    &frame[x],
+                    TUNING[x].get,
+                    NULL,
+                    0);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_touch_execute(
+                    handle,
+                    address,
+                    frame,
+                    TOUCH_TUNING_COUNT);
+
+        for (x = 0; CY3240_SUCCESS(result) && (x < TOUCH_TUNING_COUNT); x++)
+            ((uint8_t*)pTuning)[TUNING[x].offset] = frame[x].response[1];
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_set_tuning(
+        int handle,
+        uint8_t address,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        )
+{
+    if (pTuning != NULL) {
+
+        Cy3240_Error_t result = CY3240_ERROR_OK;
+        Cy3240_Touch_Frame_t frame[TOUCH_TUNING_COUNT];
+        size_t x;
+
+        for (x = 0; CY3240_SUCCESS(result) && (x < TOUCH_TUNING_COUNT); x++)
+            result = cy3240_touch_encode(
+                    &frame[x],
+                    TUNING[x].set,
+                    &((const uint8_t*)pTuning)[TUNING[x].offset],
+                    1);
+
+        if CY3240_SUCCESS(result)
+            result = cy3240_touch_execute(
+                    handle,
+                    address,
+                    frame,
+                    TOUCH_TUNING_COUNT);
+
+        return result;
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//@} End of Methods
@@ -0,0 +1,326 @@
+/**
+ * @file cy3240_touch.h
+ *
+ * @brief Touch controller driver for the CY3240 bridge
+ *
+ * Driver for the FW_TOUCH_INPUT_CMD_* protocol listed in
+ * doc/USB_I2C_Bridge_Commands.iic. A command is written to the controller
+ * as the command byte followed by its arguments, and the answer is read
+ * back as the response byte (command | 0x80) followed by the values.
+ *
+ * Commands are collected in frames and executed together, so a group of
+ * related GET or SET commands costs a single pipelined transfer.
+ *
+ * Multi byte values are sent most significant byte first. GET_RAW_DATA
+ * takes the first sensor and the number of sensors as arguments and
+ * returns one 16 bit count per sensor.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+#ifndef INCLUSION_GUARD_CY3240_TOUCH_H
+#define INCLUSION_GUARD_CY3240_TOUCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+#include "cy3240_types.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_TOUCH_RESPONSE(cmd)     ((cmd) | 0x80)      ///< Response byte of a command
+#define CY3240_TOUCH_MAX_FRAME         (61)                ///< Largest command or response, one packet
+#define CY3240_TOUCH_MAX_RAW_SENSORS   ((CY3240_TOUCH_MAX_FRAME - 1) / 2) ///< Raw counts per frame
+#define CY3240_TOUCH_MAX_SENSORS       (256)               ///< Largest sensor count
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Touch controller commands
+ */
+typedef enum {
+    FW_TOUCH_INPUT_CMD_NONE                          = 0x00,
+    FW_TOUCH_INPUT_CMD_RESET                         = 0x01,
+    FW_TOUCH_INPUT_CMD_GET_USERMODE                  = 0x02,
+    FW_TOUCH_INPUT_CMD_SET_USERMODE                  = 0x03,
+    FW_TOUCH_INPUT_CMD_GET_POWERSTATE                = 0x04,
+    FW_TOUCH_INPUT_CMD_SET_POWERSTATE                = 0x05,
+    FW_TOUCH_INPUT_CMD_GET_SENSITIVITY               = 0x06,
+    FW_TOUCH_INPUT_CMD_SET_SENSITIVITY               = 0x07,
+    FW_TOUCH_INPUT_CMD_GET_NUM_LD                    = 0x08,
+    FW_TOUCH_INPUT_CMD_GET_DEVICE_INFO               = 0x09,
+    FW_TOUCH_INPUT_CMD_GET_CAPABILITIES              = 0x0A,
+    FW_TOUCH_INPUT_CMD_GET_STATUS_BTN                = 0x0B,
+    FW_TOUCH_INPUT_CMD_GET_STATUS_BTN_ALL            = 0x0C,
+    FW_TOUCH_INPUT_CMD_GET_STATUS_1D                 = 0x0D,
+    FW_TOUCH_INPUT_CMD_GET_STATUS_2D                 = 0x0E,
+    FW_TOUCH_INPUT_CMD_GET_GPIO_VAL                  = 0x30,
+    FW_TOUCH_INPUT_CMD_SET_GPIO_VAL                  = 0x31,
+    FW_TOUCH_INPUT_CMD_GET_GPIO_DIR                  = 0x32,
+    FW_TOUCH_INPUT_CMD_SET_GPIO_DIR                  = 0x33,
+    FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS               = 0x50,
+    FW_TOUCH_INPUT_CMD_GET_RAW_DATA                  = 0x51,
+    FW_TOUCH_INPUT_CMD_GET_FINGER_THRESHOLD          = 0x52,
+    FW_TOUCH_INPUT_CMD_SET_FINGER_THRESHOLD          = 0x53,
+    FW_TOUCH_INPUT_CMD_GET_NOISE_THRESHOLD           = 0x54,
+    FW_TOUCH_INPUT_CMD_SET_NOISE_THRESHOLD           = 0x55,
+    FW_TOUCH_INPUT_CMD_GET_BASELINE_UPDATE_THRESHOLD = 0x56,
+    FW_TOUCH_INPUT_CMD_SET_BASELINE_UPDATE_THRESHOLD = 0x57,
+    FW_TOUCH_INPUT_CMD_GET_SENSOR_AUTORESET          = 0x58,
+    FW_TOUCH_INPUT_CMD_SET_SENSOR_AUTORESET          = 0x59,
+    FW_TOUCH_INPUT_CMD_GET_HYSTERESIS                = 0x5A,
+    FW_TOUCH_INPUT_CMD_SET_HYSTERESIS                = 0x5B,
+    FW_TOUCH_INPUT_CMD_GET_DEBOUNCE                  = 0x5C,
+    FW_TOUCH_INPUT_CMD_SET_DEBOUNCE                  = 0x5D,
+    FW_TOUCH_INPUT_CMD_GET_NEGATIVE_NOISE_THRESHOLD  = 0x5E,
+    FW_TOUCH_INPUT_CMD_SET_NEGATIVE_NOISE_THRESHOLD  = 0x5F,
+    FW_TOUCH_INPUT_CMD_GET_LOW_BASELINE_RESET        = 0x60,
+    FW_TOUCH_INPUT_CMD_SET_LOW_BASELINE_RESET        = 0x61,
+    FW_TOUCH_INPUT_CMD_GET_SCANNING_SPEED            = 0x62,
+    FW_TOUCH_INPUT_CMD_SET_SCANNING_SPEED            = 0x63,
+    FW_TOUCH_INPUT_CMD_GET_RESOLUTION                = 0x64,
+    FW_TOUCH_INPUT_CMD_SET_RESOLUTION                = 0x65,
+    FW_TOUCH_INPUT_CMD_GET_PRESCALER_PERIOD          = 0x66,
+    FW_TOUCH_INPUT_CMD_SET_PRESCALER_PERIOD          = 0x67
+} Cy3240_Touch_Cmd_t;
+
+/**
+ * A command and its response
+ */
+typedef struct {
+    uint8_t request[CY3240_TOUCH_MAX_FRAME];   ///< Command byte followed by the arguments
+    uint8_t request_length;                    ///< Bytes in request
+    uint8_t response[CY3240_TOUCH_MAX_FRAME];  ///< Response byte followed by the values
+    uint8_t response_length;                   ///< Bytes expected in response
+    Cy3240_Error_t result;                     ///< Result of the command
+    uint64_t complete_us;                      ///< Monotonic time the response arrived
+} Cy3240_Touch_Frame_t;
+
+/**
+ * Tuning parameters, read and written together
+ */
+typedef struct {
+    uint8_t finger_threshold;                  ///< Finger detection threshold
+    uint8_t noise_threshold;                   ///< Noise threshold
+    uint8_t negative_noise_threshold;          ///< Negative noise threshold
+    uint8_t baseline_update_threshold;         ///< Baseline update threshold
+    uint8_t low_baseline_reset;                ///< Low baseline reset count
+    uint8_t sensor_autoreset;                  ///< Sensor auto reset
+    uint8_t hysteresis;                        ///< Detection hysteresis
+    uint8_t debounce;                          ///< Detection debounce
+} Cy3240_Touch_Tuning_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to encode a command in a frame
+ *
+ *  @param pFrame  [out] the frame
+ *  @param cmd     [in] the command
+ *  @param pArgs   [in] the arguments, may be NULL without arguments
+ *  @param length  [in] the number of argument bytes the command takes
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_encode(
+        Cy3240_Touch_Frame_t* const pFrame,
+        Cy3240_Touch_Cmd_t cmd,
+        const uint8_t* const pArgs,
+        uint8_t length
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to execute frames in as few transfers as possible. A response
+ *  that does not start with the response byte of its command fails with
+ *  CY3240_ERROR_RX.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param pFrames [in,out] the encoded frames
+ *  @param count   [in] the number of frames
+ *  @returns the first error of any frame
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_execute(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Frame_t* const pFrames,
+        uint16_t count
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a GET command that returns a single byte
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param cmd     [in] the command
+ *  @param pValue  [out] the value
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Cmd_t cmd,
+        uint8_t* const pValue
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a SET command that takes a single byte
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param cmd     [in] the command
+ *  @param value   [in] the value
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_set(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Cmd_t cmd,
+        uint8_t value
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read the raw counts of a range of sensors. Ranges larger than
+ *  one frame are split in several commands of the same transfer.
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param first   [in] the first sensor
+ *  @param count   [in] the number of sensors
+ *  @param pRaw    [out] count raw values
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_raw_data(
+        int handle,
+        uint8_t address,
+        uint8_t first,
+        uint16_t count,
+        uint16_t* const pRaw
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to encode a GET_RAW_DATA command for a range of sensors
+ *
+ *  @param pFrame [out] the frame
+ *  @param first  [in] the first sensor
+ *  @param count  [in] the number of sensors, at most CY3240_TOUCH_MAX_RAW_SENSORS
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_encode_raw_data(
+        Cy3240_Touch_Frame_t* const pFrame,
+        uint8_t first,
+        uint8_t count
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to decode the raw counts of an executed GET_RAW_DATA frame
+ *
+ *  @param pFrame [in] the frame
+ *  @param pRaw   [out] one raw value per requested sensor
+ *  @returns the number of values decoded
+ */
+//-----------------------------------------------------------------------------
+uint16_t
+cy3240_touch_decode_raw_data(
+        const Cy3240_Touch_Frame_t* const pFrame,
+        uint16_t* const pRaw
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read the position of the 2D touch area
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param pX      [out] the X position
+ *  @param pY      [out] the Y position
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_status_2d(
+        int handle,
+        uint8_t address,
+        uint16_t* const pX,
+        uint16_t* const pY
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read all tuning parameters in one transfer
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param pTuning [out] the tuning parameters
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_get_tuning(
+        int handle,
+        uint8_t address,
+        Cy3240_Touch_Tuning_t* const pTuning
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to write all tuning parameters in one transfer
+ *
+ *  @param handle  [in] the handle to the bridge controller
+ *  @param address [in] the I2C address of the touch controller
+ *  @param pTuning [in] the tuning parameters
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+Cy3240_Error_t
+cy3240_touch_set_tuning(
+        int handle,
+        uint8_t address,
+        const Cy3240_Touch_Tuning_t* const pTuning
+        );
+
+//@} End of Methods
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCLUSION_GUARD_CY3240_TOUCH_H
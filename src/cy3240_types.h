@@ -16,6 +16,24 @@
 extern "C" {
 #endif
 
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdint.h>
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define CY3240_SERIAL_MAX  (64)      ///< Size of a serial number including the terminator
+#define CY3240_LOCATION_MAX (16)     ///< Size of a USB bus and device location including the terminator
+#define CY3240_LATENCY_BUCKETS (24)  ///< Round trip histogram buckets, bucket n counts 2^n up to 2^(n+1) us
+
+//@} End of Defines
+
 //////////////////////////////////////////////////////////////////////
 /// @name Types
 //@{
@@ -31,7 +49,8 @@ typedef enum {
     CY3240_ERROR_JNI,                ///< Error occurred in the JNI interface
     CY3240_ERROR_RECONFIG,           ///< Error during reconfigure
     CY3240_ERROR_INVALID_PARAMETERS, ///< Invalid parameters provided
-    CY3240_ERROR_UNKNOWN             ///< Unknown Error
+    CY3240_ERROR_UNKNOWN,            ///< Unknown Error
+    CY3240_ERROR_TIMEOUT             ///< Timed out waiting for the device
 } Cy3240_Error_t;
 
 
@@ -64,6 +83,139 @@ typedef enum {
     CY3240_POWER_3_3V     = 0x02  ///< 3.3V Power
 } Cy3240_Power_t;
 
+/**
+ * USB round trip statistics behind the adaptive timeouts
+ */
+typedef struct {
+    uint64_t samples;                ///< Round trips measured
+    uint64_t timeouts;               ///< Adaptive timeouts that expired
+    uint32_t latency_us;             ///< Smoothed round trip without the bus time
+    uint32_t deviation_us;           ///< Smoothed deviation of the round trip
+    int last_timeout;                ///< Timeout of the last read (ms)
+} Cy3240_Latency_t;
+
+/**
+ * Kinds of NAK a write can be retried after
+ */
+typedef enum {
+    CY3240_NAK_ADDRESS,              ///< The slave did not acknowledge its address
+    CY3240_NAK_DATA,                 ///< The slave refused a data byte
+    CY3240_NAK_COUNT                 ///< Number of NAK kinds
+} Cy3240_Nak_t;
+
+/**
+ * Retry policy for one kind of NAK
+ */
+typedef struct {
+    uint16_t attempts;               ///< Attempts per packet including the first, 1 disables retries
+    uint32_t backoff_us;             ///< Delay before the first retry
+    uint32_t max_backoff_us;         ///< Upper bound of the delay
+    uint16_t multiplier;             ///< Growth of the delay after each retry
+    uint8_t jitter;                  ///< Random part of the delay in percent
+} Cy3240_Retry_Policy_t;
+
+/**
+ * Write retry statistics
+ */
+typedef struct {
+    uint64_t naks[CY3240_NAK_COUNT]; ///< NAKs seen per kind by writes, reads, transfers and probes
+    uint64_t retries;                ///< Packets sent again after a NAK
+    uint64_t resent_bytes;           ///< Data bytes sent again after a NAK
+    uint64_t exhausted;              ///< Writes that failed after the last attempt
+    uint64_t backoff_us;             ///< Total time spent waiting to retry
+} Cy3240_Retry_Stats_t;
+
+/**
+ * Recovery tiers, from the cheapest to the most expensive
+ */
+typedef enum {
+    CY3240_TIER_RETRY,               ///< Drop late responses and repeat a round trip
+    CY3240_TIER_REINIT,              ///< Reinitialize the bridge
+    CY3240_TIER_RECLAIM,             ///< Close and claim the open interface again
+    CY3240_TIER_REBUILD,             ///< Replace the interface of the handle
+    CY3240_TIER_COUNT                ///< Number of recovery tiers
+} Cy3240_Tier_t;
+
+/**
+ * Recovery statistics of one tier
+ */
+typedef struct {
+    uint64_t attempts;               ///< Times the tier was tried
+    uint64_t successes;              ///< Times the tier brought the bridge back
+    uint64_t last_us;                ///< Duration of the last attempt
+    uint64_t max_us;                 ///< Longest attempt
+    uint64_t total_us;               ///< Sum of all attempts
+} Cy3240_Tier_Stats_t;
+
+/**
+ * Traffic counters and round trip histogram
+ */
+typedef struct {
+    uint64_t writes;                 ///< Writes and probes that succeeded
+    uint64_t reads;                  ///< Reads that succeeded
+    uint64_t write_bytes;            ///< Data bytes written
+    uint64_t read_bytes;             ///< Data bytes read
+    uint64_t errors;                 ///< Writes, reads and probes that failed, a probe NAK is an answer
+    uint64_t histogram[CY3240_LATENCY_BUCKETS]; ///< Round trips including the bus time, the last bucket is open ended
+} Cy3240_Traffic_t;
+
+/**
+ * Priority classes of writes, reads and transfers. A waiting class is let
+ * on to the bridge before the lower classes and in between the packets of
+ * a lower class transfer wherever the bus is stopped.
+ */
+typedef enum {
+    CY3240_PRIORITY_REALTIME,        ///< Latency critical, e.g. periodic sensor reads
+    CY3240_PRIORITY_INTERACTIVE,     ///< The default class
+    CY3240_PRIORITY_BULK,            ///< Long transfers such as EEPROM images
+    CY3240_PRIORITY_COUNT            ///< Number of priority classes
+} Cy3240_Priority_t;
+
+/**
+ * Latency statistics of a priority class, from the call to its return
+ */
+typedef struct {
+    uint64_t calls;                  ///< Writes, reads, transfers and bridge commands completed
+    uint64_t preempted;              ///< Times a call let a higher class in between its packets
+    uint64_t wait_us;                ///< Sum of the times waiting for the bridge
+    uint64_t max_wait_us;            ///< Longest wait for the bridge
+    uint64_t total_us;               ///< Sum of the call durations
+    uint64_t max_us;                 ///< Longest call
+    uint64_t histogram[CY3240_LATENCY_BUCKETS]; ///< Call durations, bucketed as the round trips
+} Cy3240_Class_Stats_t;
+
+/**
+ * All statistics of a handle, taken under one lock
+ */
+typedef struct {
+    Cy3240_Traffic_t traffic;        ///< Traffic counters
+    Cy3240_Latency_t latency;        ///< Round trip statistics
+    Cy3240_Retry_Stats_t retry;      ///< Write retry statistics
+    Cy3240_Tier_Stats_t recovery[CY3240_TIER_COUNT]; ///< Recovery statistics per tier
+    Cy3240_Class_Stats_t classes[CY3240_PRIORITY_COUNT]; ///< Latency statistics per priority class
+} Cy3240_Stats_t;
+
+/**
+ * Transfer operation types
+ */
+typedef enum {
+    CY3240_OP_WRITE,                 ///< Write data to a slave
+    CY3240_OP_READ,                  ///< Read data from a slave
+    CY3240_OP_PROBE                  ///< Address only write, checks the slave acknowledges
+} Cy3240_Op_Type_t;
+
+/**
+ * A single packet operation of a pipelined transfer
+ */
+typedef struct {
+    Cy3240_Op_Type_t type;           ///< The operation
+    uint8_t address;                 ///< I2C address of the slave
+    uint8_t* pData;                  ///< Data to write or buffer to read into
+    uint16_t length;                 ///< Number of bytes, at most one packet
+    Cy3240_Error_t result;           ///< Result of the operation
+    uint64_t complete_us;            ///< Monotonic time the response arrived
+} Cy3240_Op_t;
+
 //@} End of Types
 
 #ifdef __cplusplus
@@ -16,6 +16,9 @@
 //@{
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
 #include "hid.h"
 #include "cy3240_types.h"
 #include "cy3240_util.h"
@@ -57,4 +60,51 @@ cy3240_util_match_serial_number(
     return ret;
 }
 
+//-----------------------------------------------------------------------------
+bool
+cy3240_util_match_location(
+        struct usb_dev_handle* usbdev,
+        void* custom,
+        unsigned int len
+        )
+{
+    const struct usb_device* pDevice = usb_device(usbdev);
+    const char* pLocation = (const char*)custom;
+    const size_t busLength = strlen(pDevice->bus->dirname);
+
+    // The location is the bus directory and device file of libusb
+    return (strncmp(pLocation, pDevice->bus->dirname, busLength) == 0) &&
+           (pLocation[busLength] == '/') &&
+           (strcmp(&pLocation[busLength + 1], pDevice->filename) == 0);
+}
+
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_util_time_us(
+        void
+        )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+//-----------------------------------------------------------------------------
+void
+cy3240_util_sleep_until_us(
+        uint64_t wakeup
+        )
+{
+    struct timespec when;
+
+    when.tv_sec = wakeup / 1000000;
+    when.tv_nsec = (wakeup % 1000000) * 1000;
+
+    // Restart the sleep if a signal interrupted it
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &when, NULL) == EINTR)
+        ;
+}
+
 //@} End of Methods
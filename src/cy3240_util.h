@@ -21,6 +21,8 @@ extern "C" {
 /// @name Includes
 //@{
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "cy3240.h"
 #include "cy3240_types.h"
 #include "cy3240_util.h"
@@ -49,6 +51,47 @@ cy3240_util_match_serial_number(
         unsigned int len
         );
 
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check the USB bus and device of the specified device
+ *
+ *  @param usbdev [in] The handle to the usb device
+ *  @param custom [in] The location to check, see cy3240_set_location()
+ *  @param len    [in] The length of the custom location
+ *  @returns true if the device is at the location, otherwise, false
+ */
+//-----------------------------------------------------------------------------
+bool
+cy3240_util_match_location(
+        struct usb_dev_handle* usbdev,
+        void* custom,
+        unsigned int len
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read the monotonic clock
+ *
+ *  @returns the current monotonic time in microseconds
+ */
+//-----------------------------------------------------------------------------
+uint64_t
+cy3240_util_time_us(
+        void
+        );
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to sleep until the monotonic clock reaches the specified time
+ *
+ *  @param wakeup [in] the absolute monotonic time in microseconds
+ */
+//-----------------------------------------------------------------------------
+void
+cy3240_util_sleep_until_us(
+        uint64_t wakeup
+        );
+
 //@} End of Methods
 
 #ifdef __cplusplus
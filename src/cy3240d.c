@@ -0,0 +1,422 @@
+/**
+ * @file cy3240d.c
+ *
+ * @brief Daemon sharing CY3240 bridges with other processes
+ *
+ * Holds one or more bridges open and serves them on a Unix socket, so
+ * tools and tests in several processes can use the same bridge at once:
+ *
+ * @code
+ * $ cy3240d -s 0123 -s 4567 &                 ; share two bridges
+ * $ cy3240d -S /run/cy3240.sock -c 400 &      ; share the first bridge
+ * $ cy3240d -j 0x48:0x00:2:10000 &           ; publish a register every 10 ms
+ * @endcode
+ *
+ * Clients connect with cy3240_client_open(). Jobs given with -j are read
+ * periodically from the first bridge by a scheduler and every sample is
+ * published to all subscribed clients, see cy3240_client_wait_sample().
+ * The daemon runs until it receives SIGINT or SIGTERM and prints the
+ * server statistics on exit.
+ *
+ * @ingroup CY3240
+ *
+ * @owner  Kevin Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h> /* for getopt() */
+#include <pthread.h>
+#include "cy3240.h"
+#include "cy3240_types.h"
+#include "cy3240_protocol.h"
+#include "cy3240_scheduler.h"
+#include "cy3240_server.h"
+
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define DEFAULT_TIMEOUT     (1000)   ///< Bridge timeout in milliseconds
+#define SAMPLE_QUEUE        (256)    ///< Samples the scheduler queues
+#define PUBLISH_NS          (1000000) ///< How often samples are published
+
+#define EXIT_FAILED         (1)      ///< A bridge or the socket could not be opened
+#define EXIT_USAGE          (2)      ///< The command line is wrong
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Command line options
+ */
+typedef struct {
+    const char* pPath;                         ///< Socket path, NULL for the default
+    int iface;                                 ///< USB interface number
+    int timeout;                               ///< Bridge timeout in milliseconds
+    const char* pSerials[CY3240_SERVER_MAX_BRIDGES]; ///< Serial numbers of the bridges
+    int count;                                 ///< Number of serial numbers
+    Cy3240_Job_t jobs[CY3240_SCHEDULER_MAX_JOBS]; ///< Registers to publish, handle not set
+    int job_count;                             ///< Number of jobs
+    Cy3240_Power_t power;                      ///< Power supplied to the targets
+    Cy3240_I2C_ClockSpeed_t clock;             ///< I2C clock
+} Options_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to parse a job, ADDR:REG:LEN:PERIOD_US
+ *
+ *  @param pText [in] the text
+ *  @param pJob  [out] the job
+ *  @returns true if the job is valid
+ */
+//-----------------------------------------------------------------------------
+static bool
+parse_job(
+        const char* pText,
+        Cy3240_Job_t* const pJob
+        )
+{
+    unsigned long values[4];
+    char* pEnd = (char*)pText;
+    int x;
+
+    for (x = 0; x < 4; x++) {
+
+        values[x] = strtoul(pEnd, &pEnd, 0);
+
+        if (*pEnd != ((x < 3) ? ':' : '\0'))
+            return false;
+
+        pEnd++;
+    }
+
+    if ((values[0] > 0x7F) ||
+        (values[1] > 0xFF) ||
+        (values[2] == 0) ||
+        (values[2] > CY3240_SCHEDULER_MAX_SAMPLE) ||
+        (values[3] == 0) ||
+        (values[3] > UINT32_MAX))
+        return false;
+
+    memset(pJob, 0x00, sizeof(Cy3240_Job_t));
+    pJob->address = (uint8_t)values[0];
+    pJob->reg = (uint8_t)values[1];
+    pJob->length = (uint16_t)values[2];
+    pJob->period_us = (uint32_t)values[3];
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to parse the command line options
+ *
+ *  @param argc     [in] The number of arguments
+ *  @param argv     [in] The command line arguments
+ *  @param pOptions [out] the options
+ *  @returns true if the options are valid
+ */
+//-----------------------------------------------------------------------------
+static bool
+parse_options(
+        int argc,
+        char *argv[],
+        Options_t* const pOptions
+        )
+{
+    char* pEnd = NULL;
+    int flag;
+
+    memset(pOptions, 0x00, sizeof(Options_t));
+    pOptions->timeout = DEFAULT_TIMEOUT;
+    pOptions->power = CY3240_POWER_5V;
+    pOptions->clock = CY3240_CLOCK__100kHz;
+
+    while ((flag = getopt(argc, argv, "S:i:s:j:p:c:t:h")) != -1) {
+
+        switch (flag) {
+
+            // The socket path
+            case 'S':
+                pOptions->pPath = optarg;
+                break;
+
+            // The usb interface
+            case 'i':
+                pOptions->iface = (int)strtol(optarg, &pEnd, 0);
+                if ((*pEnd != '\0') || (pOptions->iface < 0) || (pOptions->iface > 255))
+                    return false;
+                break;
+
+            // A bridge serial number, once per bridge
+            case 's':
+                if (pOptions->count == CY3240_SERVER_MAX_BRIDGES)
+                    return false;
+                pOptions->pSerials[pOptions->count++] = optarg;
+                break;
+
+            // A register to publish, once per job
+            case 'j':
+                if ((pOptions->job_count == CY3240_SCHEDULER_MAX_JOBS) ||
+                    !parse_job(optarg, &pOptions->jobs[pOptions->job_count]))
+                    return false;
+                pOptions->job_count++;
+                break;
+
+            // The target power
+            case 'p':
+                if (!strcmp(optarg, "5"))
+                    pOptions->power = CY3240_POWER_5V;
+                else if (!strcmp(optarg, "3.3"))
+                    pOptions->power = CY3240_POWER_3_3V;
+                else if (!strcmp(optarg, "ext"))
+                    pOptions->power = CY3240_POWER_EXTERNAL;
+                else
+                    return false;
+                break;
+
+            // The I2C clock in kHz
+            case 'c':
+                if (!strcmp(optarg, "50"))
+                    pOptions->clock = CY3240_CLOCK__50kHz;
+                else if (!strcmp(optarg, "100"))
+                    pOptions->clock = CY3240_CLOCK__100kHz;
+                else if (!strcmp(optarg, "400"))
+                    pOptions->clock = CY3240_CLOCK__400kHz;
+                else
+                    return false;
+                break;
+
+            // The bridge timeout
+            case 't':
+                pOptions->timeout = (int)strtol(optarg, &pEnd, 0);
+                if ((*pEnd != '\0') || (pOptions->timeout <= 0) || (pOptions->timeout > 60000))
+                    return false;
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    // Without a serial number the first bridge found is shared
+    if (pOptions->count == 0)
+        pOptions->pSerials[pOptions->count++] = NULL;
+
+    return optind == argc;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to print the usage
+ *
+ *  @param pName [in] the name of the daemon
+ */
+//-----------------------------------------------------------------------------
+static void
+usage(
+        const char* pName
+        )
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", pName);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -S PATH     socket path (%s)\n", CY3240_PROTOCOL_DEFAULT_PATH);
+    fprintf(stderr, "  -s SERIAL   serial number of a bridge to share, repeat for more (first found)\n");
+    fprintf(stderr, "  -j ADDR:REG:LEN:PERIOD_US  register of the first bridge to publish, repeat for more\n");
+    fprintf(stderr, "  -i IFACE    USB interface number (0)\n");
+    fprintf(stderr, "  -p POWER    target power: 5, 3.3 or ext (5)\n");
+    fprintf(stderr, "  -c CLOCK    I2C clock in kHz: 50, 100 or 400 (100)\n");
+    fprintf(stderr, "  -t TIMEOUT  bridge timeout in milliseconds (%d)\n", DEFAULT_TIMEOUT);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to open a bridge
+ *
+ *  @param pOptions [in] the options
+ *  @param pSerial  [in] the serial number, NULL for any bridge
+ *  @param pHandle  [out] the handle
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+open_bridge(
+        const Options_t* const pOptions,
+        const char* pSerial,
+        int* const pHandle
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    *pHandle = 0;
+
+    result = cy3240_factory(
+            pHandle,
+            pOptions->iface,
+            pOptions->timeout,
+            pOptions->power,
+            CY3240_BUS_I2C,
+            pOptions->clock
+            );
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_set_serial_number(
+                *pHandle,
+                pSerial);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_open(*pHandle);
+
+    if CY3240_FAILURE(result) {
+
+        fprintf(stderr, "Failed to open bridge %s: %d\n", (pSerial != NULL) ? pSerial : "(any)", result);
+
+        // Drop its libhid reference, the other bridges keep theirs
+        if (*pHandle != 0)
+            cy3240_close(*pHandle);
+    }
+
+    return result;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Main entry point
+ *
+ *  @param argc [in] The number of arguments
+ *  @param argv [in] The command line arguments
+ *  @returns The result
+ */
+//-----------------------------------------------------------------------------
+int
+main(
+        int argc,
+        char *argv[]
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Server_t* pServer = NULL;
+    Cy3240_Scheduler_t* pScheduler = NULL;
+    Cy3240_Server_Stats_t stats;
+    Cy3240_Sample_t sample;
+    struct timespec tick = { 0, PUBLISH_NS };
+    int handles[CY3240_SERVER_MAX_BRIDGES];
+    Options_t options;
+    sigset_t signals;
+    int opened = 0;
+    int received = 0;
+    int x;
+
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_USAGE;
+    }
+
+    // Block the signals before any thread starts, only sigwait() gets them
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    result = cy3240_server_create(&pServer, options.pPath);
+
+    for (x = 0; CY3240_SUCCESS(result) && (x < options.count); x++) {
+
+        result = open_bridge(&options, options.pSerials[x], &handles[x]);
+
+        if CY3240_SUCCESS(result) {
+            opened++;
+            result = cy3240_server_add_bridge(pServer, handles[x], options.pSerials[x]);
+        }
+    }
+
+    // Sample ids are the indexes of the jobs on the command line
+    if (CY3240_SUCCESS(result) && (options.job_count > 0))
+        result = cy3240_scheduler_create(&pScheduler, SAMPLE_QUEUE);
+
+    for (x = 0; CY3240_SUCCESS(result) && (x < options.job_count); x++) {
+
+        int job = 0;
+
+        options.jobs[x].handle = handles[0];
+        result = cy3240_scheduler_add_job(pScheduler, &options.jobs[x], &job);
+    }
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_start(pServer);
+
+    if (CY3240_SUCCESS(result) && (pScheduler != NULL))
+        result = cy3240_scheduler_start(pScheduler);
+
+    if CY3240_SUCCESS(result) {
+
+        fprintf(stderr, "Sharing %d bridge(s) on %s\n",
+                options.count,
+                (options.pPath != NULL) ? options.pPath : CY3240_PROTOCOL_DEFAULT_PATH);
+
+        if (pScheduler == NULL) {
+            sigwait(&signals, &received);
+
+        } else {
+
+            // Hand the samples over until a signal arrives
+            while (sigtimedwait(&signals, NULL, &tick) < 0)
+                while (cy3240_scheduler_poll(pScheduler, &sample))
+                    cy3240_server_publish(pServer, &sample);
+        }
+
+        cy3240_scheduler_destroy(pScheduler);
+        pScheduler = NULL;
+        cy3240_server_stop(pServer);
+        cy3240_server_get_stats(pServer, &stats);
+
+        fprintf(stderr, "%llu connections, %llu rejected, %llu requests, %llu merged in %llu batches\n",
+                (unsigned long long)stats.connections,
+                (unsigned long long)stats.rejected,
+                (unsigned long long)stats.requests,
+                (unsigned long long)stats.merged,
+                (unsigned long long)stats.batches);
+
+        fprintf(stderr, "%llu samples published, %llu dropped\n",
+                (unsigned long long)stats.samples,
+                (unsigned long long)stats.dropped);
+    }
+
+    if (pScheduler != NULL)
+        cy3240_scheduler_destroy(pScheduler);
+
+    cy3240_server_destroy(pServer);
+
+    for (x = 0; x < opened; x++)
+        cy3240_close(handles[x]);
+
+    return CY3240_SUCCESS(result) ? EXIT_SUCCESS : EXIT_FAILED;
+}
+
+//@} End of Methods
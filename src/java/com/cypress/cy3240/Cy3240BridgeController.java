@@ -5,6 +5,13 @@
 
 package com.cypress.cy3240;
 
+import java.lang.management.ManagementFactory;
+import java.nio.ByteBuffer;
+import java.util.concurrent.CompletableFuture;
+import javax.management.JMException;
+import javax.management.MBeanServer;
+import javax.management.ObjectName;
+
 /**
  * JNI interface to the CY3240 Bridge controller
  */
@@ -16,6 +23,22 @@ public class Cy3240BridgeController {
      */
     public static final int SLEEP_BETWEEN_CMD = 250;
 
+    /**
+     * The number of asynchronous operations that can be outstanding when the
+     * completion thread is started by the first asynchronous call.
+     */
+    public static final int ASYNC_SLOTS = 32;
+
+    /**
+     * The longest transfer writeCritical and readCritical accept, as in the
+     * native CRITICAL_MAX.
+     */
+    public static final int CRITICAL_MAX = 64;
+
+    // The asynchronous request types, as in the native Async_Type_t
+    private static final int ASYNC_WRITE = 0;
+    private static final int ASYNC_READ = 1;
+
     static {
 
         // Load the static library for the bridge controller
@@ -23,7 +46,26 @@ public class Cy3240BridgeController {
     }
 
     // The device handle to the bridge controller
-    private int handle = 0;
+    private long handle = 0;
+
+    // The name the JMX monitor is registered under, null if it is not
+    private ObjectName monitorName = null;
+
+    // The native completion thread, 0 if not started
+    private long asyncContext = 0;
+
+    // Set while stopAsync() waits for the outstanding operations
+    private boolean stopping = false;
+
+    // The future of each outstanding asynchronous operation by slot
+    private CompletableFuture<Integer>[] pending;
+
+    // The buffer or transaction of each slot, kept reachable until completed
+    private Object[] pendingRefs;
+
+    // The free slots
+    private int[] freeSlots;
+    private int freeCount = 0;
 
     /**
      * Method to create the interface to the CY3240 device
@@ -43,7 +85,7 @@ public class Cy3240BridgeController {
      * @param handle [in] the device handle
      * @return Cy3240ErrorCode
      */
-    private native int open(int handle);
+    private native int open(long handle);
 
     /**
      * Method to open the device
@@ -52,7 +94,13 @@ public class Cy3240BridgeController {
      */
     public int open() {
 
-        return open(handle);
+        int result = open(handle);
+
+        if (result == Cy3240ErrorCode.OK) {
+            registerMonitor();
+        }
+
+        return result;
     }
 
     /**
@@ -61,7 +109,7 @@ public class Cy3240BridgeController {
      * @param handle [in] the device handle
      * @return Cy3240ErrorCode
      */
-    private native int close(int handle);
+    private native int close(long handle);
 
     /**
      * Method to close the device
@@ -69,6 +117,8 @@ public class Cy3240BridgeController {
      * @return Cy3240ErrorCode
      */
     public int close() {
+        stopAsync();
+        unregisterMonitor();
         return close(handle);
     }
 
@@ -80,7 +130,7 @@ public class Cy3240BridgeController {
      * @param data [in] the data to write
      * @return Cy3240ErrorCode
      */
-    private native int write(int handle, byte address, byte[] data);
+    private native int write(long handle, byte address, byte[] data);
 
     /**
      * Method to write to an I2C device
@@ -101,7 +151,7 @@ public class Cy3240BridgeController {
      * @param data [out] the data read from the device
      * @return Cy3240ErrorCode
      */
-    private native int read(int handle, byte address, byte[] data);
+    private native int read(long handle, byte address, byte[] data);
 
     /**
      * Method to read for an I2C device
@@ -114,13 +164,639 @@ public class Cy3240BridgeController {
         return read(handle, address, data);
     }
 
+    /**
+     * Method to write to an I2C device straight from the memory of a direct
+     * buffer
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param buffer [in] the direct buffer holding the data
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write
+     * @return Cy3240ErrorCode
+     */
+    private native int writeDirect(long handle, byte address, ByteBuffer buffer, int offset, int length);
+
+    /**
+     * Method to read from an I2C device straight into the memory of a direct
+     * buffer
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param buffer [out] the direct buffer for the data
+     * @param offset [in] the index of the first byte to fill
+     * @param length [in] the number of bytes to read
+     * @return Cy3240ErrorCode
+     */
+    private native int readDirect(long handle, byte address, ByteBuffer buffer, int offset, int length);
+
+    /**
+     * Method to write part of an array to an I2C device. The bytes are copied
+     * out before the transfer, the array is not held while it runs.
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write
+     * @return Cy3240ErrorCode
+     */
+    private native int writeRegion(long handle, byte address, byte[] data, int offset, int length);
+
+    /**
+     * Method to read from an I2C device into part of an array. The bytes are
+     * copied in once the transfer is done, the array is not held while it
+     * runs.
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param data [out] the data read from the device
+     * @param offset [in] the index of the first byte to fill
+     * @param length [in] the number of bytes to read
+     * @return Cy3240ErrorCode
+     */
+    private native int readRegion(long handle, byte address, byte[] data, int offset, int length);
+
+    /**
+     * Method to write to an I2C device from a pinned array. The garbage
+     * collector is held off for the whole transfer, so at most
+     * CRITICAL_MAX bytes are accepted.
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write
+     * @return Cy3240ErrorCode
+     */
+    private native int writeCritical(long handle, byte address, byte[] data, int offset, int length);
+
+    /**
+     * Method to read from an I2C device into a pinned array. The garbage
+     * collector is held off for the whole transfer, so at most
+     * CRITICAL_MAX bytes are accepted.
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the device address
+     * @param data [out] the data read from the device
+     * @param offset [in] the index of the first byte to fill
+     * @param length [in] the number of bytes to read
+     * @return Cy3240ErrorCode
+     */
+    private native int readCritical(long handle, byte address, byte[] data, int offset, int length);
+
+    /**
+     * Method to write part of an array to an I2C device. The bytes are copied
+     * once, the garbage collector keeps running during the transfer.
+     * 
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write
+     * @return Cy3240ErrorCode
+     */
+    public int write(byte address, byte[] data, int offset, int length) {
+        return writeRegion(handle, address, data, offset, length);
+    }
+
+    /**
+     * Method to read from an I2C device into part of an array. The bytes are
+     * copied once, the garbage collector keeps running during the transfer.
+     * 
+     * @param address [in] the device address
+     * @param data [out] the data read from the device
+     * @param offset [in] the index of the first byte to fill
+     * @param length [in] the number of bytes to read
+     * @return Cy3240ErrorCode
+     */
+    public int read(byte address, byte[] data, int offset, int length) {
+        return readRegion(handle, address, data, offset, length);
+    }
+
+    /**
+     * Method to write part of an array to an I2C device without copying it.
+     * The array is pinned and the garbage collector of every thread is held
+     * off until the bridge answered, only use it for short transfers where
+     * the copy matters.
+     * 
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write, at most CRITICAL_MAX
+     * @return Cy3240ErrorCode
+     */
+    public int writeCritical(byte address, byte[] data, int offset, int length) {
+        return writeCritical(handle, address, data, offset, length);
+    }
+
+    /**
+     * Method to read from an I2C device into part of an array without
+     * copying it. The array is pinned and the garbage collector of every
+     * thread is held off until the bridge answered, only use it for short
+     * transfers where the copy matters.
+     * 
+     * @param address [in] the device address
+     * @param data [out] the data read from the device
+     * @param offset [in] the index of the first byte to fill
+     * @param length [in] the number of bytes to read, at most CRITICAL_MAX
+     * @return Cy3240ErrorCode
+     */
+    public int readCritical(byte address, byte[] data, int offset, int length) {
+        return readCritical(handle, address, data, offset, length);
+    }
+
+    /**
+     * Method to write the remaining bytes of a buffer to an I2C device. Direct
+     * buffers are passed to the library as they are, heap buffers are copied.
+     * The position is moved to the limit when the write succeeds.
+     * 
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @return Cy3240ErrorCode
+     */
+    public int write(byte address, ByteBuffer data) {
+
+        int result = Cy3240ErrorCode.INVALID_PARAMS;
+
+        if (data.isDirect()) {
+            result = writeDirect(handle, address, data, data.position(), data.remaining());
+        } else if (data.hasArray()) {
+            result = writeRegion(handle, address, data.array(),
+                    data.arrayOffset() + data.position(), data.remaining());
+        }
+
+        if (result == Cy3240ErrorCode.OK) {
+            data.position(data.limit());
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to fill the remaining bytes of a buffer from an I2C device.
+     * Direct buffers are passed to the library as they are, heap buffers are
+     * copied. The position is moved to the limit when the read succeeds.
+     * 
+     * @param address [in] the device address
+     * @param data [out] the data read from the device
+     * @return Cy3240ErrorCode
+     */
+    public int read(byte address, ByteBuffer data) {
+
+        int result = Cy3240ErrorCode.INVALID_PARAMS;
+
+        if (data.isDirect()) {
+            result = readDirect(handle, address, data, data.position(), data.remaining());
+        } else if (data.hasArray()) {
+            result = readRegion(handle, address, data.array(),
+                    data.arrayOffset() + data.position(), data.remaining());
+        }
+
+        if (result == Cy3240ErrorCode.OK) {
+            data.position(data.limit());
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to program an EEPROM from a direct buffer
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the I2C address of the part
+     * @param addressWidth [in] the number of memory address bytes
+     * @param pageSize [in] the write page size
+     * @param size [in] the size of the part
+     * @param offset [in] the first EEPROM byte to write
+     * @param buffer [in] the direct buffer holding the data
+     * @param position [in] the index of the first byte in the buffer
+     * @param length [in] the number of bytes to write
+     * @return Cy3240ErrorCode
+     */
+    private native int eepromWrite(long handle, byte address, int addressWidth, int pageSize,
+            int size, int offset, ByteBuffer buffer, int position, int length);
+
+    /**
+     * Method to read an EEPROM in to a direct buffer
+     * 
+     * @param handle [in] the device handle
+     * @param address [in] the I2C address of the part
+     * @param addressWidth [in] the number of memory address bytes
+     * @param pageSize [in] the write page size
+     * @param size [in] the size of the part
+     * @param offset [in] the first EEPROM byte to read
+     * @param buffer [out] the direct buffer for the data
+     * @param position [in] the index of the first byte in the buffer
+     * @param length [in] the number of bytes to read
+     * @return Cy3240ErrorCode
+     */
+    private native int eepromRead(long handle, byte address, int addressWidth, int pageSize,
+            int size, int offset, ByteBuffer buffer, int position, int length);
+
+    /**
+     * Method to program the remaining bytes of a direct buffer in to an
+     * EEPROM. The write is split on page boundaries and the end of each
+     * write cycle is polled. The position is moved to the limit when the
+     * write succeeds.
+     * 
+     * @param eeprom [in] the EEPROM geometry
+     * @param offset [in] the first EEPROM byte to write
+     * @param data [in] the data to write
+     * @return Cy3240ErrorCode
+     */
+    public int writeEeprom(Cy3240Eeprom eeprom, int offset, ByteBuffer data) {
+
+        int result = eepromWrite(handle, eeprom.address, eeprom.addressWidth, eeprom.pageSize,
+                eeprom.size, offset, data, data.position(), data.remaining());
+
+        if (result == Cy3240ErrorCode.OK) {
+            data.position(data.limit());
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to fill the remaining bytes of a direct buffer from an EEPROM
+     * with pipelined sequential reads. The position is moved to the limit
+     * when the read succeeds.
+     * 
+     * @param eeprom [in] the EEPROM geometry
+     * @param offset [in] the first EEPROM byte to read
+     * @param data [out] the data read
+     * @return Cy3240ErrorCode
+     */
+    public int readEeprom(Cy3240Eeprom eeprom, int offset, ByteBuffer data) {
+
+        int result = eepromRead(handle, eeprom.address, eeprom.addressWidth, eeprom.pageSize,
+                eeprom.size, offset, data, data.position(), data.remaining());
+
+        if (result == Cy3240ErrorCode.OK) {
+            data.position(data.limit());
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to run a list of operations in one call
+     * 
+     * @param handle [in] the device handle
+     * @param ops [in] the encoded operations
+     * @param length [in] the number of encoded bytes
+     * @param count [in] the number of operations
+     * @param results [out] the results followed by the read data
+     * @return Cy3240ErrorCode, the first bus error
+     */
+    private native int transaction(long handle, ByteBuffer ops, int length, int count, ByteBuffer results);
+
+    /**
+     * Method to run all operations of a transaction in one call. The results
+     * and read data are kept in the transaction.
+     * 
+     * @param transaction [in,out] the operations
+     * @return Cy3240ErrorCode, the first bus error
+     */
+    public int execute(Cy3240Transaction transaction) {
+
+        if (transaction.size() == 0) {
+            return Cy3240ErrorCode.OK;
+        }
+
+        return transaction(handle, transaction.getOps(), transaction.getOps().position(),
+                transaction.size(), transaction.getResults());
+    }
+
+    /**
+     * Method to start the completion thread
+     * 
+     * @param handle [in] the device handle
+     * @param slots [in] the number of outstanding operations
+     * @return the native context, 0 on failure
+     */
+    private native long asyncStart(long handle, int slots);
+
+    /**
+     * Method to queue a write or read of a direct buffer
+     * 
+     * @param context [in] the native context
+     * @param slot [in] the slot completed when the operation finished
+     * @param type [in] ASYNC_WRITE or ASYNC_READ
+     * @param address [in] the device address
+     * @param buffer [in,out] the direct buffer
+     * @param offset [in] the index of the first byte
+     * @param length [in] the number of bytes
+     * @return Cy3240ErrorCode
+     */
+    private native int asyncSubmit(long context, int slot, int type, byte address,
+            ByteBuffer buffer, int offset, int length);
+
+    /**
+     * Method to queue a transaction
+     * 
+     * @param context [in] the native context
+     * @param slot [in] the slot completed when the transaction finished
+     * @param ops [in] the encoded operations
+     * @param length [in] the number of encoded bytes
+     * @param count [in] the number of operations
+     * @param results [out] the results followed by the read data
+     * @return Cy3240ErrorCode
+     */
+    private native int asyncSubmitTransaction(long context, int slot, ByteBuffer ops, int length,
+            int count, ByteBuffer results);
+
+    /**
+     * Method to run the queued operations and stop the completion thread
+     * 
+     * @param context [in] the native context
+     * @return Cy3240ErrorCode
+     */
+    private native int asyncStop(long context);
+
+    /**
+     * Method to start the native completion thread. It is started with
+     * ASYNC_SLOTS by the first asynchronous call if this is not called.
+     * Waits for a running stopAsync() to finish first.
+     * 
+     * @param slots [in] the number of operations that can be outstanding,
+     *            further calls wait for a free slot
+     * @return Cy3240ErrorCode
+     */
+    @SuppressWarnings("unchecked")
+    public synchronized int startAsync(int slots) {
+
+        // The completions of the old thread still use the slot arrays
+        while (stopping) {
+            try {
+                wait();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                return Cy3240ErrorCode.JNI;
+            }
+        }
+
+        if (asyncContext != 0) {
+            return Cy3240ErrorCode.OK;
+        }
+
+        long context = asyncStart(handle, slots);
+
+        if (context == 0) {
+            return Cy3240ErrorCode.JNI;
+        }
+
+        pending = new CompletableFuture[slots];
+        pendingRefs = new Object[slots];
+        freeSlots = new int[slots];
+
+        for (freeCount = 0; freeCount < slots; freeCount++) {
+            freeSlots[freeCount] = slots - 1 - freeCount;
+        }
+
+        asyncContext = context;
+
+        return Cy3240ErrorCode.OK;
+    }
+
+    /**
+     * Method to stop the completion thread once the outstanding operations
+     * are completed. Must not be called from a completion.
+     * 
+     * @return Cy3240ErrorCode
+     */
+    public int stopAsync() {
+
+        long context;
+        int result;
+
+        synchronized (this) {
+
+            if ((asyncContext == 0) || stopping) {
+                return Cy3240ErrorCode.OK;
+            }
+
+            context = asyncContext;
+            asyncContext = 0;
+            stopping = true;
+        }
+
+        // The completions need the lock
+        result = asyncStop(context);
+
+        synchronized (this) {
+            stopping = false;
+            notifyAll();
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to write the remaining bytes of a direct buffer to an I2C device
+     * without waiting. The future is completed from the native completion
+     * thread, so long running dependent stages should use the *Async
+     * variants of CompletableFuture. The position is moved to the limit when
+     * the write succeeds.
+     * 
+     * @param address [in] the device address
+     * @param data [in] the data to write, not to be touched until completed
+     * @return the future Cy3240ErrorCode
+     */
+    public CompletableFuture<Integer> writeAsync(byte address, ByteBuffer data) {
+
+        CompletableFuture<Integer> future = new CompletableFuture<Integer>();
+        CompletableFuture<Integer> failed = null;
+        int result = Cy3240ErrorCode.OK;
+
+        // Under the lock of stopAsync(), so the context stays valid
+        synchronized (this) {
+
+            int slot = acquire(future, data);
+
+            if (slot >= 0) {
+                result = asyncSubmit(asyncContext, slot, ASYNC_WRITE, address, data,
+                        data.position(), data.remaining());
+
+                if (result != Cy3240ErrorCode.OK) {
+                    failed = release(slot);
+                }
+            }
+        }
+
+        if (failed != null) {
+            failed.complete(result);
+        }
+
+        return future;
+    }
+
+    /**
+     * Method to fill the remaining bytes of a direct buffer from an I2C
+     * device without waiting. The future is completed as for writeAsync().
+     * 
+     * @param address [in] the device address
+     * @param data [out] the data read, not to be touched until completed
+     * @return the future Cy3240ErrorCode
+     */
+    public CompletableFuture<Integer> readAsync(byte address, ByteBuffer data) {
+
+        CompletableFuture<Integer> future = new CompletableFuture<Integer>();
+        CompletableFuture<Integer> failed = null;
+        int result = Cy3240ErrorCode.OK;
+
+        // Under the lock of stopAsync(), so the context stays valid
+        synchronized (this) {
+
+            int slot = acquire(future, data);
+
+            if (slot >= 0) {
+                result = asyncSubmit(asyncContext, slot, ASYNC_READ, address, data,
+                        data.position(), data.remaining());
+
+                if (result != Cy3240ErrorCode.OK) {
+                    failed = release(slot);
+                }
+            }
+        }
+
+        if (failed != null) {
+            failed.complete(result);
+        }
+
+        return future;
+    }
+
+    /**
+     * Method to run a transaction without waiting. The future is completed
+     * as for writeAsync().
+     * 
+     * @param transaction [in,out] the operations, not to be changed until
+     *            completed
+     * @return the future Cy3240ErrorCode, the first bus error
+     */
+    public CompletableFuture<Integer> transactionAsync(Cy3240Transaction transaction) {
+
+        CompletableFuture<Integer> future = new CompletableFuture<Integer>();
+
+        if (transaction.size() == 0) {
+            future.complete(Cy3240ErrorCode.OK);
+            return future;
+        }
+
+        CompletableFuture<Integer> failed = null;
+        int result = Cy3240ErrorCode.OK;
+
+        // Under the lock of stopAsync(), so the context stays valid
+        synchronized (this) {
+
+            int slot = acquire(future, transaction);
+
+            if (slot >= 0) {
+                result = asyncSubmitTransaction(asyncContext, slot, transaction.getOps(),
+                        transaction.getOps().position(), transaction.size(),
+                        transaction.getResults());
+
+                if (result != Cy3240ErrorCode.OK) {
+                    failed = release(slot);
+                }
+            }
+        }
+
+        if (failed != null) {
+            failed.complete(result);
+        }
+
+        return future;
+    }
+
+    /**
+     * Method to take a free slot for an asynchronous operation, starting the
+     * completion thread if needed. The completion thread is checked again
+     * after every wait, as stopAsync() may have run meanwhile.
+     * 
+     * @param future [in] the future of the operation
+     * @param ref [in] the buffer or transaction used by the operation
+     * @return the slot, -1 if the future was completed instead
+     */
+    private synchronized int acquire(CompletableFuture<Integer> future, Object ref) {
+
+        while (true) {
+
+            if (startAsync(ASYNC_SLOTS) != Cy3240ErrorCode.OK) {
+                future.complete(Cy3240ErrorCode.JNI);
+                return -1;
+            }
+
+            if (freeCount > 0) {
+                break;
+            }
+
+            try {
+                wait();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                future.completeExceptionally(e);
+                return -1;
+            }
+        }
+
+        int slot = freeSlots[--freeCount];
+        pending[slot] = future;
+        pendingRefs[slot] = ref;
+
+        return slot;
+    }
+
+    /**
+     * Method to free the slot of an operation that was not submitted, called
+     * with the lock held so the slot arrays are the ones it was taken from
+     * 
+     * @param slot [in] the slot of the operation
+     * @return the future of the operation
+     */
+    private synchronized CompletableFuture<Integer> release(int slot) {
+
+        CompletableFuture<Integer> future = pending[slot];
+
+        pending[slot] = null;
+        pendingRefs[slot] = null;
+        freeSlots[freeCount++] = slot;
+        notifyAll();
+
+        return future;
+    }
+
+    /**
+     * Called by the native completion thread when an operation finished
+     * 
+     * @param slot [in] the slot of the operation
+     * @param result [in] Cy3240ErrorCode
+     */
+    private void complete(int slot, int result) {
+
+        CompletableFuture<Integer> future;
+        Object ref;
+
+        synchronized (this) {
+            ref = pendingRefs[slot];
+            future = release(slot);
+        }
+
+        if ((result == Cy3240ErrorCode.OK) && (ref instanceof ByteBuffer)) {
+            ByteBuffer buffer = (ByteBuffer)ref;
+            buffer.position(buffer.limit());
+        }
+
+        future.complete(result);
+    }
+
     /**
      * Method to restart the bridge controller
      * 
      * @param handle [in] the device handle
      * @return Cy3240ErrorCode
      */
-    private native int restart(int handle);
+    private native int restart(long handle);
 
     /**
      * Method to restart the bridge controller
@@ -140,7 +816,7 @@ public class Cy3240BridgeController {
      * @param clock [in] the clock speed to use
      * @return Cy3240ErrorCode
      */
-    private native int reconfigure(int handle, byte power, byte bus, byte clock);
+    private native int reconfigure(long handle, byte power, byte bus, byte clock);
 
     /**
      * Method to reconfigure the bridge controller settings
@@ -160,7 +836,7 @@ public class Cy3240BridgeController {
      * @param handle [in] the device handle
      * @return Cy3240ErrorCode
      */
-    private native int reinitialize(int handle);
+    private native int reinitialize(long handle);
 
     /**
      * Method to reinitialize the bridge controller
@@ -171,4 +847,76 @@ public class Cy3240BridgeController {
         return reinitialize(handle);
     }
 
+    /**
+     * Method to copy the native statistics in to a snapshot
+     * 
+     * @param handle [in] the device handle
+     * @param values [out] the counters, laid out as in Cy3240Stats
+     * @return Cy3240ErrorCode
+     */
+    private native int stats(long handle, long[] values);
+
+    /**
+     * Method to take a snapshot of the statistics in one native call
+     * 
+     * @param stats [out] the snapshot, reused between calls
+     * @return Cy3240ErrorCode
+     */
+    public int getStats(Cy3240Stats stats) {
+
+        long now = System.nanoTime();
+        int result = stats(handle, stats.values());
+
+        if (result == Cy3240ErrorCode.OK) {
+            stats.setTimestamp(now);
+        }
+
+        return result;
+    }
+
+    /**
+     * Method to get the name the JMX monitor of the open device is
+     * registered under
+     * 
+     * @return the name, null if it is not registered
+     */
+    public ObjectName getMonitorName() {
+        return monitorName;
+    }
+
+    /**
+     * Method to register a Cy3240BridgeMonitor with the platform MBean
+     * server. Monitoring is optional, so a failure leaves the device usable.
+     */
+    private void registerMonitor() {
+
+        MBeanServer server = ManagementFactory.getPlatformMBeanServer();
+
+        try {
+            ObjectName name = new ObjectName("com.cypress.cy3240:type=Cy3240BridgeController,handle="
+                    + Long.toHexString(handle));
+            server.registerMBean(new Cy3240BridgeMonitor(this), name);
+            monitorName = name;
+        } catch (JMException e) {
+            monitorName = null;
+        }
+    }
+
+    /**
+     * Method to remove the JMX monitor before the handle is closed
+     */
+    private void unregisterMonitor() {
+
+        if (monitorName == null) {
+            return;
+        }
+
+        try {
+            ManagementFactory.getPlatformMBeanServer().unregisterMBean(monitorName);
+        } catch (JMException e) {
+            // Already gone
+        }
+
+        monitorName = null;
+    }
 }
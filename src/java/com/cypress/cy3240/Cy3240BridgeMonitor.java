@@ -0,0 +1,167 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+/**
+ * Publishes the statistics of a bridge controller over JMX. A snapshot is
+ * only taken when an attribute is read and the last one is older than the
+ * refresh interval, so a monitoring agent reading every attribute costs one
+ * native call per interval and nothing runs between reads. The rates and
+ * percentiles cover the round trips between the last two snapshots.
+ */
+public class Cy3240BridgeMonitor implements Cy3240BridgeMonitorMXBean {
+
+    /**
+     * The default refresh interval in milliseconds
+     */
+    public static final long DEFAULT_REFRESH_MS = 1000;
+
+    // The bridge controller
+    private final Cy3240BridgeController controller;
+
+    // The shortest time between two snapshots in nanoseconds
+    private final long refreshNs;
+
+    // The last snapshot and the one before it
+    private Cy3240Stats current = new Cy3240Stats();
+    private Cy3240Stats previous = new Cy3240Stats();
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     * @param refreshMs [in] the shortest time between two snapshots in milliseconds
+     */
+    public Cy3240BridgeMonitor(Cy3240BridgeController controller, long refreshMs) {
+        this.controller = controller;
+        this.refreshNs = refreshMs * 1000000L;
+    }
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     */
+    public Cy3240BridgeMonitor(Cy3240BridgeController controller) {
+        this(controller, DEFAULT_REFRESH_MS);
+    }
+
+    public synchronized long getWrites() {
+        return refresh().getWrites();
+    }
+
+    public synchronized long getReads() {
+        return refresh().getReads();
+    }
+
+    public synchronized long getBytes() {
+        Cy3240Stats stats = refresh();
+        return stats.getWriteBytes() + stats.getReadBytes();
+    }
+
+    public synchronized long getErrors() {
+        return refresh().getErrors();
+    }
+
+    public synchronized long getTimeouts() {
+        return refresh().getTimeouts();
+    }
+
+    public synchronized long getNaks() {
+        return naks(refresh());
+    }
+
+    public synchronized long getRetries() {
+        return refresh().getRetries();
+    }
+
+    public synchronized double getOperationsPerSecond() {
+        Cy3240Stats stats = refresh();
+        return rate(operations(stats) - operations(previous));
+    }
+
+    public synchronized double getBytesPerSecond() {
+        Cy3240Stats stats = refresh();
+        return rate(bytes(stats) - bytes(previous));
+    }
+
+    public synchronized double getNaksPerSecond() {
+        Cy3240Stats stats = refresh();
+        return rate(naks(stats) - naks(previous));
+    }
+
+    public synchronized double getNakRatio() {
+
+        // NAKs of reads and of the operations of transfers count as well
+        Cy3240Stats stats = refresh();
+        long operations = operations(stats) - operations(previous);
+
+        return (operations > 0) ? (double)(naks(stats) - naks(previous)) / operations : 0.0;
+    }
+
+    public synchronized long getLatencyUs() {
+        return refresh().getLatencyUs();
+    }
+
+    public synchronized long getP50LatencyUs() {
+        return refresh().getLatencyPercentile(previous, 50);
+    }
+
+    public synchronized long getP99LatencyUs() {
+        return refresh().getLatencyPercentile(previous, 99);
+    }
+
+    /**
+     * Method to take a new snapshot once the refresh interval has passed
+     *
+     * @return the last snapshot
+     */
+    private Cy3240Stats refresh() {
+
+        if ((current.getTimestamp() == 0) ||
+            (System.nanoTime() - current.getTimestamp() >= refreshNs)) {
+
+            // The snapshots are swapped so no garbage is created
+            Cy3240Stats stats = previous;
+
+            if (controller.getStats(stats) == Cy3240ErrorCode.OK) {
+                previous = current;
+                current = stats;
+            }
+        }
+
+        return current;
+    }
+
+    /**
+     * Method to turn a difference between the last two snapshots in to a rate
+     *
+     * @param delta [in] the difference
+     * @return the difference per second, 0 before the second snapshot
+     */
+    private double rate(long delta) {
+
+        long elapsed = current.getTimestamp() - previous.getTimestamp();
+
+        if ((previous.getTimestamp() == 0) || (elapsed <= 0)) {
+            return 0.0;
+        }
+
+        return delta * 1e9 / elapsed;
+    }
+
+    private static long operations(Cy3240Stats stats) {
+        return stats.getWrites() + stats.getReads() + stats.getErrors();
+    }
+
+    private static long bytes(Cy3240Stats stats) {
+        return stats.getWriteBytes() + stats.getReadBytes();
+    }
+
+    private static long naks(Cy3240Stats stats) {
+        return stats.getAddressNaks() + stats.getDataNaks();
+    }
+}
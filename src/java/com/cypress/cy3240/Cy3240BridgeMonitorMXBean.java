@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+/**
+ * JMX view of the statistics of an open bridge controller. The rates cover
+ * the time between the last two snapshots.
+ */
+public interface Cy3240BridgeMonitorMXBean {
+
+    /**
+     * @return the writes and probes that succeeded
+     */
+    long getWrites();
+
+    /**
+     * @return the reads that succeeded
+     */
+    long getReads();
+
+    /**
+     * @return the data bytes written and read
+     */
+    long getBytes();
+
+    /**
+     * @return the writes, reads and probes that failed, not counting the
+     *         probes no slave answered
+     */
+    long getErrors();
+
+    /**
+     * @return the adaptive timeouts that expired
+     */
+    long getTimeouts();
+
+    /**
+     * @return the NAKs seen by writes, reads and probes
+     */
+    long getNaks();
+
+    /**
+     * @return the packets sent again after a NAK
+     */
+    long getRetries();
+
+    /**
+     * @return the writes, reads and probes per second
+     */
+    double getOperationsPerSecond();
+
+    /**
+     * @return the data bytes written and read per second
+     */
+    double getBytesPerSecond();
+
+    /**
+     * @return the NAKs per second
+     */
+    double getNaksPerSecond();
+
+    /**
+     * @return the NAKs per write, read or transfer operation, 0 without
+     *         operations
+     */
+    double getNakRatio();
+
+    /**
+     * @return the smoothed USB round trip in microseconds
+     */
+    long getLatencyUs();
+
+    /**
+     * @return the median round trip in microseconds
+     */
+    long getP50LatencyUs();
+
+    /**
+     * @return the 99th percentile round trip in microseconds
+     */
+    long getP99LatencyUs();
+}
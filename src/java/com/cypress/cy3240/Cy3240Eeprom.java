@@ -0,0 +1,47 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+/**
+ * Geometry of a 24Cxx serial EEPROM, as in Cy3240_Eeprom_t
+ */
+public class Cy3240Eeprom {
+
+    /**
+     * The I2C address of the part, block bits clear
+     */
+    public final byte address;
+
+    /**
+     * The number of memory address bytes, 1 or 2
+     */
+    public final int addressWidth;
+
+    /**
+     * The write page size in bytes, a power of two
+     */
+    public final int pageSize;
+
+    /**
+     * The size of the part in bytes
+     */
+    public final int size;
+
+    /**
+     * Constructor
+     * 
+     * @param address [in] the I2C address of the part
+     * @param addressWidth [in] the number of memory address bytes
+     * @param pageSize [in] the write page size in bytes
+     * @param size [in] the size of the part in bytes
+     */
+    public Cy3240Eeprom(byte address, int addressWidth, int pageSize, int size) {
+        this.address = address;
+        this.addressWidth = addressWidth;
+        this.pageSize = pageSize;
+        this.size = size;
+    }
+}
@@ -0,0 +1,293 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.ClosedChannelException;
+import java.nio.channels.SeekableByteChannel;
+
+/**
+ * Seekable channel over the contents of a serial EEPROM, so images can be
+ * dumped and flashed with the standard NIO copy loops such as
+ * FileChannel.transferFrom() and transferTo().
+ *
+ * Reads are served from a direct read-ahead block filled by one pipelined
+ * native read. Direct buffers at least a block long are read and written
+ * in place. Writes are split on page boundaries by the library. Closing
+ * the channel does not close the controller.
+ */
+public class Cy3240EepromChannel implements SeekableByteChannel {
+
+    /**
+     * The default size of the read-ahead block and of the write staging
+     * buffer in bytes
+     */
+    public static final int DEFAULT_BLOCK_SIZE = 4096;
+
+    // The bridge controller
+    private final Cy3240BridgeController controller;
+
+    // The part
+    private final Cy3240Eeprom eeprom;
+
+    // The read-ahead block, valid from blockStart for block.limit() bytes
+    private final ByteBuffer block;
+    private int blockStart = 0;
+
+    // Heap data is staged here on its way to the part
+    private final ByteBuffer staging;
+
+    // The current position in the part
+    private long position = 0;
+
+    private boolean open = true;
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     * @param eeprom [in] the EEPROM geometry
+     * @param blockSize [in] the size of the read-ahead block in bytes
+     */
+    public Cy3240EepromChannel(Cy3240BridgeController controller, Cy3240Eeprom eeprom, int blockSize) {
+        this.controller = controller;
+        this.eeprom = eeprom;
+        this.block = ByteBuffer.allocateDirect(blockSize);
+        this.staging = ByteBuffer.allocateDirect(blockSize);
+
+        // Nothing read ahead yet
+        block.limit(0);
+    }
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     * @param eeprom [in] the EEPROM geometry
+     */
+    public Cy3240EepromChannel(Cy3240BridgeController controller, Cy3240Eeprom eeprom) {
+        this(controller, eeprom, DEFAULT_BLOCK_SIZE);
+    }
+
+    /**
+     * Method to read from the current position
+     *
+     * @param dst [out] the buffer to fill
+     * @return the number of bytes read, -1 at the end of the part
+     * @throws IOException if the bridge reported an error
+     */
+    public int read(ByteBuffer dst) throws IOException {
+
+        checkOpen();
+
+        if (position >= eeprom.size) {
+            return -1;
+        }
+
+        int length = (int)Math.min(dst.remaining(), eeprom.size - position);
+
+        if (length == 0) {
+            return 0;
+        }
+
+        // Large direct reads skip the read-ahead block
+        if (dst.isDirect() && (length >= block.capacity())) {
+
+            ByteBuffer window = dst.duplicate();
+            window.limit(window.position() + length);
+            check(controller.readEeprom(eeprom, (int)position, window));
+
+            dst.position(dst.position() + length);
+            position += length;
+
+            return length;
+        }
+
+        // Refill the block when the position is outside of it
+        if ((position < blockStart) || (position >= blockStart + block.limit())) {
+
+            int fill = (int)Math.min(block.capacity(), eeprom.size - position);
+
+            block.clear();
+            block.limit(fill);
+            blockStart = (int)position;
+
+            int result = controller.readEeprom(eeprom, blockStart, block);
+            block.position(0);
+
+            if (result != Cy3240ErrorCode.OK) {
+                block.limit(0);
+                check(result);
+            }
+        }
+
+        ByteBuffer view = block.duplicate();
+        view.position((int)(position - blockStart));
+        view.limit(Math.min(view.limit(), view.position() + length));
+
+        int copied = view.remaining();
+        dst.put(view);
+        position += copied;
+
+        return copied;
+    }
+
+    /**
+     * Method to program the part at the current position
+     *
+     * @param src [in] the data to write
+     * @return the number of bytes written
+     * @throws IOException if the bridge reported an error or the data does
+     *             not fit the part
+     */
+    public int write(ByteBuffer src) throws IOException {
+
+        checkOpen();
+
+        int length = src.remaining();
+
+        if (position + length > eeprom.size) {
+            throw new IOException("Write past the end of the EEPROM");
+        }
+
+        if (length == 0) {
+            return 0;
+        }
+
+        // The read-ahead block no longer matches the part
+        block.limit(0);
+
+        if (src.isDirect()) {
+
+            check(controller.writeEeprom(eeprom, (int)position, src));
+            position += length;
+
+            return length;
+        }
+
+        // Heap data goes through the staging buffer a block at a time
+        while (src.hasRemaining()) {
+
+            ByteBuffer chunk = src.duplicate();
+            chunk.limit(chunk.position() + Math.min(chunk.remaining(), staging.capacity()));
+
+            staging.clear();
+            staging.put(chunk);
+            staging.flip();
+
+            int count = staging.remaining();
+
+            check(controller.writeEeprom(eeprom, (int)position, staging));
+
+            src.position(src.position() + count);
+            position += count;
+        }
+
+        return length;
+    }
+
+    /**
+     * Method to get the current position
+     *
+     * @return the position in bytes from the start of the part
+     * @throws IOException if the channel is closed
+     */
+    public long position() throws IOException {
+        checkOpen();
+        return position;
+    }
+
+    /**
+     * Method to move the current position
+     *
+     * @param newPosition [in] the position in bytes from the start of the part
+     * @return this channel
+     * @throws IOException if the channel is closed
+     */
+    public SeekableByteChannel position(long newPosition) throws IOException {
+
+        checkOpen();
+
+        if (newPosition < 0) {
+            throw new IllegalArgumentException("Negative position " + newPosition);
+        }
+
+        position = newPosition;
+
+        return this;
+    }
+
+    /**
+     * Method to get the size of the part
+     *
+     * @return the size in bytes
+     * @throws IOException if the channel is closed
+     */
+    public long size() throws IOException {
+        checkOpen();
+        return eeprom.size;
+    }
+
+    /**
+     * The size of a part is fixed, so it can not be truncated
+     *
+     * @param size [in] the new size
+     * @return this channel if size is not smaller than the part
+     * @throws IOException if the channel is closed
+     */
+    public SeekableByteChannel truncate(long size) throws IOException {
+
+        checkOpen();
+
+        if (size < eeprom.size) {
+            throw new UnsupportedOperationException("An EEPROM can not be truncated");
+        }
+
+        return this;
+    }
+
+    /**
+     * Method to check if the channel is open
+     *
+     * @return true if the channel is open
+     */
+    public boolean isOpen() {
+        return open;
+    }
+
+    /**
+     * Method to close the channel, the controller stays open
+     */
+    public void close() {
+        open = false;
+    }
+
+    /**
+     * Method to check the channel is still open
+     *
+     * @throws ClosedChannelException if it is not
+     */
+    private void checkOpen() throws ClosedChannelException {
+        if (!open) {
+            throw new ClosedChannelException();
+        }
+    }
+
+    /**
+     * Method to turn a bridge error in to an exception
+     *
+     * @param result [in] Cy3240ErrorCode
+     * @return result if it is OK
+     * @throws IOException if it is not
+     */
+    private static int check(int result) throws IOException {
+        if (result != Cy3240ErrorCode.OK) {
+            throw new IOException("CY3240 error " + result);
+        }
+        return result;
+    }
+}
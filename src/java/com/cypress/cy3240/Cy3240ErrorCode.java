@@ -25,4 +25,6 @@ public class Cy3240ErrorCode {
     public static final int INVALID_PARAMS = 6;
 
     public static final int UNKNOWN = 7;
+
+    public static final int TIMEOUT = 8;
 }
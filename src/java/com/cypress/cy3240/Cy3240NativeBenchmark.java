@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Measures the cost of crossing in to the native library. The calls are
+ * made on a controller that was never created, so the library rejects them
+ * at once and only the JNI entry and argument handling are timed. No bridge
+ * is needed.
+ *
+ * Usage: Cy3240NativeBenchmark [calls]
+ */
+public class Cy3240NativeBenchmark {
+
+    // Rounds run before timing so the calls are compiled
+    private static final int WARMUP_ROUNDS = 3;
+
+    // Timed rounds, the fastest is reported
+    private static final int ROUNDS = 5;
+
+    /**
+     * A native call to time
+     */
+    private interface Call {
+        int run();
+    }
+
+    /**
+     * Main entry point
+     *
+     * @param args [in] the number of calls per round
+     */
+    public static void main(String[] args) {
+
+        final int calls = (args.length > 0) ? Integer.parseInt(args[0]) : 1000000;
+        final Cy3240BridgeController c = new Cy3240BridgeController();
+        final byte[] data = new byte[8];
+        final ByteBuffer direct = ByteBuffer.allocateDirect(8);
+        final Cy3240Transaction transaction = new Cy3240Transaction();
+
+        transaction.write((byte)0x00, data);
+
+        measure("write(byte[])", calls, new Call() {
+            public int run() {
+                return c.write((byte)0x00, data);
+            }
+        });
+
+        measure("write(byte[], offset, length)", calls, new Call() {
+            public int run() {
+                return c.write((byte)0x00, data, 0, data.length);
+            }
+        });
+
+        measure("write(direct ByteBuffer)", calls, new Call() {
+            public int run() {
+                direct.clear();
+                return c.write((byte)0x00, direct);
+            }
+        });
+
+        measure("execute(1 op)", calls, new Call() {
+            public int run() {
+                return c.execute(transaction);
+            }
+        });
+    }
+
+    /**
+     * Method to time a call and print the time per call
+     *
+     * @param name [in] the name printed
+     * @param calls [in] the number of calls per round
+     * @param call [in] the call
+     */
+    private static void measure(String name, int calls, Call call) {
+
+        long best = Long.MAX_VALUE;
+        int sink = 0;
+
+        for (int round = 0; round < WARMUP_ROUNDS + ROUNDS; round++) {
+
+            long start = System.nanoTime();
+
+            for (int x = 0; x < calls; x++) {
+                sink += call.run();
+            }
+
+            long elapsed = System.nanoTime() - start;
+
+            if (round >= WARMUP_ROUNDS) {
+                best = Math.min(best, elapsed);
+            }
+        }
+
+        System.out.println(name + ": " + ((double)best / calls) + " ns/call (" + sink + ")");
+    }
+}
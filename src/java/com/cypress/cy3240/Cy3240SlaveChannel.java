@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.ByteChannel;
+import java.nio.channels.ClosedChannelException;
+
+/**
+ * Channel that streams bytes to and from a slave without a memory address,
+ * such as a FIFO. Every read or write is one I2C transfer of up to
+ * maxTransfer bytes, framed in to packets by the library. Direct buffers
+ * are transferred in place and heap buffers are pinned, so no copy is made
+ * on the Java side. Nothing is read ahead, because a FIFO would lose the
+ * data. Closing the channel does not close the controller.
+ */
+public class Cy3240SlaveChannel implements ByteChannel {
+
+    /**
+     * The largest transfer the library accepts in one call
+     */
+    public static final int MAX_TRANSFER = 65535;
+
+    // The bridge controller
+    private final Cy3240BridgeController controller;
+
+    // The slave address
+    private final byte address;
+
+    // The longest single transfer
+    private final int maxTransfer;
+
+    private boolean open = true;
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     * @param address [in] the slave address
+     * @param maxTransfer [in] the longest single transfer in bytes
+     */
+    public Cy3240SlaveChannel(Cy3240BridgeController controller, byte address, int maxTransfer) {
+
+        if ((maxTransfer <= 0) || (maxTransfer > MAX_TRANSFER)) {
+            throw new IllegalArgumentException("Transfer size " + maxTransfer);
+        }
+
+        this.controller = controller;
+        this.address = address;
+        this.maxTransfer = maxTransfer;
+    }
+
+    /**
+     * Constructor
+     *
+     * @param controller [in] the opened bridge controller
+     * @param address [in] the slave address
+     */
+    public Cy3240SlaveChannel(Cy3240BridgeController controller, byte address) {
+        this(controller, address, MAX_TRANSFER);
+    }
+
+    /**
+     * Method to read from the slave
+     *
+     * @param dst [out] the buffer to fill
+     * @return the number of bytes read
+     * @throws IOException if the bridge reported an error
+     */
+    public int read(ByteBuffer dst) throws IOException {
+
+        checkOpen();
+
+        ByteBuffer window = window(dst);
+        int length = window.remaining();
+
+        if (length > 0) {
+            check(controller.read(address, window));
+            dst.position(dst.position() + length);
+        }
+
+        return length;
+    }
+
+    /**
+     * Method to write to the slave
+     *
+     * @param src [in] the data to write
+     * @return the number of bytes written
+     * @throws IOException if the bridge reported an error
+     */
+    public int write(ByteBuffer src) throws IOException {
+
+        checkOpen();
+
+        ByteBuffer window = window(src);
+        int length = window.remaining();
+
+        if (length > 0) {
+            check(controller.write(address, window));
+            src.position(src.position() + length);
+        }
+
+        return length;
+    }
+
+    /**
+     * Method to check if the channel is open
+     *
+     * @return true if the channel is open
+     */
+    public boolean isOpen() {
+        return open;
+    }
+
+    /**
+     * Method to close the channel, the controller stays open
+     */
+    public void close() {
+        open = false;
+    }
+
+    /**
+     * Method to get the part of a buffer moved by one transfer
+     *
+     * @param buffer [in] the buffer
+     * @return a view of at most maxTransfer remaining bytes
+     */
+    private ByteBuffer window(ByteBuffer buffer) {
+
+        ByteBuffer window = buffer.duplicate();
+        window.limit(window.position() + Math.min(window.remaining(), maxTransfer));
+
+        return window;
+    }
+
+    /**
+     * Method to check the channel is still open
+     *
+     * @throws ClosedChannelException if it is not
+     */
+    private void checkOpen() throws ClosedChannelException {
+        if (!open) {
+            throw new ClosedChannelException();
+        }
+    }
+
+    /**
+     * Method to turn a bridge error in to an exception
+     *
+     * @param result [in] Cy3240ErrorCode
+     * @throws IOException if it is not OK
+     */
+    private static void check(int result) throws IOException {
+        if (result != Cy3240ErrorCode.OK) {
+            throw new IOException("CY3240 error " + result);
+        }
+    }
+}
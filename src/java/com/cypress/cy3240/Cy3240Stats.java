@@ -0,0 +1,243 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+/**
+ * Snapshot of the native statistics of a bridge controller. The counters
+ * are copied from the library under one lock and in to Java with one call,
+ * so they are consistent with each other. A snapshot can be filled again
+ * by Cy3240BridgeController.getStats() without creating garbage.
+ */
+public class Cy3240Stats {
+
+    /**
+     * The number of round trip histogram buckets, bucket n counts the round
+     * trips from 2^n up to 2^(n+1) microseconds
+     */
+    public static final int LATENCY_BUCKETS = 24;
+
+    // Layout of the array filled by the native call, as in Stats_Index_t
+    private static final int WRITES = 0;
+    private static final int READS = 1;
+    private static final int WRITE_BYTES = 2;
+    private static final int READ_BYTES = 3;
+    private static final int ERRORS = 4;
+    private static final int SAMPLES = 5;
+    private static final int TIMEOUTS = 6;
+    private static final int LATENCY_US = 7;
+    private static final int DEVIATION_US = 8;
+    private static final int ADDRESS_NAKS = 9;
+    private static final int DATA_NAKS = 10;
+    private static final int RETRIES = 11;
+    private static final int EXHAUSTED = 12;
+    private static final int HISTOGRAM = 13;
+    static final int COUNT = HISTOGRAM + LATENCY_BUCKETS;
+
+    // The native counters
+    private final long[] values = new long[COUNT];
+
+    // System.nanoTime() when the snapshot was taken, 0 if never
+    private long timestamp = 0;
+
+    /**
+     * Method to get the array the native call fills
+     *
+     * @return the counters
+     */
+    long[] values() {
+        return values;
+    }
+
+    /**
+     * Method to record when the snapshot was taken
+     *
+     * @param timestamp [in] System.nanoTime() of the native call
+     */
+    void setTimestamp(long timestamp) {
+        this.timestamp = timestamp;
+    }
+
+    /**
+     * @return System.nanoTime() when the snapshot was taken, 0 if never
+     */
+    public long getTimestamp() {
+        return timestamp;
+    }
+
+    /**
+     * @return the writes and probes that succeeded
+     */
+    public long getWrites() {
+        return values[WRITES];
+    }
+
+    /**
+     * @return the reads that succeeded
+     */
+    public long getReads() {
+        return values[READS];
+    }
+
+    /**
+     * @return the data bytes written
+     */
+    public long getWriteBytes() {
+        return values[WRITE_BYTES];
+    }
+
+    /**
+     * @return the data bytes read
+     */
+    public long getReadBytes() {
+        return values[READ_BYTES];
+    }
+
+    /**
+     * @return the writes, reads and probes that failed, not counting the
+     *         probes no slave answered
+     */
+    public long getErrors() {
+        return values[ERRORS];
+    }
+
+    /**
+     * @return the round trips measured
+     */
+    public long getSamples() {
+        return values[SAMPLES];
+    }
+
+    /**
+     * @return the adaptive timeouts that expired
+     */
+    public long getTimeouts() {
+        return values[TIMEOUTS];
+    }
+
+    /**
+     * @return the smoothed USB round trip without the bus time in microseconds
+     */
+    public long getLatencyUs() {
+        return values[LATENCY_US];
+    }
+
+    /**
+     * @return the smoothed deviation of the round trip in microseconds
+     */
+    public long getDeviationUs() {
+        return values[DEVIATION_US];
+    }
+
+    /**
+     * @return the times a slave did not acknowledge its address
+     */
+    public long getAddressNaks() {
+        return values[ADDRESS_NAKS];
+    }
+
+    /**
+     * @return the times a slave refused a data byte
+     */
+    public long getDataNaks() {
+        return values[DATA_NAKS];
+    }
+
+    /**
+     * @return the packets sent again after a NAK
+     */
+    public long getRetries() {
+        return values[RETRIES];
+    }
+
+    /**
+     * @return the writes that failed after the last retry
+     */
+    public long getExhausted() {
+        return values[EXHAUSTED];
+    }
+
+    /**
+     * Method to get a bucket of the round trip histogram
+     *
+     * @param bucket [in] the bucket, 0 to LATENCY_BUCKETS - 1
+     * @return the round trips from 2^bucket up to 2^(bucket+1) microseconds
+     */
+    public long getHistogram(int bucket) {
+
+        if ((bucket < 0) || (bucket >= LATENCY_BUCKETS)) {
+            throw new IndexOutOfBoundsException("Bucket " + bucket);
+        }
+
+        return values[HISTOGRAM + bucket];
+    }
+
+    /**
+     * Method to estimate a round trip percentile from the histogram, as
+     * cy3240_stats_percentile() does
+     *
+     * @param percent [in] the percentile, 1 to 100
+     * @return the upper bound of the bucket holding the percentile in
+     *         microseconds, 0 without round trips
+     */
+    public long getLatencyPercentile(int percent) {
+        return getLatencyPercentile(null, percent);
+    }
+
+    /**
+     * Method to estimate a percentile of the round trips measured after an
+     * earlier snapshot
+     *
+     * @param since [in] the earlier snapshot, null for all round trips
+     * @param percent [in] the percentile, 1 to 100
+     * @return the upper bound of the bucket holding the percentile in
+     *         microseconds, 0 without round trips
+     */
+    public long getLatencyPercentile(Cy3240Stats since, int percent) {
+
+        if ((percent <= 0) || (percent > 100)) {
+            throw new IllegalArgumentException("Percentile " + percent);
+        }
+
+        long total = 0;
+
+        for (int x = 0; x < LATENCY_BUCKETS; x++) {
+            total += bucket(since, x);
+        }
+
+        // The round trip at this rank is the percentile
+        long rank = (total * percent + 99) / 100;
+        long seen = 0;
+
+        for (int x = 0; (x < LATENCY_BUCKETS) && (rank != 0); x++) {
+
+            seen += bucket(since, x);
+
+            if (seen >= rank) {
+                return 1L << (x + 1);
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * Method to get the round trips of a bucket after an earlier snapshot
+     *
+     * @param since [in] the earlier snapshot, null for all round trips
+     * @param bucket [in] the bucket
+     * @return the number of round trips
+     */
+    private long bucket(Cy3240Stats since, int bucket) {
+
+        long count = values[HISTOGRAM + bucket];
+
+        if (since != null) {
+            count -= since.values[HISTOGRAM + bucket];
+        }
+
+        return count;
+    }
+}
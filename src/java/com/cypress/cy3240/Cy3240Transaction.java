@@ -0,0 +1,260 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+import java.nio.ByteBuffer;
+
+/**
+ * A list of I2C operations run by the bridge controller in a single native
+ * call. The operations are encoded in to a direct buffer as they are added
+ * and the results and read data come back in a second direct buffer, so a
+ * transaction can be cleared and built again without creating garbage.
+ */
+public class Cy3240Transaction {
+
+    /**
+     * The largest write or read of a single operation in bytes, one packet
+     */
+    public static final int MAX_OP_BYTES = 61;
+
+    // The operation types, as in Cy3240_Op_Type_t
+    private static final byte OP_WRITE = 0;
+    private static final byte OP_READ = 1;
+    private static final byte OP_PROBE = 2;
+
+    // Type, address and length of every encoded operation
+    private static final int OP_HEADER = 3;
+
+    // The encoded operations
+    private ByteBuffer ops;
+
+    // The results followed by the read data
+    private ByteBuffer results;
+
+    // The offset of the read data of each operation after the results
+    private int[] dataOffsets = new int[16];
+
+    // The length of the read data of each operation
+    private int[] dataLengths = new int[16];
+
+    // The number of operations
+    private int count = 0;
+
+    // The number of bytes read by all operations
+    private int readBytes = 0;
+
+    /**
+     * Constructor
+     *
+     * @param capacity [in] the initial size of the operation buffer in bytes
+     */
+    public Cy3240Transaction(int capacity) {
+        ops = ByteBuffer.allocateDirect(Math.max(capacity, OP_HEADER + MAX_OP_BYTES));
+        results = ByteBuffer.allocateDirect(16);
+    }
+
+    /**
+     * Constructor
+     */
+    public Cy3240Transaction() {
+        this(1024);
+    }
+
+    /**
+     * Method to add a write
+     *
+     * @param address [in] the device address
+     * @param data [in] the data to write
+     * @param offset [in] the index of the first byte to write
+     * @param length [in] the number of bytes to write, at most MAX_OP_BYTES
+     * @return this transaction
+     */
+    public Cy3240Transaction write(byte address, byte[] data, int offset, int length) {
+
+        if ((length <= 0) || (length > MAX_OP_BYTES)) {
+            throw new IllegalArgumentException("Write length " + length);
+        }
+
+        add(OP_WRITE, address, length, length);
+        ops.put(data, offset, length);
+        return this;
+    }
+
+    /**
+     * Method to add a write
+     *
+     * @param address [in] the device address
+     * @param data [in] the data to write, at most MAX_OP_BYTES
+     * @return this transaction
+     */
+    public Cy3240Transaction write(byte address, byte[] data) {
+        return write(address, data, 0, data.length);
+    }
+
+    /**
+     * Method to add a read
+     *
+     * @param address [in] the device address
+     * @param length [in] the number of bytes to read, at most MAX_OP_BYTES
+     * @return this transaction
+     */
+    public Cy3240Transaction read(byte address, int length) {
+
+        if ((length <= 0) || (length > MAX_OP_BYTES)) {
+            throw new IllegalArgumentException("Read length " + length);
+        }
+
+        add(OP_READ, address, length, 0);
+        return this;
+    }
+
+    /**
+     * Method to add a check that a device acknowledges its address
+     *
+     * @param address [in] the device address
+     * @return this transaction
+     */
+    public Cy3240Transaction probe(byte address) {
+        add(OP_PROBE, address, 0, 0);
+        return this;
+    }
+
+    /**
+     * Method to remove all operations, the buffers are kept
+     */
+    public void clear() {
+        ops.clear();
+        count = 0;
+        readBytes = 0;
+    }
+
+    /**
+     * Method to get the number of operations
+     *
+     * @return the number of operations
+     */
+    public int size() {
+        return count;
+    }
+
+    /**
+     * Method to get the result of an operation after the transaction ran
+     *
+     * @param index [in] the operation, in the order they were added
+     * @return Cy3240ErrorCode
+     */
+    public int getResult(int index) {
+        checkIndex(index);
+        return results.get(index);
+    }
+
+    /**
+     * Method to copy the data of a read after the transaction ran
+     *
+     * @param index [in] the operation, in the order they were added
+     * @param data [out] the data read from the device
+     * @param offset [in] the index in data of the first byte
+     * @return the number of bytes copied
+     */
+    public int getData(int index, byte[] data, int offset) {
+
+        checkIndex(index);
+
+        ByteBuffer view = results.duplicate();
+        view.position(count + dataOffsets[index]);
+        view.get(data, offset, dataLengths[index]);
+
+        return dataLengths[index];
+    }
+
+    /**
+     * Method to get the data of a read after the transaction ran
+     *
+     * @param index [in] the operation, in the order they were added
+     * @return the data read from the device, empty for other operations
+     */
+    public byte[] getData(int index) {
+
+        checkIndex(index);
+
+        byte[] data = new byte[dataLengths[index]];
+        getData(index, data, 0);
+
+        return data;
+    }
+
+    /**
+     * Method to get the encoded operations
+     *
+     * @return the operation buffer, valid up to its position
+     */
+    ByteBuffer getOps() {
+        return ops;
+    }
+
+    /**
+     * Method to get the buffer for the results, sized for the operations
+     *
+     * @return the results buffer
+     */
+    ByteBuffer getResults() {
+
+        if (results.capacity() < count + readBytes) {
+            results = ByteBuffer.allocateDirect(Math.max(count + readBytes, results.capacity() * 2));
+        }
+
+        return results;
+    }
+
+    /**
+     * Method to encode the header of an operation
+     *
+     * @param type [in] the operation type
+     * @param address [in] the device address
+     * @param length [in] the number of bytes written or read
+     * @param payload [in] the number of data bytes following the header
+     */
+    private void add(byte type, byte address, int length, int payload) {
+
+        // Grow the buffers, keeping what is encoded
+        if (ops.remaining() < OP_HEADER + payload) {
+            ByteBuffer larger = ByteBuffer.allocateDirect(ops.capacity() * 2);
+            ops.flip();
+            larger.put(ops);
+            ops = larger;
+        }
+
+        if (count == dataOffsets.length) {
+            int[] offsets = new int[count * 2];
+            int[] lengths = new int[count * 2];
+            System.arraycopy(dataOffsets, 0, offsets, 0, count);
+            System.arraycopy(dataLengths, 0, lengths, 0, count);
+            dataOffsets = offsets;
+            dataLengths = lengths;
+        }
+
+        ops.put(type);
+        ops.put(address);
+        ops.put((byte)length);
+
+        // Reads land after the results in the order they were added
+        dataOffsets[count] = readBytes;
+        dataLengths[count] = (type == OP_READ) ? length : 0;
+        readBytes += dataLengths[count];
+        count++;
+    }
+
+    /**
+     * Method to check an operation index
+     *
+     * @param index [in] the operation
+     */
+    private void checkIndex(int index) {
+        if ((index < 0) || (index >= count)) {
+            throw new IndexOutOfBoundsException("Operation " + index);
+        }
+    }
+}
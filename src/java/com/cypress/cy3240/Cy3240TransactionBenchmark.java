@@ -0,0 +1,80 @@
+/**
+ * @file
+ * @author Kevin Kirkup (kevin.kirkup@sonyericsson.com)
+ */
+
+package com.cypress.cy3240;
+
+/**
+ * Compares the time per operation of single write calls with the same
+ * writes run as transactions. Needs a bridge with a device that accepts
+ * short writes, by default the LED port of the demo board.
+ *
+ * Usage: Cy3240TransactionBenchmark [address] [operations] [batch]
+ */
+public class Cy3240TransactionBenchmark {
+
+    /**
+     * Main entry point
+     *
+     * @param args [in] the device address, the number of operations and the
+     *             number of operations per transaction
+     */
+    public static void main(String[] args) {
+
+        byte address = (args.length > 0) ? (byte)Integer.decode(args[0]).intValue() : 0x00;
+        int operations = (args.length > 1) ? Integer.parseInt(args[1]) : 10000;
+        int batch = (args.length > 2) ? Integer.parseInt(args[2]) : 100;
+
+        Cy3240BridgeController c = new Cy3240BridgeController();
+
+        // Create the device
+        if ((c.create(0, 1000, Cy3240PowerMode.CY3240_POWER_5V, Cy3240BusMode.CY3240_BUS_I2C,
+                Cy3240ClockSpeed.CY3240_CLOCK_100kHz) != Cy3240ErrorCode.OK) ||
+            (c.open() != Cy3240ErrorCode.OK)) {
+            System.err.println("Failed to open the bridge controller");
+            return;
+        }
+
+        byte[] data = new byte[] { 0x00, 0x01 };
+        Cy3240Transaction transaction = new Cy3240Transaction();
+        int failures = 0;
+
+        // One JNI call and one lock per operation
+        long start = System.nanoTime();
+
+        for (int x = 0; x < operations; x++) {
+            if (c.write(address, data) != Cy3240ErrorCode.OK) {
+                failures++;
+            }
+        }
+
+        long single = System.nanoTime() - start;
+
+        // One JNI call per batch, the builder is reused
+        start = System.nanoTime();
+
+        for (int x = 0; x < operations; x += batch) {
+
+            transaction.clear();
+
+            for (int y = x; (y < x + batch) && (y < operations); y++) {
+                transaction.write(address, data);
+            }
+
+            if (c.execute(transaction) != Cy3240ErrorCode.OK) {
+                failures++;
+            }
+        }
+
+        long batched = System.nanoTime() - start;
+
+        System.out.println("operations:  " + operations);
+        System.out.println("single:      " + (single / operations) + " ns/op");
+        System.out.println("transaction: " + (batched / operations) + " ns/op, " + batch
+                + " ops per call");
+        System.out.println("failures:    " + failures);
+
+        c.close();
+    }
+}
@@ -16,17 +16,502 @@
 //@{
 
 #include <jni.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include "native_cy3240bridgecontroller.h"
 #include "cy3240_types.h"
 #include "cy3240.h"
+#include "cy3240_eeprom.h"
 
 //@} End of Includes
 
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define TRANSACTION_CHUNK  (64)      ///< Operations handed to cy3240_transfer() at once
+#define TRANSACTION_HEADER (3)       ///< Type, address and length of an encoded operation
+#define REGION_STAGE       (256)     ///< Array bytes copied through the stack, more are allocated
+#define CRITICAL_MAX       (64)      ///< Longest transfer allowed to pin an array, about one report
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Asynchronous request types
+ */
+typedef enum {
+    ASYNC_WRITE,                     ///< cy3240_write() of a direct buffer
+    ASYNC_READ,                      ///< cy3240_read() in to a direct buffer
+    ASYNC_TRANSACTION                ///< Encoded transaction, see run_transaction()
+} Async_Type_t;
+
+/**
+ * A queued asynchronous request. The buffers are kept reachable by the
+ * Java side until the request is completed.
+ */
+typedef struct {
+    int type;                        ///< Async_Type_t
+    uint8_t address;                 ///< I2C address for a write or read
+    uint8_t* pData;                  ///< Data, or the encoded operations
+    jlong capacity;                  ///< Size of the operation buffer
+    jint length;                     ///< Bytes to transfer, or encoded bytes
+    jint count;                      ///< Operations of a transaction
+    uint8_t* pResults;               ///< Results of a transaction
+    jlong resultsCapacity;           ///< Size of the results buffer
+} Async_Request_t;
+
+/**
+ * Completion thread of one controller. Requests are stored in the slot
+ * chosen by the Java side and the slot numbers are queued in order.
+ */
+typedef struct {
+    jobject controller;              ///< Global reference to the controller
+    int handle;                      ///< The bridge handle
+    pthread_t thread;                ///< The completion thread
+    pthread_mutex_t lock;            ///< Protects the queue
+    pthread_cond_t ready;            ///< Signals queued requests and the attach
+    volatile bool running;           ///< Cleared to stop the thread
+    Cy3240_Error_t attached;         ///< Result of attaching to the VM
+    int slots;                       ///< Number of request slots
+    int head;                        ///< Oldest queued slot number
+    int count;                       ///< Number of queued requests
+    int* pQueue;                     ///< Queued slot numbers
+    Async_Request_t* pRequests;      ///< Request of each slot
+} Async_t;
+
+/**
+ * Layout of the statistics array filled by stats(), as in Cy3240Stats
+ */
+typedef enum {
+    STATS_WRITES,                    ///< Cy3240_Traffic_t.writes
+    STATS_READS,                     ///< Cy3240_Traffic_t.reads
+    STATS_WRITE_BYTES,               ///< Cy3240_Traffic_t.write_bytes
+    STATS_READ_BYTES,                ///< Cy3240_Traffic_t.read_bytes
+    STATS_ERRORS,                    ///< Cy3240_Traffic_t.errors
+    STATS_SAMPLES,                   ///< Cy3240_Latency_t.samples
+    STATS_TIMEOUTS,                  ///< Cy3240_Latency_t.timeouts
+    STATS_LATENCY_US,                ///< Cy3240_Latency_t.latency_us
+    STATS_DEVIATION_US,              ///< Cy3240_Latency_t.deviation_us
+    STATS_ADDRESS_NAKS,              ///< Cy3240_Retry_Stats_t.naks[CY3240_NAK_ADDRESS]
+    STATS_DATA_NAKS,                 ///< Cy3240_Retry_Stats_t.naks[CY3240_NAK_DATA]
+    STATS_RETRIES,                   ///< Cy3240_Retry_Stats_t.retries
+    STATS_EXHAUSTED,                 ///< Cy3240_Retry_Stats_t.exhausted
+    STATS_HISTOGRAM,                 ///< First of the Cy3240_Traffic_t.histogram buckets
+    STATS_COUNT = STATS_HISTOGRAM + CY3240_LATENCY_BUCKETS ///< Length of the array
+} Stats_Index_t;
+
+/**
+ * IDs looked up once when the library is loaded
+ */
+typedef struct {
+    JavaVM* pVm;                     ///< The VM that loaded the library
+    jclass controllerClass;          ///< Global reference, keeps the IDs valid
+    jfieldID handle;                 ///< Cy3240BridgeController.handle
+    jmethodID complete;              ///< Cy3240BridgeController.complete(II)V
+} Jni_Cache_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+static Jni_Cache_t cache;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check a window of a Java buffer before it is handed to the
+ *  library, the library takes a 16 bit length
+ *
+ *  @param capacity [in] the size of the buffer
+ *  @param offset   [in] the start of the window
+ *  @param length   [in] the number of bytes in the window
+ *  @returns true if the window lies inside the buffer
+ */
+//-----------------------------------------------------------------------------
+static bool
+check_window(
+        jlong capacity,
+        jint offset,
+        jint length
+        )
+{
+    return (offset >= 0) &&
+           (length > 0) &&
+           (length <= UINT16_MAX) &&
+           ((jlong)offset + length <= capacity);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to decode and run the operations encoded by Cy3240Transaction.
+ *  Each operation is a type, address and length byte followed by the data
+ *  of a write. The results buffer starts with one result byte per operation
+ *  followed by the data of the reads in operation order. The data is
+ *  written from and read into the buffers without a copy.
+ *
+ *  @param handle          [in] the handle to the bridge controller
+ *  @param pOps            [in] the encoded operations
+ *  @param opsCapacity     [in] the size of the operation buffer
+ *  @param length          [in] the number of encoded bytes
+ *  @param count           [in] the number of operations
+ *  @param pResults        [out] the results followed by the read data
+ *  @param resultsCapacity [in] the size of the results buffer
+ *  @returns the first HID error
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+run_transaction(
+        int handle,
+        uint8_t* const pOps,
+        jlong opsCapacity,
+        jint length,
+        jint count,
+        uint8_t* const pResults,
+        jlong resultsCapacity
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    Cy3240_Op_t chunk[TRANSACTION_CHUNK];
+    jlong opOffset = 0;
+    jlong dataOffset = count;
+    jint done = 0;
+    jint x;
+
+    if ((pOps == NULL) ||
+        (pResults == NULL) ||
+        (count <= 0) ||
+        (length < 0) ||
+        (length > opsCapacity) ||
+        (count > resultsCapacity))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    // Ops that never run keep this result
+    memset(pResults, CY3240_ERROR_UNKNOWN, count);
+
+    while (CY3240_SUCCESS(result) && (done < count)) {
+
+        uint16_t n = 0;
+
+        // Decode the next chunk, the data stays in the buffers
+        while ((n < TRANSACTION_CHUNK) && ((done + n) < count)) {
+
+            Cy3240_Op_t* pOp = &chunk[n];
+
+            if (opOffset + TRANSACTION_HEADER > length)
+                return CY3240_ERROR_INVALID_PARAMETERS;
+
+            pOp->type = (Cy3240_Op_Type_t)pOps[opOffset];
+            pOp->address = pOps[opOffset + 1];
+            pOp->length = pOps[opOffset + 2];
+            pOp->pData = NULL;
+            opOffset += TRANSACTION_HEADER;
+
+            if (pOp->type == CY3240_OP_WRITE) {
+
+                if (opOffset + pOp->length > length)
+                    return CY3240_ERROR_INVALID_PARAMETERS;
+
+                pOp->pData = &pOps[opOffset];
+                opOffset += pOp->length;
+
+            } else if (pOp->type == CY3240_OP_READ) {
+
+                if (dataOffset + pOp->length > resultsCapacity)
+                    return CY3240_ERROR_INVALID_PARAMETERS;
+
+                pOp->pData = &pResults[dataOffset];
+                dataOffset += pOp->length;
+            }
+
+            n++;
+        }
+
+        // One lock and one pipeline for the whole chunk
+        result = cy3240_transfer(
+                (int)handle,
+                chunk,
+                n);
+
+        if (result != CY3240_ERROR_INVALID_PARAMETERS)
+            for (x = 0; x < n; x++)
+                pResults[done + x] = (uint8_t)chunk[x].result;
+
+        done += n;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a queued asynchronous request
+ *
+ *  @param handle   [in] the handle to the bridge controller
+ *  @param pRequest [in] the request
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+async_run(
+        int handle,
+        const Async_Request_t* const pRequest
+        )
+{
+    uint16_t count = (uint16_t)pRequest->length;
+
+    switch (pRequest->type) {
+
+        case ASYNC_WRITE:
+            return cy3240_write(
+                    handle,
+                    pRequest->address,
+                    pRequest->pData,
+                    &count);
+
+        case ASYNC_READ:
+            return cy3240_read(
+                    handle,
+                    pRequest->address,
+                    pRequest->pData,
+                    &count);
+
+        case ASYNC_TRANSACTION:
+            return run_transaction(
+                    handle,
+                    pRequest->pData,
+                    pRequest->capacity,
+                    pRequest->length,
+                    pRequest->count,
+                    pRequest->pResults,
+                    pRequest->resultsCapacity);
+    }
+
+    return CY3240_ERROR_INVALID_PARAMETERS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Completion thread. It attaches to the VM once, runs the requests in the
+ *  order they were queued and completes each through the complete method
+ *  of the controller. It exits once it was stopped and the queue is empty.
+ *
+ *  @param arg [in] the Async_t
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+async_thread(
+        void* arg
+        )
+{
+    Async_t* pAsync = (Async_t*)arg;
+    JNIEnv* jenv = NULL;
+    Cy3240_Error_t attached = CY3240_ERROR_OK;
+
+    if ((*cache.pVm)->AttachCurrentThreadAsDaemon(
+                cache.pVm,
+                (void**)&jenv,
+                NULL) != 0)
+        attached = CY3240_ERROR_JNI;
+
+    pthread_mutex_lock(&pAsync->lock);
+    pAsync->attached = attached;
+    pthread_cond_broadcast(&pAsync->ready);
+
+    while (CY3240_SUCCESS(attached)) {
+
+        Async_Request_t request;
+        Cy3240_Error_t result;
+        int slot;
+
+        while (pAsync->running && (pAsync->count == 0))
+            pthread_cond_wait(&pAsync->ready, &pAsync->lock);
+
+        if (pAsync->count == 0)
+            break;
+
+        slot = pAsync->pQueue[pAsync->head];
+        request = pAsync->pRequests[slot];
+        pAsync->head = (pAsync->head + 1) % pAsync->slots;
+        pAsync->count--;
+
+        pthread_mutex_unlock(&pAsync->lock);
+
+        result = async_run(
+                pAsync->handle,
+                &request);
+
+        (*jenv)->CallVoidMethod(
+                jenv,
+                pAsync->controller,
+                cache.complete,
+                (jint)slot,
+                (jint)result);
+
+        // An exception in a completion must not stop the thread
+        if ((*jenv)->ExceptionCheck(jenv))
+            (*jenv)->ExceptionClear(jenv);
+
+        pthread_mutex_lock(&pAsync->lock);
+    }
+
+    pthread_mutex_unlock(&pAsync->lock);
+
+    if CY3240_SUCCESS(attached)
+        (*cache.pVm)->DetachCurrentThread(cache.pVm);
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to queue an asynchronous request
+ *
+ *  @param pAsync   [in] the completion thread state
+ *  @param slot     [in] the request slot, owned by the caller until completed
+ *  @param pRequest [in] the request
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+async_queue(
+        Async_t* const pAsync,
+        jint slot,
+        const Async_Request_t* const pRequest
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_INVALID_PARAMETERS;
+
+    if ((pAsync != NULL) &&
+        (slot >= 0) &&
+        (slot < pAsync->slots)) {
+
+        pthread_mutex_lock(&pAsync->lock);
+
+        // Every slot is queued at most once, so the queue cannot overflow
+        if (pAsync->running && (pAsync->count < pAsync->slots)) {
+
+            pAsync->pRequests[slot] = *pRequest;
+            pAsync->pQueue[(pAsync->head + pAsync->count) % pAsync->slots] = slot;
+            pAsync->count++;
+            pthread_cond_signal(&pAsync->ready);
+            result = CY3240_ERROR_OK;
+        }
+
+        pthread_mutex_unlock(&pAsync->lock);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to free the completion thread state
+ *
+ *  @param pAsync [in] the state, the thread must not be running
+ */
+//-----------------------------------------------------------------------------
+static void
+async_free(
+        Async_t* const pAsync
+        )
+{
+    pthread_cond_destroy(&pAsync->ready);
+    pthread_mutex_destroy(&pAsync->lock);
+    free(pAsync->pRequests);
+    free(pAsync->pQueue);
+    free(pAsync);
+}
+
+//@} End of Private Methods
+
 //////////////////////////////////////////////////////////////////////
 /// @name Methods
 //@{
 
+//-----------------------------------------------------------------------------
+/**
+ *  Called by the VM when the library is loaded. Looks up the class, field
+ *  and method IDs used by the native methods, so the entry points do not
+ *  have to.
+ *
+ *  @param pVm      [in] the VM
+ *  @param reserved [in] unused
+ *  @returns the JNI version needed, JNI_ERR if a lookup failed
+ */
+//-----------------------------------------------------------------------------
+JNIEXPORT jint JNICALL
+JNI_OnLoad(
+        JavaVM* pVm,
+        void* reserved
+        )
+{
+    JNIEnv* jenv = NULL;
+    jclass objClass;
+
+    if ((*pVm)->GetEnv(pVm, (void**)&jenv, JNI_VERSION_1_6) != JNI_OK)
+        return JNI_ERR;
+
+    objClass = (*jenv)->FindClass(
+            jenv,
+            "com/cypress/cy3240/Cy3240BridgeController"
+            );
+
+    if (objClass == NULL)
+        return JNI_ERR;
+
+    cache.pVm = pVm;
+    cache.controllerClass = (*jenv)->NewGlobalRef(jenv, objClass);
+    cache.handle = (*jenv)->GetFieldID(jenv, objClass, "handle", "J");
+    cache.complete = (*jenv)->GetMethodID(jenv, objClass, "complete", "(II)V");
+
+    (*jenv)->DeleteLocalRef(jenv, objClass);
+
+    if ((cache.controllerClass == NULL) ||
+        (cache.handle == NULL) ||
+        (cache.complete == NULL))
+        return JNI_ERR;
+
+    return JNI_VERSION_1_6;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Called by the VM when the library is unloaded
+ *
+ *  @param pVm      [in] the VM
+ *  @param reserved [in] unused
+ */
+//-----------------------------------------------------------------------------
+JNIEXPORT void JNICALL
+JNI_OnUnload(
+        JavaVM* pVm,
+        void* reserved
+        )
+{
+    JNIEnv* jenv = NULL;
+
+    if ((*pVm)->GetEnv(pVm, (void**)&jenv, JNI_VERSION_1_6) == JNI_OK)
+        (*jenv)->DeleteGlobalRef(jenv, cache.controllerClass);
+
+    memset(&cache, 0x00, sizeof(cache));
+}
+
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    create
@@ -46,61 +531,25 @@ Java_com_cypress_cy3240_Cy3240BridgeController_create(
     Cy3240_Error_t result = CY3240_ERROR_OK;
 
     // The device handle
-    jint handle = 0;
-    jfieldID handleId = NULL;
-
-    // Get the class for the object
-    jclass objClass = (*jenv)->GetObjectClass(
-            jenv,
-            jobj
-            );
-
-    if (objClass == NULL) {
-        result = CY3240_ERROR_JNI;
-        printf("Failed to find get Object class\n");
-    }
-
-    // Create the device
-    if CY3240_SUCCESS(result) {
-
-        // Get the field
-        handleId = (*jenv)->GetFieldID(
-                jenv,
-                objClass,
-                "handle",
-                "I"
-                );
-
-        // Check the handle
-        if (handleId == NULL) {
-            result = CY3240_ERROR_JNI;
-            printf("Failed to find \"handle\" field\n");
-        }
-    }
+    int handle = 0;
 
     // Create the device
-    if CY3240_SUCCESS(result) {
-
-        result = cy3240_factory(
-                (int*)&handle,
-                (uint8_t)iface,
-                (int)timeout,
-                (uint8_t)power,
-                (uint8_t)bus,
-                (uint8_t)clock
-                );
-
-        if CY3240_FAILURE(result)
-            printf("Failed to create device!\n");
-    }
+    result = cy3240_factory(
+            &handle,
+            (uint8_t)iface,
+            (int)timeout,
+            (uint8_t)power,
+            (uint8_t)bus,
+            (uint8_t)clock
+            );
 
     // Update the field of the device
     if CY3240_SUCCESS(result)
-        (*jenv)->SetIntField(
+        (*jenv)->SetLongField(
                 jenv,
                 jobj,
-                handleId,
-                handle
+                cache.handle,
+                (jlong)handle
                 );
 
     return result;
@@ -109,13 +558,13 @@ Java_com_cypress_cy3240_Cy3240BridgeController_create(
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    open
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_open(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
@@ -123,44 +572,38 @@ Java_com_cypress_cy3240_Cy3240BridgeController_open(
     // Open the device
     result = cy3240_open((int)handle);
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to open CY3240 Bridge Controller!\n");
-
     return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    close
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_close(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
 
     result = cy3240_close((int)handle);
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to close CY3240 Bridge Controller!\n");
-
     return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    write
- * Signature: (IB[B)I
+ * Signature: (JB[B)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_write(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
+        jlong handle,
         jbyte address,
         jbyteArray dataout
         )
@@ -192,30 +635,27 @@ Java_com_cypress_cy3240_Cy3240BridgeController_write(
             );
 
 
-    // Release the pointer to the data
+    // Release the pointer to the data, nothing to copy back
     (*jenv)->ReleaseByteArrayElements(
             jenv,
             dataout,
             pBytes,
-            0
+            JNI_ABORT
             );
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to write data to CY3240 Bridge Controller!\n");
-
-    return 0x00;
+    return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    read
- * Signature: (IB[B)I
+ * Signature: (JB[B)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_read(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
+        jlong handle,
         jbyte address,
         jbyteArray datain
         )
@@ -254,90 +694,789 @@ Java_com_cypress_cy3240_Cy3240BridgeController_read(
             0
             );
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to read data from CY3240 Bridge Controller!\n");
-
     return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
- * Method:    restart
- * Signature: (I)I
+ * Method:    writeDirect
+ * Signature: (JBLjava/nio/ByteBuffer;II)I
  */
 JNIEXPORT jint JNICALL
-Java_com_cypress_cy3240_Cy3240BridgeController_restart(
+Java_com_cypress_cy3240_Cy3240BridgeController_writeDirect(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
 
-    result = cy3240_restart((int)handle);
+    uint16_t count = 0;
+    jbyte* pBytes;
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to restart CY3240 Bridge Controller!\n");
+    // Only direct buffers have an address
+    pBytes = (*jenv)->GetDirectBufferAddress(
+            jenv,
+            buffer
+            );
+
+    if ((pBytes == NULL) ||
+        !check_window(
+            (*jenv)->GetDirectBufferCapacity(jenv, buffer),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    count = (uint16_t)length;
+
+    // Write straight from the buffer memory
+    result = cy3240_write(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes + offset,
+            &count
+            );
 
     return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
- * Method:    reconfigure
- * Signature: (IBBB)I
+ * Method:    readDirect
+ * Signature: (JBLjava/nio/ByteBuffer;II)I
  */
 JNIEXPORT jint JNICALL
-Java_com_cypress_cy3240_Cy3240BridgeController_reconfigure(
+Java_com_cypress_cy3240_Cy3240BridgeController_readDirect(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
-        jbyte power,
-        jbyte bus,
-        jbyte clock
+        jlong handle,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
 
-    printf("Starting reconfigure request\n");
+    uint16_t count = 0;
+    jbyte* pBytes;
 
-    result = cy3240_reconfigure(
-            (int)handle,
-            (uint8_t)power,
-            (uint8_t)bus,
-            (uint8_t)clock
+    // Only direct buffers have an address
+    pBytes = (*jenv)->GetDirectBufferAddress(
+            jenv,
+            buffer
             );
 
-    printf("Finished reconfigure request\n");
+    if ((pBytes == NULL) ||
+        !check_window(
+            (*jenv)->GetDirectBufferCapacity(jenv, buffer),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to read data from CY3240 Bridge Controller!\n");
+    count = (uint16_t)length;
 
-    return result;
+    // Read straight into the buffer memory
+    result = cy3240_read(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes + offset,
+            &count
+            );
 
+    return result;
 }
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
- * Method:    reinitialize
- * Signature: (I)I
+ * Method:    writeRegion
+ * Signature: (JB[BII)I
  */
 JNIEXPORT jint JNICALL
-Java_com_cypress_cy3240_Cy3240BridgeController_reinitialize(
+Java_com_cypress_cy3240_Cy3240BridgeController_writeRegion(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle,
+        jbyte address,
+        jbyteArray dataout,
+        jint offset,
+        jint length
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
 
-    result = cy3240_reinit((int)handle);
+    uint16_t count = 0;
+    jbyte stage[REGION_STAGE];
+    jbyte* pBytes = stage;
 
-    if (CY3240_FAILURE(result))
-        printf("Failed to read data from CY3240 Bridge Controller!\n");
+    if (!check_window(
+            (*jenv)->GetArrayLength(jenv, dataout),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    if ((length > REGION_STAGE) &&
+        ((pBytes = (jbyte*)malloc(length)) == NULL))
+        return CY3240_ERROR_UNKNOWN;
+
+    count = (uint16_t)length;
+
+    // Copy the data out, the array is not held during the transfer
+    (*jenv)->GetByteArrayRegion(
+            jenv,
+            dataout,
+            offset,
+            length,
+            pBytes
+            );
+
+    // Write the data to the device
+    result = cy3240_write(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes,
+            &count
+            );
+
+    if (pBytes != stage)
+        free(pBytes);
 
     return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    readRegion
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_readRegion(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray datain,
+        jint offset,
+        jint length
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    uint16_t count = 0;
+    jbyte stage[REGION_STAGE];
+    jbyte* pBytes = stage;
+
+    if (!check_window(
+            (*jenv)->GetArrayLength(jenv, datain),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
 
+    if ((length > REGION_STAGE) &&
+        ((pBytes = (jbyte*)malloc(length)) == NULL))
+        return CY3240_ERROR_UNKNOWN;
+
+    count = (uint16_t)length;
+
+    // Read the data from the device
+    result = cy3240_read(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes,
+            &count
+            );
+
+    // Copy the data in once the transfer is done
+    if CY3240_SUCCESS(result)
+        (*jenv)->SetByteArrayRegion(
+                jenv,
+                datain,
+                offset,
+                length,
+                pBytes
+                );
+
+    if (pBytes != stage)
+        free(pBytes);
+
+    return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    writeCritical
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_writeCritical(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray dataout,
+        jint offset,
+        jint length
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    uint16_t count = 0;
+    jbyte* pBytes;
+
+    // The garbage collector is held off while the array is pinned
+    if ((length > CRITICAL_MAX) ||
+        !check_window(
+            (*jenv)->GetArrayLength(jenv, dataout),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    count = (uint16_t)length;
+
+    // Pin the array, no JNI calls are allowed until it is released
+    pBytes = (*jenv)->GetPrimitiveArrayCritical(
+            jenv,
+            dataout,
+            NULL
+            );
+
+    if (pBytes == NULL)
+        return CY3240_ERROR_JNI;
+
+    // Write the data to the device
+    result = cy3240_write(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes + offset,
+            &count
+            );
+
+    // Unpin the array, nothing to copy back
+    (*jenv)->ReleasePrimitiveArrayCritical(
+            jenv,
+            dataout,
+            pBytes,
+            JNI_ABORT
+            );
+
+    return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    readCritical
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_readCritical(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray datain,
+        jint offset,
+        jint length
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    uint16_t count = 0;
+    jbyte* pBytes;
+
+    // The garbage collector is held off while the array is pinned
+    if ((length > CRITICAL_MAX) ||
+        !check_window(
+            (*jenv)->GetArrayLength(jenv, datain),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    count = (uint16_t)length;
+
+    // Pin the array, no JNI calls are allowed until it is released
+    pBytes = (*jenv)->GetPrimitiveArrayCritical(
+            jenv,
+            datain,
+            NULL
+            );
+
+    if (pBytes == NULL)
+        return CY3240_ERROR_JNI;
+
+    // Read the data from the device
+    result = cy3240_read(
+            (int)handle,
+            (uint8_t)address,
+            (uint8_t*)pBytes + offset,
+            &count
+            );
+
+    // Unpin the array, copying back if the VM made a copy
+    (*jenv)->ReleasePrimitiveArrayCritical(
+            jenv,
+            datain,
+            pBytes,
+            0
+            );
+
+    return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    eepromWrite
+ * Signature: (JBIIIILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_eepromWrite(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jint addressWidth,
+        jint pageSize,
+        jint size,
+        jint offset,
+        jobject buffer,
+        jint position,
+        jint length
+        )
+{
+    Cy3240_Eeprom_t eeprom;
+    uint8_t* pBytes;
+    jlong capacity;
+
+    // Only direct buffers have an address
+    pBytes = (*jenv)->GetDirectBufferAddress(
+            jenv,
+            buffer
+            );
+    capacity = (*jenv)->GetDirectBufferCapacity(
+            jenv,
+            buffer
+            );
+
+    if ((pBytes == NULL) ||
+        (offset < 0) ||
+        (position < 0) ||
+        (length <= 0) ||
+        ((jlong)position + length > capacity))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    memset(&eeprom, 0x00, sizeof(eeprom));
+    eeprom.address = (uint8_t)address;
+    eeprom.address_width = (uint8_t)addressWidth;
+    eeprom.page_size = (uint16_t)pageSize;
+    eeprom.size = (uint32_t)size;
+
+    // The library splits the transfer in to pages and packets
+    return cy3240_eeprom_write(
+            (int)handle,
+            &eeprom,
+            (uint32_t)offset,
+            pBytes + position,
+            (uint32_t)length);
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    eepromRead
+ * Signature: (JBIIIILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_eepromRead(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jint addressWidth,
+        jint pageSize,
+        jint size,
+        jint offset,
+        jobject buffer,
+        jint position,
+        jint length
+        )
+{
+    Cy3240_Eeprom_t eeprom;
+    uint8_t* pBytes;
+    jlong capacity;
+
+    // Only direct buffers have an address
+    pBytes = (*jenv)->GetDirectBufferAddress(
+            jenv,
+            buffer
+            );
+    capacity = (*jenv)->GetDirectBufferCapacity(
+            jenv,
+            buffer
+            );
+
+    if ((pBytes == NULL) ||
+        (offset < 0) ||
+        (position < 0) ||
+        (length <= 0) ||
+        ((jlong)position + length > capacity))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    memset(&eeprom, 0x00, sizeof(eeprom));
+    eeprom.address = (uint8_t)address;
+    eeprom.address_width = (uint8_t)addressWidth;
+    eeprom.page_size = (uint16_t)pageSize;
+    eeprom.size = (uint32_t)size;
+
+    // The library splits the transfer in to pages and packets
+    return cy3240_eeprom_read(
+            (int)handle,
+            &eeprom,
+            (uint32_t)offset,
+            pBytes + position,
+            (uint32_t)length);
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    transaction
+ * Signature: (JLjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_transaction(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jobject ops,
+        jint length,
+        jint count,
+        jobject results
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = run_transaction(
+            (int)handle,
+            (*jenv)->GetDirectBufferAddress(jenv, ops),
+            (*jenv)->GetDirectBufferCapacity(jenv, ops),
+            length,
+            count,
+            (*jenv)->GetDirectBufferAddress(jenv, results),
+            (*jenv)->GetDirectBufferCapacity(jenv, results)
+            );
+
+    return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncStart
+ * Signature: (JI)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncStart(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jint slots
+        )
+{
+    Async_t* pAsync;
+
+    if (slots <= 0)
+        return 0;
+
+    pAsync = calloc(1, sizeof(Async_t));
+
+    if (pAsync == NULL)
+        return 0;
+
+    pAsync->handle = (int)handle;
+    pAsync->slots = slots;
+    pAsync->pQueue = calloc(slots, sizeof(int));
+    pAsync->pRequests = calloc(slots, sizeof(Async_Request_t));
+    pthread_mutex_init(&pAsync->lock, NULL);
+    pthread_cond_init(&pAsync->ready, NULL);
+
+    if ((pAsync->pQueue != NULL) &&
+        (pAsync->pRequests != NULL))
+        pAsync->controller = (*jenv)->NewGlobalRef(jenv, jobj);
+
+    if (pAsync->controller != NULL) {
+
+        pAsync->running = true;
+        pAsync->attached = CY3240_ERROR_UNKNOWN;
+
+        if (pthread_create(&pAsync->thread, NULL, async_thread, pAsync) == 0) {
+
+            // Wait until the thread is attached to the VM
+            pthread_mutex_lock(&pAsync->lock);
+
+            while (pAsync->attached == CY3240_ERROR_UNKNOWN)
+                pthread_cond_wait(&pAsync->ready, &pAsync->lock);
+
+            pthread_mutex_unlock(&pAsync->lock);
+
+            if CY3240_SUCCESS(pAsync->attached)
+                return (jlong)(intptr_t)pAsync;
+
+            pthread_join(pAsync->thread, NULL);
+        }
+    }
+
+    if (pAsync->controller != NULL)
+        (*jenv)->DeleteGlobalRef(jenv, pAsync->controller);
+
+    async_free(pAsync);
+
+    return 0;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncSubmit
+ * Signature: (JIIBLjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncSubmit(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context,
+        jint slot,
+        jint type,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
+        )
+{
+    Async_t* pAsync = (Async_t*)(intptr_t)context;
+    Async_Request_t request;
+    uint8_t* pBytes;
+
+    memset(&request, 0x00, sizeof(request));
+
+    // Only direct buffers stay put until the request has run
+    pBytes = (*jenv)->GetDirectBufferAddress(
+            jenv,
+            buffer
+            );
+
+    if ((pBytes == NULL) ||
+        ((type != ASYNC_WRITE) && (type != ASYNC_READ)) ||
+        !check_window(
+            (*jenv)->GetDirectBufferCapacity(jenv, buffer),
+            offset,
+            length))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    request.type = type;
+    request.address = (uint8_t)address;
+    request.pData = pBytes + offset;
+    request.length = length;
+
+    return async_queue(
+            pAsync,
+            slot,
+            &request);
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncSubmitTransaction
+ * Signature: (JILjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncSubmitTransaction(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context,
+        jint slot,
+        jobject ops,
+        jint length,
+        jint count,
+        jobject results
+        )
+{
+    Async_t* pAsync = (Async_t*)(intptr_t)context;
+    Async_Request_t request;
+
+    memset(&request, 0x00, sizeof(request));
+
+    request.type = ASYNC_TRANSACTION;
+    request.pData = (*jenv)->GetDirectBufferAddress(jenv, ops);
+    request.capacity = (*jenv)->GetDirectBufferCapacity(jenv, ops);
+    request.length = length;
+    request.count = count;
+    request.pResults = (*jenv)->GetDirectBufferAddress(jenv, results);
+    request.resultsCapacity = (*jenv)->GetDirectBufferCapacity(jenv, results);
+
+    if ((request.pData == NULL) ||
+        (request.pResults == NULL))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    return async_queue(
+            pAsync,
+            slot,
+            &request);
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncStop
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncStop(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context
+        )
+{
+    Async_t* pAsync = (Async_t*)(intptr_t)context;
+
+    if (pAsync == NULL)
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    // The thread runs what is queued before it exits
+    pthread_mutex_lock(&pAsync->lock);
+    pAsync->running = false;
+    pthread_cond_signal(&pAsync->ready);
+    pthread_mutex_unlock(&pAsync->lock);
+
+    pthread_join(pAsync->thread, NULL);
+
+    (*jenv)->DeleteGlobalRef(jenv, pAsync->controller);
+    async_free(pAsync);
+
+    return CY3240_ERROR_OK;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    restart
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_restart(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = cy3240_restart((int)handle);
+
+    return result;
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    reconfigure
+ * Signature: (JBBB)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_reconfigure(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte power,
+        jbyte bus,
+        jbyte clock
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = cy3240_reconfigure(
+            (int)handle,
+            (uint8_t)power,
+            (uint8_t)bus,
+            (uint8_t)clock
+            );
+
+    return result;
+
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    reinitialize
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_reinitialize(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = cy3240_reinit((int)handle);
+
+    return result;
+
+}
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    stats
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_stats(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jlongArray values
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Stats_t stats;
+    jlong flat[STATS_COUNT];
+    int x;
+
+    if ((values == NULL) ||
+        ((*jenv)->GetArrayLength(jenv, values) < STATS_COUNT))
+        return CY3240_ERROR_INVALID_PARAMETERS;
+
+    result = cy3240_get_stats(
+            (int)handle,
+            &stats
+            );
+
+    if CY3240_SUCCESS(result) {
+
+        flat[STATS_WRITES] = (jlong)stats.traffic.writes;
+        flat[STATS_READS] = (jlong)stats.traffic.reads;
+        flat[STATS_WRITE_BYTES] = (jlong)stats.traffic.write_bytes;
+        flat[STATS_READ_BYTES] = (jlong)stats.traffic.read_bytes;
+        flat[STATS_ERRORS] = (jlong)stats.traffic.errors;
+        flat[STATS_SAMPLES] = (jlong)stats.latency.samples;
+        flat[STATS_TIMEOUTS] = (jlong)stats.latency.timeouts;
+        flat[STATS_LATENCY_US] = (jlong)stats.latency.latency_us;
+        flat[STATS_DEVIATION_US] = (jlong)stats.latency.deviation_us;
+        flat[STATS_ADDRESS_NAKS] = (jlong)stats.retry.naks[CY3240_NAK_ADDRESS];
+        flat[STATS_DATA_NAKS] = (jlong)stats.retry.naks[CY3240_NAK_DATA];
+        flat[STATS_RETRIES] = (jlong)stats.retry.retries;
+        flat[STATS_EXHAUSTED] = (jlong)stats.retry.exhausted;
+
+        for (x = 0; x < CY3240_LATENCY_BUCKETS; x++)
+            flat[STATS_HISTOGRAM + x] = (jlong)stats.traffic.histogram[x];
+
+        // One copy in to the Java array
+        (*jenv)->SetLongArrayRegion(
+                jenv,
+                values,
+                0,
+                STATS_COUNT,
+                flat
+                );
+    }
+
+    return result;
 }
 
 //@} End of Methods
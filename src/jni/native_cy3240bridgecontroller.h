@@ -28,37 +28,37 @@ Java_com_cypress_cy3240_Cy3240BridgeController_create(
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    open
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_open(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
         );
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    close
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_close(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
         );
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    write
- * Signature: (IB[B)I
+ * Signature: (JB[B)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_write(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
+        jlong handle,
         jbyte address,
         jbyteArray dataout
         );
@@ -66,39 +66,251 @@ Java_com_cypress_cy3240_Cy3240BridgeController_write(
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    read
- * Signature: (IB[B)I
+ * Signature: (JB[B)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_read(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
+        jlong handle,
         jbyte address,
         jbyteArray datain
         );
 
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    writeDirect
+ * Signature: (JBLjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_writeDirect(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    readDirect
+ * Signature: (JBLjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_readDirect(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    writeRegion
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_writeRegion(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray dataout,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    readRegion
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_readRegion(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray datain,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    writeCritical
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_writeCritical(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray dataout,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    readCritical
+ * Signature: (JB[BII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_readCritical(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jbyteArray datain,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    eepromWrite
+ * Signature: (JBIIIILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_eepromWrite(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jint addressWidth,
+        jint pageSize,
+        jint size,
+        jint offset,
+        jobject buffer,
+        jint position,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    eepromRead
+ * Signature: (JBIIIILjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_eepromRead(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jbyte address,
+        jint addressWidth,
+        jint pageSize,
+        jint size,
+        jint offset,
+        jobject buffer,
+        jint position,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    transaction
+ * Signature: (JLjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_transaction(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jobject ops,
+        jint length,
+        jint count,
+        jobject results
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncStart
+ * Signature: (JI)J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncStart(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jint slots
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncSubmit
+ * Signature: (JIIBLjava/nio/ByteBuffer;II)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncSubmit(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context,
+        jint slot,
+        jint type,
+        jbyte address,
+        jobject buffer,
+        jint offset,
+        jint length
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncSubmitTransaction
+ * Signature: (JILjava/nio/ByteBuffer;IILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncSubmitTransaction(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context,
+        jint slot,
+        jobject ops,
+        jint length,
+        jint count,
+        jobject results
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    asyncStop
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_asyncStop(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong context
+        );
+
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    restart
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_restart(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
         );
 
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    reconfigure
- * Signature: (IBBB)I
+ * Signature: (JBBB)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_reconfigure(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle,
+        jlong handle,
         jbyte power,
         jbyte bus,
         jbyte clock
@@ -107,13 +319,26 @@ Java_com_cypress_cy3240_Cy3240BridgeController_reconfigure(
 /*
  * Class:     com_cypress_cy3240_Cy3240BridgeController
  * Method:    reinitialize
- * Signature: (I)I
+ * Signature: (J)I
  */
 JNIEXPORT jint JNICALL
 Java_com_cypress_cy3240_Cy3240BridgeController_reinitialize(
         JNIEnv *jenv,
         jobject jobj,
-        jint handle
+        jlong handle
+        );
+
+/*
+ * Class:     com_cypress_cy3240_Cy3240BridgeController
+ * Method:    stats
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_cypress_cy3240_Cy3240BridgeController_stats(
+        JNIEnv *jenv,
+        jobject jobj,
+        jlong handle,
+        jlongArray values
         );
 
 #ifdef __cplusplus
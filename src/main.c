@@ -1,9 +1,24 @@
 /**
  * @file main.c
  *
- * @brief Main Entry point for the CY3240 i2c test
+ * @brief Command line tool for the CY3240 bridge
  *
- * Main Entry point for the CY3240 i2c test
+ * Command line tool for the CY3240 bridge, with commands in the style of
+ * the Linux i2c-tools and a batch mode that runs .iic scripts:
+ *
+ * @code
+ * $ cy3240_i2c get 0x50 0x00 4          ; read 4 bytes from register 0
+ * $ cy3240_i2c set 0x50 0x10 0xAA 0x55  ; write two bytes to register 0x10
+ * $ cy3240_i2c dump 0x50                ; print registers 0x00 to 0xFF
+ * $ cy3240_i2c transfer w1@0x50 0x00 r8@0x50
+ * $ cy3240_i2c batch ops.iic 100        ; run a script 100 times
+ * $ generate_ops | cy3240_i2c batch -
+ * @endcode
+ *
+ * A batch script is compiled once and every run is sent as pipelined
+ * transfers, so thousands of operations cost one process and one open of
+ * the bridge. The result of every script line is printed to stdout and
+ * the timing and throughput summary to stderr.
  *
  * @ingroup CY3240
  *
@@ -15,14 +30,18 @@
 //@{
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <unistd.h> /* for getopt() */
-#include <time.h>
+#include <sys/param.h>
 #include <hid.h>
 #include "cy3240.h"
+#include "cy3240_types.h"
+#include "cy3240_packet.h"
+#include "cy3240_script.h"
 #include "cy3240_util.h"
-#include "i2c_demo.h"
 
 //@} End of Includes
 
@@ -30,11 +49,43 @@
 /// @name Defines
 //@{
 
-#define SLEEP_BETWEEN_CMD   (250000)
-#define BLINK_DELAY         (500000)
+#define DEFAULT_TIMEOUT     (1000)   ///< Bridge timeout in milliseconds
+#define MAX_VALUES          (256)    ///< Most bytes written by the set command
+#define MAX_MESSAGES        (256)    ///< Most messages of the transfer command
+#define DUMP_ROW            (16)     ///< Registers per line of a dump
+#define DUMP_ROWS           (16)     ///< Lines of a full dump
+#define READ_CHUNK          (4096)   ///< Bytes read from a batch file at once
+
+#define EXIT_FAILED         (1)      ///< A bus operation failed
+#define EXIT_USAGE          (2)      ///< The command line is wrong
 
 //@} End of Defines
 
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * Command line options
+ */
+typedef struct {
+    int iface;                                 ///< USB interface number
+    int timeout;                               ///< Bridge timeout in milliseconds
+    const char* pSerial;                       ///< Serial number of the bridge, NULL for any
+    Cy3240_Power_t power;                      ///< Power supplied to the target
+    Cy3240_I2C_ClockSpeed_t clock;             ///< I2C clock
+} Options_t;
+
+/**
+ * A command of the tool
+ */
+typedef struct {
+    const char* pName;                         ///< Name on the command line
+    const char* pUsage;                        ///< Arguments
+    int (*run)(int handle, int argc, char* argv[]); ///< Runs the command, returns the exit status
+} Command_t;
+
+//@} End of Types
 
 //////////////////////////////////////////////////////////////////////
 /// @name Private Methods
@@ -42,209 +93,826 @@
 
 //-----------------------------------------------------------------------------
 /**
- *  Method to parse the command line arguments
- *  Currently, we only accept the "-i" flag to select the interface (default 0).
- *  The syntax is one of the following:
+ *  Method to parse a number in decimal, or in hexadecimal with 0x
  *
- *  $ test_libhid
- *  $ test_libhid -i 1
+ *  @param pText  [in] the text
+ *  @param max    [in] the largest value allowed
+ *  @param pValue [out] the value
+ *  @returns true if the text is a number no larger than max
+ */
+//-----------------------------------------------------------------------------
+static bool
+parse_number(
+        const char* pText,
+        unsigned long max,
+        unsigned long* const pValue
+        )
+{
+    char* pEnd = NULL;
+
+    if ((pText == NULL) || (*pText == '\0') || (*pText == '-'))
+        return false;
+
+    *pValue = strtoul(pText, &pEnd, 0);
+
+    if ((*pEnd != '\0') || (*pValue > max)) {
+        fprintf(stderr, "Invalid number: %s\n", pText);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to parse a 7 bit slave address
  *
- *  @param argc       [in]  The number of arguments
- *  @param argv       [in]  The command line arguments
+ *  @param pText    [in] the text
+ *  @param pAddress [out] the address
+ *  @returns true if the text is a valid address
  */
 //-----------------------------------------------------------------------------
-static void
-parse_arguments(
+static bool
+parse_address(
+        const char* pText,
+        uint8_t* const pAddress
+        )
+{
+    unsigned long value;
+
+    if (!parse_number(pText, 0x7F, &value))
+        return false;
+
+    *pAddress = (uint8_t)value;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to parse the command line options in front of the command
+ *
+ *  @param argc     [in] The number of arguments
+ *  @param argv     [in] The command line arguments
+ *  @param pOptions [out] the options
+ *  @returns true if the options are valid
+ */
+//-----------------------------------------------------------------------------
+static bool
+parse_options(
         int argc,
         char *argv[],
-        int *iface_num
+        Options_t* const pOptions
         )
 {
-    char *vendor;
-    char *product;
+    unsigned long value;
     int flag;
 
-    // Iterate through all of the command line arguments
-    while((flag = getopt(argc, argv, "i:")) != -1) {
+    pOptions->iface = 0;
+    pOptions->timeout = DEFAULT_TIMEOUT;
+    pOptions->pSerial = NULL;
+    pOptions->power = CY3240_POWER_5V;
+    pOptions->clock = CY3240_CLOCK__100kHz;
+
+    // Stop at the command, its arguments may look like options
+    while ((flag = getopt(argc, argv, "+i:s:p:c:t:h")) != -1) {
 
-        // Check the current argument
         switch (flag) {
 
             // The usb interface
             case 'i':
-                iface_num = atoi(optarg);
+                if (!parse_number(optarg, 255, &value))
+                    return false;
+                pOptions->iface = (int)value;
+                break;
+
+            // The bridge serial number
+            case 's':
+                pOptions->pSerial = optarg;
+                break;
+
+            // The target power
+            case 'p':
+                if (!strcmp(optarg, "5"))
+                    pOptions->power = CY3240_POWER_5V;
+                else if (!strcmp(optarg, "3.3"))
+                    pOptions->power = CY3240_POWER_3_3V;
+                else if (!strcmp(optarg, "ext"))
+                    pOptions->power = CY3240_POWER_EXTERNAL;
+                else
+                    return false;
+                break;
+
+            // The I2C clock in kHz
+            case 'c':
+                if (!strcmp(optarg, "50"))
+                    pOptions->clock = CY3240_CLOCK__50kHz;
+                else if (!strcmp(optarg, "100"))
+                    pOptions->clock = CY3240_CLOCK__100kHz;
+                else if (!strcmp(optarg, "400"))
+                    pOptions->clock = CY3240_CLOCK__400kHz;
+                else
+                    return false;
+                break;
+
+            // The bridge timeout
+            case 't':
+                if (!parse_number(optarg, 60000, &value) || (value == 0))
+                    return false;
+                pOptions->timeout = (int)value;
                 break;
+
+            default:
+                return false;
         }
     }
 
-}   /* -----  end of static function parse_arguments  ----- */
-
+    return optind < argc;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Method print out the specified buffer
+ *  Method to print bytes on one line, as i2ctransfer does
  *
- *  @param buffer [in] the data buffer to print
- *  @praam length [in] the length of the buffer
+ *  @param pData  [in] the data
+ *  @param length [in] the number of bytes
  */
 //-----------------------------------------------------------------------------
-void
-print_buffer(
-        const uint8_t* const buffer,
+static void
+print_data(
+        const uint8_t* const pData,
         uint16_t length
         )
 {
-    int count;
+    uint16_t x;
+
+    for (x = 0; x < length; x++)
+        printf("%s0x%02x", x ? " " : "", pData[x]);
+
+    printf("\n");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read registers, as i2cget does
+ *
+ *  get ADDR [REG [COUNT]]
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param argc   [in] the number of command arguments
+ *  @param argv   [in] the command arguments
+ *  @returns the exit status
+ */
+//-----------------------------------------------------------------------------
+static int
+command_get(
+        int handle,
+        int argc,
+        char* argv[]
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Op_t ops[2];
+    uint8_t reg = 0;
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    unsigned long value;
+    unsigned long count = 1;
+    uint16_t x = 0;
+    uint8_t address;
+
+    if ((argc < 1) || (argc > 3) ||
+        !parse_address(argv[0], &address))
+        return EXIT_USAGE;
+
+    if ((argc > 2) &&
+        (!parse_number(argv[2], CY3240_MAX_READ_BYTES, &count) || (count == 0)))
+        return EXIT_USAGE;
+
+    memset(ops, 0x00, sizeof(ops));
+
+    // Select the register, then read from it
+    if (argc > 1) {
+
+        if (!parse_number(argv[1], 0xFF, &value))
+            return EXIT_USAGE;
+
+        reg = (uint8_t)value;
+        ops[x].type = CY3240_OP_WRITE;
+        ops[x].address = address;
+        ops[x].pData = &reg;
+        ops[x].length = 1;
+        x++;
+    }
+
+    ops[x].type = CY3240_OP_READ;
+    ops[x].address = address;
+    ops[x].pData = data;
+    ops[x].length = (uint16_t)count;
+    x++;
+
+    result = cy3240_transfer(handle, ops, x);
+
+    if CY3240_SUCCESS(result)
+        result = ops[0].result;
+
+    if CY3240_SUCCESS(result)
+        result = ops[x - 1].result;
+
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Read from 0x%02x failed: %d\n", address, result);
+        return EXIT_FAILED;
+    }
+
+    print_data(data, ops[x - 1].length);
+
+    return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to write registers, as i2cset does
+ *
+ *  set ADDR REG VALUE...
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param argc   [in] the number of command arguments
+ *  @param argv   [in] the command arguments
+ *  @returns the exit status
+ */
+//-----------------------------------------------------------------------------
+static int
+command_set(
+        int handle,
+        int argc,
+        char* argv[]
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint8_t data[1 + MAX_VALUES];
+    unsigned long value;
+    uint16_t length;
+    uint8_t address;
+    int x;
+
+    if ((argc < 3) || (argc > 2 + MAX_VALUES) ||
+        !parse_address(argv[0], &address))
+        return EXIT_USAGE;
+
+    // The register followed by the values
+    for (x = 1; x < argc; x++) {
 
-    printf("\nBuffer: (Length=%i)", length);
+        if (!parse_number(argv[x], 0xFF, &value))
+            return EXIT_USAGE;
 
-    for (count = 0; count < length; count ++) {
+        data[x - 1] = (uint8_t)value;
+    }
+
+    length = (uint16_t)(argc - 1);
+
+    result = cy3240_write(handle, address, data, &length);
+
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Write to 0x%02x failed: %d\n", address, result);
+        return EXIT_FAILED;
+    }
+
+    return EXIT_SUCCESS;
+}
 
-        if(count % 16 == 0) {
-            printf("\n0%d: ", (int)(count / 16));
+//-----------------------------------------------------------------------------
+/**
+ *  Method to print a range of registers, as i2cdump does. Every line is
+ *  a register select and a read, all lines go out as one transfer.
+ *
+ *  dump ADDR [FIRST [LAST]]
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param argc   [in] the number of command arguments
+ *  @param argv   [in] the command arguments
+ *  @returns the exit status
+ */
+//-----------------------------------------------------------------------------
+static int
+command_dump(
+        int handle,
+        int argc,
+        char* argv[]
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Op_t ops[2 * DUMP_ROWS];
+    uint8_t regs[DUMP_ROWS];
+    uint8_t data[DUMP_ROWS][DUMP_ROW];
+    unsigned long first = 0x00;
+    unsigned long last = 0xFF;
+    uint16_t count = 0;
+    uint8_t address;
+    int failed = 0;
+    int row;
+    int x;
+
+    if ((argc < 1) || (argc > 3) ||
+        !parse_address(argv[0], &address))
+        return EXIT_USAGE;
+
+    if (((argc > 1) && !parse_number(argv[1], 0xFF, &first)) ||
+        ((argc > 2) && !parse_number(argv[2], 0xFF, &last)) ||
+        (first > last))
+        return EXIT_USAGE;
+
+    memset(ops, 0x00, sizeof(ops));
+
+    for (row = (int)first / DUMP_ROW; row <= (int)last / DUMP_ROW; row++) {
+
+        int start = MAX(row * DUMP_ROW, (int)first);
+        int end = MIN(row * DUMP_ROW + DUMP_ROW - 1, (int)last);
+
+        regs[row] = (uint8_t)start;
+
+        ops[count].type = CY3240_OP_WRITE;
+        ops[count].address = address;
+        ops[count].pData = &regs[row];
+        ops[count].length = 1;
+        count++;
+
+        ops[count].type = CY3240_OP_READ;
+        ops[count].address = address;
+        ops[count].pData = &data[row][start % DUMP_ROW];
+        ops[count].length = (uint16_t)(end - start + 1);
+        count++;
+    }
+
+    result = cy3240_transfer(handle, ops, count);
+
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Dump of 0x%02x failed: %d\n", address, result);
+        return EXIT_FAILED;
+    }
+
+    printf("     0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f    0123456789abcdef\n");
+
+    for (row = (int)first / DUMP_ROW, count = 0; row <= (int)last / DUMP_ROW; row++, count += 2) {
+
+        const bool ok = CY3240_SUCCESS(ops[count].result) && CY3240_SUCCESS(ops[count + 1].result);
+
+        failed += ok ? 0 : 1;
+        printf("%02x: ", row * DUMP_ROW);
+
+        for (x = 0; x < DUMP_ROW; x++) {
+
+            const int reg = row * DUMP_ROW + x;
+
+            if ((reg < (int)first) || (reg > (int)last))
+                printf("   ");
+            else if (!ok)
+                printf("XX ");
+            else
+                printf("%02x ", data[row][x]);
         }
 
-        if(count % 4 == 0) {
-            printf(" %02x",buffer[count]);
+        printf("   ");
+
+        for (x = 0; x < DUMP_ROW; x++) {
+
+            const int reg = row * DUMP_ROW + x;
+            const uint8_t byte = data[row][x];
+
+            if ((reg < (int)first) || (reg > (int)last))
+                printf(" ");
+            else if (!ok)
+                printf("X");
+            else
+                printf("%c", ((byte >= 0x20) && (byte < 0x7F)) ? byte : '.');
+        }
+
+        printf("\n");
+    }
+
+    return failed ? EXIT_FAILED : EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to run a list of messages in one transfer, as i2ctransfer does.
+ *  A message is {r|w}LENGTH@ADDR, a write is followed by its data bytes.
+ *  The data of every read is printed on a line of its own.
+ *
+ *  transfer MSG...
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param argc   [in] the number of command arguments
+ *  @param argv   [in] the command arguments
+ *  @returns the exit status
+ */
+//-----------------------------------------------------------------------------
+static int
+command_transfer(
+        int handle,
+        int argc,
+        char* argv[]
+        )
+{
+    static Cy3240_Op_t ops[MAX_MESSAGES];
+    static uint8_t data[MAX_MESSAGES][CY3240_MAX_READ_BYTES];
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t count = 0;
+    int failed = 0;
+    int arg = 0;
+    int x;
+
+    if (argc < 1)
+        return EXIT_USAGE;
+
+    memset(ops, 0x00, sizeof(ops));
+
+    while (arg < argc) {
+
+        Cy3240_Op_t* const pOp = &ops[count];
+        unsigned long length;
+        unsigned long value;
+        char direction;
+        char* pAt;
+
+        if (count == MAX_MESSAGES) {
+            fprintf(stderr, "More than %d messages\n", MAX_MESSAGES);
+            return EXIT_USAGE;
+        }
+
+        direction = argv[arg][0];
+        pAt = strchr(argv[arg], '@');
+
+        if (((direction != 'r') && (direction != 'w')) || (pAt == NULL)) {
+            fprintf(stderr, "Invalid message: %s\n", argv[arg]);
+            return EXIT_USAGE;
+        }
+
+        *pAt = '\0';
+
+        if (!parse_number(&argv[arg][1], CY3240_MAX_READ_BYTES, &length) ||
+            !parse_address(pAt + 1, &pOp->address))
+            return EXIT_USAGE;
+
+        pOp->pData = data[count];
+        pOp->length = (uint16_t)length;
+        arg++;
+
+        // A write without data is an address probe
+        if (direction == 'r') {
+            pOp->type = CY3240_OP_READ;
+
+            if (length == 0)
+                return EXIT_USAGE;
 
         } else {
-            printf("%02x",buffer[count]);
+            pOp->type = (length != 0) ? CY3240_OP_WRITE : CY3240_OP_PROBE;
+
+            for (x = 0; x < (int)length; x++, arg++) {
+
+                if ((arg == argc) || !parse_number(argv[arg], 0xFF, &value))
+                    return EXIT_USAGE;
+
+                data[count][x] = (uint8_t)value;
+            }
         }
+
+        count++;
     }
 
-    printf("\n");
+    result = cy3240_transfer(handle, ops, count);
+
+    for (x = 0; x < count; x++) {
+
+        if CY3240_FAILURE(ops[x].result) {
+            fprintf(stderr, "Message %d to 0x%02x failed: %d\n", x, ops[x].address, ops[x].result);
+            failed++;
+
+        } else if (ops[x].type == CY3240_OP_READ) {
+            print_data(ops[x].pData, ops[x].length);
+        }
+    }
+
+    return (failed || CY3240_FAILURE(result)) ? EXIT_FAILED : EXIT_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read a whole file in to a string
+ *
+ *  @param pFile [in] the file
+ *  @returns the text to free(), NULL if out of memory
+ */
+//-----------------------------------------------------------------------------
+static char*
+read_text(
+        FILE* pFile
+        )
+{
+    char* pText = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    size_t bytes;
 
-//@} End of Private Methods
+    do {
+        if (capacity - length < READ_CHUNK + 1) {
 
+            char* pLarger = (char*)realloc(pText, capacity + READ_CHUNK + 1);
 
-//////////////////////////////////////////////////////////////////////
-/// @name Methods
-//@{
+            if (pLarger == NULL) {
+                free(pText);
+                return NULL;
+            }
+
+            pText = pLarger;
+            capacity += READ_CHUNK + 1;
+        }
+
+        bytes = fread(&pText[length], 1, READ_CHUNK, pFile);
+        length += bytes;
+
+    } while (bytes != 0);
+
+    pText[length] = '\0';
+
+    return pText;
+}
 
 //-----------------------------------------------------------------------------
 /**
- *  Main entry point
+ *  Method to run an .iic script, see cy3240_script.h. Every bus command
+ *  prints one line:
  *
- *  @param argc [in] The number of arguments
- *  @param argv [in] The command line arguments
- *  @returns The result
+ *  LINE OP RESULT AVERAGE_US MAX_US [DATA...]
+ *
+ *  OP counts the commands of the line from 1. RESULT is ok, skipped when
+ *  a failure stopped the last run before the line, or the Cy3240_Error_t
+ *  of the command in the last run. AVERAGE_US and MAX_US time the whole
+ *  line, DATA are the bytes a read got in the last run.
+ *
+ *  batch FILE|- [RUNS]
+ *
+ *  @param handle [in] the handle to the bridge controller
+ *  @param argc   [in] the number of command arguments
+ *  @param argv   [in] the command arguments
+ *  @returns the exit status
  */
 //-----------------------------------------------------------------------------
-int
-main(
+static int
+command_batch(
+        int handle,
         int argc,
-        char *argv[]
+        char* argv[]
         )
 {
-    int iface_num = 0;
-    int retry;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+    Cy3240_Stats_t before;
+    Cy3240_Stats_t after;
+    FILE* pFile = stdin;
+    unsigned long runs = 1;
+    unsigned long run;
+    uint64_t ops;
+    uint64_t bytes;
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t steps = 0;
+    uint32_t x;
+    uint16_t y;
+    char* pText;
+    int errorLine = 0;
+
+    if ((argc < 1) || (argc > 2) ||
+        ((argc > 1) && (!parse_number(argv[1], 0xFFFFFFFF, &runs) || (runs == 0))))
+        return EXIT_USAGE;
+
+    if (strcmp(argv[0], "-") && ((pFile = fopen(argv[0], "r")) == NULL)) {
+        fprintf(stderr, "Failed to open %s\n", argv[0]);
+        return EXIT_USAGE;
+    }
 
-    hid_return ret;
-    int handle = 0;
+    pText = read_text(pFile);
 
-    uint8_t data[8] = {0};
-    uint16_t length = 0;
+    if (pFile != stdin)
+        fclose(pFile);
 
-    // Parse the command line arguments
-    parse_arguments(
-            argc,
-            argv,
-            &iface_num);
+    if (pText == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILED;
+    }
 
-    fprintf(stderr, "Interface: %i\n", iface_num);
+    // Parse and pack the whole script before the first run
+    result = cy3240_script_compile(&pScript, pText, &errorLine);
+    free(pText);
 
-    // Initialize the device
-    cy3240_factory(
-            &handle,
-            iface_num,
-            1000,
-            CY3240_POWER_5V,
-            CY3240_BUS_I2C,
-            CY3240_CLOCK__100kHz
-            );
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Syntax error on line %d\n", errorLine);
+        return EXIT_FAILED;
+    }
 
-    // Open the device
-    cy3240_open(handle);
+    cy3240_script_get_step_count(pScript, &steps);
+    cy3240_get_stats(handle, &before);
 
-    /* Read the configuration from an undefined address
-     * I think this is M8C_SetBank1
-     */
-    length = sizeof(data);
-    cy3240_read(
-            handle,
-            CONTROL_1,
-            data,
-            &length);
+    start = cy3240_util_time_us();
 
-    print_buffer(&data, length);
+    for (run = 0; CY3240_SUCCESS(result) && (run < runs); run++)
+        result = cy3240_script_run(pScript, handle);
 
-    usleep(SLEEP_BETWEEN_CMD);
+    elapsed = cy3240_util_time_us() - start;
 
-    // Configure the bridge controller using the default settings
-    cy3240_reconfigure(
-            handle,
-            CY3240_POWER_5V,
-            CY3240_BUS_I2C,
-            CY3240_CLOCK__100kHz);
+    cy3240_get_stats(handle, &after);
 
-    usleep(SLEEP_BETWEEN_CMD);
+    for (x = 0; x < steps; x++) {
 
-    /* blink LED 1 */
-    for (retry = 0; retry < 10; retry++) {
+        cy3240_script_get_step(pScript, x, &step);
 
-        data[LED_NUMBER] = 0x01;
-        data[BRIGHTNESS] = ~data[BRIGHTNESS];
-        data[UNK_7] = 0x01;
+        for (y = 0; y < step.op_count; y++) {
 
-        length = sizeof(data);
+            const Cy3240_Op_t* const pOp = &step.pOps[y];
 
-        cy3240_write(
-                handle,
-                PSOC,
-                data,
-                &length);
+            if (step.skipped) {
+                printf("%d %d skipped\n", step.line, y + 1);
+                continue;
+            }
+
+            if CY3240_SUCCESS(pOp->result)
+                printf("%d %d ok ", step.line, y + 1);
+            else
+                printf("%d %d %d ", step.line, y + 1, pOp->result);
 
+            printf("%llu %llu",
+                    (unsigned long long)(step.total_us / step.runs),
+                    (unsigned long long)step.max_us);
 
-        usleep(BLINK_DELAY);
+            if (CY3240_SUCCESS(pOp->result) && (pOp->type == CY3240_OP_READ)) {
+                printf(" ");
+                print_data(pOp->pData, pOp->length);
+            } else {
+                printf("\n");
+            }
+        }
     }
 
-    /* blink LED 2 */
-    for (retry = 0; retry < 10; retry++) {
+    // Only the traffic of the runs is counted
+    ops = (after.traffic.writes - before.traffic.writes) +
+          (after.traffic.reads - before.traffic.reads) +
+          (after.traffic.errors - before.traffic.errors);
+    bytes = (after.traffic.write_bytes - before.traffic.write_bytes) +
+            (after.traffic.read_bytes - before.traffic.read_bytes);
+
+    for (x = 0; x < CY3240_LATENCY_BUCKETS; x++)
+        after.traffic.histogram[x] -= before.traffic.histogram[x];
+
+    fprintf(stderr, "%lu of %lu runs, %u lines, %llu ops, %llu bytes in %llu us\n",
+            CY3240_SUCCESS(result) ? run : run - 1,
+            runs,
+            steps,
+            (unsigned long long)ops,
+            (unsigned long long)bytes,
+            (unsigned long long)elapsed);
+
+    fprintf(stderr, "%.0f ops/s, %.0f bytes/s, round trip p50 %llu us p99 %llu us\n",
+            elapsed ? ops * 1e6 / elapsed : 0.0,
+            elapsed ? bytes * 1e6 / elapsed : 0.0,
+            (unsigned long long)cy3240_stats_percentile(&after, 50),
+            (unsigned long long)cy3240_stats_percentile(&after, 99));
+
+    cy3240_script_destroy(pScript);
+
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Run %lu failed: %d\n", run, result);
+        return EXIT_FAILED;
+    }
 
-        data[LED_NUMBER] = 0x02;
-        data[BRIGHTNESS] = ~data[BRIGHTNESS];
-        data[UNK_7] = 0x01;
+    return EXIT_SUCCESS;
+}
 
-        length = sizeof(data);
+//-----------------------------------------------------------------------------
+/**
+ *  Method to print the usage
+ *
+ *  @param pName     [in] the name of the tool
+ *  @param pCommands [in] the commands
+ *  @param count     [in] the number of commands
+ */
+//-----------------------------------------------------------------------------
+static void
+usage(
+        const char* pName,
+        const Command_t* const pCommands,
+        size_t count
+        )
+{
+    size_t x;
+
+    fprintf(stderr, "Usage: %s [options] COMMAND [ARGS]\n\n", pName);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -i IFACE    USB interface number (0)\n");
+    fprintf(stderr, "  -s SERIAL   serial number of the bridge (first found)\n");
+    fprintf(stderr, "  -p POWER    target power: 5, 3.3 or ext (5)\n");
+    fprintf(stderr, "  -c CLOCK    I2C clock in kHz: 50, 100 or 400 (100)\n");
+    fprintf(stderr, "  -t TIMEOUT  bridge timeout in milliseconds (%d)\n\n", DEFAULT_TIMEOUT);
+    fprintf(stderr, "Commands:\n");
+
+    for (x = 0; x < count; x++)
+        fprintf(stderr, "  %-9s %s\n", pCommands[x].pName, pCommands[x].pUsage);
+}
 
-        cy3240_write(
-                handle,
-                PSOC,
-                data,
-                &length);
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+/**
+ * The commands of the tool
+ */
+static const Command_t commands[] = {
+    { "get",      "ADDR [REG [COUNT]]",     command_get },
+    { "set",      "ADDR REG VALUE...",      command_set },
+    { "dump",     "ADDR [FIRST [LAST]]",    command_dump },
+    { "transfer", "{r|w}LEN@ADDR [DATA...]...", command_transfer },
+    { "batch",    "FILE|- [RUNS]",          command_batch },
+};
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
 
-        usleep(BLINK_DELAY);
+//-----------------------------------------------------------------------------
+/**
+ *  Main entry point
+ *
+ *  @param argc [in] The number of arguments
+ *  @param argv [in] The command line arguments
+ *  @returns The result
+ */
+//-----------------------------------------------------------------------------
+int
+main(
+        int argc,
+        char *argv[]
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    const Command_t* pCommand = NULL;
+    Options_t options;
+    int handle = 0;
+    int status;
+    size_t x;
 
+    // Parse the command line arguments
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0], commands, sizeof(commands) / sizeof(commands[0]));
+        return EXIT_USAGE;
     }
 
-    /* Turn off debug messages */
-    hid_set_debug(HID_DEBUG_NONE);
+    for (x = 0; x < sizeof(commands) / sizeof(commands[0]); x++)
+        if (!strcmp(argv[optind], commands[x].pName))
+            pCommand = &commands[x];
 
-    // Reconfigure the bridge controller
-    cy3240_reconfigure(
-            handle,
-            CY3240_POWER_EXTERNAL,
+    if (pCommand == NULL) {
+        usage(argv[0], commands, sizeof(commands) / sizeof(commands[0]));
+        return EXIT_USAGE;
+    }
+
+    // Initialize the device
+    result = cy3240_factory(
+            &handle,
+            options.iface,
+            options.timeout,
+            options.power,
             CY3240_BUS_I2C,
-            CY3240_CLOCK__100kHz);
+            options.clock
+            );
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_set_serial_number(
+                handle,
+                options.pSerial);
+
+    // Open the device
+    if CY3240_SUCCESS(result)
+        result = cy3240_open(handle);
+
+    if CY3240_FAILURE(result) {
+        fprintf(stderr, "Failed to open the bridge on interface %d: %d\n", options.iface, result);
+        return EXIT_FAILED;
+    }
+
+    status = pCommand->run(
+            handle,
+            argc - optind - 1,
+            &argv[optind + 1]);
 
-    usleep(SLEEP_BETWEEN_CMD);
+    if (status == EXIT_USAGE)
+        fprintf(stderr, "Usage: %s [options] %s %s\n", argv[0], pCommand->pName, pCommand->pUsage);
 
     // Close the device
     cy3240_close(handle);
 
-    return 0;
+    return status;
 }
 
 //@} End of Methods
@@ -8,13 +8,41 @@
 
 #ifdef ACEUNIT_SUITES
 
+extern TestSuite_t eepromTestFixture;
+extern TestSuite_t filterTestFixture;
+extern TestSuite_t handleTestFixture;
+extern TestSuite_t latencyTestFixture;
+extern TestSuite_t managerTestFixture;
+extern TestSuite_t priorityTestFixture;
 extern TestSuite_t readTestFixture;
+extern TestSuite_t recoverTestFixture;
 extern TestSuite_t reconfigTestFixture;
+extern TestSuite_t ringTestFixture;
+extern TestSuite_t scanTestFixture;
+extern TestSuite_t schedulerTestFixture;
+extern TestSuite_t scriptTestFixture;
+extern TestSuite_t serverTestFixture;
+extern TestSuite_t streamTestFixture;
+extern TestSuite_t touchTestFixture;
 extern TestSuite_t writeTestFixture;
 
 const TestSuite_t *suitesOf1[] = {
+    &eepromTestFixture,
+    &filterTestFixture,
+    &handleTestFixture,
+    &latencyTestFixture,
+    &managerTestFixture,
+    &priorityTestFixture,
     &readTestFixture,
+    &recoverTestFixture,
     &reconfigTestFixture,
+    &ringTestFixture,
+    &scanTestFixture,
+    &schedulerTestFixture,
+    &scriptTestFixture,
+    &serverTestFixture,
+    &streamTestFixture,
+    &touchTestFixture,
     &writeTestFixture,
     NULL
 };
@@ -0,0 +1,483 @@
+/**
+ * @file eepromTest
+ *
+ * @brief CY3240 EEPROM programmer tests
+ *
+ * CY3240 EEPROM programmer tests against a simulated 24C04
+ *
+ * @ingroup EEPROM
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <limits.h>
+#include "unittest.h"
+#include "cy3240_eeprom.h"
+#include "eepromTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define EEPROM_ADDRESS  (0x50)
+#define EEPROM_SIZE     (512)
+#define EEPROM_PAGE     (16)
+#define EEPROM_BUSY     (6)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// The simulated part
+static uint8_t memory[EEPROM_SIZE];
+static uint32_t pointer;
+static int busy;
+static int stuck;                   // The write cycle never ends
+
+// Writes that spilled over a page boundary
+static int pageCrossings;
+
+// Number of data writes
+static int pageWrites;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+// The part under test
+static const Cy3240_Eeprom_t eeprom = {
+    EEPROM_ADDRESS,
+    1,
+    EEPROM_PAGE,
+    EEPROM_SIZE,
+    0
+};
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, runs the packet against the
+ *  simulated part and queues the response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t* const pPacket = (const uint8_t*)bytes;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    uint8_t control = pPacket[INPUT_PACKET_INDEX_CMD];
+    uint8_t length = pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS;
+    uint8_t address = pPacket[INPUT_PACKET_INDEX_ADDRESS];
+    int x;
+
+    memset(pResponse, 0x00, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    // The bridge itself always answers
+    if (address == CONTROL_I2C_ADDRESS) {
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+        return HID_RET_SUCCESS;
+    }
+
+    // Nobody else is on the bus, and a busy part does not answer
+    if (((address & ~0x01) != EEPROM_ADDRESS) || (busy > 0)) {
+        if (busy > 0)
+            busy--;
+
+        return HID_RET_SUCCESS;
+    }
+
+    if (control & CONTROL_BYTE_I2C_READ) {
+
+        // Sequential read from the address counter
+        for (x = 0; x < length; x++) {
+            pResponse[OUTPUT_PACKET_INDEX_DATA + x] = memory[pointer];
+            pointer = (pointer + 1) % EEPROM_SIZE;
+        }
+
+        return HID_RET_SUCCESS;
+    }
+
+    memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+
+    // Address only write, a probe
+    if (length == 0)
+        return HID_RET_SUCCESS;
+
+    // The first byte sets the address counter, the block comes from the address
+    pointer = ((address & 0x01) << 8) | pPacket[INPUT_PACKET_INDEX_ADDRESS + 1];
+
+    // The data wraps around inside the page
+    for (x = 1; x < length; x++) {
+
+        uint32_t page = pointer & ~(EEPROM_PAGE - 1);
+
+        memory[pointer] = pPacket[INPUT_PACKET_INDEX_ADDRESS + 1 + x];
+        pointer = page | ((pointer + 1) & (EEPROM_PAGE - 1));
+
+        if ((pointer == page) && (x + 1 < length))
+            pageCrossings++;
+    }
+
+    // A write starts the write cycle
+    if (length > 1) {
+        pageWrites++;
+        busy = stuck ? INT_MAX : EEPROM_BUSY;
+    }
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, returns the oldest response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to fill a buffer with a test image
+ *
+ *  @param pData  [out] the buffer
+ *  @param length [in] the length of the buffer
+ *  @param seed   [in] the first value
+ */
+//-----------------------------------------------------------------------------
+static void
+fillImage(
+        uint8_t* const pData,
+        uint32_t length,
+        uint8_t seed
+        )
+{
+    uint32_t x;
+
+    for (x = 0; x < length; x++)
+        pData[x] = (uint8_t)(seed + x * 7);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testEepromSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    memset(memory, 0xFF, sizeof(memory));
+    pointer = 0;
+    busy = 0;
+    stuck = 0;
+    pageCrossings = 0;
+    pageWrites = 0;
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testEepromCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testEepromError(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t data[4] = {0};
+
+    result = cy3240_eeprom_write(
+            handle,
+            &eeprom,
+            EEPROM_SIZE - 2,
+            data,
+            sizeof(data)
+            );
+
+    assertEquals("Writing past the end should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_eeprom_read(
+            handle,
+            NULL,
+            0,
+            data,
+            sizeof(data)
+            );
+
+    assertEquals("Reading without geometry should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testEepromProgram(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t image[300];
+    uint8_t readBack[300];
+    uint32_t mismatch = 0;
+
+    fillImage(image, sizeof(image), 0x11);
+
+    // Start in the middle of a page and cross in to the second block
+    result = cy3240_eeprom_write(
+            handle,
+            &eeprom,
+            100,
+            image,
+            sizeof(image)
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("No write should cross a page",
+            0,
+            pageCrossings
+            );
+
+    assertEquals("The image should be split on page boundaries",
+            (100 + 300 + EEPROM_PAGE - 1) / EEPROM_PAGE - 100 / EEPROM_PAGE,
+            pageWrites
+            );
+
+    assertTrue("The data should land at the right offsets",
+            memcmp(&memory[100], image, sizeof(image)) == 0
+            );
+
+    memset(readBack, 0x00, sizeof(readBack));
+
+    result = cy3240_eeprom_read(
+            handle,
+            &eeprom,
+            100,
+            readBack,
+            sizeof(readBack)
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The read back data should match the image",
+            memcmp(readBack, image, sizeof(image)) == 0
+            );
+
+    result = cy3240_eeprom_verify(
+            handle,
+            &eeprom,
+            100,
+            image,
+            sizeof(image),
+            &mismatch
+            );
+
+    assertEquals("The verify should pass",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("No mismatch should be reported",
+            100 + sizeof(image),
+            mismatch
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testEepromVerifyMismatch(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t image[200];
+    uint32_t mismatch = 0;
+
+    fillImage(image, sizeof(image), 0x22);
+    memcpy(&memory[40], image, sizeof(image));
+
+    // Corrupt one byte near the end of the first block
+    memory[230] ^= 0x5A;
+
+    result = cy3240_eeprom_verify(
+            handle,
+            &eeprom,
+            40,
+            image,
+            sizeof(image),
+            &mismatch
+            );
+
+    assertEquals("The verify should fail",
+            CY3240_ERROR_RX,
+            result
+            );
+
+    assertEquals("The first difference should be reported",
+            230,
+            mismatch
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testEepromPollTimeout(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Eeprom_t part = eeprom;
+    uint8_t data[EEPROM_PAGE];
+    uint64_t start;
+
+    fillImage(data, sizeof(data), 0x33);
+
+    // The write goes through, then the part never finishes the cycle
+    part.poll_timeout_us = 2000;
+    stuck = 1;
+
+    start = cy3240_util_time_us();
+
+    result = cy3240_eeprom_write(
+            handle,
+            &part,
+            0,
+            data,
+            sizeof(data)
+            );
+
+    assertEquals("A part that stays busy should time out",
+            CY3240_ERROR_TIMEOUT,
+            result
+            );
+
+    assertTrue("The poll should give up after the timeout",
+            cy3240_util_time_us() - start >= part.poll_timeout_us
+            );
+
+    assertEquals("Only one page should be written",
+            1,
+            pageWrites
+            );
+}
+
+//@} End of Methods
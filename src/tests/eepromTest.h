@@ -0,0 +1,125 @@
+/** AceUnit test header file for fixture eepromTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file eepromTest.h
+ */
+
+#ifndef _EEPROMTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _EEPROMTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 37
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testEepromError(void);
+A_Test void testEepromProgram(void);
+A_Test void testEepromVerifyMismatch(void);
+A_Test void testEepromPollTimeout(void);
+A_Before void testEepromSetup(void);
+A_After void testEepromCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    38, /* testEepromError */
+    39, /* testEepromProgram */
+    40, /* testEepromVerifyMismatch */
+    41, /* testEepromPollTimeout */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testEepromError",
+    "testEepromProgram",
+    "testEepromVerifyMismatch",
+    "testEepromPollTimeout",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testEepromError,
+    testEepromProgram,
+    testEepromVerifyMismatch,
+    testEepromPollTimeout,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testEepromSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testEepromCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t eepromTestFixture = {
+    37,
+#ifndef ACEUNIT_EMBEDDED
+    "eepromTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _EEPROMTEST_H */
@@ -0,0 +1,360 @@
+/**
+ * @file filterTest
+ *
+ * @brief CY3240 touch baseline filter tests
+ *
+ * CY3240 touch baseline filter tests
+ *
+ * @ingroup Filter
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdlib.h>
+#include <string.h>
+#include "unittest.h"
+#include "cy3240_filter.h"
+#include "filterTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define FILTER_SENSORS  (20)
+#define FILTER_BASE     (1000)
+#define RANDOM_SENSORS  (250)
+#define RANDOM_FRAMES   (500)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Finger 50, noise 15, negative noise 20, baseline update 30,
+// low baseline reset 3, hysteresis 10 and debounce 2
+static const Cy3240_Touch_Tuning_t tuning = {50, 15, 20, 30, 3, 0, 10, 2};
+
+static Cy3240_Filter_t* pFilter;
+static Cy3240_Frame_t frame;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to fill the frame with the baseline count
+ */
+//-----------------------------------------------------------------------------
+static void
+flatFrame(
+        void
+        )
+{
+    int x;
+
+    memset(&frame, 0x00, sizeof(frame));
+    frame.count = FILTER_SENSORS;
+
+    for (x = 0; x < FILTER_SENSORS; x++)
+        frame.raw[x] = FILTER_BASE;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testFilterSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    pFilter = NULL;
+
+    result = cy3240_filter_create(
+            &pFilter,
+            FILTER_SENSORS,
+            &tuning
+            );
+
+    assertEquals("The filter should be created",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // The first frame is the baseline
+    flatFrame();
+    cy3240_filter_process(pFilter, &frame);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testFilterCleanup(
+        void
+        )
+{
+    cy3240_filter_destroy(pFilter);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testFilterError(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Filter_t* pOther = NULL;
+
+    result = cy3240_filter_create(
+            &pOther,
+            CY3240_STREAM_MAX_SENSORS + 1,
+            &tuning
+            );
+
+    assertEquals("Too many sensors should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_filter_create(
+            &pOther,
+            FILTER_SENSORS,
+            NULL
+            );
+
+    assertEquals("Missing tuning should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    flatFrame();
+    frame.count = FILTER_SENSORS - 1;
+
+    result = cy3240_filter_process(pFilter, &frame);
+
+    assertEquals("A frame of the wrong size should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_filter_set_isa(pFilter, (Cy3240_Filter_Isa_t)99);
+
+    assertEquals("An unknown implementation should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testFilterDetect(
+        void
+        )
+{
+    // Above the finger threshold, but not for debounce frames yet
+    flatFrame();
+    frame.raw[3] = FILTER_BASE + 100;
+    frame.raw[5] = FILTER_BASE + 20;
+    cy3240_filter_process(pFilter, &frame);
+
+    assertEquals("The signal should be above the baseline",
+            100,
+            frame.signal[3]
+            );
+
+    assertEquals("A touch should be debounced",
+            0,
+            frame.touches
+            );
+
+    assertTrue("Until then the sensor should be noisy",
+            CY3240_STREAM_SENSOR_SET(frame.noisy, 3)
+            );
+
+    assertTrue("A small signal should be noisy",
+            CY3240_STREAM_SENSOR_SET(frame.noisy, 5)
+            );
+
+    // Second frame above the threshold
+    cy3240_filter_process(pFilter, &frame);
+
+    assertEquals("The touch should be reported",
+            1,
+            frame.touches
+            );
+
+    assertTrue("The touched sensor should be set",
+            CY3240_STREAM_SENSOR_SET(frame.touched, 3) &&
+            !CY3240_STREAM_SENSOR_SET(frame.noisy, 3)
+            );
+
+    // Inside the hysteresis band
+    frame.raw[3] = FILTER_BASE + 45;
+    cy3240_filter_process(pFilter, &frame);
+
+    assertTrue("The hysteresis should keep the touch",
+            CY3240_STREAM_SENSOR_SET(frame.touched, 3)
+            );
+
+    // Below the band
+    frame.raw[3] = FILTER_BASE + 35;
+    cy3240_filter_process(pFilter, &frame);
+
+    assertEquals("The touch should be released",
+            0,
+            frame.touches
+            );
+
+    // A failed frame reports nothing
+    frame.raw[3] = FILTER_BASE + 100;
+    frame.result = CY3240_ERROR_RX;
+    cy3240_filter_process(pFilter, &frame);
+
+    assertTrue("A failed frame should have no touches",
+            (frame.touches == 0) && !CY3240_STREAM_SENSOR_SET(frame.noisy, 3)
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testFilterBaseline(
+        void
+        )
+{
+    uint16_t baseline[FILTER_SENSORS];
+    int x;
+
+    // Slow drift up, small drop and a large drop
+    flatFrame();
+    frame.raw[0] = FILTER_BASE + 10;
+    frame.raw[1] = FILTER_BASE - 10;
+    frame.raw[2] = FILTER_BASE - 100;
+
+    for (x = 0; x < 3; x++)
+        cy3240_filter_process(pFilter, &frame);
+
+    cy3240_filter_get_baseline(pFilter, baseline);
+
+    assertEquals("The bucket should move the baseline up one count",
+            FILTER_BASE + 1,
+            baseline[0]
+            );
+
+    assertEquals("A small drop should be tracked one count per frame",
+            FILTER_BASE - 3,
+            baseline[1]
+            );
+
+    assertEquals("A large drop should reset the baseline",
+            FILTER_BASE - 100,
+            baseline[2]
+            );
+
+    assertEquals("Quiet sensors should keep their baseline",
+            FILTER_BASE,
+            baseline[4]
+            );
+
+    // Starting over takes the next frame as the baseline
+    cy3240_filter_reset(pFilter);
+    cy3240_filter_process(pFilter, &frame);
+    cy3240_filter_get_baseline(pFilter, baseline);
+
+    assertEquals("The reset should take the raw count",
+            FILTER_BASE + 10,
+            baseline[0]
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testFilterIsa(
+        void
+        )
+{
+    static Cy3240_Frame_t expected;
+    static Cy3240_Frame_t actual;
+    Cy3240_Filter_t* pReference = NULL;
+    Cy3240_Filter_t* pFast = NULL;
+    uint16_t referenceBaseline[RANDOM_SENSORS];
+    uint16_t fastBaseline[RANDOM_SENSORS];
+    int isa;
+    int x;
+    int y;
+
+    // Every implementation the processor has should match the scalar one
+    for (isa = CY3240_FILTER_ISA_SSE2; isa <= CY3240_FILTER_ISA_AVX2; isa++) {
+
+        cy3240_filter_create(&pReference, RANDOM_SENSORS, &tuning);
+        cy3240_filter_create(&pFast, RANDOM_SENSORS, &tuning);
+        cy3240_filter_set_isa(pReference, CY3240_FILTER_ISA_SCALAR);
+
+        if CY3240_FAILURE(cy3240_filter_set_isa(pFast, (Cy3240_Filter_Isa_t)isa)) {
+            cy3240_filter_destroy(pReference);
+            cy3240_filter_destroy(pFast);
+            continue;
+        }
+
+        srand(isa);
+
+        for (x = 0; x < RANDOM_FRAMES; x++) {
+
+            memset(&expected, 0x00, sizeof(expected));
+            expected.count = RANDOM_SENSORS;
+
+            for (y = 0; y < RANDOM_SENSORS; y++)
+                expected.raw[y] = FILTER_BASE - 150 + rand() % ((x & 0x10) ? 300 : 40);
+
+            actual = expected;
+
+            cy3240_filter_process(pReference, &expected);
+            cy3240_filter_process(pFast, &actual);
+
+            assertTrue("The signal should match",
+                    memcmp(expected.signal, actual.signal, sizeof(expected.signal)) == 0
+                    );
+
+            assertTrue("The touched sensors should match",
+                    (expected.touches == actual.touches) &&
+                    (memcmp(expected.touched, actual.touched, sizeof(expected.touched)) == 0)
+                    );
+
+            assertTrue("The noisy sensors should match",
+                    memcmp(expected.noisy, actual.noisy, sizeof(expected.noisy)) == 0
+                    );
+        }
+
+        cy3240_filter_get_baseline(pReference, referenceBaseline);
+        cy3240_filter_get_baseline(pFast, fastBaseline);
+
+        assertTrue("The baselines should match",
+                memcmp(referenceBaseline, fastBaseline, sizeof(fastBaseline)) == 0
+                );
+
+        cy3240_filter_destroy(pReference);
+        cy3240_filter_destroy(pFast);
+    }
+}
+
+//@} End of Methods
@@ -0,0 +1,396 @@
+/**
+ * @file handleTest
+ *
+ * @brief CY3240 handle table tests
+ *
+ * CY3240 handle table tests
+ *
+ * @ingroup Handle
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "unittest.h"
+#include "cy3240_handle.h"
+#include "handleTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+// Time the release is given to finish while a lookup is still held
+#define DRAIN_US  (20000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// States the handles point to
+static int states[CY3240_HANDLE_MAX];
+
+// Handles allocated by the test
+static int handles[CY3240_HANDLE_MAX];
+static int handleCount;
+
+// Set once the release thread returned
+static bool released;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to create and open a bridge on the generic HID substitutes
+ *
+ *  @param pHandle [out] the handle
+ *  @returns Cy3240_Error_t of the open
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+openBridge(
+        int* const pHandle
+        )
+{
+    Cy3240_t* pCy3240;
+
+    assertEquals("The usb device should be successfully created",
+            CY3240_ERROR_OK,
+            cy3240_factory(
+                    pHandle,
+                    0,
+                    1000,
+                    CY3240_POWER_5V,
+                    CY3240_BUS_I2C,
+                    CY3240_CLOCK__100kHz)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pCy3240 = cy3240_handle_get(*pHandle);
+    cy3240_handle_put(*pHandle);
+
+    pCy3240->w.init = testGenericInit;
+    pCy3240->w.close = testGenericClose;
+    pCy3240->w.write = testGenericWrite;
+    pCy3240->w.read = testGenericRead;
+    pCy3240->w.cleanup = testGenericCleanup;
+    pCy3240->w.delete_if = testGenericDeleteIf;
+    pCy3240->w.force_open = testGenericForceOpen;
+    pCy3240->w.new_if = testGenericNewHidInterface;
+
+    return cy3240_open(*pHandle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Thread releasing a handle
+ *
+ *  @param arg [in] the handle
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+releaseHandle(
+        void* arg
+        )
+{
+    cy3240_handle_release(*(int*)arg);
+    __atomic_store_n(&released, true, __ATOMIC_SEQ_CST);
+
+    return NULL;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testHandleSetup(
+        void
+        )
+{
+    handleCount = 0;
+    memset(handles, 0x00, sizeof(handles));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testHandleCleanup(
+        void
+        )
+{
+    int x;
+
+    // Give the slots back for the other fixtures
+    for (x = 0; x < handleCount; x++)
+        cy3240_handle_release(handles[x]);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Every handle finds its own state
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testHandleLookup(
+        void
+        )
+{
+    int x;
+
+    for (x = 0; x < 4; x++) {
+
+        assertEquals("The handle should be allocated",
+                CY3240_ERROR_OK,
+                cy3240_handle_alloc(&states[x], &handles[x])
+                );
+
+        assertTrue("A handle should never be 0",
+                handles[x] > 0
+                );
+
+        handleCount++;
+    }
+
+    for (x = 0; x < 4; x++) {
+
+        void* pState = cy3240_handle_get(handles[x]);
+        cy3240_handle_put(handles[x]);
+
+        assertTrue("The handle should find its state",
+                pState == &states[x]
+                );
+    }
+
+    assertTrue("Handle 0 should not be valid",
+            cy3240_handle_get(0) == NULL
+            );
+
+    assertTrue("A negative handle should not be valid",
+            cy3240_handle_get(-1) == NULL
+            );
+
+    assertEquals("A NULL state should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_handle_alloc(NULL, &handles[4])
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A released handle stays invalid when its slot is reused
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testHandleStale(
+        void
+        )
+{
+    void* pState;
+    int stale = 0;
+
+    assertEquals("The handle should be allocated",
+            CY3240_ERROR_OK,
+            cy3240_handle_alloc(&states[0], &stale)
+            );
+
+    assertEquals("The handle should be released",
+            CY3240_ERROR_OK,
+            cy3240_handle_release(stale)
+            );
+
+    assertTrue("A released handle should not be valid",
+            cy3240_handle_get(stale) == NULL
+            );
+
+    assertEquals("A handle should only be released once",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_handle_release(stale)
+            );
+
+    // The freed slot is the next one handed out
+    assertEquals("The handle should be allocated",
+            CY3240_ERROR_OK,
+            cy3240_handle_alloc(&states[1], &handles[0])
+            );
+    handleCount = 1;
+
+    assertTrue("The slot should be reused with a new generation",
+            ((handles[0] & (CY3240_HANDLE_MAX - 1)) == (stale & (CY3240_HANDLE_MAX - 1))) &&
+            (handles[0] != stale)
+            );
+
+    assertTrue("The stale handle should not find the new state",
+            cy3240_handle_get(stale) == NULL
+            );
+
+    pState = cy3240_handle_get(handles[0]);
+    cy3240_handle_put(handles[0]);
+
+    assertTrue("The new handle should find the new state",
+            pState == &states[1]
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A full table is reported and recovers once a handle is released
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testHandleExhausted(
+        void
+        )
+{
+    int extra = 0;
+
+    // Other fixtures may still hold a few slots
+    while ((handleCount < CY3240_HANDLE_MAX) &&
+           CY3240_SUCCESS(cy3240_handle_alloc(&states[handleCount], &handles[handleCount])))
+        handleCount++;
+
+    assertTrue("Most of the table should have been allocated",
+            handleCount > (CY3240_HANDLE_MAX / 2)
+            );
+
+    assertEquals("A full table should be reported",
+            CY3240_ERROR_UNKNOWN,
+            cy3240_handle_alloc(&states[0], &extra)
+            );
+
+    handleCount--;
+    cy3240_handle_release(handles[handleCount]);
+
+    assertEquals("A released slot should be allocated again",
+            CY3240_ERROR_OK,
+            cy3240_handle_alloc(&states[0], &handles[handleCount])
+            );
+    handleCount++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bridges share libhid, closing one leaves it initialized for the others
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testHandleShared(
+        void
+        )
+{
+    uint8_t data[4] = {0x01, 0x02, 0x03, 0x04};
+    uint16_t length = sizeof(data);
+    int first = 0;
+    int second = 0;
+
+    memset(RECEIVE_BUFFER, TX_ACK, sizeof(RECEIVE_BUFFER));
+
+    assertEquals("The first bridge should open",
+            CY3240_ERROR_OK,
+            openBridge(&first)
+            );
+
+    assertEquals("The second bridge should open alongside the first",
+            CY3240_ERROR_OK,
+            openBridge(&second)
+            );
+
+    assertEquals("The first bridge should close",
+            CY3240_ERROR_OK,
+            cy3240_close(first)
+            );
+
+    assertEquals("The second bridge should still work",
+            CY3240_ERROR_OK,
+            cy3240_write(second, MY_ADDRESS, data, &length)
+            );
+
+    assertEquals("The last bridge should clean libhid up",
+            CY3240_ERROR_OK,
+            cy3240_close(second)
+            );
+
+    assertEquals("libhid should be initialized again by the next open",
+            CY3240_ERROR_OK,
+            openBridge(&first)
+            );
+
+    cy3240_close(first);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A release waits for the lookups of the handle to be put back
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testHandleDrain(
+        void
+        )
+{
+    pthread_t thread;
+    void* pState;
+    void* pStale;
+    bool early;
+    int handle = 0;
+
+    released = false;
+
+    assertEquals("The handle should be allocated",
+            CY3240_ERROR_OK,
+            cy3240_handle_alloc(&states[0], &handle)
+            );
+
+    pState = cy3240_handle_get(handle);
+
+    pthread_create(&thread, NULL, releaseHandle, &handle);
+    usleep(DRAIN_US);
+
+    // Look at the table before the put lets the release go on
+    early = __atomic_load_n(&released, __ATOMIC_SEQ_CST);
+    pStale = cy3240_handle_get(handle);
+
+    cy3240_handle_put(handle);
+    pthread_join(thread, NULL);
+
+    assertTrue("The handle should find its state",
+            pState == &states[0]
+            );
+
+    assertTrue("The release should wait for the lookup",
+            !early
+            );
+
+    assertTrue("A handle being released should not be found",
+            pStale == NULL
+            );
+
+    assertTrue("The release should finish once the lookup is put",
+            __atomic_load_n(&released, __ATOMIC_SEQ_CST)
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,131 @@
+/** AceUnit test header file for fixture handleTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file handleTest.h
+ */
+
+#ifndef _HANDLETEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _HANDLETEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 75
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testHandleLookup(void);
+A_Test void testHandleStale(void);
+A_Test void testHandleExhausted(void);
+A_Test void testHandleShared(void);
+A_Test void testHandleDrain(void);
+A_Before void testHandleSetup(void);
+A_After void testHandleCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    76, /* testHandleLookup */
+    77, /* testHandleStale */
+    78, /* testHandleExhausted */
+    104, /* testHandleShared */
+    107, /* testHandleDrain */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testHandleLookup",
+    "testHandleStale",
+    "testHandleExhausted",
+    "testHandleShared",
+    "testHandleDrain",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testHandleLookup,
+    testHandleStale,
+    testHandleExhausted,
+    testHandleShared,
+    testHandleDrain,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testHandleSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testHandleCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t handleTestFixture = {
+    75,
+#ifndef ACEUNIT_EMBEDDED
+    "handleTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _HANDLETEST_H */
@@ -0,0 +1,430 @@
+/**
+ * @file latencyTest
+ *
+ * @brief CY3240 adaptive timeout tests
+ *
+ * CY3240 adaptive timeout tests against a bridge with a simulated
+ * response time
+ *
+ * @ingroup Latency
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include "unittest.h"
+#include "latencyTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SLAVE_ADDRESS   (0x21)
+#define SLOW_ADDRESS    (0x22)
+#define STATIC_TIMEOUT  (1000)
+#define LEARN_RUNS      (20)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Time the bridge takes to answer the next packets in milliseconds
+static unsigned int responseMs;
+
+// Number of the next response and the largest read timeout seen
+static uint8_t serial;
+static unsigned int lastTimeout;
+static unsigned int maxTimeout;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static unsigned int delay[QUEUE_SIZE];
+static int queueHead;
+static int queueTail;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, queues a response numbered in
+ *  the order of the packets
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    uint8_t* const pResponse = queue[queueHead % QUEUE_SIZE];
+
+    delay[queueHead++ % QUEUE_SIZE] = responseMs;
+
+    memset(pResponse, TX_ACK, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if (bytes[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ)
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], serial, RECV_PACKET_LEN - 1);
+
+    serial++;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read. A response that takes longer than
+ *  the timeout stays queued, as late as before, and is read by a later call.
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    lastTimeout = timeout;
+
+    if (timeout > maxTimeout)
+        maxTimeout = timeout;
+
+    if ((queueHead == queueTail) ||
+        (timeout < delay[queueTail % QUEUE_SIZE]))
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read one full packet from a slave
+ *
+ *  @param address [in] the slave
+ *  @param pData   [out] the data read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+readPacket(
+        uint8_t address,
+        uint8_t* const pData
+        )
+{
+    Cy3240_Op_t op;
+
+    memset(&op, 0x00, sizeof(op));
+    op.type = CY3240_OP_READ;
+    op.address = address;
+    op.pData = pData;
+    op.length = CY3240_MAX_READ_BYTES;
+
+    return cy3240_transfer(myHandle, &op, 1);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testLatencySetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    responseMs = 0;
+    serial = 0;
+    lastTimeout = 0;
+    maxTimeout = 0;
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            STATIC_TIMEOUT,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+
+    // The slow slave runs at 50 kHz
+    cy3240_set_slave_clock(handle, SLOW_ADDRESS, CY3240_CLOCK__50kHz);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testLatencyCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  The timeouts shrink once the round trip is known and grow with the
+ *  time the packet spends on the bus
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testLatencyLearn(
+        void
+        )
+{
+    int handle = myHandle;
+    Cy3240_Latency_t latency;
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    unsigned int fastTimeout;
+    int x;
+
+    readPacket(SLAVE_ADDRESS, data);
+
+    assertEquals("Without measurements the fixed timeout should be used",
+            STATIC_TIMEOUT,
+            lastTimeout
+            );
+
+    for (x = 0; x < LEARN_RUNS; x++)
+        readPacket(SLAVE_ADDRESS, data);
+
+    fastTimeout = lastTimeout;
+
+    assertTrue("The learned timeout should be far below the fixed one",
+            (fastTimeout >= 1) && (fastTimeout < STATIC_TIMEOUT / 10)
+            );
+
+    // 62 bytes at 50 kHz take more than 11 ms on the bus
+    readPacket(SLOW_ADDRESS, data);
+
+    assertTrue("A slower clock should get a longer timeout",
+            (lastTimeout > fastTimeout) && (lastTimeout >= 12)
+            );
+
+    cy3240_get_latency(handle, &latency);
+
+    assertTrue("The round trips should be counted",
+            (latency.samples > LEARN_RUNS) && (latency.timeouts == 0) &&
+            (latency.last_timeout == (int)lastTimeout)
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testLatencyTimeout(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Latency_t latency;
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    uint8_t expected;
+    int x;
+
+    for (x = 0; x < LEARN_RUNS; x++)
+        readPacket(SLAVE_ADDRESS, data);
+
+    // The bridge stalls for longer than the learned round trip
+    responseMs = STATIC_TIMEOUT / 2;
+
+    result = readPacket(SLAVE_ADDRESS, data);
+
+    assertEquals("The stall should be detected before the fixed timeout",
+            CY3240_ERROR_TIMEOUT,
+            result
+            );
+
+    cy3240_get_latency(handle, &latency);
+
+    assertEquals("The expired timeout should be counted",
+            1,
+            latency.timeouts
+            );
+
+    // The late response is still on its way when the next packet goes out
+    responseMs = 0;
+    expected = serial;
+
+    result = readPacket(SLAVE_ADDRESS, data);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The late response should not be taken for the new one",
+            expected,
+            data[0]
+            );
+
+    assertTrue("The queue should be empty",
+            queueHead == queueTail
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testLatencyDisabled(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    int x;
+
+    result = cy3240_set_adaptive_timeout(handle, FALSE);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    for (x = 0; x < LEARN_RUNS; x++)
+        readPacket(SLAVE_ADDRESS, data);
+
+    assertEquals("The fixed timeout should be used",
+            STATIC_TIMEOUT,
+            lastTimeout
+            );
+
+    cy3240_set_adaptive_timeout(handle, TRUE);
+    readPacket(SLAVE_ADDRESS, data);
+
+    assertTrue("The statistics should have been kept",
+            lastTimeout < STATIC_TIMEOUT
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testLatencyStats(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Stats_t stats;
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    uint16_t length = 2;
+    uint64_t total = 0;
+    int x;
+
+    for (x = 0; x < LEARN_RUNS; x++)
+        readPacket(SLAVE_ADDRESS, data);
+
+    result = cy3240_write(handle, SLAVE_ADDRESS, data, &length);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // The bridge stalls for longer than the learned round trip
+    responseMs = STATIC_TIMEOUT / 2;
+    readPacket(SLAVE_ADDRESS, data);
+
+    result = cy3240_get_stats(handle, &stats);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The traffic should be counted",
+            (stats.traffic.reads == LEARN_RUNS) &&
+            (stats.traffic.read_bytes == LEARN_RUNS * CY3240_MAX_READ_BYTES) &&
+            (stats.traffic.writes == 1) &&
+            (stats.traffic.write_bytes == 2) &&
+            (stats.traffic.errors == 1)
+            );
+
+    for (x = 0; x < CY3240_LATENCY_BUCKETS; x++)
+        total += stats.traffic.histogram[x];
+
+    assertTrue("Every measured round trip should be in the histogram",
+            (total == stats.latency.samples) && (stats.latency.timeouts == 1)
+            );
+
+    assertTrue("The percentiles should be ordered",
+            (cy3240_stats_percentile(&stats, 50) > 0) &&
+            (cy3240_stats_percentile(&stats, 50) <= cy3240_stats_percentile(&stats, 99)) &&
+            (cy3240_stats_percentile(&stats, 101) == 0)
+            );
+
+    assertEquals("An invalid handle should be rejected",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_get_stats(0, &stats)
+            );
+}
+
+//@} End of Methods
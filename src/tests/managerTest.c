@@ -0,0 +1,715 @@
+/**
+ * @file managerTest
+ *
+ * @brief CY3240 device manager tests
+ *
+ * CY3240 device manager tests with a fake event source and a bridge that
+ * can be unplugged
+ *
+ * @ingroup Manager
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <pthread.h>
+#include "unittest.h"
+#include "cy3240_handle.h"
+#include "cy3240_manager.h"
+#include "managerTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SERIAL_A        "CY000001"
+#define SERIAL_B        "CY000002"
+#define SERIAL_C        "CY000003"
+#define LOCATION_A      "001/002"
+#define LOCATION_B      "001/003"
+#define LOCATION_MOVED  "002/004"
+#define EVENT_QUEUE     (8)
+#define WAIT_US         (1000000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Events waiting to be delivered by the fake source
+static Cy3240_Device_Event_t events[EVENT_QUEUE];
+static int eventHead;
+static int eventTail;
+static pthread_mutex_t eventLock = PTHREAD_MUTEX_INITIALIZER;
+
+// The bridge is unplugged and claims that still fail once it is back
+static volatile bool unplugged;
+static volatile int claimFailures;
+
+// Calls to the HID wrapper and what the last open matched on
+static volatile int inits;
+static volatile int forceOpens;
+static char matched[CY3240_SERIAL_MAX];
+
+// Callbacks from the manager thread
+static volatile int removedCalls;
+static volatile int addedCalls;
+static volatile int callbackHandle;
+static volatile Cy3240_Error_t callbackResult;
+
+// The manager under test
+static Cy3240_Manager_t* pManager;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Fake enumeration, bridges A and B are connected
+ *
+ *  @see Cy3240_Event_Source_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+fakeEnumerate(
+        void* pContext,
+        Cy3240_Device_Found_t found,
+        void* arg
+        )
+{
+    found(arg, SERIAL_A, LOCATION_A);
+    found(arg, SERIAL_B, LOCATION_B);
+
+    return CY3240_ERROR_OK;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Fake wait for the events queued by the test
+ *
+ *  @see Cy3240_Event_Source_t
+ */
+//-----------------------------------------------------------------------------
+static bool
+fakeWait(
+        void* pContext,
+        int timeout_ms,
+        Cy3240_Device_Event_t* pEvent
+        )
+{
+    uint64_t end = cy3240_util_time_us() + (uint64_t)timeout_ms * 1000;
+
+    do {
+        bool found = false;
+
+        pthread_mutex_lock(&eventLock);
+
+        if (eventHead != eventTail) {
+            *pEvent = events[eventTail++ % EVENT_QUEUE];
+            found = true;
+        }
+
+        pthread_mutex_unlock(&eventLock);
+
+        if (found)
+            return true;
+
+        cy3240_util_sleep_until_us(cy3240_util_time_us() + 1000);
+
+    } while (cy3240_util_time_us() < end);
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to queue a hotplug event
+ *
+ *  @param type      [in] what happened
+ *  @param pSerial   [in] the bridge
+ *  @param pLocation [in] where the bridge is plugged in
+ */
+//-----------------------------------------------------------------------------
+static void
+sendEvent(
+        Cy3240_Device_Event_Type_t type,
+        const char* pSerial,
+        const char* pLocation
+        )
+{
+    pthread_mutex_lock(&eventLock);
+
+    events[eventHead % EVENT_QUEUE].type = type;
+    strcpy(events[eventHead % EVENT_QUEUE].serial, pSerial);
+    strcpy(events[eventHead % EVENT_QUEUE].location, pLocation);
+    eventHead++;
+
+    pthread_mutex_unlock(&eventLock);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to wait for a counter to reach a value
+ *
+ *  @param pCounter [in] the counter
+ *  @param value    [in] the value
+ *  @returns true if the value was reached in time
+ */
+//-----------------------------------------------------------------------------
+static bool
+waitFor(
+        volatile int* pCounter,
+        int value
+        )
+{
+    uint64_t end = cy3240_util_time_us() + WAIT_US;
+
+    while ((*pCounter < value) && (cy3240_util_time_us() < end))
+        cy3240_util_sleep_until_us(cy3240_util_time_us() + 1000);
+
+    return *pCounter >= value;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Callback from the manager thread
+ *
+ *  @see Cy3240_Device_Callback_t
+ */
+//-----------------------------------------------------------------------------
+static void
+myCallback(
+        void* arg,
+        const char* pSerial,
+        int handle,
+        Cy3240_Device_Event_Type_t type,
+        Cy3240_Error_t result
+        )
+{
+    callbackHandle = handle;
+    callbackResult = result;
+
+    if (type == CY3240_DEVICE_ADDED)
+        addedCalls++;
+    else
+        removedCalls++;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID init
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myInit(
+        void
+        )
+{
+    inits++;
+
+    return testGenericInit();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID force open, fails while unplugged
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myForceOpen(
+        HIDInterface* const hidif,
+        int const interface,
+        HIDInterfaceMatcher const* const matcher,
+        unsigned short retries
+        )
+{
+    forceOpens++;
+
+    if (unplugged)
+        return HID_RET_DEVICE_NOT_FOUND;
+
+    if (claimFailures > 0) {
+        claimFailures--;
+        return HID_RET_FAIL_CLAIM_IFACE;
+    }
+
+    // The bridge is selected by its serial number or where it is plugged in
+    if (matcher->custom_data == NULL)
+        return HID_RET_DEVICE_NOT_FOUND;
+
+    strcpy(matched, (const char*)matcher->custom_data);
+
+    if ((strcmp(matched, SERIAL_A) != 0) &&
+        (strcmp(matched, SERIAL_B) != 0) &&
+        (strcmp(matched, LOCATION_MOVED) != 0))
+        return HID_RET_DEVICE_NOT_FOUND;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, fails while unplugged or while
+ *  libhid is not initialized
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    if (unplugged)
+        return HID_RET_FAIL_INT_READ;
+
+    return testGenericWrite(hidif, ep, bytes, size, timeout);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, acknowledges everything while
+ *  libhid is initialized
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    hid_return error;
+
+    if (unplugged)
+        return HID_RET_FAIL_INT_READ;
+
+    error = testGenericRead(hidif, ep, bytes, size, timeout);
+
+    if (error != HID_RET_SUCCESS)
+        return error;
+
+    memset(bytes, TX_ACK, size);
+    bytes[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to create a handle on a simulated bridge
+ *
+ *  @param pSerial [in] the serial number of the bridge
+ *  @returns the handle
+ */
+//-----------------------------------------------------------------------------
+static int
+openBridge(
+        const char* pSerial
+        )
+{
+    int handle = 0;
+
+    cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = myInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = myForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    cy3240_set_serial_number(handle, pSerial);
+    cy3240_open(handle);
+
+    return handle;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testManagerSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Event_Source_t source = {NULL, fakeEnumerate, fakeWait, NULL};
+
+    eventHead = 0;
+    eventTail = 0;
+    unplugged = false;
+    claimFailures = 0;
+    inits = 0;
+    forceOpens = 0;
+    matched[0] = '\0';
+    removedCalls = 0;
+    addedCalls = 0;
+    callbackHandle = 0;
+    callbackResult = CY3240_ERROR_UNKNOWN;
+
+    result = cy3240_manager_create(
+            &pManager,
+            &source,
+            myCallback,
+            NULL);
+
+    assertEquals("The manager should be created",
+            CY3240_ERROR_OK,
+            result
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testManagerCleanup(
+        void
+        )
+{
+    // Closes the handles still attached
+    cy3240_manager_destroy(pManager);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  The enumeration is cached and kept current by the events
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testManagerEnumerate(
+        void
+        )
+{
+    char serials[CY3240_MANAGER_MAX_DEVICES][CY3240_SERIAL_MAX];
+    Cy3240_Manager_Stats_t stats;
+    int handle = 0;
+    int count;
+
+    count = cy3240_manager_get_devices(
+            pManager,
+            serials,
+            CY3240_MANAGER_MAX_DEVICES);
+
+    assertTrue("Both bridges should be listed",
+            (count == 2) &&
+            (strcmp(serials[0], SERIAL_A) == 0) &&
+            (strcmp(serials[1], SERIAL_B) == 0)
+            );
+
+    assertTrue("Bridge C should not be connected",
+            !cy3240_manager_is_present(pManager, SERIAL_C)
+            );
+
+    assertEquals("Opening a missing bridge should fail without a search",
+            CY3240_ERROR_HID,
+            cy3240_manager_open(pManager, SERIAL_C, 1000, CY3240_POWER_5V, CY3240_BUS_I2C, CY3240_CLOCK__100kHz, &handle)
+            );
+
+    assertTrue("No handle should have been created",
+            handle == 0
+            );
+
+    sendEvent(CY3240_DEVICE_ADDED, SERIAL_C, LOCATION_MOVED);
+    sendEvent(CY3240_DEVICE_REMOVED, SERIAL_A, "");
+
+    do {
+        cy3240_manager_get_stats(pManager, &stats);
+        cy3240_util_sleep_until_us(cy3240_util_time_us() + 1000);
+    } while (stats.events < 2);
+
+    assertTrue("Bridge C should have been added",
+            cy3240_manager_is_present(pManager, SERIAL_C)
+            );
+
+    assertTrue("Bridge A should have been removed",
+            !cy3240_manager_is_present(pManager, SERIAL_A)
+            );
+
+    assertEquals("Nobody should have been told, nothing was open",
+            0,
+            removedCalls
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  An open handle is reattached when its bridge is plugged in again
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testManagerReattach(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Manager_Stats_t stats;
+    int handle = openBridge(SERIAL_A);
+    uint8_t data = 0;
+    uint16_t length = 1;
+
+    result = cy3240_manager_attach(
+            pManager,
+            SERIAL_A,
+            handle);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("A handle can only be attached once",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_manager_attach(pManager, SERIAL_A, handle)
+            );
+
+    // Unplug the bridge
+    unplugged = true;
+    sendEvent(CY3240_DEVICE_REMOVED, SERIAL_A, "");
+
+    assertTrue("The application should be told about the removal",
+            waitFor(&removedCalls, 1) && (callbackHandle == handle)
+            );
+
+    assertTrue("Transfers should fail while unplugged",
+            CY3240_FAILURE(cy3240_read(handle, 0x21, &data, &length))
+            );
+
+    // Plug it in again on another port, the first two claims fail
+    unplugged = false;
+    claimFailures = 2;
+    sendEvent(CY3240_DEVICE_ADDED, SERIAL_A, LOCATION_MOVED);
+
+    assertTrue("The handle should be reattached without polling",
+            waitFor(&addedCalls, 1) &&
+            (callbackHandle == handle) &&
+            (callbackResult == CY3240_ERROR_OK)
+            );
+
+    assertTrue("The interface should have been rebuilt without restarting libhid",
+            (inits == 1) && (forceOpens == 4)
+            );
+
+    assertEquals("The bridge should be opened where it was plugged in",
+            0,
+            strcmp(matched, LOCATION_MOVED)
+            );
+
+    length = 1;
+
+    assertEquals("The same handle should work again",
+            CY3240_ERROR_OK,
+            cy3240_read(handle, 0x21, &data, &length)
+            );
+
+    cy3240_manager_get_stats(pManager, &stats);
+
+    assertTrue("The reconnect should have been timed",
+            (stats.reattaches == 1) &&
+            (stats.failures == 0) &&
+            (stats.last_reconnect_us > 0) &&
+            (stats.max_reconnect_us == stats.last_reconnect_us)
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testManagerError(
+        void
+        )
+{
+    Cy3240_Event_Source_t source = {NULL, NULL, fakeWait, NULL};
+    Cy3240_Manager_t* pOther = NULL;
+    int handle = 0;
+
+    assertEquals("A source without enumeration should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_manager_create(&pOther, &source, NULL, NULL)
+            );
+
+    assertEquals("A NULL serial number should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_manager_open(pManager, NULL, 1000, CY3240_POWER_5V, CY3240_BUS_I2C, CY3240_CLOCK__100kHz, &handle)
+            );
+
+    assertEquals("An unknown handle should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_manager_close(pManager, 0x1234)
+            );
+
+    assertEquals("A NULL statistics pointer should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_manager_get_stats(pManager, NULL)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A handle that cannot be attached is closed again, not leaked
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testManagerOpenFailure(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = openBridge(SERIAL_A);
+    int other = 0;
+    int probe = 0;
+    int slot;
+
+    cy3240_manager_attach(
+            pManager,
+            SERIAL_A,
+            handle);
+
+    // The slot the open is going to use
+    cy3240_factory(&probe, 0, 1000, CY3240_POWER_5V, CY3240_BUS_I2C, CY3240_CLOCK__100kHz);
+    slot = probe & (CY3240_HANDLE_MAX - 1);
+    cy3240_close(probe);
+
+    result = cy3240_manager_open(
+            pManager,
+            SERIAL_A,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz,
+            &other);
+
+    assertEquals("A bridge can only be attached to one handle",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result
+            );
+
+    assertTrue("No handle should have been returned",
+            other == 0
+            );
+
+    cy3240_factory(&probe, 0, 1000, CY3240_POWER_5V, CY3240_BUS_I2C, CY3240_CLOCK__100kHz);
+
+    assertEquals("The handle of the failed open should have been released",
+            slot,
+            probe & (CY3240_HANDLE_MAX - 1)
+            );
+
+    cy3240_close(probe);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Closing one of two managed bridges leaves the other working and able
+ *  to reattach
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testManagerTwoBridges(
+        void
+        )
+{
+    int first = openBridge(SERIAL_A);
+    int second = openBridge(SERIAL_B);
+    uint8_t data = 0;
+    uint16_t length = 1;
+
+    assertTrue("Both bridges should be attached",
+            CY3240_SUCCESS(cy3240_manager_attach(pManager, SERIAL_A, first)) &&
+            CY3240_SUCCESS(cy3240_manager_attach(pManager, SERIAL_B, second))
+            );
+
+    assertTrue("Both bridges should work",
+            CY3240_SUCCESS(cy3240_read(first, 0x21, &data, &length)) &&
+            CY3240_SUCCESS(cy3240_read(second, 0x21, &data, &length))
+            );
+
+    assertEquals("The second bridge should close",
+            CY3240_ERROR_OK,
+            cy3240_manager_close(pManager, second)
+            );
+
+    assertEquals("The first bridge should still work",
+            CY3240_ERROR_OK,
+            cy3240_read(first, 0x21, &data, &length)
+            );
+
+    // Unplug the first bridge and plug it in again
+    unplugged = true;
+    sendEvent(CY3240_DEVICE_REMOVED, SERIAL_A, "");
+
+    assertTrue("The application should be told about the removal",
+            waitFor(&removedCalls, 1) && (callbackHandle == first)
+            );
+
+    unplugged = false;
+    sendEvent(CY3240_DEVICE_ADDED, SERIAL_A, LOCATION_MOVED);
+
+    assertTrue("The first bridge should be reattached",
+            waitFor(&addedCalls, 1) &&
+            (callbackHandle == first) &&
+            (callbackResult == CY3240_ERROR_OK)
+            );
+
+    assertEquals("libhid should have been initialized once",
+            1,
+            inits
+            );
+
+    assertEquals("The reattached bridge should work",
+            CY3240_ERROR_OK,
+            cy3240_read(first, 0x21, &data, &length)
+            );
+}
+
+//@} End of Methods
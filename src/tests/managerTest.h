@@ -0,0 +1,131 @@
+/** AceUnit test header file for fixture managerTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file managerTest.h
+ */
+
+#ifndef _MANAGERTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _MANAGERTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 71
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testManagerEnumerate(void);
+A_Test void testManagerReattach(void);
+A_Test void testManagerError(void);
+A_Test void testManagerOpenFailure(void);
+A_Test void testManagerTwoBridges(void);
+A_Before void testManagerSetup(void);
+A_After void testManagerCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    72, /* testManagerEnumerate */
+    73, /* testManagerReattach */
+    74, /* testManagerError */
+    103, /* testManagerOpenFailure */
+    106, /* testManagerTwoBridges */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testManagerEnumerate",
+    "testManagerReattach",
+    "testManagerError",
+    "testManagerOpenFailure",
+    "testManagerTwoBridges",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testManagerEnumerate,
+    testManagerReattach,
+    testManagerError,
+    testManagerOpenFailure,
+    testManagerTwoBridges,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testManagerSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testManagerCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t managerTestFixture = {
+    71,
+#ifndef ACEUNIT_EMBEDDED
+    "managerTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _MANAGERTEST_H */
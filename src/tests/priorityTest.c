@@ -0,0 +1,675 @@
+/**
+ * @file priorityTest
+ *
+ * @brief CY3240 priority class tests
+ *
+ * CY3240 priority class tests. A bulk transfer runs on its own thread
+ * against a bridge that takes a millisecond per packet while the test
+ * thread sends a realtime read, the packets the bridge saw show where the
+ * realtime read went.
+ *
+ * @ingroup Priority
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "unittest.h"
+#include "priorityTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define BULK_ADDRESS    (0x50)
+#define FAST_ADDRESS    (0x48)
+#define BULK_PACKETS    (32)
+#define STATIC_TIMEOUT  (1000)
+#define PACKET_US       (1000)
+#define HEAD_START      (3)
+#define QUEUE_SIZE      (64)
+#define LOG_SIZE        (256)
+#define RETRY_US        (20000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+// Packets the bridge saw, W write, S write ending with a stop, R bulk
+// read and r read of the fast slave
+static char packetLog[LOG_SIZE + 1];
+static int packetCount;
+
+// Write packets still to refuse
+static int nakPackets;
+
+// Data of the bulk transfer
+static uint8_t bulkData[BULK_PACKETS * CY3240_MAX_READ_BYTES];
+static uint16_t bulkLength;
+static Cy3240_Error_t bulkResult;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, logs the packet and queues a
+ *  response. Reads return the address of the slave in every byte, the
+ *  first nakPackets writes are refused.
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t cmd = (uint8_t)bytes[INPUT_PACKET_INDEX_CMD];
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    char kind;
+
+    memset(pResponse, TX_ACK, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if (cmd & CONTROL_BYTE_I2C_READ) {
+
+        const uint8_t address = (uint8_t)bytes[INPUT_PACKET_INDEX_ADDRESS];
+
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], address, RECV_PACKET_LEN - 1);
+        kind = (address == FAST_ADDRESS) ? 'r' : 'R';
+
+    } else {
+        kind = (cmd & CONTROL_BYTE_STOP) ? 'S' : 'W';
+
+        if (nakPackets > 0) {
+            nakPackets--;
+            pResponse[OUTPUT_PACKET_INDEX_DATA] = 0x00;
+        }
+    }
+
+    if (packetCount < LOG_SIZE)
+        packetLog[packetCount] = kind;
+
+    __atomic_add_fetch(&packetCount, 1, __ATOMIC_SEQ_CST);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, the response takes PACKET_US
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    usleep(PACKET_US);
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bulk thread reading the bulk slave with cy3240_read()
+ *
+ *  @param arg [in] unused
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+bulkRead(
+        void* arg
+        )
+{
+    cy3240_set_priority(CY3240_PRIORITY_BULK);
+
+    bulkResult = cy3240_read(
+            myHandle,
+            BULK_ADDRESS,
+            bulkData,
+            &bulkLength);
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bulk thread writing the bulk slave with cy3240_write()
+ *
+ *  @param arg [in] unused
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+bulkWrite(
+        void* arg
+        )
+{
+    cy3240_set_priority(CY3240_PRIORITY_BULK);
+
+    bulkResult = cy3240_write(
+            myHandle,
+            BULK_ADDRESS,
+            bulkData,
+            &bulkLength);
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bulk thread reading the bulk slave with a cy3240_transfer() of single
+ *  packet reads
+ *
+ *  @param arg [in] unused
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+bulkTransfer(
+        void* arg
+        )
+{
+    Cy3240_Op_t ops[BULK_PACKETS];
+    int x;
+
+    cy3240_set_priority(CY3240_PRIORITY_BULK);
+
+    memset(ops, 0x00, sizeof(ops));
+
+    for (x = 0; x < BULK_PACKETS; x++) {
+        ops[x].type = CY3240_OP_READ;
+        ops[x].address = BULK_ADDRESS;
+        ops[x].pData = &bulkData[x * CY3240_MAX_READ_BYTES];
+        ops[x].length = CY3240_MAX_READ_BYTES;
+    }
+
+    bulkResult = cy3240_transfer(
+            myHandle,
+            ops,
+            BULK_PACKETS);
+
+    for (x = 0; CY3240_SUCCESS(bulkResult) && (x < BULK_PACKETS); x++)
+        bulkResult = ops[x].result;
+
+    return NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to start a bulk thread, read the fast slave in the realtime class
+ *  once the bulk transfer is under way and wait for the bulk thread
+ *
+ *  @param pBulk [in] the bulk thread
+ *  @param pFast [out] the data read from the fast slave
+ *  @returns the result of the fast read
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+runBoth(
+        void* (*pBulk)(void*),
+        uint8_t* const pFast
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    uint16_t length = CY3240_MAX_READ_BYTES;
+    pthread_t thread;
+
+    pthread_create(&thread, NULL, pBulk, NULL);
+
+    while (__atomic_load_n(&packetCount, __ATOMIC_SEQ_CST) < HEAD_START)
+        usleep(100);
+
+    cy3240_set_priority(CY3240_PRIORITY_REALTIME);
+
+    result = cy3240_read(
+            myHandle,
+            FAST_ADDRESS,
+            pFast,
+            &length);
+
+    cy3240_set_priority(CY3240_PRIORITY_INTERACTIVE);
+
+    pthread_join(thread, NULL);
+
+    packetLog[MIN(packetCount, LOG_SIZE)] = '\0';
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check every byte of a buffer
+ *
+ *  @param pData  [in] the buffer
+ *  @param length [in] the length of the buffer
+ *  @param value  [in] the expected value
+ *  @returns true if every byte has the value
+ */
+//-----------------------------------------------------------------------------
+static bool
+allEqual(
+        const uint8_t* const pData,
+        uint32_t length,
+        uint8_t value
+        )
+{
+    uint32_t x;
+
+    for (x = 0; x < length; x++)
+        if (pData[x] != value)
+            return false;
+
+    return true;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testPrioritySetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    queueHead = 0;
+    queueTail = 0;
+    packetCount = 0;
+    nakPackets = 0;
+    memset(packetLog, 0x00, sizeof(packetLog));
+    memset(bulkData, 0x00, sizeof(bulkData));
+    bulkLength = sizeof(bulkData);
+    bulkResult = CY3240_ERROR_UNKNOWN;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            STATIC_TIMEOUT,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+
+    // Only the packets of the test are logged
+    queueHead = 0;
+    queueTail = 0;
+    packetCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testPriorityCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A realtime read goes in between the packets of a bulk read
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityRead(
+        void
+        )
+{
+    uint8_t fast[CY3240_MAX_READ_BYTES];
+    Cy3240_Stats_t stats;
+    Cy3240_Error_t result;
+    const char* pFast;
+
+    result = runBoth(bulkRead, fast);
+
+    assertTrue("Both reads should succeed",
+            CY3240_SUCCESS(result) && CY3240_SUCCESS(bulkResult)
+            );
+
+    assertTrue("Both reads should get the data of their slave",
+            allEqual(fast, sizeof(fast), FAST_ADDRESS) &&
+            allEqual(bulkData, sizeof(bulkData), BULK_ADDRESS)
+            );
+
+    pFast = strchr(packetLog, 'r');
+
+    assertTrue("The realtime read should go in between the bulk packets",
+            (pFast != NULL) &&
+            (pFast - packetLog >= HEAD_START) &&
+            (pFast - packetLog < BULK_PACKETS) &&
+            (packetCount == BULK_PACKETS + 1)
+            );
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertTrue("The bulk read should have been preempted once",
+            (stats.classes[CY3240_PRIORITY_BULK].preempted == 1) &&
+            (stats.classes[CY3240_PRIORITY_BULK].calls == 1) &&
+            (stats.classes[CY3240_PRIORITY_REALTIME].calls == 1) &&
+            (stats.classes[CY3240_PRIORITY_REALTIME].preempted == 0)
+            );
+
+    assertTrue("The realtime read should not wait for the bulk read",
+            stats.classes[CY3240_PRIORITY_REALTIME].max_us * 4 <
+            stats.classes[CY3240_PRIORITY_BULK].max_us
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A multi packet write only stops the bus after its last packet, so a
+ *  realtime read waits for the whole write
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityWrite(
+        void
+        )
+{
+    uint8_t fast[CY3240_MAX_READ_BYTES];
+    Cy3240_Stats_t stats;
+    Cy3240_Error_t result;
+    const uint16_t packets = BULK_PACKETS / 2;
+
+    bulkLength = packets * CY3240_MAX_WRITE_BYTES;
+
+    result = runBoth(bulkWrite, fast);
+
+    assertTrue("Both transfers should succeed",
+            CY3240_SUCCESS(result) && CY3240_SUCCESS(bulkResult)
+            );
+
+    assertTrue("The realtime read should follow the stop of the write",
+            (packetCount == packets + 1) &&
+            (packetLog[packets - 1] == 'S') &&
+            (packetLog[packets] == 'r') &&
+            (strchr(packetLog, 'S') == &packetLog[packets - 1])
+            );
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertEquals("The write should not count as preempted",
+            0,
+            stats.classes[CY3240_PRIORITY_BULK].preempted
+            );
+
+    assertTrue("The realtime read should count its wait",
+            stats.classes[CY3240_PRIORITY_REALTIME].max_wait_us >= PACKET_US
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A realtime read goes in between the operations of a pipelined bulk
+ *  transfer once the pipeline is drained
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityTransfer(
+        void
+        )
+{
+    uint8_t fast[CY3240_MAX_READ_BYTES];
+    Cy3240_Stats_t stats;
+    Cy3240_Error_t result;
+    const char* pFast;
+
+    result = runBoth(bulkTransfer, fast);
+
+    assertTrue("Both transfers should succeed",
+            CY3240_SUCCESS(result) && CY3240_SUCCESS(bulkResult)
+            );
+
+    assertTrue("Both transfers should get the data of their slave",
+            allEqual(fast, sizeof(fast), FAST_ADDRESS) &&
+            allEqual(bulkData, sizeof(bulkData), BULK_ADDRESS)
+            );
+
+    pFast = strchr(packetLog, 'r');
+
+    assertTrue("The realtime read should go in between the bulk operations",
+            (pFast != NULL) &&
+            (pFast - packetLog >= HEAD_START) &&
+            (pFast - packetLog < BULK_PACKETS) &&
+            (packetCount == BULK_PACKETS + 1)
+            );
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertEquals("The bulk transfer should have been preempted once",
+            1,
+            stats.classes[CY3240_PRIORITY_BULK].preempted
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Calls are counted in the class of the calling thread
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityStats(
+        void
+        )
+{
+    uint8_t data[CY3240_MAX_READ_BYTES];
+    uint16_t length = sizeof(data);
+    Cy3240_Stats_t stats;
+    int x;
+
+    assertEquals("Threads should start in the interactive class",
+            CY3240_PRIORITY_INTERACTIVE,
+            cy3240_get_priority()
+            );
+
+    assertEquals("An unknown class should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_set_priority(CY3240_PRIORITY_COUNT)
+            );
+
+    assertEquals("A refused class should not change the class",
+            CY3240_PRIORITY_INTERACTIVE,
+            cy3240_get_priority()
+            );
+
+    for (x = 0; x < 4; x++)
+        cy3240_read(myHandle, BULK_ADDRESS, data, &length);
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertTrue("Only the interactive class should count the reads",
+            (stats.classes[CY3240_PRIORITY_INTERACTIVE].calls == 4) &&
+            (stats.classes[CY3240_PRIORITY_REALTIME].calls == 0) &&
+            (stats.classes[CY3240_PRIORITY_BULK].calls == 0)
+            );
+
+    assertTrue("Every read should take at least the packet time",
+            (stats.classes[CY3240_PRIORITY_INTERACTIVE].total_us >= 4 * PACKET_US) &&
+            (stats.classes[CY3240_PRIORITY_INTERACTIVE].max_us >= PACKET_US)
+            );
+
+    assertTrue("The percentile should come from the class histogram",
+            (cy3240_class_percentile(&stats, CY3240_PRIORITY_INTERACTIVE, 50) > PACKET_US) &&
+            (cy3240_class_percentile(&stats, CY3240_PRIORITY_REALTIME, 50) == 0) &&
+            (cy3240_class_percentile(&stats, CY3240_PRIORITY_COUNT, 50) == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bridge commands take the bridge through the class gate as well
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityCommand(
+        void
+        )
+{
+    Cy3240_Stats_t stats;
+
+    cy3240_set_priority(CY3240_PRIORITY_BULK);
+
+    cy3240_restart(myHandle);
+    cy3240_reinit(myHandle);
+    cy3240_reconfigure(myHandle, CY3240_POWER_5V, CY3240_BUS_I2C, CY3240_CLOCK__100kHz);
+
+    cy3240_set_priority(CY3240_PRIORITY_INTERACTIVE);
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertTrue("Every command should be counted in the class of the caller",
+            (stats.classes[CY3240_PRIORITY_BULK].calls == 3) &&
+            (stats.classes[CY3240_PRIORITY_INTERACTIVE].calls == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A realtime read uses the bus while a refused bulk write backs off, and
+ *  the write takes the bridge back through the class gate
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testPriorityRetry(
+        void
+        )
+{
+    uint8_t fast[CY3240_MAX_READ_BYTES];
+    uint16_t length = sizeof(fast);
+    Cy3240_Retry_Policy_t policy = {2, RETRY_US, RETRY_US, 1, 0};
+    Cy3240_Stats_t stats;
+    Cy3240_Error_t result;
+    pthread_t thread;
+    int x;
+
+    cy3240_set_retry_policy(
+            myHandle,
+            CY3240_NAK_ADDRESS,
+            &policy);
+
+    nakPackets = 1;
+    bulkLength = CY3240_MAX_WRITE_BYTES;
+
+    pthread_create(&thread, NULL, bulkWrite, NULL);
+
+    while (__atomic_load_n(&packetCount, __ATOMIC_SEQ_CST) < 1)
+        usleep(100);
+
+    cy3240_set_priority(CY3240_PRIORITY_REALTIME);
+
+    result = cy3240_read(
+            myHandle,
+            FAST_ADDRESS,
+            fast,
+            &length);
+
+    cy3240_set_priority(CY3240_PRIORITY_INTERACTIVE);
+
+    pthread_join(thread, NULL);
+
+    packetLog[MIN(packetCount, LOG_SIZE)] = '\0';
+
+    assertTrue("Both transfers should succeed",
+            CY3240_SUCCESS(result) && CY3240_SUCCESS(bulkResult)
+            );
+
+    assertEquals("The realtime read should go in during the backoff",
+            0,
+            strcmp(packetLog, "SrS")
+            );
+
+    for (x = 0; x < CY3240_PRIORITY_COUNT; x++)
+        assertEquals("No class should be left waiting",
+                0,
+                pMyData->waiting[x]
+                );
+
+    cy3240_get_stats(myHandle, &stats);
+
+    assertTrue("The realtime read should not wait for the backoff",
+            stats.classes[CY3240_PRIORITY_REALTIME].max_us < RETRY_US
+            );
+}
+
+//@} End of Methods
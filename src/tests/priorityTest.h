@@ -0,0 +1,137 @@
+/** AceUnit test header file for fixture priorityTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file priorityTest.h
+ */
+
+#ifndef _PRIORITYTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _PRIORITYTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 86
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testPriorityRead(void);
+A_Test void testPriorityWrite(void);
+A_Test void testPriorityTransfer(void);
+A_Test void testPriorityStats(void);
+A_Test void testPriorityCommand(void);
+A_Test void testPriorityRetry(void);
+A_Before void testPrioritySetup(void);
+A_After void testPriorityCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    87, /* testPriorityRead */
+    88, /* testPriorityWrite */
+    89, /* testPriorityTransfer */
+    90, /* testPriorityStats */
+    111, /* testPriorityCommand */
+    101, /* testPriorityRetry */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testPriorityRead",
+    "testPriorityWrite",
+    "testPriorityTransfer",
+    "testPriorityStats",
+    "testPriorityCommand",
+    "testPriorityRetry",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testPriorityRead,
+    testPriorityWrite,
+    testPriorityTransfer,
+    testPriorityStats,
+    testPriorityCommand,
+    testPriorityRetry,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testPrioritySetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testPriorityCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t priorityTestFixture = {
+    86,
+#ifndef ACEUNIT_EMBEDDED
+    "priorityTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _PRIORITYTEST_H */
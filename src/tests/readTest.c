@@ -135,7 +135,10 @@ testReadSetup(
               CY3240_SUCCESS(result)
               );
 
-    pMyData = (Cy3240_t*)handle;
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
 
     // Modify the read and write interfaces to point to our functions
     pMyData->w.init = testGenericInit;
@@ -161,7 +164,7 @@ testReadCleanup(
         void
         )
 {
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Close the device handle
     cy3240_close(handle);
@@ -196,7 +199,7 @@ testReadError(
               );
 
     // Initialize the handle
-    handle = (int)pMyData;
+    handle = myHandle;
 
     // NULL Data buffer
     result = cy3240_read(
@@ -252,7 +255,7 @@ testReadSmall(
     uint8_t data[8] = {0};
     uint16_t length = 8;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Write a small packet to the device
     result = cy3240_read(
@@ -300,7 +303,7 @@ testReadMedium (
     uint8_t data[CY3240_MAX_READ_BYTES] = {0};
     uint16_t length = CY3240_MAX_READ_BYTES;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Write a small packet to the device
     result = cy3240_read(
@@ -347,7 +350,7 @@ testReadLarge(
     uint8_t data[69] = {0};
     uint16_t length = 69;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Write a small packet to the device
     result = cy3240_read(
@@ -403,4 +406,93 @@ testReadLarge(
             );
 }
 
+//-----------------------------------------------------------------------------
+/**
+ *  Test Case for the status byte and interrupt flag of a read response
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testReadInterruptStatus(
+        void
+        )
+{
+    uint8_t data[8] = {0};
+    uint16_t length = 8;
+    uint8_t status = 0;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+
+    // Nothing has been received yet
+    result = cy3240_interrupt_wait(
+            handle,
+            0
+            );
+
+    assertEquals("Waiting before any response should time out",
+            CY3240_ERROR_TIMEOUT,
+            result
+            );
+
+    // The response status byte has the interrupt flag set
+    result = cy3240_read(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length
+            );
+
+    assertTrue("The read should complete successfully",
+            CY3240_SUCCESS(result)
+            );
+
+    result = cy3240_get_status(
+            handle,
+            &status
+            );
+
+    assertEquals("The status should match the response status byte: 0x07",
+            0x07,
+            status
+            );
+
+    result = cy3240_interrupt_wait(
+            handle,
+            0
+            );
+
+    assertEquals("The interrupt flag in the last response should wake the waiter",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // The flag stays set in the next response
+    length = 8;
+    result = cy3240_read(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length
+            );
+
+    result = cy3240_interrupt_wait(
+            handle,
+            0
+            );
+
+    assertEquals("An interrupt should only be returned once",
+            CY3240_ERROR_TIMEOUT,
+            result
+            );
+
+    result = cy3240_interrupt_wait(
+            handle,
+            -1
+            );
+
+    assertEquals("A negative timeout should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result
+            );
+}
+
 //@} End of Methods
@@ -21,6 +21,7 @@ A_Test void testReadError(void);
 A_Test void testReadSmall(void);
 A_Test void testReadMedium(void);
 A_Test void testReadLarge(void);
+A_Test void testReadInterruptStatus(void);
 A_Before void testReadSetup(void);
 A_After void testReadCleanup(void);
 
@@ -30,6 +31,7 @@ static const TestCaseId_t testIds[] = {
     4, /* testReadSmall */
     5, /* testReadMedium */
     6, /* testReadLarge */
+   27, /* testReadInterruptStatus */
 };
 
 #ifndef ACEUNIT_EMBEDDED
@@ -39,6 +41,7 @@ static const char *const testNames[] = {
     "testReadSmall",
     "testReadMedium",
     "testReadLarge",
+    "testReadInterruptStatus",
 };
 #endif
 
@@ -49,6 +52,7 @@ static const aceunit_loop_t loops[] = {
     1,
     1,
     1,
+    1,
 };
 #endif
 
@@ -59,6 +63,7 @@ static const AceGroupId_t groups[] = {
     0,
     0,
     0,
+    0,
 };
 #endif
 
@@ -68,6 +73,7 @@ static const testMethod_t testCases[] = {
     testReadSmall,
     testReadMedium,
     testReadLarge,
+    testReadInterruptStatus,
     NULL
 };
 
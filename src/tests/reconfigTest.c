@@ -223,7 +223,10 @@ testReconfigSetup(
             CY3240_SUCCESS(result)
             );
 
-    pMyData = (Cy3240_t*)handle;
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
 
     // Modify the read and write interfaces to point to our functions
     pMyData->w.init = testGenericInit;
@@ -249,7 +252,7 @@ testReconfigCleanup (
         void
         )
 {
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Initialize the write buffer pointer
     pWrite = SEND_BUFFER;
@@ -291,7 +294,7 @@ testReconfigPowerExternal(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set external power mode
     result = cy3240_reconfigure(
@@ -323,7 +326,7 @@ testReconfigPower5V(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set 5V power mode
     result = cy3240_reconfigure(
@@ -355,7 +358,7 @@ testReconfigPower3_3V(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set 3.3V power mode
     result = cy3240_reconfigure(
@@ -387,7 +390,7 @@ testReconfigClock100kHz(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -418,7 +421,7 @@ testReconfigClock400kHz(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -449,7 +452,7 @@ testReconfigClock50kHz(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -480,7 +483,7 @@ testReconfigClockReserved(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -507,7 +510,7 @@ testReconfigBusI2C(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -526,7 +529,7 @@ testReconfigBusSPI(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -545,7 +548,7 @@ testReconfigBusUART(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -564,7 +567,7 @@ testReconfigBusLIN(
         )
 {
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Set the power mode
     result = cy3240_reconfigure(
@@ -593,4 +596,218 @@ testReinitError(
             );
 }
 
+//-----------------------------------------------------------------------------
+A_Test void
+testReconfigSlaveClock(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t data = 0x5A;
+    uint16_t length = sizeof(data);
+
+    // The slave runs at 400 kHz while the bridge default is 100 kHz
+    result = cy3240_set_slave_clock(
+            handle,
+            MY_ADDRESS,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            &data,
+            &length
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The first write to the slave should switch to 400KHz",
+            testClockPacket(
+            SEND_BUFFER,
+            CONTROL_BYTE_RECONFIG | CY3240_CLOCK__400kHz | CY3240_BUS_I2C,
+            0x00,
+            CONTROL_I2C_ADDRESS
+            ));
+
+    assertEquals("The data packet should follow the clock packet",
+            CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START | CONTROL_BYTE_STOP,
+            SEND_BUFFER[CY3240_MAX_SIZE_PACKET + INPUT_PACKET_INDEX_CMD]
+            );
+
+    // A second write at the same speed should not send a clock packet
+    pWrite = SEND_BUFFER;
+    length = sizeof(data);
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            &data,
+            &length
+            );
+
+    assertEquals("The second write should not switch the clock",
+            CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START | CONTROL_BYTE_STOP,
+            SEND_BUFFER[INPUT_PACKET_INDEX_CMD]
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testReconfigRedundant(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // The same settings again should not touch the bridge
+    memset(SEND_BUFFER, 0x00, sizeof(SEND_BUFFER));
+    pWrite = SEND_BUFFER;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("No packet should be sent for confirmed settings",
+            pWrite == SEND_BUFFER
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testReconfigInvalidate(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    result = cy3240_invalidate(handle);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // Forgotten settings must be sent again
+    memset(SEND_BUFFER, 0x00, sizeof(SEND_BUFFER));
+    pWrite = SEND_BUFFER;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertTrue("Power 5V",
+            testPowerPacket(
+            SEND_BUFFER,
+            CONTROL_BYTE_I2C_WRITE | CONTROL_BYTE_START | CY3240_CLOCK__100kHz | CY3240_BUS_I2C,
+            0x01,
+            CONTROL_I2C_ADDRESS,
+            CY3240_POWER_5V
+            ));
+
+    assertTrue("Clock 100KHz",
+            testClockPacket(
+            &SEND_BUFFER[CY3240_MAX_SIZE_PACKET],
+            CONTROL_BYTE_RECONFIG | CY3240_CLOCK__100kHz | CY3240_BUS_I2C,
+            0x00,
+            CONTROL_I2C_ADDRESS
+            ));
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testReconfigClockOnly(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // Only the clock changes, so only the clock packet is sent
+    memset(SEND_BUFFER, 0x00, sizeof(SEND_BUFFER));
+    pWrite = SEND_BUFFER;
+
+    result = cy3240_reconfigure(
+            handle,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("Clock 400KHz",
+            testClockPacket(
+            SEND_BUFFER,
+            CONTROL_BYTE_RECONFIG | CY3240_CLOCK__400kHz | CY3240_BUS_I2C,
+            0x00,
+            CONTROL_I2C_ADDRESS
+            ));
+
+    assertTrue("Only one packet should be sent",
+            pWrite == &SEND_BUFFER[CY3240_MAX_SIZE_PACKET]
+            );
+}
+
 //@} End of Methods
@@ -30,6 +30,10 @@ A_Test void testReconfigBusSPI(void);
 A_Test void testReconfigBusUART(void);
 A_Test void testReconfigBusLIN(void);
 A_Test void testReinitError(void);
+A_Test void testReconfigSlaveClock(void);
+A_Test void testReconfigRedundant(void);
+A_Test void testReconfigInvalidate(void);
+A_Test void testReconfigClockOnly(void);
 A_Before void testReconfigSetup(void);
 A_After void testReconfigCleanup(void);
 
@@ -48,6 +52,10 @@ static const TestCaseId_t testIds[] = {
     18, /* testReconfigBusUART */
     19, /* testReconfigBusLIN */
     20, /* testReinitError */
+    28, /* testReconfigSlaveClock */
+    29, /* testReconfigRedundant */
+    30, /* testReconfigInvalidate */
+    31, /* testReconfigClockOnly */
 };
 
 #ifndef ACEUNIT_EMBEDDED
@@ -66,6 +74,10 @@ static const char *const testNames[] = {
     "testReconfigBusUART",
     "testReconfigBusLIN",
     "testReinitError",
+    "testReconfigSlaveClock",
+    "testReconfigRedundant",
+    "testReconfigInvalidate",
+    "testReconfigClockOnly",
 };
 #endif
 
@@ -85,6 +97,10 @@ static const aceunit_loop_t loops[] = {
     1,
     1,
     1,
+    1,
+    1,
+    1,
+    1,
 };
 #endif
 
@@ -104,6 +120,10 @@ static const AceGroupId_t groups[] = {
     0,
     0,
     0,
+    0,
+    0,
+    0,
+    0,
 };
 #endif
 
@@ -122,6 +142,10 @@ static const testMethod_t testCases[] = {
     testReconfigBusUART,
     testReconfigBusLIN,
     testReinitError,
+    testReconfigSlaveClock,
+    testReconfigRedundant,
+    testReconfigInvalidate,
+    testReconfigClockOnly,
     NULL
 };
 
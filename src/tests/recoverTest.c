@@ -0,0 +1,587 @@
+/**
+ * @file recoverTest
+ *
+ * @brief CY3240 bus recovery tests
+ *
+ * CY3240 bus recovery tests against a bridge that stops answering until
+ * it is reinitialized, claimed again or rebuilt
+ *
+ * @ingroup Recover
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include "unittest.h"
+#include "recoverTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SLAVE_ADDRESS   (0x21)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Types
+//@{
+
+/**
+ * What the simulated bridge needs before it answers again
+ */
+typedef enum {
+    WEDGE_NONE,
+    WEDGE_REINIT,
+    WEDGE_RECLAIM,
+    WEDGE_REBUILD
+} Wedge_t;
+
+//@} End of Types
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// State of the simulated bridge
+static Wedge_t wedge;
+
+// Reads that time out before the response is delivered
+static int delayReads;
+
+// Number of the next response
+static uint8_t serial;
+
+// New interfaces that cannot be created
+static int newIfFailures;
+
+// Calls to the HID wrapper
+static int inits;
+static int newIfs;
+static int forceOpens;
+static int reinits;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID init
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myInit(
+        void
+        )
+{
+    inits++;
+
+    return testGenericInit();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the new HID interface, clears a wedge that needs
+ *  a rebuild
+ *
+ *  @see hid.h
+ *  @returns HIDInterface
+ */
+//-----------------------------------------------------------------------------
+static HIDInterface*
+myNewIf(
+        void
+        )
+{
+    newIfs++;
+
+    if (newIfFailures > 0) {
+        newIfFailures--;
+        return NULL;
+    }
+
+    if (wedge == WEDGE_REBUILD)
+        wedge = WEDGE_NONE;
+
+    return testGenericNewHidInterface();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID force open, clears a wedge that needs
+ *  the interface to be claimed again
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myForceOpen(
+        HIDInterface* const hidif,
+        int const interface,
+        HIDInterfaceMatcher const* const matcher,
+        unsigned short retries
+        )
+{
+    forceOpens++;
+
+    if (wedge == WEDGE_RECLAIM)
+        wedge = WEDGE_NONE;
+
+    // The matcher must still select the bridge
+    if ((matcher->vendor_id != CY3240_VID) ||
+        (matcher->product_id != CY3240_PID))
+        return HID_RET_DEVICE_NOT_FOUND;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, queues a numbered response unless
+ *  the bridge is wedged
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    uint8_t* pResponse;
+
+    if (bytes[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_REINIT) {
+
+        reinits++;
+
+        if (wedge == WEDGE_REINIT)
+            wedge = WEDGE_NONE;
+    }
+
+    if (wedge != WEDGE_NONE)
+        return HID_RET_SUCCESS;
+
+    pResponse = queue[queueHead++ % QUEUE_SIZE];
+
+    memset(pResponse, TX_ACK, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if (bytes[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ)
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], serial, RECV_PACKET_LEN - 1);
+
+    serial++;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (delayReads > 0) {
+        delayReads--;
+        return HID_RET_TIMEOUT;
+    }
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to read one byte from the slave
+ *
+ *  @param pData [out] the byte read
+ *  @returns Cy3240_Error_t
+ */
+//-----------------------------------------------------------------------------
+static Cy3240_Error_t
+readByte(
+        uint8_t* const pData
+        )
+{
+    Cy3240_Op_t op;
+
+    memset(&op, 0x00, sizeof(op));
+    op.type = CY3240_OP_READ;
+    op.address = SLAVE_ADDRESS;
+    op.pData = pData;
+    op.length = 1;
+
+    return cy3240_transfer(myHandle, &op, 1);
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testRecoverSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    wedge = WEDGE_NONE;
+    delayReads = 0;
+    newIfFailures = 0;
+    serial = 0;
+    inits = 0;
+    newIfs = 0;
+    forceOpens = 0;
+    reinits = 0;
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = myInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = myForceOpen;
+    pMyData->w.new_if = myNewIf;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testRecoverCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A late response is dropped by the first tier without touching the
+ *  interface
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRecoverRetry(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Tier_t tier = CY3240_TIER_COUNT;
+    Cy3240_Tier_Stats_t stats;
+    uint8_t data = 0;
+    uint8_t expected;
+
+    // The response arrives after the read gave up
+    delayReads = 1;
+
+    result = readByte(&data);
+
+    assertTrue("The read should fail",
+            CY3240_FAILURE(result)
+            );
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_REBUILD,
+            &tier);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("Dropping the late response should be enough",
+            CY3240_TIER_RETRY,
+            tier
+            );
+
+    assertTrue("The interface should not have been touched",
+            (reinits == 0) && (forceOpens == 1) && (inits == 1)
+            );
+
+    // The next read gets its own response
+    expected = serial;
+    result = readByte(&data);
+
+    assertTrue("The read should return the fresh response",
+            CY3240_SUCCESS(result) && (data == expected)
+            );
+
+    cy3240_get_recovery_stats(handle, CY3240_TIER_RETRY, &stats);
+
+    assertTrue("The tier should have been timed",
+            (stats.attempts == 1) &&
+            (stats.successes == 1) &&
+            (stats.total_us == stats.last_us) &&
+            (stats.max_us == stats.last_us)
+            );
+
+    cy3240_get_recovery_stats(handle, CY3240_TIER_REINIT, &stats);
+
+    assertEquals("The reinit tier should not have been tried",
+            0,
+            stats.attempts
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  The tiers are escalated until the bridge answers
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRecoverEscalate(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Tier_t tier = CY3240_TIER_COUNT;
+    Cy3240_Tier_Stats_t stats;
+    uint8_t data = 0;
+
+    // The bridge needs a reinit
+    wedge = WEDGE_REINIT;
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_REBUILD,
+            &tier);
+
+    assertTrue("The reinit should recover the bridge",
+            CY3240_SUCCESS(result) &&
+            (tier == CY3240_TIER_REINIT) &&
+            (reinits == 1) &&
+            (forceOpens == 1)
+            );
+
+    // The interface has to be claimed again
+    wedge = WEDGE_RECLAIM;
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_REBUILD,
+            &tier);
+
+    assertTrue("Claiming the interface should recover the bridge",
+            CY3240_SUCCESS(result) &&
+            (tier == CY3240_TIER_RECLAIM) &&
+            (forceOpens == 2) &&
+            (inits == 1) &&
+            (newIfs == 1)
+            );
+
+    // Only a rebuild helps, but it is not allowed
+    wedge = WEDGE_REBUILD;
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_RECLAIM,
+            &tier);
+
+    assertTrue("The recovery should fail below the rebuild tier",
+            CY3240_FAILURE(result) &&
+            (inits == 1)
+            );
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_REBUILD,
+            &tier);
+
+    assertTrue("The rebuild should recover the bridge",
+            CY3240_SUCCESS(result) &&
+            (tier == CY3240_TIER_REBUILD) &&
+            (inits == 1) &&
+            (newIfs == 2)
+            );
+
+    assertTrue("The bridge should work again",
+            CY3240_SUCCESS(readByte(&data))
+            );
+
+    cy3240_get_recovery_stats(handle, CY3240_TIER_RETRY, &stats);
+
+    assertTrue("The retry tier should have failed every time",
+            (stats.attempts == 4) && (stats.successes == 0)
+            );
+
+    cy3240_get_recovery_stats(handle, CY3240_TIER_RECLAIM, &stats);
+
+    assertTrue("The reclaim tier should have been tried three times",
+            (stats.attempts == 3) && (stats.successes == 1)
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testRecoverError(
+        void
+        )
+{
+    int handle = myHandle;
+    Cy3240_Tier_Stats_t stats;
+
+    assertEquals("A NULL handle should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_recover(0, CY3240_TIER_RETRY, NULL)
+            );
+
+    assertEquals("An unknown tier should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_recover(handle, CY3240_TIER_COUNT, NULL)
+            );
+
+    assertEquals("An unknown tier should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_get_recovery_stats(handle, CY3240_TIER_COUNT, &stats)
+            );
+
+    assertEquals("A NULL statistics pointer should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_get_recovery_stats(handle, CY3240_TIER_RETRY, NULL)
+            );
+
+    assertEquals("The first tier should be enough for a healthy bridge",
+            CY3240_ERROR_OK,
+            cy3240_recover(handle, CY3240_TIER_RETRY, NULL)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A rebuild that cannot create an interface leaves the handle failing
+ *  every transfer until a later rebuild succeeds
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRecoverUnusable(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Tier_t tier = CY3240_TIER_COUNT;
+    uint8_t data = 0;
+    int writes;
+
+    wedge = WEDGE_REBUILD;
+    newIfFailures = 1;
+
+    result = cy3240_reattach(handle);
+
+    assertEquals("The rebuild should fail without an interface",
+            CY3240_ERROR_HID,
+            result
+            );
+
+    writes = serial;
+
+    assertTrue("Transfers should fail without touching the bridge",
+            (readByte(&data) == CY3240_ERROR_HID) &&
+            (serial == writes) &&
+            (reinits == 0)
+            );
+
+    result = cy3240_recover(
+            handle,
+            CY3240_TIER_RECLAIM,
+            &tier);
+
+    assertTrue("The cheaper tiers cannot give the handle an interface",
+            CY3240_FAILURE(result) &&
+            (forceOpens == 1)
+            );
+
+    result = cy3240_reattach(handle);
+
+    assertTrue("A later rebuild should recover the handle",
+            CY3240_SUCCESS(result) &&
+            (newIfs == 3) &&
+            (inits == 1) &&
+            CY3240_SUCCESS(readByte(&data))
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,294 @@
+/**
+ * @file ringTest
+ *
+ * @brief CY3240 single producer single consumer ring tests
+ *
+ * CY3240 ring tests for the empty and full conditions, index wrap around
+ * and sleeping on an empty ring
+ *
+ * @ingroup Ring
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "unittest.h"
+#include "cy3240_ring.h"
+#include "ringTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define RING_CAPACITY   (4)
+#define WAIT_MS         (20)
+#define PRODUCE_US      (5000)
+#define LONG_WAIT_MS    (2000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// The ring under test, holding uint32_t elements
+static Cy3240_Ring_t* pRing;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Producer thread, pushes one element after a delay and wakes the consumer
+ *
+ *  @param arg [in] unused
+ *  @returns NULL
+ */
+//-----------------------------------------------------------------------------
+static void*
+producer(
+        void* arg
+        )
+{
+    const uint32_t value = 0xC0FFEE;
+
+    usleep(PRODUCE_US);
+
+    cy3240_ring_push(pRing, &value);
+    cy3240_ring_wake(pRing);
+
+    return NULL;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testRingSetup(
+        void
+        )
+{
+    pRing = (Cy3240_Ring_t*)malloc(cy3240_ring_size(RING_CAPACITY, sizeof(uint32_t)));
+
+    assertTrue("The ring should be allocated",
+            pRing != NULL
+            );
+
+    cy3240_ring_init(pRing, RING_CAPACITY, sizeof(uint32_t));
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testRingCleanup(
+        void
+        )
+{
+    free(pRing);
+    pRing = NULL;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Capacities must be powers of two and elements must have a size
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRingInit(
+        void
+        )
+{
+    assertEquals("A capacity of 0 should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_ring_init(pRing, 0, sizeof(uint32_t))
+            );
+
+    assertEquals("A capacity of 3 should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_ring_init(pRing, 3, sizeof(uint32_t))
+            );
+
+    assertEquals("An element size of 0 should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_ring_init(pRing, RING_CAPACITY, 0)
+            );
+
+    assertTrue("The size should cover the elements",
+            cy3240_ring_size(RING_CAPACITY, sizeof(uint32_t)) >=
+            sizeof(Cy3240_Ring_t) + RING_CAPACITY * sizeof(uint32_t)
+            );
+
+    assertEquals("A capacity of 4 should be accepted",
+            CY3240_ERROR_OK,
+            cy3240_ring_init(pRing, RING_CAPACITY, sizeof(uint32_t))
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  An empty ring has nothing to pop and a full ring refuses a push
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRingFullEmpty(
+        void
+        )
+{
+    uint32_t value = 0;
+    uint32_t x;
+
+    assertTrue("An empty ring should have nothing to pop",
+            !cy3240_ring_pop(pRing, &value) &&
+            (cy3240_ring_count(pRing) == 0)
+            );
+
+    for (x = 0; x < RING_CAPACITY; x++)
+        assertTrue("The ring should take as many elements as its capacity",
+                cy3240_ring_push(pRing, &x)
+                );
+
+    value = RING_CAPACITY;
+
+    assertTrue("A full ring should refuse a push",
+            !cy3240_ring_push(pRing, &value) &&
+            (cy3240_ring_count(pRing) == RING_CAPACITY)
+            );
+
+    for (x = 0; x < RING_CAPACITY; x++)
+        assertTrue("The elements should come out in order",
+                cy3240_ring_pop(pRing, &value) &&
+                (value == x)
+                );
+
+    assertTrue("The ring should be empty again",
+            !cy3240_ring_pop(pRing, &value) &&
+            (cy3240_ring_count(pRing) == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  The slots are reused once the indexes pass the capacity and the 32 bit
+ *  indexes keep working when they overflow
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRingWrap(
+        void
+        )
+{
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    uint32_t value;
+    int round;
+    int x;
+
+    // Start just before the indexes overflow
+    pRing->head = UINT32_MAX - 5;
+    pRing->tail = UINT32_MAX - 5;
+
+    for (round = 0; round < 8; round++) {
+
+        for (x = 0; x < RING_CAPACITY - 1; x++) {
+            cy3240_ring_push(pRing, &pushed);
+            pushed++;
+        }
+
+        assertEquals("The count should hold across the wrap",
+                RING_CAPACITY - 1,
+                cy3240_ring_count(pRing)
+                );
+
+        for (x = 0; x < RING_CAPACITY - 1; x++) {
+
+            assertTrue("Every element should come out once and in order",
+                    cy3240_ring_pop(pRing, &value) &&
+                    (value == popped)
+                    );
+
+            popped++;
+        }
+    }
+
+    assertTrue("The indexes should have overflowed",
+            pRing->head < RING_CAPACITY * 8
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A wait on an empty ring times out, and a push followed by a wake ends
+ *  the wait early
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testRingWait(
+        void
+        )
+{
+    uint32_t value = 0;
+    uint64_t start;
+    uint64_t elapsed;
+    pthread_t thread;
+    bool woken;
+
+    start = cy3240_util_time_us();
+
+    assertTrue("A wait on an empty ring should report it empty",
+            !cy3240_ring_wait(pRing, WAIT_MS)
+            );
+
+    elapsed = cy3240_util_time_us() - start;
+
+    assertTrue("The wait should last about the timeout",
+            elapsed >= (WAIT_MS * 1000) / 2
+            );
+
+    pthread_create(&thread, NULL, producer, NULL);
+
+    start = cy3240_util_time_us();
+    woken = cy3240_ring_wait(pRing, LONG_WAIT_MS);
+    elapsed = cy3240_util_time_us() - start;
+
+    pthread_join(thread, NULL);
+
+    assertTrue("The wake should end the wait long before the timeout",
+            woken &&
+            (elapsed < (LONG_WAIT_MS * 1000) / 2)
+            );
+
+    assertTrue("The pushed element should be there",
+            cy3240_ring_pop(pRing, &value) &&
+            (value == 0xC0FFEE)
+            );
+
+    cy3240_ring_push(pRing, &value);
+
+    assertTrue("A wait on a ring with elements should return at once",
+            cy3240_ring_wait(pRing, LONG_WAIT_MS)
+            );
+}
+
+//@} End of Methods
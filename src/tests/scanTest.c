@@ -0,0 +1,428 @@
+/**
+ * @file scanTest
+ *
+ * @brief CY3240 transfer and scan tests
+ *
+ * CY3240 transfer and scan tests
+ *
+ * @ingroup Scan
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include "unittest.h"
+#include "cy3240_scan.h"
+#include "scanTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define QUEUE_SIZE      (64)
+#define PRESENT_FIRST   (0x10)
+#define PRESENT_SECOND  (0x50)
+#define PRESENT_LAST    (0x77)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Packets written but not answered yet, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][2];
+static int queueHead;
+static int queueTail;
+
+// Most packets in flight at the same time
+static int maxOutstanding;
+
+// A clock packet was sent while other packets were in flight
+static bool clockWhileBusy;
+
+// Number of probes of reserved addresses
+static int reservedProbes;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, queues the packet for myRead
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    uint8_t control = bytes[INPUT_PACKET_INDEX_CMD];
+    uint8_t address = bytes[INPUT_PACKET_INDEX_ADDRESS];
+
+    if ((control & CONTROL_BYTE_RECONFIG) && (queueHead != queueTail))
+        clockWhileBusy = true;
+
+    if ((address != CONTROL_I2C_ADDRESS) &&
+        ((address < CY3240_SCAN_FIRST) || (address > CY3240_SCAN_LAST)))
+        reservedProbes++;
+
+    queue[queueHead % QUEUE_SIZE][0] = control;
+    queue[queueHead % QUEUE_SIZE][1] = address;
+    queueHead++;
+
+    if ((queueHead - queueTail) > maxOutstanding)
+        maxOutstanding = queueHead - queueTail;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, answers the oldest queued packet.
+ *  Only the PRESENT_* slaves acknowledge, reads return the slave address.
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    uint8_t control;
+    uint8_t address;
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    control = queue[queueTail % QUEUE_SIZE][0];
+    address = queue[queueTail % QUEUE_SIZE][1];
+    queueTail++;
+
+    memset(bytes, 0x00, size);
+    bytes[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if ((address == CONTROL_I2C_ADDRESS) ||
+        (address == PRESENT_FIRST) ||
+        (address == PRESENT_SECOND) ||
+        (address == PRESENT_LAST)) {
+
+        bytes[OUTPUT_PACKET_INDEX_STATUS] |= STATUS_BYTE_ACK;
+
+        if (control & CONTROL_BYTE_I2C_READ)
+            memset(&bytes[OUTPUT_PACKET_INDEX_DATA], address, size - OUTPUT_PACKET_INDEX_DATA);
+        else
+            memset(&bytes[OUTPUT_PACKET_INDEX_DATA], TX_ACK, size - OUTPUT_PACKET_INDEX_DATA);
+    }
+
+    return HID_RET_SUCCESS;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testScanSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    queueHead = 0;
+    queueTail = 0;
+    maxOutstanding = 0;
+    clockWhileBusy = false;
+    reservedProbes = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__100kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testScanCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testScanError(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t data[CY3240_MAX_READ_BYTES + 1];
+    Cy3240_Op_t op = {CY3240_OP_READ, MY_ADDRESS, data, sizeof(data), CY3240_ERROR_OK};
+
+    result = cy3240_scan(
+            handle,
+            NULL
+            );
+
+    assertEquals("Scan with NULL bitmap should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_transfer(
+            handle,
+            &op,
+            1
+            );
+
+    assertEquals("Operations larger than one packet should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    assertEquals("Nothing should be sent for invalid operations",
+            0,
+            queueHead);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScanPresent(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t bitmap[CY3240_SCAN_BITMAP_SIZE];
+    Cy3240_Stats_t stats;
+    int address;
+
+    result = cy3240_scan(
+            handle,
+            bitmap
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    for (address = 0; address < CY3240_SLAVE_COUNT; address++) {
+
+        bool expected = (address == PRESENT_FIRST) ||
+                        (address == PRESENT_SECOND) ||
+                        (address == PRESENT_LAST);
+
+        assertEquals("Only the acknowledging slaves should be marked present",
+                expected,
+                CY3240_SCAN_PRESENT(bitmap, address)
+                );
+    }
+
+    assertEquals("Every address in range should be probed once",
+            CY3240_SCAN_LAST - CY3240_SCAN_FIRST + 1,
+            queueHead
+            );
+
+    assertEquals("Reserved addresses should not be probed",
+            0,
+            reservedProbes
+            );
+
+    assertEquals("The pipeline should be kept full",
+            CY3240_PIPELINE_DEPTH_DEFAULT,
+            maxOutstanding
+            );
+
+    cy3240_get_stats(handle, &stats);
+
+    assertTrue("The missing slaves should be address NAKs and not errors",
+            (stats.retry.naks[CY3240_NAK_ADDRESS] == CY3240_SCAN_LAST - CY3240_SCAN_FIRST + 1 - 3) &&
+            (stats.retry.naks[CY3240_NAK_DATA] == 0) &&
+            (stats.traffic.writes == 3) &&
+            (stats.traffic.errors == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScanSlaveClock(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t bitmap[CY3240_SCAN_BITMAP_SIZE];
+
+    // One slave needs a different clock in the middle of the scan
+    result = cy3240_set_slave_clock(
+            handle,
+            PRESENT_SECOND,
+            CY3240_CLOCK__400kHz
+            );
+
+    result = cy3240_scan(
+            handle,
+            bitmap
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The slave with a clock profile should be found",
+            CY3240_SCAN_PRESENT(bitmap, PRESENT_SECOND)
+            );
+
+    assertTrue("The slave after the clock switch should be found",
+            CY3240_SCAN_PRESENT(bitmap, PRESENT_LAST)
+            );
+
+    assertTrue("The pipeline should be drained before a clock switch",
+            !clockWhileBusy
+            );
+
+    assertEquals("The clock should be switched there and back",
+            (CY3240_SCAN_LAST - CY3240_SCAN_FIRST + 1) + 2,
+            queueHead
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testTransferReadWrite(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t out[4] = {0x01, 0x02, 0x03, 0x04};
+    uint8_t in[8];
+    Cy3240_Stats_t stats;
+    Cy3240_Op_t ops[3] = {
+        {CY3240_OP_WRITE, PRESENT_FIRST, out, sizeof(out), CY3240_ERROR_UNKNOWN},
+        {CY3240_OP_READ, PRESENT_FIRST, in, sizeof(in), CY3240_ERROR_UNKNOWN},
+        {CY3240_OP_WRITE, PRESENT_FIRST + 1, out, sizeof(out), CY3240_ERROR_UNKNOWN}
+    };
+
+    memset(in, 0x00, sizeof(in));
+
+    result = cy3240_transfer(
+            handle,
+            ops,
+            3
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The write should be acknowledged",
+            CY3240_ERROR_OK,
+            ops[0].result
+            );
+
+    assertEquals("The read should succeed",
+            CY3240_ERROR_OK,
+            ops[1].result
+            );
+
+    assertEquals("The read data should be copied out",
+            PRESENT_FIRST,
+            in[sizeof(in) - 1]
+            );
+
+    assertEquals("The write to a missing slave should be a NAK",
+            CY3240_ERROR_TX,
+            ops[2].result
+            );
+
+    assertEquals("All operations should be in flight together",
+            3,
+            maxOutstanding
+            );
+
+    cy3240_get_stats(handle, &stats);
+
+    assertTrue("The NAK of the write should be counted as an error",
+            (stats.retry.naks[CY3240_NAK_ADDRESS] == 1) &&
+            (stats.traffic.writes == 1) &&
+            (stats.traffic.reads == 1) &&
+            (stats.traffic.errors == 1)
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,657 @@
+/**
+ * @file schedulerTest
+ *
+ * @brief CY3240 periodic sampling scheduler tests
+ *
+ * CY3240 scheduler tests against a bridge whose slaves answer every read
+ * with the register and address they were asked for, so each sample shows
+ * which job produced it
+ *
+ * @ingroup Scheduler
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <unistd.h>
+#include "unittest.h"
+#include "cy3240_scheduler.h"
+#include "schedulerTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define LAX_ADDRESS     (0x40)
+#define URGENT_ADDRESS  (0x41)
+#define LAX_REG         (0x01)
+#define URGENT_REG      (0x02)
+#define SAMPLE_LENGTH   (4)
+#define STATIC_TIMEOUT  (1000)
+#define QUEUE_SIZE      (64)
+#define MAX_SAMPLES     (16)
+#define POLL_TIMEOUT_US (1000000)
+#define SLOW_US         (30000)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+// Register pointer of every slave
+static uint8_t pointer[CY3240_SLAVE_COUNT];
+
+// Time the bridge takes to answer a packet
+static unsigned int responseUs;
+
+// Responses of the slow second bridge, which only acknowledges
+static uint8_t slowQueue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int slowHead;
+static int slowTail;
+
+// The scheduler under test
+static Cy3240_Scheduler_t* pScheduler;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write. A write sets the register pointer
+ *  of the slave, a read returns the pointer xor the address in every byte.
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t cmd = (uint8_t)bytes[INPUT_PACKET_INDEX_CMD];
+    const uint8_t address = (uint8_t)bytes[INPUT_PACKET_INDEX_ADDRESS] & 0x7F;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+
+    memset(pResponse, TX_ACK, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if (cmd & CONTROL_BYTE_I2C_READ)
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA],
+               pointer[address] ^ address,
+               RECV_PACKET_LEN - 1);
+
+    else if (!(cmd & (CONTROL_BYTE_RECONFIG | CONTROL_BYTE_REINIT)))
+        pointer[address] = (uint8_t)bytes[INPUT_PACKET_INDEX_ADDRESS + 1];
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, the response takes responseUs
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    if (responseUs != 0)
+        usleep(responseUs);
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write of the slow second bridge
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+mySlowWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    uint8_t* const pResponse = slowQueue[slowHead++ % QUEUE_SIZE];
+
+    memset(pResponse, TX_ACK, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read of the slow second bridge, the
+ *  response takes SLOW_US
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+mySlowRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    if (slowHead == slowTail)
+        return HID_RET_TIMEOUT;
+
+    usleep(SLOW_US);
+
+    memcpy(bytes, slowQueue[slowTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to add a job reading SAMPLE_LENGTH bytes
+ *
+ *  @param address     [in] the slave
+ *  @param reg         [in] the register
+ *  @param period_us   [in] the period
+ *  @param deadline_us [in] the relative deadline, 0 for the period
+ *  @returns the job id
+ */
+//-----------------------------------------------------------------------------
+static int
+addJob(
+        uint8_t address,
+        uint8_t reg,
+        uint32_t period_us,
+        uint32_t deadline_us
+        )
+{
+    Cy3240_Job_t job;
+    int id = -1;
+
+    memset(&job, 0x00, sizeof(job));
+    job.handle = myHandle;
+    job.address = address;
+    job.reg = reg;
+    job.length = SAMPLE_LENGTH;
+    job.period_us = period_us;
+    job.deadline_us = deadline_us;
+
+    cy3240_scheduler_add_job(pScheduler, &job, &id);
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to collect samples from the running scheduler
+ *
+ *  @param pSamples [out] the samples
+ *  @param count    [in] the number of samples to wait for
+ *  @returns the number of samples collected
+ */
+//-----------------------------------------------------------------------------
+static int
+collect(
+        Cy3240_Sample_t* const pSamples,
+        int count
+        )
+{
+    const uint64_t deadline = cy3240_util_time_us() + POLL_TIMEOUT_US;
+    int got = 0;
+
+    while ((got < count) && (cy3240_util_time_us() < deadline)) {
+
+        if (cy3240_scheduler_poll(pScheduler, &pSamples[got]))
+            got++;
+        else
+            usleep(100);
+    }
+
+    return got;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to check a sample carries the register of its slave
+ *
+ *  @param pSample [in] the sample
+ *  @param address [in] the slave
+ *  @param reg     [in] the register
+ *  @returns true if the sample is valid
+ */
+//-----------------------------------------------------------------------------
+static bool
+sampleValid(
+        const Cy3240_Sample_t* const pSample,
+        uint8_t address,
+        uint8_t reg
+        )
+{
+    int x;
+
+    if (CY3240_FAILURE(pSample->result) ||
+        (pSample->length != SAMPLE_LENGTH))
+        return false;
+
+    for (x = 0; x < SAMPLE_LENGTH; x++)
+        if (pSample->data[x] != (reg ^ address))
+            return false;
+
+    return true;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testSchedulerSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    queueHead = 0;
+    queueTail = 0;
+    slowHead = 0;
+    slowTail = 0;
+    responseUs = 0;
+    memset(pointer, 0x00, sizeof(pointer));
+    pScheduler = NULL;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            STATIC_TIMEOUT,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testSchedulerCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    if (pScheduler != NULL)
+        cy3240_scheduler_destroy(pScheduler);
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Invalid queues and jobs are refused, jobs can only be added while the
+ *  scheduler is stopped
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testSchedulerInvalid(
+        void
+        )
+{
+    Cy3240_Scheduler_t* pOther = NULL;
+    Cy3240_Job_t job;
+
+    assertEquals("A queue of 3 samples should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_scheduler_create(&pOther, 3)
+            );
+
+    cy3240_scheduler_create(&pScheduler, 4);
+
+    memset(&job, 0x00, sizeof(job));
+    job.handle = myHandle;
+    job.address = LAX_ADDRESS;
+    job.period_us = 1000;
+
+    assertEquals("A job without a length should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_scheduler_add_job(pScheduler, &job, NULL)
+            );
+
+    job.length = CY3240_SCHEDULER_MAX_SAMPLE + 1;
+
+    assertEquals("A job longer than a read packet should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_scheduler_add_job(pScheduler, &job, NULL)
+            );
+
+    job.length = SAMPLE_LENGTH;
+    job.period_us = 0;
+
+    assertEquals("A job without a period should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_scheduler_add_job(pScheduler, &job, NULL)
+            );
+
+    job.period_us = 100000;
+
+    assertEquals("A valid job should be accepted",
+            CY3240_ERROR_OK,
+            cy3240_scheduler_add_job(pScheduler, &job, NULL)
+            );
+
+    cy3240_scheduler_start(pScheduler);
+
+    assertEquals("A job should be refused while running",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_scheduler_add_job(pScheduler, &job, NULL)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Jobs released together run earliest deadline first, and every job is
+ *  released again one period later
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testSchedulerDeadline(
+        void
+        )
+{
+    Cy3240_Sample_t samples[4];
+    int lax;
+    int urgent;
+    int x;
+
+    cy3240_scheduler_create(&pScheduler, 16);
+
+    // Added first, but with the later deadline
+    lax = addJob(LAX_ADDRESS, LAX_REG, 20000, 0);
+    urgent = addJob(URGENT_ADDRESS, URGENT_REG, 20000, 2000);
+
+    cy3240_scheduler_start(pScheduler);
+
+    assertEquals("Two releases of both jobs should arrive",
+            4,
+            collect(samples, 4)
+            );
+
+    cy3240_scheduler_stop(pScheduler);
+
+    for (x = 0; x < 4; x += 2) {
+
+        assertTrue("The urgent job should run first in every release",
+                (samples[x].job == urgent) &&
+                (samples[x + 1].job == lax)
+                );
+
+        assertTrue("Every sample should carry the register of its job",
+                sampleValid(&samples[x], URGENT_ADDRESS, URGENT_REG) &&
+                sampleValid(&samples[x + 1], LAX_ADDRESS, LAX_REG)
+                );
+    }
+
+    assertTrue("Both jobs should be released together",
+            samples[0].release_us == samples[1].release_us
+            );
+
+    assertTrue("The next release should be one period later",
+            (samples[2].release_us - samples[0].release_us == 20000) &&
+            (samples[3].release_us - samples[1].release_us == 20000)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  A job that takes longer than its period misses its deadline and skips
+ *  releases instead of running back to back to catch up
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testSchedulerOverrun(
+        void
+        )
+{
+    Cy3240_Sample_t samples[MAX_SAMPLES];
+    Cy3240_Job_Stats_t stats;
+    const uint32_t period = 2000;
+    int job;
+    int got;
+    int x;
+
+    cy3240_scheduler_create(&pScheduler, 16);
+
+    job = addJob(LAX_ADDRESS, LAX_REG, period, 0);
+
+    // A register write and a read take 6 ms, three periods
+    responseUs = 3000;
+
+    cy3240_scheduler_start(pScheduler);
+
+    got = collect(samples, 6);
+
+    cy3240_scheduler_stop(pScheduler);
+    cy3240_scheduler_get_stats(pScheduler, job, &stats);
+
+    assertEquals("The overrunning job should still produce samples",
+            6,
+            got
+            );
+
+    assertTrue("Every run should miss its deadline and skip releases",
+            (stats.misses >= (uint64_t)got) &&
+            (stats.skipped >= (uint64_t)got)
+            );
+
+    for (x = 1; x < got; x++)
+        assertTrue("A release should be a whole number of periods after the last and not more than a period in the past",
+                ((samples[x].release_us - samples[x - 1].release_us) % period == 0) &&
+                (samples[x].release_us + period > samples[x - 1].complete_us)
+                );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Samples nobody takes are dropped once the queue is full and the oldest
+ *  samples are kept
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testSchedulerQueueFull(
+        void
+        )
+{
+    Cy3240_Sample_t first;
+    Cy3240_Sample_t second;
+    Cy3240_Sample_t extra;
+    Cy3240_Job_Stats_t stats;
+    int job;
+
+    cy3240_scheduler_create(&pScheduler, 2);
+
+    job = addJob(URGENT_ADDRESS, URGENT_REG, 1000, 0);
+
+    cy3240_scheduler_start(pScheduler);
+
+    usleep(30000);
+
+    cy3240_scheduler_stop(pScheduler);
+    cy3240_scheduler_get_stats(pScheduler, job, &stats);
+
+    assertTrue("Runs beyond the queue capacity should be dropped",
+            (stats.dropped > 0) &&
+            (stats.runs == stats.dropped + 2)
+            );
+
+    assertTrue("The queue should hold the two oldest samples",
+            cy3240_scheduler_poll(pScheduler, &first) &&
+            cy3240_scheduler_poll(pScheduler, &second) &&
+            !cy3240_scheduler_poll(pScheduler, &extra)
+            );
+
+    assertTrue("The kept samples should be valid and in order",
+            sampleValid(&first, URGENT_ADDRESS, URGENT_REG) &&
+            sampleValid(&second, URGENT_ADDRESS, URGENT_REG) &&
+            (second.release_us > first.release_us) &&
+            ((second.release_us - first.release_us) % 1000 == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Every bridge has a worker of its own, a slow bridge does not delay the
+ *  jobs of another
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testSchedulerBridges(
+        void
+        )
+{
+    Cy3240_Job_Stats_t stats;
+    Cy3240_Job_Stats_t slowStats;
+    Cy3240_Job_t job;
+    Cy3240_t* pCy3240;
+    int second = 0;
+    int fast;
+    int slow = -1;
+
+    assertEquals("The second usb device should be successfully created",
+            CY3240_ERROR_OK,
+            cy3240_factory(
+                    &second,
+                    0,
+                    STATIC_TIMEOUT,
+                    CY3240_POWER_5V,
+                    CY3240_BUS_I2C,
+                    CY3240_CLOCK__400kHz)
+            );
+
+    pCy3240 = cy3240_handle_get(second);
+    cy3240_handle_put(second);
+
+    pCy3240->w.init = testGenericInit;
+    pCy3240->w.close = testGenericClose;
+    pCy3240->w.write = mySlowWrite;
+    pCy3240->w.read = mySlowRead;
+    pCy3240->w.cleanup = testGenericCleanup;
+    pCy3240->w.delete_if = testGenericDeleteIf;
+    pCy3240->w.force_open = testGenericForceOpen;
+    pCy3240->w.new_if = testGenericNewHidInterface;
+
+    assertEquals("The second bridge should open",
+            CY3240_ERROR_OK,
+            cy3240_open(second)
+            );
+
+    cy3240_scheduler_create(&pScheduler, QUEUE_SIZE);
+
+    fast = addJob(URGENT_ADDRESS, URGENT_REG, 5000, 0);
+
+    memset(&job, 0x00, sizeof(job));
+    job.handle = second;
+    job.address = LAX_ADDRESS;
+    job.reg = LAX_REG;
+    job.length = SAMPLE_LENGTH;
+    job.period_us = 5000;
+
+    cy3240_scheduler_add_job(pScheduler, &job, &slow);
+
+    cy3240_scheduler_start(pScheduler);
+
+    // The slow job takes two responses of SLOW_US for every run
+    usleep(4 * SLOW_US);
+
+    cy3240_scheduler_stop(pScheduler);
+    cy3240_scheduler_get_stats(pScheduler, fast, &stats);
+    cy3240_scheduler_get_stats(pScheduler, slow, &slowStats);
+
+    cy3240_close(second);
+
+    assertTrue("The slow bridge should have run its job",
+            (slowStats.runs >= 1) && (slowStats.errors == 0)
+            );
+
+    assertTrue("The fast bridge should keep its period meanwhile",
+            (stats.runs >= 10) && (stats.errors == 0)
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,131 @@
+/** AceUnit test header file for fixture schedulerTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file schedulerTest.h
+ */
+
+#ifndef _SCHEDULERTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _SCHEDULERTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 96
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testSchedulerInvalid(void);
+A_Test void testSchedulerDeadline(void);
+A_Test void testSchedulerOverrun(void);
+A_Test void testSchedulerQueueFull(void);
+A_Test void testSchedulerBridges(void);
+A_Before void testSchedulerSetup(void);
+A_After void testSchedulerCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    97, /* testSchedulerInvalid */
+    98, /* testSchedulerDeadline */
+    99, /* testSchedulerOverrun */
+    100, /* testSchedulerQueueFull */
+    112, /* testSchedulerBridges */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testSchedulerInvalid",
+    "testSchedulerDeadline",
+    "testSchedulerOverrun",
+    "testSchedulerQueueFull",
+    "testSchedulerBridges",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testSchedulerInvalid,
+    testSchedulerDeadline,
+    testSchedulerOverrun,
+    testSchedulerQueueFull,
+    testSchedulerBridges,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testSchedulerSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testSchedulerCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t schedulerTestFixture = {
+    96,
+#ifndef ACEUNIT_EMBEDDED
+    "schedulerTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _SCHEDULERTEST_H */
@@ -0,0 +1,586 @@
+/**
+ * @file scriptTest
+ *
+ * @brief CY3240 .iic script engine tests
+ *
+ * CY3240 .iic script engine tests against a simulated register slave
+ *
+ * @ingroup Script
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "unittest.h"
+#include "cy3240_script.h"
+#include "scriptTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SLAVE_ADDRESS   (0x21)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Registers of the slave and the register pointer
+static uint8_t registers[256];
+static uint8_t pointer;
+
+// Packets in flight and packets sent
+static int maxOutstanding;
+static int writes;
+
+// The slave stops answering
+static bool absent;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+static const char* const program =
+    "; Program three registers and read them back\n"
+    "w 21 10 AA BB CC p\n"
+    "\n"
+    "  s w 21 10 r 21 x x*2 p   ; pointer then read\n"
+    "[delay=1]\n"
+    "w 21 p\n"
+    "r 21 x p\n";
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, runs the packet against the
+ *  simulated slave and queues the response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t* const pPacket = (const uint8_t*)bytes;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    uint8_t length = pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS;
+    int x;
+
+    writes++;
+
+    if ((queueHead - queueTail) > maxOutstanding)
+        maxOutstanding = queueHead - queueTail;
+
+    memset(pResponse, 0x00, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    // Nobody else answers
+    if (absent || (pPacket[INPUT_PACKET_INDEX_ADDRESS] != SLAVE_ADDRESS))
+        return HID_RET_SUCCESS;
+
+    if (pPacket[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ) {
+
+        for (x = 0; x < length; x++)
+            pResponse[OUTPUT_PACKET_INDEX_DATA + x] = registers[pointer++];
+
+        return HID_RET_SUCCESS;
+    }
+
+    // The first byte written sets the pointer
+    for (x = 0; x < length; x++) {
+
+        if (x == 0)
+            pointer = pPacket[INPUT_PACKET_INDEX_ADDRESS + 1];
+
+        else
+            registers[pointer++] = pPacket[INPUT_PACKET_INDEX_ADDRESS + 1 + x];
+    }
+
+    memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, returns the oldest response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Method to compile a script that is expected to fail
+ *
+ *  @param pText [in] the script
+ *  @returns the line of the error
+ */
+//-----------------------------------------------------------------------------
+static int
+errorLine(
+        const char* pText
+        )
+{
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Error_t result;
+    int line = 0;
+
+    result = cy3240_script_compile(&pScript, pText, &line);
+
+    assertEquals("A syntax error should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    return line;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testScriptSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    memset(registers, 0x00, sizeof(registers));
+    pointer = 0;
+    maxOutstanding = 0;
+    writes = 0;
+    absent = false;
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+
+    writes = 0;
+    maxOutstanding = 0;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testScriptCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptError(
+        void
+        )
+{
+    assertEquals("An address above 7 bits should be rejected",
+            2,
+            errorLine("w 21 00\nw 80 00\n")
+            );
+
+    assertEquals("A read without bytes should be rejected",
+            1,
+            errorLine("r 21 p")
+            );
+
+    assertEquals("A byte that is not hexadecimal should be rejected",
+            3,
+            errorLine("; comment\n\nw 21 zz p\n")
+            );
+
+    assertEquals("A delay inside a transaction should be rejected",
+            1,
+            errorLine("w 21 00 [delay=5]")
+            );
+
+    assertEquals("A read larger than a packet should be rejected",
+            1,
+            errorLine("r 21 x*62 p")
+            );
+
+    assertEquals("A missing address should be rejected",
+            1,
+            errorLine("w")
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptRun(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+    uint32_t count = 0;
+    int line = -1;
+
+    result = cy3240_script_compile(&pScript, program, &line);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("No error line should be reported",
+            0,
+            line
+            );
+
+    cy3240_script_get_step_count(pScript, &count);
+
+    assertEquals("Every line with bus commands should be a step",
+            4,
+            count
+            );
+
+    result = cy3240_script_run(pScript, handle);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("Each command should be one report",
+            5,
+            writes
+            );
+
+    assertEquals("The commands before the delay should be one pipelined transfer",
+            3,
+            maxOutstanding
+            );
+
+    cy3240_script_get_step(pScript, 1, &step);
+
+    assertEquals("The step should know its line",
+            4,
+            step.line
+            );
+
+    assertEquals("The reads of the line should be collected",
+            3,
+            step.read_length
+            );
+
+    assertTrue("The registers should read back",
+            (step.pRead[0] == 0xAA) && (step.pRead[1] == 0xBB) && (step.pRead[2] == 0xCC)
+            );
+
+    assertTrue("The step should be timed",
+            (step.runs == 1) && (step.errors == 0) && (step.total_us == step.last_us)
+            );
+
+    assertTrue("The step should report each command",
+            !step.skipped && (step.op_count == 2) &&
+            (step.pOps[0].type == CY3240_OP_WRITE) && CY3240_SUCCESS(step.pOps[0].result) &&
+            (step.pOps[1].type == CY3240_OP_READ) && (step.pOps[1].length == 3)
+            );
+
+    // A second run sends the same reports again
+    registers[0x13] = 0x5A;
+    result = cy3240_script_run(pScript, handle);
+    cy3240_script_get_step(pScript, 3, &step);
+
+    assertTrue("The last step should read on from the pointer",
+            CY3240_SUCCESS(result) && (step.pRead[0] == 0x5A) && (step.runs == 2)
+            );
+
+    cy3240_script_destroy(pScript);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptNak(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+
+    result = cy3240_script_compile(
+            &pScript,
+            "w 21 00 11 p\nw 22 00 p\n[delay=0]\nw 21 00 22 p\n",
+            NULL);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    result = cy3240_script_run(pScript, handle);
+
+    assertEquals("The NAK should fail the script",
+            CY3240_ERROR_TX,
+            result
+            );
+
+    cy3240_script_get_step(pScript, 1, &step);
+
+    assertTrue("The step should record the NAK",
+            (step.result == CY3240_ERROR_TX) && (step.errors == 1)
+            );
+
+    cy3240_script_get_step(pScript, 2, &step);
+
+    assertTrue("The script should stop after the failed transfer",
+            (step.runs == 0) && (registers[0] == 0x11)
+            );
+
+    cy3240_script_destroy(pScript);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptSkipped(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+
+    result = cy3240_script_compile(
+            &pScript,
+            "w 21 00 11 p\n[delay=0]\nr 21 x p\n",
+            NULL);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The first run should result in an OK",
+            CY3240_ERROR_OK,
+            cy3240_script_run(pScript, handle)
+            );
+
+    // The second run fails in the first transfer
+    absent = true;
+
+    assertEquals("The NAK should fail the script",
+            CY3240_ERROR_TX,
+            cy3240_script_run(pScript, handle)
+            );
+
+    cy3240_script_get_step(pScript, 0, &step);
+
+    assertTrue("The failed step should report the NAK of its command",
+            !step.skipped && (step.result == CY3240_ERROR_TX) &&
+            (step.pOps[0].result == CY3240_ERROR_TX)
+            );
+
+    cy3240_script_get_step(pScript, 1, &step);
+
+    assertTrue("The step after the failure should not report the first run",
+            step.skipped && CY3240_SUCCESS(step.result) && (step.runs == 1)
+            );
+
+    cy3240_script_destroy(pScript);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptLong(
+        void
+        )
+{
+    static const char probe[] = "w 21 p\n[delay=0]\n";
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+    uint32_t count = 0;
+    char* pText;
+    int x;
+
+    // The most bus commands a script takes, each in a transfer of its own,
+    // makes one more transfer than a 16 bit count holds
+    pText = (char*)malloc(0xFFFF * (sizeof(probe) - 1) + 1);
+
+    assertTrue("The script text should be allocated",
+            pText != NULL
+            );
+
+    for (x = 0; x < 0xFFFF; x++)
+        memcpy(&pText[x * (sizeof(probe) - 1)], probe, sizeof(probe) - 1);
+
+    pText[0xFFFF * (sizeof(probe) - 1)] = '\0';
+
+    result = cy3240_script_compile(&pScript, pText, NULL);
+    free(pText);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    cy3240_script_get_step_count(pScript, &count);
+
+    assertEquals("Every line with bus commands should be a step",
+            0xFFFF,
+            count
+            );
+
+    result = cy3240_script_run(pScript, handle);
+    cy3240_script_get_step(pScript, count - 1, &step);
+
+    assertTrue("Every transfer should run",
+            CY3240_SUCCESS(result) && !step.skipped && (step.runs == 1) &&
+            (writes == 0xFFFF)
+            );
+
+    cy3240_script_destroy(pScript);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testScriptLoad(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Script_t* pScript = NULL;
+    Cy3240_Script_Step_t step;
+    char path[] = "/tmp/scriptTestXXXXXX";
+    int fd;
+    int x;
+
+    fd = mkstemp(path);
+
+    assertTrue("The script file should be created",
+            (fd >= 0) && (write(fd, program, strlen(program)) == (ssize_t)strlen(program))
+            );
+
+    close(fd);
+
+    result = cy3240_script_load(&pScript, path, NULL);
+    unlink(path);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    for (x = 0; x < 3; x++)
+        cy3240_script_run(pScript, handle);
+
+    cy3240_script_get_step(pScript, 0, &step);
+
+    assertTrue("Every run should be counted",
+            (step.runs == 3) && (step.max_us <= step.total_us)
+            );
+
+    cy3240_script_destroy(pScript);
+
+    result = cy3240_script_load(&pScript, "/nonexistent/script.iic", NULL);
+
+    assertEquals("A missing file should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,137 @@
+/** AceUnit test header file for fixture scriptTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file scriptTest.h
+ */
+
+#ifndef _SCRIPTTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _SCRIPTTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 56
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testScriptError(void);
+A_Test void testScriptRun(void);
+A_Test void testScriptNak(void);
+A_Test void testScriptSkipped(void);
+A_Test void testScriptLong(void);
+A_Test void testScriptLoad(void);
+A_Before void testScriptSetup(void);
+A_After void testScriptCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    57, /* testScriptError */
+    58, /* testScriptRun */
+    59, /* testScriptNak */
+    108, /* testScriptSkipped */
+    110, /* testScriptLong */
+    60, /* testScriptLoad */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testScriptError",
+    "testScriptRun",
+    "testScriptNak",
+    "testScriptSkipped",
+    "testScriptLong",
+    "testScriptLoad",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testScriptError,
+    testScriptRun,
+    testScriptNak,
+    testScriptSkipped,
+    testScriptLong,
+    testScriptLoad,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testScriptSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testScriptCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t scriptTestFixture = {
+    56,
+#ifndef ACEUNIT_EMBEDDED
+    "scriptTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _SCRIPTTEST_H */
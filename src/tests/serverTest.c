@@ -0,0 +1,770 @@
+/**
+ * @file serverTest
+ *
+ * @brief CY3240 bridge sharing tests
+ *
+ * CY3240 server and client tests against a simulated register slave
+ *
+ * @ingroup Server
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "unittest.h"
+#include "cy3240_client.h"
+#include "cy3240_server.h"
+#include "serverTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define SLAVE_ADDRESS   (0x21)
+#define QUEUE_SIZE      (64)
+#define SERIAL          "SERVERTEST"
+#define SERIAL_SECOND   "SERVERTEST2"
+#define CLIENT_THREADS  (4)
+#define CLIENT_ROUNDS   (50)
+#define SHARED_OPS      (300)
+#define SAMPLES         (3)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Registers of the slave and the register pointer
+static uint8_t registers[256];
+static uint8_t pointer;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+// The server, its socket and a client of it
+static Cy3240_Server_t* pServer;
+static Cy3240_Client_t* pClient;
+static char path[64];
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, runs the packet against the
+ *  simulated slave and queues the response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t* const pPacket = (const uint8_t*)bytes;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    uint8_t length = pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS;
+    int x;
+
+    memset(pResponse, 0x00, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    // Nobody else answers
+    if (pPacket[INPUT_PACKET_INDEX_ADDRESS] != SLAVE_ADDRESS)
+        return HID_RET_SUCCESS;
+
+    if (pPacket[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ) {
+
+        for (x = 0; x < length; x++)
+            pResponse[OUTPUT_PACKET_INDEX_DATA + x] = registers[pointer++];
+
+        return HID_RET_SUCCESS;
+    }
+
+    // The first byte written sets the pointer
+    for (x = 0; x < length; x++) {
+
+        if (x == 0)
+            pointer = pPacket[INPUT_PACKET_INDEX_ADDRESS + 1];
+
+        else
+            registers[pointer++] = pPacket[INPUT_PACKET_INDEX_ADDRESS + 1 + x];
+    }
+
+    memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, returns the oldest response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Client thread, writes and reads back its own registers. Asserts cannot
+ *  be used off the test thread, so mismatches are counted instead.
+ *
+ *  @param arg [in] the index of the thread
+ *  @returns the number of failed rounds
+ */
+//-----------------------------------------------------------------------------
+static void*
+clientThread(
+        void* arg
+        )
+{
+    const uint8_t base = (uint8_t)(0x80 + (intptr_t)arg * 0x10);
+    Cy3240_Client_t* pMine = NULL;
+    uintptr_t failures = 0;
+    uint8_t data[3];
+    uint8_t pointerOnly[1];
+    uint8_t readBack[2];
+    Cy3240_Op_t ops[3];
+    int round;
+
+    if CY3240_FAILURE(cy3240_client_open(&pMine, path, SERIAL))
+        return (void*)(uintptr_t)CLIENT_ROUNDS;
+
+    for (round = 0; round < CLIENT_ROUNDS; round++) {
+
+        data[0] = (uint8_t)(base + (round % 8) * 2);
+        data[1] = (uint8_t)round;
+        data[2] = (uint8_t)~round;
+        pointerOnly[0] = data[0];
+
+        memset(ops, 0x00, sizeof(ops));
+        memset(readBack, 0x00, sizeof(readBack));
+
+        ops[0].type = CY3240_OP_WRITE;
+        ops[0].address = SLAVE_ADDRESS;
+        ops[0].pData = data;
+        ops[0].length = sizeof(data);
+
+        ops[1].type = CY3240_OP_WRITE;
+        ops[1].address = SLAVE_ADDRESS;
+        ops[1].pData = pointerOnly;
+        ops[1].length = sizeof(pointerOnly);
+
+        ops[2].type = CY3240_OP_READ;
+        ops[2].address = SLAVE_ADDRESS;
+        ops[2].pData = readBack;
+        ops[2].length = sizeof(readBack);
+
+        if (CY3240_FAILURE(cy3240_client_transfer(pMine, ops, 3)) ||
+            CY3240_FAILURE(ops[2].result) ||
+            memcmp(readBack, &data[1], sizeof(readBack)))
+            failures++;
+    }
+
+    cy3240_client_close(pMine);
+
+    return (void*)failures;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testServerSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    memset(registers, 0x00, sizeof(registers));
+    pointer = 0;
+    queueHead = 0;
+    queueTail = 0;
+    pServer = NULL;
+    pClient = NULL;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+
+    // Share it on a socket of this process
+    snprintf(path, sizeof(path), "/tmp/cy3240_test_%d.sock", (int)getpid());
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_create(&pServer, path);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_add_bridge(pServer, handle, SERIAL);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_start(pServer);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_client_open(&pClient, path, SERIAL);
+
+    assertEquals("The client should connect to the server",
+            CY3240_ERROR_OK,
+            result
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testServerCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    cy3240_client_close(pClient);
+    cy3240_server_destroy(pServer);
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Transfer Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerTransfer(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Client_t* pOther = NULL;
+    uint8_t data[] = { 0x10, 0xAA, 0xBB, 0xCC };
+    uint8_t readBack[3] = { 0 };
+    Cy3240_Op_t ops[4];
+
+    memset(ops, 0x00, sizeof(ops));
+
+    ops[0].type = CY3240_OP_WRITE;
+    ops[0].address = SLAVE_ADDRESS;
+    ops[0].pData = data;
+    ops[0].length = sizeof(data);
+
+    ops[1].type = CY3240_OP_WRITE;
+    ops[1].address = SLAVE_ADDRESS;
+    ops[1].pData = data;
+    ops[1].length = 1;
+
+    ops[2].type = CY3240_OP_READ;
+    ops[2].address = SLAVE_ADDRESS;
+    ops[2].pData = readBack;
+    ops[2].length = sizeof(readBack);
+
+    ops[3].type = CY3240_OP_PROBE;
+    ops[3].address = SLAVE_ADDRESS + 1;
+
+    result = cy3240_client_transfer(pClient, ops, 4);
+
+    assertEquals("The transfer should succeed",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The operations on the slave should succeed",
+            CY3240_SUCCESS(ops[0].result) &&
+            CY3240_SUCCESS(ops[1].result) &&
+            CY3240_SUCCESS(ops[2].result)
+            );
+
+    assertEquals("The missing slave should not acknowledge",
+            CY3240_ERROR_TX,
+            ops[3].result
+            );
+
+    assertTrue("The read should return the written registers",
+            !memcmp(readBack, &data[1], sizeof(readBack))
+            );
+
+    // Malformed operations are refused before they are sent
+    ops[0].length = CY3240_MAX_WRITE_BYTES + 1;
+
+    assertEquals("An oversized write should be refused",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_client_transfer(pClient, ops, 1)
+            );
+
+    assertEquals("A bridge that is not shared should not be found",
+            CY3240_ERROR_HID,
+            cy3240_client_open(&pOther, path, "UNKNOWN")
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Multi Packet Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerMultiPacket(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Stats_t stats;
+    uint8_t data[100];
+    uint8_t start = 0x20;
+    uint16_t length = 1;
+    int x;
+
+    for (x = 0; x < (int)sizeof(data); x++)
+        registers[start + x] = (uint8_t)(x * 3);
+
+    result = cy3240_client_write(pClient, SLAVE_ADDRESS, &start, &length);
+
+    assertEquals("The write should succeed",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    length = sizeof(data);
+    result = cy3240_client_read(pClient, SLAVE_ADDRESS, data, &length);
+
+    assertEquals("The read should succeed",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The read should span two packets",
+            (length == sizeof(data)) && (data[0] == 0) && (data[99] == (uint8_t)(99 * 3))
+            );
+
+    result = cy3240_client_get_stats(pClient, &stats);
+
+    assertEquals("The statistics should be returned",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The statistics should count the traffic of the client",
+            (stats.traffic.writes == 1) &&
+            (stats.traffic.reads == 1) &&
+            (stats.traffic.read_bytes == sizeof(data))
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Concurrent Clients Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerClients(
+        void
+        )
+{
+    pthread_t threads[CLIENT_THREADS];
+    Cy3240_Server_Stats_t stats;
+    uintptr_t failures = 0;
+    intptr_t x;
+
+    for (x = 0; x < CLIENT_THREADS; x++)
+        pthread_create(&threads[x], NULL, clientThread, (void*)x);
+
+    for (x = 0; x < CLIENT_THREADS; x++) {
+
+        void* pFailures = NULL;
+
+        pthread_join(threads[x], &pFailures);
+        failures += (uintptr_t)pFailures;
+    }
+
+    assertEquals("Every client should read back its own registers",
+            0,
+            failures
+            );
+
+    cy3240_server_get_stats(pServer, &stats);
+
+    assertTrue("Every request should be run once",
+            (stats.connections == 1 + CLIENT_THREADS) &&
+            (stats.requests == CLIENT_THREADS * CLIENT_ROUNDS) &&
+            (stats.batches <= stats.requests)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Shared Memory Transfer Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerShared(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    static Cy3240_Op_t ops[SHARED_OPS];
+    static uint8_t data[SHARED_OPS / 3][3];
+    static uint8_t readBack[SHARED_OPS / 3][2];
+    int failures = 0;
+    int x;
+
+    result = cy3240_client_map(pClient, false);
+
+    assertEquals("The client should map the rings",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    // More operations than the rings hold, each write read back
+    memset(ops, 0x00, sizeof(ops));
+    memset(readBack, 0x00, sizeof(readBack));
+
+    for (x = 0; x < SHARED_OPS / 3; x++) {
+
+        Cy3240_Op_t* const pOp = &ops[x * 3];
+
+        data[x][0] = (uint8_t)((x % 64) * 2);
+        data[x][1] = (uint8_t)x;
+        data[x][2] = (uint8_t)(x + 1);
+
+        pOp[0].type = CY3240_OP_WRITE;
+        pOp[0].address = SLAVE_ADDRESS;
+        pOp[0].pData = data[x];
+        pOp[0].length = 3;
+
+        pOp[1].type = CY3240_OP_WRITE;
+        pOp[1].address = SLAVE_ADDRESS;
+        pOp[1].pData = data[x];
+        pOp[1].length = 1;
+
+        pOp[2].type = CY3240_OP_READ;
+        pOp[2].address = SLAVE_ADDRESS;
+        pOp[2].pData = readBack[x];
+        pOp[2].length = 2;
+    }
+
+    ops[SHARED_OPS - 1].type = CY3240_OP_PROBE;
+    ops[SHARED_OPS - 1].address = SLAVE_ADDRESS + 1;
+
+    result = cy3240_client_transfer(pClient, ops, SHARED_OPS);
+
+    assertEquals("The transfer should succeed",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    for (x = 0; x < SHARED_OPS / 3 - 1; x++)
+        if (CY3240_FAILURE(ops[x * 3 + 2].result) ||
+            memcmp(readBack[x], &data[x][1], 2))
+            failures++;
+
+    assertEquals("Every read should return the written registers",
+            0,
+            failures
+            );
+
+    assertEquals("The missing slave should not acknowledge",
+            CY3240_ERROR_TX,
+            ops[SHARED_OPS - 1].result
+            );
+
+    // Writes and reads keep using the socket
+    assertEquals("The socket should still serve the client",
+            CY3240_ERROR_OK,
+            cy3240_client_read(pClient, SLAVE_ADDRESS, readBack[0], &(uint16_t){ 2 })
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Broadcast Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerBroadcast(
+        void
+        )
+{
+    Cy3240_Client_t* pOther = NULL;
+    Cy3240_Sample_t sample;
+    Cy3240_Sample_t received;
+    Cy3240_Server_Stats_t stats;
+    int matches = 0;
+    int x;
+
+    assertEquals("The second client should connect",
+            CY3240_ERROR_OK,
+            cy3240_client_open(&pOther, path, SERIAL)
+            );
+
+    assertTrue("Both clients should subscribe",
+            CY3240_SUCCESS(cy3240_client_map(pClient, true)) &&
+            CY3240_SUCCESS(cy3240_client_map(pOther, true))
+            );
+
+    assertEquals("No sample should be waiting",
+            CY3240_ERROR_TIMEOUT,
+            cy3240_client_wait_sample(pOther, &received, 1)
+            );
+
+    // One read reaches every subscriber
+    memset(&sample, 0x00, sizeof(sample));
+
+    for (x = 0; x < SAMPLES; x++) {
+        sample.job = x;
+        sample.length = 1;
+        sample.data[0] = (uint8_t)(0xA0 + x);
+        cy3240_server_publish(pServer, &sample);
+    }
+
+    for (x = 0; x < SAMPLES; x++) {
+
+        if (CY3240_SUCCESS(cy3240_client_wait_sample(pClient, &received, 1000)) &&
+            (received.job == x) && (received.data[0] == 0xA0 + x))
+            matches++;
+
+        if (CY3240_SUCCESS(cy3240_client_wait_sample(pOther, &received, 1000)) &&
+            (received.job == x) && (received.data[0] == 0xA0 + x))
+            matches++;
+    }
+
+    cy3240_server_get_stats(pServer, &stats);
+    cy3240_client_close(pOther);
+
+    assertEquals("Every subscriber should get every sample in order",
+            2 * SAMPLES,
+            matches
+            );
+
+    assertTrue("The delivered samples should be counted",
+            (stats.samples == 2 * SAMPLES) && (stats.dropped == 0)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Two Bridges Test Case, as the daemon shares them. The second bridge
+ *  acknowledges everything.
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerBridges(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Client_t* pSecond = NULL;
+    Cy3240_t* pCy3240;
+    uint8_t data[] = { 0x30, 0x5A };
+    uint16_t length = sizeof(data);
+    int second = 0;
+
+    memset(RECEIVE_BUFFER, TX_ACK, sizeof(RECEIVE_BUFFER));
+
+    // Bridges are only added before the server starts
+    cy3240_client_close(pClient);
+    cy3240_server_destroy(pServer);
+    pClient = NULL;
+    pServer = NULL;
+
+    result = cy3240_factory(
+            &second,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The second usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    pCy3240 = cy3240_handle_get(second);
+    cy3240_handle_put(second);
+    pCy3240->w.init = testGenericInit;
+    pCy3240->w.close = testGenericClose;
+    pCy3240->w.write = testGenericWrite;
+    pCy3240->w.read = testGenericRead;
+    pCy3240->w.cleanup = testGenericCleanup;
+    pCy3240->w.delete_if = testGenericDeleteIf;
+    pCy3240->w.force_open = testGenericForceOpen;
+    pCy3240->w.new_if = testGenericNewHidInterface;
+
+    assertEquals("The second bridge should open alongside the first",
+            CY3240_ERROR_OK,
+            cy3240_open(second)
+            );
+
+    result = cy3240_server_create(&pServer, path);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_add_bridge(pServer, myHandle, SERIAL);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_add_bridge(pServer, second, SERIAL_SECOND);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_start(pServer);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_client_open(&pClient, path, SERIAL);
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_client_open(&pSecond, path, SERIAL_SECOND);
+
+    assertEquals("The clients should connect to both bridges",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The first bridge should be served",
+            CY3240_ERROR_OK,
+            cy3240_client_write(pClient, SLAVE_ADDRESS, data, &length)
+            );
+
+    length = sizeof(data);
+
+    assertEquals("The second bridge should be served",
+            CY3240_ERROR_OK,
+            cy3240_client_write(pSecond, SLAVE_ADDRESS, data, &length)
+            );
+
+    // Take the second bridge down, the first keeps working
+    cy3240_client_close(pSecond);
+    cy3240_server_destroy(pServer);
+    pServer = NULL;
+
+    assertEquals("The second bridge should close",
+            CY3240_ERROR_OK,
+            cy3240_close(second)
+            );
+
+    length = sizeof(data);
+
+    assertEquals("The first bridge should outlive the second",
+            CY3240_ERROR_OK,
+            cy3240_write(myHandle, SLAVE_ADDRESS, data, &length)
+            );
+
+    assertEquals("The first bridge should have written the register",
+            0x5A,
+            registers[0x30]
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Bind Failure Test Case, a socket that cannot be bound is not listened on
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testServerBindFailure(
+        void
+        )
+{
+    Cy3240_Server_t* pOther = NULL;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+
+    result = cy3240_server_create(&pOther, "/nonexistent/cy3240.sock");
+
+    if CY3240_SUCCESS(result)
+        result = cy3240_server_add_bridge(pOther, myHandle, SERIAL);
+
+    assertEquals("The server should be created",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("A directory that does not exist should fail the start",
+            CY3240_ERROR_UNKNOWN,
+            cy3240_server_start(pOther)
+            );
+
+    assertEquals("A server that did not start should be destroyed",
+            CY3240_ERROR_OK,
+            cy3240_server_destroy(pOther)
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,143 @@
+/** AceUnit test header file for fixture serverTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file serverTest.h
+ */
+
+#ifndef _SERVERTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _SERVERTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 80
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testServerTransfer(void);
+A_Test void testServerMultiPacket(void);
+A_Test void testServerClients(void);
+A_Test void testServerShared(void);
+A_Test void testServerBroadcast(void);
+A_Test void testServerBridges(void);
+A_Test void testServerBindFailure(void);
+A_Before void testServerSetup(void);
+A_After void testServerCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    81, /* testServerTransfer */
+    82, /* testServerMultiPacket */
+    83, /* testServerClients */
+    84, /* testServerShared */
+    85, /* testServerBroadcast */
+    105, /* testServerBridges */
+    109, /* testServerBindFailure */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testServerTransfer",
+    "testServerMultiPacket",
+    "testServerClients",
+    "testServerShared",
+    "testServerBroadcast",
+    "testServerBridges",
+    "testServerBindFailure",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testServerTransfer,
+    testServerMultiPacket,
+    testServerClients,
+    testServerShared,
+    testServerBroadcast,
+    testServerBridges,
+    testServerBindFailure,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testServerSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testServerCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t serverTestFixture = {
+    80,
+#ifndef ACEUNIT_EMBEDDED
+    "serverTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _SERVERTEST_H */
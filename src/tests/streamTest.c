@@ -0,0 +1,412 @@
+/**
+ * @file streamTest
+ *
+ * @brief CY3240 raw data streaming tests
+ *
+ * CY3240 raw data streaming tests against a simulated touch controller
+ *
+ * @ingroup Stream
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include <unistd.h>
+#include "unittest.h"
+#include "cy3240_stream.h"
+#include "streamTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define TOUCH_ADDRESS   (0x21)
+#define TOUCH_SENSORS   (40)
+#define STREAM_FRAMES   (20)
+#define WAIT_LOOPS      (2000)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// The last command written and its arguments
+static uint8_t command[CY3240_TOUCH_MAX_FRAME];
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, runs the packet against the
+ *  simulated controller and queues the response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t* const pPacket = (const uint8_t*)bytes;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    uint8_t length = pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS;
+    uint8_t* const pValues = &pResponse[OUTPUT_PACKET_INDEX_DATA + 1];
+    int x;
+
+    memset(pResponse, 0x00, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    // A command, remember it
+    if ((pPacket[INPUT_PACKET_INDEX_ADDRESS] != TOUCH_ADDRESS) ||
+        !(pPacket[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ)) {
+
+        if (pPacket[INPUT_PACKET_INDEX_ADDRESS] == TOUCH_ADDRESS)
+            memcpy(command, &pPacket[INPUT_PACKET_INDEX_ADDRESS + 1], length);
+
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+
+        return HID_RET_SUCCESS;
+    }
+
+    // The response to the last command
+    pResponse[OUTPUT_PACKET_INDEX_DATA] = CY3240_TOUCH_RESPONSE(command[0]);
+
+    switch (command[0]) {
+
+        case FW_TOUCH_INPUT_CMD_GET_RAW_DATA:
+            for (x = 0; x < command[2]; x++) {
+                pValues[2 * x] = (uint8_t)((1000 + command[1] + x) >> 8);
+                pValues[2 * x + 1] = (uint8_t)(1000 + command[1] + x);
+            }
+            break;
+
+        case FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS:
+            pValues[0] = TOUCH_SENSORS;
+            break;
+
+        default:
+            break;
+    }
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, returns the oldest response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+
+    return HID_RET_SUCCESS;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testStreamSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    memset(command, 0x00, sizeof(command));
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testStreamCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testStreamError(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Stream_t* pStream = NULL;
+
+    result = cy3240_stream_create(
+            &pStream,
+            handle,
+            TOUCH_ADDRESS,
+            TOUCH_SENSORS,
+            3
+            );
+
+    assertEquals("A capacity that is not a power of two should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_stream_create(
+            &pStream,
+            handle,
+            TOUCH_ADDRESS,
+            CY3240_STREAM_MAX_SENSORS + 1,
+            4
+            );
+
+    assertEquals("Too many sensors should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_stream_start(NULL);
+
+    assertEquals("A NULL stream should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testStreamFrames(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Stream_t* pStream = NULL;
+    Cy3240_Frame_t frame;
+    uint64_t sequence = 0;
+    uint64_t timestamp = 0;
+    int frames = 0;
+    int loops = 0;
+    int sensor;
+
+    // Let the stream ask for the number of sensors
+    result = cy3240_stream_create(
+            &pStream,
+            handle,
+            TOUCH_ADDRESS,
+            0,
+            64
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    result = cy3240_stream_start(pStream);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    while ((frames < STREAM_FRAMES) && (loops++ < WAIT_LOOPS)) {
+
+        if (!cy3240_stream_poll(pStream, &frame)) {
+            usleep(1000);
+            continue;
+        }
+
+        assertEquals("The frame should be captured",
+                CY3240_ERROR_OK,
+                frame.result
+                );
+
+        assertEquals("Every sensor should be in the frame",
+                TOUCH_SENSORS,
+                frame.count
+                );
+
+        assertTrue("Sequence numbers should increase",
+                (frames == 0) || (frame.sequence > sequence)
+                );
+
+        assertTrue("Timestamps should not go backwards",
+                frame.timestamp_us >= timestamp
+                );
+
+        for (sensor = 0; sensor < TOUCH_SENSORS; sensor++)
+            assertEquals("Every raw count should be decoded",
+                    1000 + sensor,
+                    frame.raw[sensor]
+                    );
+
+        sequence = frame.sequence;
+        timestamp = frame.timestamp_us;
+        frames++;
+    }
+
+    cy3240_stream_destroy(pStream);
+
+    assertEquals("The frames should arrive",
+            STREAM_FRAMES,
+            frames
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testStreamDropped(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Stream_t* pStream = NULL;
+    Cy3240_Stream_Stats_t stats;
+    Cy3240_Frame_t frame;
+    uint64_t x;
+    int loops = 0;
+
+    result = cy3240_stream_create(
+            &pStream,
+            handle,
+            TOUCH_ADDRESS,
+            TOUCH_SENSORS,
+            4
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    memset(&stats, 0x00, sizeof(stats));
+
+    // Nobody polls, so the ring fills up
+    cy3240_stream_start(pStream);
+
+    while ((stats.frames < STREAM_FRAMES) && (loops++ < WAIT_LOOPS)) {
+        usleep(1000);
+        cy3240_stream_get_stats(pStream, &stats);
+    }
+
+    cy3240_stream_stop(pStream);
+    cy3240_stream_get_stats(pStream, &stats);
+
+    assertEquals("Every frame that did not fit should be counted",
+            stats.frames - 4,
+            stats.dropped
+            );
+
+    assertTrue("The stream should time the frames",
+            stats.last_us >= stats.first_us
+            );
+
+    // The oldest frames are kept
+    for (x = 0; x < 4; x++) {
+
+        assertTrue("The ring should hold a frame",
+                cy3240_stream_poll(pStream, &frame)
+                );
+
+        assertEquals("The oldest frames should be kept",
+                x,
+                frame.sequence
+                );
+    }
+
+    assertTrue("The ring should be empty",
+            !cy3240_stream_poll(pStream, &frame)
+            );
+
+    cy3240_stream_destroy(pStream);
+}
+
+//@} End of Methods
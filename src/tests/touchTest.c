@@ -0,0 +1,438 @@
+/**
+ * @file touchTest
+ *
+ * @brief CY3240 touch controller driver tests
+ *
+ * CY3240 touch controller driver tests against a simulated controller
+ *
+ * @ingroup Touch
+ *
+ * @owner  Kevin S Kirkup (kevin.kirkup@gmail.com)
+ * @author Kevin S Kirkup (kevin.kirkup@gmail.com)
+ */
+//////////////////////////////////////////////////////////////////////
+/// @name Includes
+//@{
+
+#include <string.h>
+#include "unittest.h"
+#include "cy3240_touch.h"
+#include "touchTest.h"
+//@} End of Includes
+
+//////////////////////////////////////////////////////////////////////
+/// @name Defines
+//@{
+
+#define TOUCH_ADDRESS   (0x21)
+#define TOUCH_SENSORS   (40)
+#define TOUCH_X         (0x0123)
+#define TOUCH_Y         (0x0456)
+#define QUEUE_SIZE      (64)
+
+//@} End of Defines
+
+//////////////////////////////////////////////////////////////////////
+/// @name Data
+//@{
+
+// Values stored by the SET commands, indexed by the SET command
+static uint8_t registers[256];
+
+// The last command written and its arguments
+static uint8_t command[CY3240_TOUCH_MAX_FRAME];
+
+// Answer with a wrong response byte
+static bool badResponse;
+
+// Packets in flight
+static int outstanding;
+static int maxOutstanding;
+
+// Responses waiting to be read, the bridge answers in order
+static uint8_t queue[QUEUE_SIZE][RECV_PACKET_LEN];
+static int queueHead;
+static int queueTail;
+
+//@} End of Data
+
+//////////////////////////////////////////////////////////////////////
+/// @name Private Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID write, runs the packet against the
+ *  simulated controller and queues the response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myWrite(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        const char* bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Write\n");)
+
+    const uint8_t* const pPacket = (const uint8_t*)bytes;
+    uint8_t* const pResponse = queue[queueHead++ % QUEUE_SIZE];
+    uint8_t length = pPacket[INPUT_PACKET_INDEX_LENGTH] & ~LENGTH_BYTE_MORE_PACKETS;
+    uint8_t* const pValues = &pResponse[OUTPUT_PACKET_INDEX_DATA + 1];
+    int x;
+
+    if (++outstanding > maxOutstanding)
+        maxOutstanding = outstanding;
+
+    memset(pResponse, 0x00, RECV_PACKET_LEN);
+    pResponse[OUTPUT_PACKET_INDEX_STATUS] = STATUS_BYTE_POWERED;
+
+    if (pPacket[INPUT_PACKET_INDEX_ADDRESS] != TOUCH_ADDRESS) {
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+        return HID_RET_SUCCESS;
+    }
+
+    // A command, remember it and run SET commands
+    if (!(pPacket[INPUT_PACKET_INDEX_CMD] & CONTROL_BYTE_I2C_READ)) {
+
+        memcpy(command, &pPacket[INPUT_PACKET_INDEX_ADDRESS + 1], length);
+
+        if (length == 2)
+            registers[command[0]] = command[1];
+
+        memset(&pResponse[OUTPUT_PACKET_INDEX_DATA], TX_ACK, RECV_PACKET_LEN - 1);
+
+        return HID_RET_SUCCESS;
+    }
+
+    // The response to the last command
+    pResponse[OUTPUT_PACKET_INDEX_DATA] = CY3240_TOUCH_RESPONSE(command[0]) ^ (badResponse ? 0x01 : 0x00);
+
+    switch (command[0]) {
+
+        case FW_TOUCH_INPUT_CMD_GET_RAW_DATA:
+            for (x = 0; x < command[2]; x++) {
+                pValues[2 * x] = (uint8_t)((1000 + command[1] + x) >> 8);
+                pValues[2 * x + 1] = (uint8_t)(1000 + command[1] + x);
+            }
+            break;
+
+        case FW_TOUCH_INPUT_CMD_GET_STATUS_2D:
+            pValues[0] = TOUCH_X >> 8;
+            pValues[1] = TOUCH_X & 0xFF;
+            pValues[2] = TOUCH_Y >> 8;
+            pValues[3] = TOUCH_Y & 0xFF;
+            break;
+
+        case FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS:
+            pValues[0] = TOUCH_SENSORS;
+            break;
+
+        default:
+            // GET commands read what the following SET command stored
+            pValues[0] = registers[command[0] + 1];
+            break;
+    }
+
+    return HID_RET_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Substitute method for the HID read, returns the oldest response
+ *
+ *  @see hid.h
+ *  @returns hid_return
+ */
+//-----------------------------------------------------------------------------
+static hid_return
+myRead(
+        HIDInterface* const hidif,
+        unsigned int const ep,
+        char* const bytes,
+        unsigned int const size,
+        unsigned int const timeout
+        )
+{
+    DBG(printf("HID Read\n");)
+
+    if (queueHead == queueTail)
+        return HID_RET_TIMEOUT;
+
+    memcpy(bytes, queue[queueTail++ % QUEUE_SIZE], size);
+    outstanding--;
+
+    return HID_RET_SUCCESS;
+}
+
+//@} End of Private Methods
+
+//////////////////////////////////////////////////////////////////////
+/// @name Methods
+//@{
+
+//-----------------------------------------------------------------------------
+/**
+ *  Setup before each test case
+ */
+//-----------------------------------------------------------------------------
+A_Before void
+testTouchSetup(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = 0;
+
+    memset(registers, 0x00, sizeof(registers));
+    memset(command, 0x00, sizeof(command));
+    badResponse = false;
+    outstanding = 0;
+    maxOutstanding = 0;
+    queueHead = 0;
+    queueTail = 0;
+
+    // Initialize the state
+    result = cy3240_factory(
+            &handle,
+            0,
+            1000,
+            CY3240_POWER_5V,
+            CY3240_BUS_I2C,
+            CY3240_CLOCK__400kHz
+            );
+
+    assertTrue("The usb device should be successfully created",
+            CY3240_SUCCESS(result)
+            );
+
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
+
+    // Modify the read and write interfaces to point to our functions
+    pMyData->w.init = testGenericInit;
+    pMyData->w.close = testGenericClose;
+    pMyData->w.write = myWrite;
+    pMyData->w.read = myRead;
+    pMyData->w.cleanup = testGenericCleanup;
+    pMyData->w.delete_if = testGenericDeleteIf;
+    pMyData->w.force_open = testGenericForceOpen;
+    pMyData->w.new_if = testGenericNewHidInterface;
+
+    // Open the device
+    result = cy3240_open(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Cleanup after each test case
+ */
+//-----------------------------------------------------------------------------
+A_After void
+testTouchCleanup(
+        void
+        )
+{
+    int handle = myHandle;
+
+    // Close the device handle
+    cy3240_close(handle);
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Error Test Case
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testTouchError(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Touch_Frame_t frame;
+    uint8_t args[2] = {0, CY3240_TOUCH_MAX_RAW_SENSORS + 1};
+
+    result = cy3240_touch_encode(
+            &frame,
+            FW_TOUCH_INPUT_CMD_SET_FINGER_THRESHOLD,
+            NULL,
+            0
+            );
+
+    assertEquals("A SET command without its argument should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_touch_encode(
+            &frame,
+            (Cy3240_Touch_Cmd_t)0x40,
+            NULL,
+            0
+            );
+
+    assertEquals("An unknown command should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+
+    result = cy3240_touch_encode(
+            &frame,
+            FW_TOUCH_INPUT_CMD_GET_RAW_DATA,
+            args,
+            sizeof(args)
+            );
+
+    assertEquals("A response larger than a packet should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            result);
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testTouchTuning(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    Cy3240_Touch_Tuning_t tuning = {10, 20, 30, 40, 50, 60, 70, 80};
+    Cy3240_Touch_Tuning_t readBack;
+    uint8_t value = 0;
+
+    result = cy3240_touch_set_tuning(
+            handle,
+            TOUCH_ADDRESS,
+            &tuning
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The commands should be pipelined",
+            CY3240_PIPELINE_DEPTH_DEFAULT,
+            maxOutstanding
+            );
+
+    memset(&readBack, 0x00, sizeof(readBack));
+
+    result = cy3240_touch_get_tuning(
+            handle,
+            TOUCH_ADDRESS,
+            &readBack
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertTrue("The tuning should read back",
+            memcmp(&tuning, &readBack, sizeof(tuning)) == 0
+            );
+
+    result = cy3240_touch_get(
+            handle,
+            TOUCH_ADDRESS,
+            FW_TOUCH_INPUT_CMD_GET_HYSTERESIS,
+            &value
+            );
+
+    assertEquals("A single GET should read the same value",
+            70,
+            value
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testTouchRawData(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint16_t raw[TOUCH_SENSORS];
+    uint16_t x = 0;
+    uint16_t y = 0;
+    int sensor;
+
+    memset(raw, 0x00, sizeof(raw));
+
+    // More sensors than fit in one frame
+    result = cy3240_touch_get_raw_data(
+            handle,
+            TOUCH_ADDRESS,
+            0,
+            TOUCH_SENSORS,
+            raw
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    for (sensor = 0; sensor < TOUCH_SENSORS; sensor++)
+        assertEquals("Every raw count should be decoded",
+                1000 + sensor,
+                raw[sensor]
+                );
+
+    result = cy3240_touch_get_status_2d(
+            handle,
+            TOUCH_ADDRESS,
+            &x,
+            &y
+            );
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The X position should be decoded",
+            TOUCH_X,
+            x
+            );
+
+    assertEquals("The Y position should be decoded",
+            TOUCH_Y,
+            y
+            );
+}
+
+//-----------------------------------------------------------------------------
+A_Test void
+testTouchBadResponse(
+        void
+        )
+{
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    int handle = myHandle;
+    uint8_t value = 0;
+
+    badResponse = true;
+
+    result = cy3240_touch_get(
+            handle,
+            TOUCH_ADDRESS,
+            FW_TOUCH_INPUT_CMD_GET_NUM_SENSORS,
+            &value
+            );
+
+    assertEquals("A wrong response byte should be a receive error",
+            CY3240_ERROR_RX,
+            result
+            );
+}
+
+//@} End of Methods
@@ -0,0 +1,125 @@
+/** AceUnit test header file for fixture touchTest.
+ *
+ * You may wonder why this is a header file and yet generates program elements.
+ * This allows you to declare test methods as static.
+ *
+ * @warning This is a generated file. Do not edit. Your changes will be lost.
+ * @file touchTest.h
+ */
+
+#ifndef _TOUCHTEST_H
+/** Include shield to protect this header file from being included more than once. */
+#define _TOUCHTEST_H
+
+/** The id of this fixture. */
+#define A_FIXTURE_ID 42
+
+#include "AceUnit.h"
+
+/* The prototypes are here to be able to include this header file at the beginning of the test file instead of at the end. */
+A_Test void testTouchError(void);
+A_Test void testTouchTuning(void);
+A_Test void testTouchRawData(void);
+A_Test void testTouchBadResponse(void);
+A_Before void testTouchSetup(void);
+A_After void testTouchCleanup(void);
+
+/** The test case ids of this fixture. */
+static const TestCaseId_t testIds[] = {
+    43, /* testTouchError */
+    44, /* testTouchTuning */
+    45, /* testTouchRawData */
+    46, /* testTouchBadResponse */
+};
+
+#ifndef ACEUNIT_EMBEDDED
+/** The test names of this fixture. */
+static const char *const testNames[] = {
+    "testTouchError",
+    "testTouchTuning",
+    "testTouchRawData",
+    "testTouchBadResponse",
+};
+#endif
+
+#ifdef ACEUNIT_LOOP
+/** The loops of this fixture. */
+static const aceunit_loop_t loops[] = {
+    1,
+    1,
+    1,
+    1,
+};
+#endif
+
+#ifdef ACEUNIT_GROUP
+/** The groups of this fixture. */
+static const AceGroupId_t groups[] = {
+    0,
+    0,
+    0,
+    0,
+};
+#endif
+
+/** The test cases of this fixture. */
+static const testMethod_t testCases[] = {
+    testTouchError,
+    testTouchTuning,
+    testTouchRawData,
+    testTouchBadResponse,
+    NULL
+};
+
+/** The before methods of this fixture. */
+static const testMethod_t before[] = {
+    testTouchSetup,
+    NULL
+};
+
+/** The after methods of this fixture. */
+static const testMethod_t after[] = {
+    testTouchCleanup,
+    NULL
+};
+
+/** The beforeClass methods of this fixture. */
+static const testMethod_t beforeClass[] = {
+    NULL
+};
+
+/** The afterClass methods of this fixture. */
+static const testMethod_t afterClass[] = {
+    NULL
+};
+
+/** This fixture. */
+#if defined __cplusplus
+extern
+#endif
+const TestFixture_t touchTestFixture = {
+    42,
+#ifndef ACEUNIT_EMBEDDED
+    "touchTest",
+#endif
+#ifdef ACEUNIT_SUITES
+    NULL,
+#endif
+    testIds,
+#ifndef ACEUNIT_EMBEDDED
+    testNames,
+#endif
+#ifdef ACEUNIT_LOOP
+    loops,
+#endif
+#ifdef ACEUNIT_GROUP
+    groups,
+#endif
+    testCases,
+    before,
+    after,
+    beforeClass,
+    afterClass
+};
+
+#endif /* _TOUCHTEST_H */
@@ -30,10 +30,18 @@
  */
 Cy3240_t* pMyData;
 
+/**
+ * The handle of pMyData
+ */
+int myHandle;
+
 // The sending buffer
 uint8_t SEND_BUFFER[SEND_BUFFER_SIZE] = {0};
 uint8_t RECEIVE_BUFFER[RECEIVE_BUFFER_SIZE] = {0};
 
+// libhid is initialized once per process, as the real library
+static bool hidInitialized = false;
+
 //@} End of Data
 
 
@@ -56,6 +64,11 @@ testGenericInit(
 {
     DBG(printf("Generic HID Init\n");)
 
+    if (hidInitialized)
+        return HID_RET_ALREADY_INITIALISED;
+
+    hidInitialized = true;
+
     return HID_RET_SUCCESS;
 }   /* -----  end of static function init_test  ----- */
 
@@ -96,6 +109,9 @@ testGenericWrite(
 {
     DBG(printf("Generic HID Write\n");)
 
+    if (!hidInitialized)
+        return HID_RET_NOT_INITIALISED;
+
     // Write the data to the send buffer
     memcpy(SEND_BUFFER, bytes, size);
 
@@ -121,6 +137,9 @@ testGenericRead(
 {
     DBG(printf("Generic HID Read\n");)
 
+    if (!hidInitialized)
+        return HID_RET_NOT_INITIALISED;
+
     // Copy the acknowledgments in the return buffer
     memcpy(bytes, RECEIVE_BUFFER, size);
 
@@ -145,6 +164,11 @@ testGenericCleanup(
 {
     DBG(printf("Generic HID Cleanup\n");)
 
+    if (!hidInitialized)
+        return HID_RET_NOT_INITIALISED;
+
+    hidInitialized = false;
+
     return HID_RET_SUCCESS;
 }
 
@@ -26,6 +26,7 @@ extern "C" {
 #include "cy3240_types.h"
 #include "cy3240_private_types.h"
 #include "cy3240_util.h"
+#include "cy3240_handle.h"
 #include "cy3240_packet.h"
 #include "AceUnitData.h"
 
@@ -50,6 +51,11 @@ extern "C" {
  */
 extern Cy3240_t* pMyData;
 
+/**
+ * The handle of pMyData
+ */
+extern int myHandle;
+
 // The sending buffer
 extern uint8_t SEND_BUFFER[SEND_BUFFER_SIZE];
 extern uint8_t RECEIVE_BUFFER[SEND_BUFFER_SIZE];
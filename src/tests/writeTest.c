@@ -28,6 +28,16 @@
 // The location where data should be written in the send buffer
 uint8_t* pWrite;
 
+// The last two packets written and the number of packets
+static uint8_t previousPacket[CY3240_MAX_SIZE_PACKET];
+static uint8_t lastPacket[CY3240_MAX_SIZE_PACKET];
+static int writes;
+
+// Packets from nakWrite on are refused at acknowledgment nakIndex
+static int nakWrite;
+static int nakCount;
+static int nakIndex;
+
 //@} End of Data
 
 
@@ -54,11 +64,17 @@ myWrite(
 {
     DBG(printf("HID Write\n");)
 
-    // Write the data to the send buffer
-    memcpy(pWrite, bytes, size);
+    // Write the data to the send buffer while there is room
+    if ((pWrite + size) <= (SEND_BUFFER + SEND_BUFFER_SIZE)) {
+        memcpy(pWrite, bytes, size);
 
-    // Move the write pointer
-    pWrite += size;
+        // Move the write pointer
+        pWrite += size;
+    }
+
+    memcpy(previousPacket, lastPacket, sizeof(lastPacket));
+    memcpy(lastPacket, bytes, size);
+    writes++;
 
     return HID_RET_SUCCESS;
 }
@@ -88,6 +104,12 @@ myRead(
     // Set the status byte to something unique
     bytes[0] = 0x07;
 
+    // Refuse the packet
+    if ((nakWrite != 0) &&
+        (writes >= nakWrite) &&
+        (writes < nakWrite + nakCount))
+        bytes[nakIndex] = 0x00;
+
     return HID_RET_SUCCESS;
 }
 
@@ -109,6 +131,10 @@ testWriteSetup(
 
     // Initialize the write location
     pWrite = SEND_BUFFER;
+    writes = 0;
+    nakWrite = 0;
+    nakCount = 0;
+    nakIndex = 0;
 
     // Fill the receive buffer with ack bytes
     memset(RECEIVE_BUFFER, TX_ACK, sizeof(RECEIVE_BUFFER));
@@ -127,7 +153,10 @@ testWriteSetup(
             CY3240_SUCCESS(result)
             );
 
-    pMyData = (Cy3240_t*)handle;
+    // Only the test thread uses the state, the lookup is not held
+    pMyData = cy3240_handle_get(handle);
+    cy3240_handle_put(handle);
+    myHandle = handle;
 
     // Modify the read and write interfaces to point to our functions
     pMyData->w.init = testGenericInit;
@@ -154,7 +183,7 @@ testWriteCleanup(
         void
         )
 {
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Close the device handle
     cy3240_close(handle);
@@ -188,7 +217,7 @@ testWriteError(
             );
 
     // Initialize the handle
-    handle = (int)pMyData;
+    handle = myHandle;
 
     // NULL Data buffer
     result = cy3240_write(
@@ -244,7 +273,7 @@ testWriteSmall(
     uint8_t data[8] = {0};
     uint16_t length = 8;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Fill the data buffer with a test pattern
     memset(data, 0xAC, sizeof(data));
@@ -295,7 +324,7 @@ testWriteMedium(
     uint8_t data[61] = {0};
     uint16_t length = 61;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Fill the data buffer with a test pattern
     memset(data, 0xAC, sizeof(data));
@@ -346,7 +375,7 @@ testWriteLarge(
     uint8_t data[69] = {0};
     uint16_t length = 69;
     Cy3240_Error_t result = CY3240_ERROR_OK;
-    int handle = (int)pMyData;
+    int handle = myHandle;
 
     // Fill the data buffer with a test pattern
     memset(data, 0xAC, sizeof(data));
@@ -410,6 +439,225 @@ testWriteNack(
         void
         )
 {
+    uint8_t data[8] = {0};
+    uint16_t length = 8;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Retry_Stats_t stats;
+    int handle = myHandle;
+
+    // The slave refuses the fourth byte
+    nakWrite = 1;
+    nakCount = 1;
+    nakIndex = OUTPUT_PACKET_INDEX_DATA + 3;
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length);
+
+    assertEquals("Without a retry policy the NAK should fail the write",
+            CY3240_ERROR_TX,
+            result
+            );
+
+    assertEquals("The packet should not have been sent again",
+            1,
+            writes
+            );
+
+    cy3240_get_retry_stats(handle, &stats);
+
+    assertTrue("The data NAK should be counted",
+            (stats.naks[CY3240_NAK_DATA] == 1) &&
+            (stats.naks[CY3240_NAK_ADDRESS] == 0) &&
+            (stats.retries == 0) &&
+            (stats.exhausted == 1)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Test Case for retrying a slave busy with an internal write cycle
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testWriteRetryAddress(
+        void
+        )
+{
+    uint8_t data[8] = {0};
+    uint16_t length = 8;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Retry_Policy_t policy = {4, 2000, 4000, 2, 0};
+    Cy3240_Retry_Stats_t stats;
+    int handle = myHandle;
+    uint64_t start;
+
+    result = cy3240_set_retry_policy(
+            handle,
+            CY3240_NAK_ADDRESS,
+            &policy);
+
+    assertEquals("The operation should result in an OK",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    policy.attempts = 0;
+
+    assertEquals("A policy without attempts should indicate invalid parameter",
+            CY3240_ERROR_INVALID_PARAMETERS,
+            cy3240_set_retry_policy(handle, CY3240_NAK_ADDRESS, &policy)
+            );
+
+    // The address is refused twice
+    nakWrite = 1;
+    nakCount = 2;
+    nakIndex = OUTPUT_PACKET_INDEX_DATA;
+
+    start = cy3240_util_time_us();
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length);
+
+    assertEquals("The write should complete once the slave answers",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The packet should have been sent three times",
+            3,
+            writes
+            );
+
+    cy3240_get_retry_stats(handle, &stats);
+
+    assertTrue("The backoff should double between the retries",
+            (stats.naks[CY3240_NAK_ADDRESS] == 2) &&
+            (stats.retries == 2) &&
+            (stats.backoff_us == 6000) &&
+            ((cy3240_util_time_us() - start) >= 6000)
+            );
+
+    // The slave stays busy
+    writes = 0;
+    nakWrite = 1;
+    nakCount = 10;
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length);
+
+    assertEquals("The write should fail after the last attempt",
+            CY3240_ERROR_TX,
+            result
+            );
+
+    cy3240_get_retry_stats(handle, &stats);
+
+    assertTrue("Every attempt should have been used",
+            (writes == 4) &&
+            (stats.exhausted == 1)
+            );
+
+    // A data NAK has its own policy
+    writes = 0;
+    nakIndex = OUTPUT_PACKET_INDEX_DATA + 1;
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length);
+
+    assertTrue("A data NAK should not use the address policy",
+            (result == CY3240_ERROR_TX) &&
+            (writes == 1)
+            );
+}
+
+//-----------------------------------------------------------------------------
+/**
+ *  Test Case for sending a large write again from its first byte after
+ *  a NAK of its second packet
+ */
+//-----------------------------------------------------------------------------
+A_Test void
+testWriteRestart(
+        void
+        )
+{
+    uint8_t data[69] = {0};
+    uint16_t length = 69;
+    Cy3240_Error_t result = CY3240_ERROR_OK;
+    Cy3240_Retry_Policy_t policy = {2, 0, 0, 1, 0};
+    Cy3240_Retry_Stats_t stats;
+    int handle = myHandle;
+    int x;
+
+    // Fill the data buffer with a test pattern
+    for (x = 0; x < sizeof(data); x++)
+        data[x] = (uint8_t)x;
+
+    cy3240_set_retry_policy(
+            handle,
+            CY3240_NAK_DATA,
+            &policy);
+
+    // The slave refuses a byte of the second packet
+    nakWrite = 2;
+    nakCount = 1;
+    nakIndex = OUTPUT_PACKET_INDEX_DATA + 4;
+
+    result = cy3240_write(
+            handle,
+            MY_ADDRESS,
+            data,
+            &length);
+
+    assertEquals("The write should complete successfully",
+            CY3240_ERROR_OK,
+            result
+            );
+
+    assertEquals("The whole write should have been sent again",
+            4,
+            writes
+            );
+
+    assertEquals("The retry should address the slave again",
+            MY_ADDRESS,
+            previousPacket[INPUT_PACKET_INDEX_ADDRESS]
+            );
+
+    assertEquals("The retry should start with the first byte",
+            0,
+            memcmp(data, &previousPacket[WRITE_INPUT_PACKET_INDEX_DATA], CY3240_MAX_WRITE_BYTES)
+            );
+
+    assertEquals("The retry should end with the second packet, start, stop, write and I2C: 0x0A",
+            0x0A,
+            lastPacket[INPUT_PACKET_INDEX_CMD]
+            );
+
+    assertEquals("The second packet should continue after the first",
+            0,
+            memcmp(&data[CY3240_MAX_WRITE_BYTES], &lastPacket[WRITE_INPUT_PACKET_INDEX_DATA - 1], 8)
+            );
+
+    cy3240_get_retry_stats(handle, &stats);
+
+    assertTrue("The data NAK should be counted",
+            (stats.naks[CY3240_NAK_DATA] == 1) &&
+            (stats.retries == 1) &&
+            (stats.resent_bytes == sizeof(data))
+            );
 }
 
 //@} End of Methods
@@ -22,6 +22,8 @@ A_Test void testWriteSmall(void);
 A_Test void testWriteMedium(void);
 A_Test void testWriteLarge(void);
 A_Test void testWriteNack(void);
+A_Test void testWriteRetryAddress(void);
+A_Test void testWriteRestart(void);
 A_Before void testWriteSetup(void);
 A_After void testWriteCleanup(void);
 
@@ -32,6 +34,8 @@ static const TestCaseId_t testIds[] = {
     24, /* testWriteMedium */
     25, /* testWriteLarge */
     26, /* testWriteNack */
+    65, /* testWriteRetryAddress */
+    66, /* testWriteRestart */
 };
 
 #ifndef ACEUNIT_EMBEDDED
@@ -42,6 +46,8 @@ static const char *const testNames[] = {
     "testWriteMedium",
     "testWriteLarge",
     "testWriteNack",
+    "testWriteRetryAddress",
+    "testWriteRestart",
 };
 #endif
 
@@ -53,6 +59,8 @@ static const aceunit_loop_t loops[] = {
     1,
     1,
     1,
+    1,
+    1,
 };
 #endif
 
@@ -64,6 +72,8 @@ static const AceGroupId_t groups[] = {
     0,
     0,
     0,
+    0,
+    0,
 };
 #endif
 
@@ -74,6 +84,8 @@ static const testMethod_t testCases[] = {
     testWriteMedium,
     testWriteLarge,
     testWriteNack,
+    testWriteRetryAddress,
+    testWriteRestart,
     NULL
 };
 